@@ -0,0 +1,124 @@
+/**
+ * backends.cpp - cost of the segment life cycle for each backend,
+ * median time for init (gen_key + init, no zeroing), open (a
+ * second mapping in the same process), close of that mapping,
+ * close + unlink of the original, and first touch per base page
+ * (writing one byte per page of a fresh segment). The page column
+ * is what the segment actually got, huge page rows fall back to
+ * base pages when none are reserved.
+ * usage: backends_bench [rounds per row]
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <shm>
+#include <unistd.h>
+
+#include "bench.hpp"
+
+static std::uint64_t median( std::vector< std::uint64_t > &samples )
+{
+   std::sort( samples.begin(), samples.end() );
+   return( samples[ samples.size() / 2 ] );
+}
+
+template < class Backend >
+static void run( const char *name,
+                 const std::size_t nbytes,
+                 const shm::page_t page,
+                 const std::uint64_t rounds )
+{
+   const auto base_page( static_cast< std::size_t >( sysconf( _SC_PAGESIZE ) ) );
+   std::vector< std::uint64_t > init, open, close_open, close_unlink, touch;
+   std::size_t page_size( 0 );
+   for( std::uint64_t i( 0 ); i < rounds; i++ )
+   {
+      typename Backend::key_type key;
+      auto start( bench::now() );
+      shm::gen_key< Backend >( key, 42 );
+      void *mem( shm::init< Backend >( key, nbytes, false, nullptr, page ) );
+      init.push_back( bench::now() - start );
+      page_size = shm::get_page_size( mem );
+
+      start = bench::now();
+      auto *bytes( reinterpret_cast< volatile char* >( mem ) );
+      for( std::size_t offset( 0 ); offset < nbytes; offset += base_page )
+      {
+         bytes[ offset ] = 1;
+      }
+      touch.push_back( ( bench::now() - start ) / ( ( nbytes + base_page - 1 ) / base_page ) );
+
+      start = bench::now();
+      void *other( shm::open< Backend >( key ) );
+      open.push_back( bench::now() - start );
+
+      start = bench::now();
+      shm::close< Backend >( key, &other, nbytes, false, false );
+      close_open.push_back( bench::now() - start );
+
+      start = bench::now();
+      shm::close< Backend >( key, &mem, nbytes, false, true );
+      close_unlink.push_back( bench::now() - start );
+   }
+   const auto label( std::string( name ) + " " + std::to_string( nbytes >> 10 ) + "KiB" );
+   std::printf( "%-24s %8zuK %12llu %12llu %12llu %12llu %12llu\n",
+                label.c_str(),
+                page_size >> 10,
+                static_cast< unsigned long long >( median( init ) ),
+                static_cast< unsigned long long >( median( open ) ),
+                static_cast< unsigned long long >( median( close_open ) ),
+                static_cast< unsigned long long >( median( close_unlink ) ),
+                static_cast< unsigned long long >( median( touch ) ) );
+}
+
+template < class Backend >
+static void run_all( const char *name, const std::uint64_t rounds )
+{
+   for( const std::size_t nbytes : { std::size_t( 1 ) << 12,
+                                     std::size_t( 1 ) << 20,
+                                     std::size_t( 1 ) << 23 } )
+   {
+      run< Backend >( name, nbytes, shm::page_t::normal, rounds );
+   }
+   const auto huge_name( std::string( name ) + " 2M" );
+   run< Backend >( huge_name.c_str(), std::size_t( 1 ) << 23, shm::page_t::huge_2MB, rounds );
+}
+
+int
+main( int argc, char **argv )
+{
+   const auto rounds( bench::iterations( argc, argv, 200 ) );
+   std::printf( "%-24s %9s %12s %12s %12s %12s %12s\n",
+                "segment life cycle",
+                "page",
+                "init(ns)",
+                "open(ns)",
+                "close(ns)",
+                "unlink(ns)",
+                "touch(ns/pg)" );
+   run_all< shm::posix >( "posix", rounds );
+   run_all< shm::sysv >( "sysv", rounds );
+#if __linux
+   run_all< shm::memfd >( "memfd", rounds );
+#endif
+   return( EXIT_SUCCESS );
+}
@@ -0,0 +1,201 @@
+/**
+ * bench.hpp - helpers shared by the benchmarks, timing,
+ * pinning and summarizing latency samples.
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _SHM_BENCH_HPP_
+#define _SHM_BENCH_HPP_  1
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE 1
+#endif
+#include <sched.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <shm_module.hpp>
+#if __linux && ( PLATFORM_HAS_NUMA == 1 )
+#include <numa.h>
+#endif
+
+namespace bench
+{
+
+/** now - monotonic time in nanoseconds **/
+inline std::uint64_t now()
+{
+   return( static_cast< std::uint64_t >(
+      std::chrono::duration_cast< std::chrono::nanoseconds >(
+         std::chrono::steady_clock::now().time_since_epoch() ).count() ) );
+}
+
+/**
+ * pin - pins the calling thread to cpu modulo the number of
+ * online cpus, so runs on small machines still work.
+ */
+inline void pin( const int cpu )
+{
+#if __linux
+   const auto ncpus( sysconf( _SC_NPROCESSORS_ONLN ) );
+   cpu_set_t set;
+   CPU_ZERO( &set );
+   CPU_SET( cpu % ncpus, &set );
+   if( sched_setaffinity( 0, sizeof( set ), &set ) != 0 )
+   {
+      std::perror( "failed to pin benchmark thread, continuing" );
+   }
+#else
+   (void) cpu;
+#endif
+}
+
+/**
+ * cpu_order - online cpus in the order processes should be
+ * pinned, compact fills one NUMA node before moving to the next,
+ * spread takes one cpu from each node in turn.
+ */
+inline std::vector< int > cpu_order( const bool spread )
+{
+   const auto ncpus( static_cast< int >( sysconf( _SC_NPROCESSORS_ONLN ) ) );
+   std::vector< std::vector< int > > by_node( 1 );
+   for( int cpu( 0 ); cpu < ncpus; cpu++ )
+   {
+      int node( 0 );
+#if __linux && ( PLATFORM_HAS_NUMA == 1 )
+      if( numa_available() != -1 )
+      {
+         node = std::max( numa_node_of_cpu( cpu ), 0 );
+      }
+#endif
+      if( static_cast< std::size_t >( node ) >= by_node.size() )
+      {
+         by_node.resize( node + 1 );
+      }
+      by_node[ node ].push_back( cpu );
+   }
+   std::vector< int > out;
+   if( ! spread )
+   {
+      for( const auto &cpus : by_node )
+      {
+         out.insert( out.end(), cpus.begin(), cpus.end() );
+      }
+      return( out );
+   }
+   for( std::size_t i( 0 ); out.size() < static_cast< std::size_t >( ncpus ); i++ )
+   {
+      for( const auto &cpus : by_node )
+      {
+         if( i < cpus.size() )
+         {
+            out.push_back( cpus[ i ] );
+         }
+      }
+   }
+   return( out );
+}
+
+inline int numa_nodes()
+{
+#if __linux && ( PLATFORM_HAS_NUMA == 1 )
+   if( numa_available() != -1 )
+   {
+      return( numa_num_configured_nodes() );
+   }
+#endif
+   return( 1 );
+}
+
+/**
+ * spin_until - spins on f, yields every so often so that runs
+ * with fewer cores than processes still make progress.
+ */
+template < class F > inline void spin_until( F &&f )
+{
+   for( std::uint32_t spins( 1 ); ! f(); spins++ )
+   {
+      if( ( spins & 0x3ff ) == 0 )
+      {
+         sched_yield();
+      }
+   }
+}
+
+/** iterations - first argument if given, otherwise def **/
+inline std::uint64_t iterations( int argc, char **argv, const std::uint64_t def )
+{
+   if( argc > 1 )
+   {
+      return( std::strtoull( argv[ 1 ], nullptr, 10 ) );
+   }
+   return( def );
+}
+
+/**
+ * latency_row - sorts samples (ns) and prints median, p99 and
+ * p99.9 under name.
+ */
+inline void latency_row( const char *name, std::vector< std::uint64_t > &samples )
+{
+   if( samples.empty() )
+   {
+      return;
+   }
+   std::sort( samples.begin(), samples.end() );
+   auto at = [&]( const double p )
+   {
+      return( samples[ static_cast< std::size_t >( p * ( samples.size() - 1 ) ) ] );
+   };
+   std::printf( "%-24s %12llu %12llu %12llu\n",
+                name,
+                static_cast< unsigned long long >( at( 0.5 ) ),
+                static_cast< unsigned long long >( at( 0.99 ) ),
+                static_cast< unsigned long long >( at( 0.999 ) ) );
+}
+
+inline void latency_header( const char *title )
+{
+   std::printf( "%-24s %12s %12s %12s\n", title, "p50(ns)", "p99(ns)", "p99.9(ns)" );
+}
+
+/** throughput_row - items moved in elapsed ns **/
+inline void throughput_row( const char *name,
+                            const std::uint64_t items,
+                            const std::size_t item_bytes,
+                            const std::uint64_t elapsed )
+{
+   const auto secs( static_cast< double >( elapsed ) / 1e9 );
+   std::printf( "%-24s %14.0f %12.1f\n",
+                name,
+                items / secs,
+                ( items * item_bytes ) / secs / ( 1 << 20 ) );
+}
+
+inline void throughput_header( const char *title )
+{
+   std::printf( "%-24s %14s %12s\n", title, "items/s", "MiB/s" );
+}
+
+} /** end namespace bench **/
+
+#endif /* END _SHM_BENCH_HPP_ */
@@ -0,0 +1,166 @@
+/**
+ * broadcast_ring.cpp - producer throughput and push latency of
+ * shm::broadcast_ring as the number of reader processes grows, with
+ * backpressure (the producer waits for the slowest reader) and
+ * lapped (it never waits, slow readers lose items). Every process is
+ * pinned to its own core where there are enough of them. Lost is
+ * the share of items the readers missed, always 0 with backpressure.
+ * usage: broadcast_ring_bench [items] [max readers]
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include <shm>
+#include <shm_broadcast_ring.hpp>
+#include <shm_futex.hpp>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "bench.hpp"
+
+/** one cache line per message **/
+struct message
+{
+   std::uint64_t seq;
+   std::uint64_t pad[ 7 ];
+};
+
+using ring_t = shm::broadcast_ring< message >;
+
+static constexpr std::size_t   capacity    = 1 << 12;
+static constexpr std::uint64_t max_readers = 64;
+
+struct control
+{
+   alignas( SHM_CACHE_LINE_SIZE ) std::atomic< std::uint32_t > ready;
+   std::atomic< std::uint32_t > go;
+   std::atomic< std::uint32_t > stop;
+   alignas( SHM_CACHE_LINE_SIZE ) std::atomic< std::uint64_t > lost;
+};
+
+static void run( const std::vector< int > &cpus,
+                 const std::uint64_t count,
+                 const std::uint64_t readers,
+                 const ring_t::policy_t policy )
+{
+   shm_key_t key;
+   shm::gen_key( key, 42 );
+   const auto ring_bytes( ( ring_t::required_bytes( capacity, readers ) + SHM_CACHE_LINE_SIZE - 1 ) &
+                          ~std::size_t( SHM_CACHE_LINE_SIZE - 1 ) );
+   const auto nbytes( ring_bytes + sizeof( control ) );
+   void *mem( shm::init( key, nbytes, false, nullptr ) );
+   auto *ring( ring_t::create( mem, capacity, readers, policy ) );
+   auto *ctl( new ( reinterpret_cast< char* >( mem ) + ring_bytes ) control() );
+   ctl->ready = 0;
+   ctl->go    = 0;
+   ctl->stop  = 0;
+   ctl->lost  = 0;
+
+   for( std::uint64_t id( 0 ); id < readers; id++ )
+   {
+      if( fork() != 0 )
+      {
+         continue;
+      }
+      bench::pin( cpus[ ( id + 1 ) % cpus.size() ] );
+      const auto cursor( ring->subscribe() );
+      ctl->ready++;
+      message item;
+      item.seq = 0;
+      /** until the last item, or until the producer is done if it can be missed **/
+      while( item.seq + 1 < count && ctl->stop.load( std::memory_order_relaxed ) == 0 )
+      {
+         if( ring->try_pop( cursor, item ) == ring_t::status::empty )
+         {
+            shm::futex::relax();
+         }
+      }
+      ctl->lost.fetch_add( ring->lost( cursor ) );
+      ring->unsubscribe( cursor );
+      _exit( EXIT_SUCCESS );
+   }
+   bench::pin( cpus[ 0 ] );
+   bench::spin_until( [&](){ return( ctl->ready.load() == readers ); } );
+   std::vector< std::uint64_t > latency;
+   latency.reserve( count );
+   message item = {};
+   ctl->go = 1;
+   const auto start( bench::now() );
+   for( std::uint64_t i( 0 ); i < count; i++ )
+   {
+      item.seq = i;
+      const auto before( bench::now() );
+      ring->push( item );
+      latency.push_back( bench::now() - before );
+   }
+   const auto elapsed( bench::now() - start );
+   if( policy == ring_t::policy_t::lapped )
+   {
+      ctl->stop = 1;
+   }
+   for( std::uint64_t i( 0 ); i < readers; i++ )
+   {
+      int status( 0 );
+      wait( &status );
+   }
+   std::sort( latency.begin(), latency.end() );
+   auto at = [&]( const double p )
+   {
+      return( static_cast< unsigned long long >( latency[ static_cast< std::size_t >( p * ( latency.size() - 1 ) ) ] ) );
+   };
+   std::printf( "%-13s %8llu %14.0f %10llu %10llu %10llu %8.2f%%\n",
+                policy == ring_t::policy_t::lapped ? "lapped" : "backpressure",
+                static_cast< unsigned long long >( readers ),
+                count / ( static_cast< double >( elapsed ) / 1e9 ),
+                at( 0.5 ),
+                at( 0.99 ),
+                at( 0.999 ),
+                100.0 * ctl->lost.load() / ( static_cast< double >( count ) * readers ) );
+   shm::close( key, &mem, nbytes, false, true );
+}
+
+int
+main( int argc, char **argv )
+{
+   const auto count( bench::iterations( argc, argv, 1000000 ) );
+   const auto ncpus( static_cast< std::uint64_t >( sysconf( _SC_NPROCESSORS_ONLN ) ) );
+   const auto most( std::min< std::uint64_t >(
+      argc > 2 ? std::strtoull( argv[ 2 ], nullptr, 10 ) : std::max< std::uint64_t >( ncpus - 1, 1 ),
+      max_readers ) );
+   std::printf( "%llu items of %zuB, %llu cpus\n",
+                static_cast< unsigned long long >( count ),
+                sizeof( message ),
+                static_cast< unsigned long long >( ncpus ) );
+   std::printf( "%-13s %8s %14s %10s %10s %10s %9s\n",
+                "policy", "readers", "items/s", "p50(ns)", "p99(ns)", "p99.9(ns)", "lost" );
+   const auto cpus( bench::cpu_order( false ) );
+   for( const auto policy : { ring_t::policy_t::backpressure, ring_t::policy_t::lapped } )
+   {
+      for( std::uint64_t n( 1 ); n <= most; n *= 2 )
+      {
+         run( cpus, count, n, policy );
+      }
+   }
+   return( EXIT_SUCCESS );
+}
@@ -0,0 +1,177 @@
+/**
+ * concurrent_map.cpp - lookups per second of shm::concurrent_map as
+ * the number of reading processes grows, with one more process
+ * updating random keys the whole time. Readers look up random keys
+ * that are all in the map, on base pages and on 2MB huge pages (which
+ * fall back to transparent huge pages without a hugetlbfs mount, the
+ * page column says which one the segment asked for). Every process is
+ * pinned to its own core where there are enough of them.
+ * usage: concurrent_map_bench [lookups per reader] [max readers] [entries]
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include <shm>
+#include <shm_concurrent_map.hpp>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "bench.hpp"
+
+using map_t = shm::concurrent_map< std::uint64_t, std::uint64_t >;
+
+static constexpr std::uint64_t max_readers = 64;
+
+struct control
+{
+   alignas( SHM_CACHE_LINE_SIZE ) std::atomic< std::uint32_t > ready;
+   std::atomic< std::uint32_t > go;
+   std::atomic< std::uint32_t > stop;
+   alignas( SHM_CACHE_LINE_SIZE ) std::atomic< std::uint64_t > hits;
+   std::atomic< std::uint64_t > updates;
+};
+
+/** key - spreads 0..entries-1 over the key space **/
+static std::uint64_t key_of( const std::uint64_t i )
+{
+   return( i * 0x9e3779b97f4a7c15ULL + 1 );
+}
+
+static std::uint64_t next( std::uint64_t &state )
+{
+   state ^= state << 13;
+   state ^= state >> 7;
+   state ^= state << 17;
+   return( state );
+}
+
+static void run( const std::vector< int > &cpus,
+                 const std::uint64_t count,
+                 const std::uint64_t readers,
+                 const std::uint64_t entries,
+                 const shm::page_t   page )
+{
+   shm_key_t key;
+   shm::gen_key( key, 45 );
+   const auto map_bytes( ( map_t::required_bytes( entries + entries / 4 ) + SHM_CACHE_LINE_SIZE - 1 ) &
+                         ~std::size_t( SHM_CACHE_LINE_SIZE - 1 ) );
+   const auto nbytes( map_bytes + sizeof( control ) );
+   void *mem( shm::init( key, nbytes, false, nullptr, page ) );
+   if( mem == nullptr )
+   {
+      std::printf( "no segment of %zuB\n", nbytes );
+      return;
+   }
+   auto *map( map_t::create( mem, entries + entries / 4 ) );
+   auto *ctl( new ( reinterpret_cast< char* >( mem ) + map_bytes ) control() );
+   ctl->ready   = 0;
+   ctl->go      = 0;
+   ctl->stop    = 0;
+   ctl->hits    = 0;
+   ctl->updates = 0;
+   for( std::uint64_t i( 0 ); i < entries; i++ )
+   {
+      map->insert( key_of( i ), i );
+   }
+
+   /** the updater, then the readers **/
+   for( std::uint64_t id( 0 ); id <= readers; id++ )
+   {
+      if( fork() != 0 )
+      {
+         continue;
+      }
+      bench::pin( cpus[ id % cpus.size() ] );
+      std::uint64_t state( 0x2545f4914f6cdd1dULL * ( id + 1 ) );
+      ctl->ready++;
+      bench::spin_until( [&](){ return( ctl->go.load() != 0 ); } );
+      if( id == 0 )
+      {
+         std::uint64_t updates( 0 );
+         while( ctl->stop.load( std::memory_order_relaxed ) == 0 )
+         {
+            const auto i( next( state ) % entries );
+            map->insert_or_assign( key_of( i ), i + updates );
+            updates++;
+         }
+         ctl->updates += updates;
+         _exit( EXIT_SUCCESS );
+      }
+      std::uint64_t hits( 0 );
+      for( std::uint64_t i( 0 ); i < count; i++ )
+      {
+         std::uint64_t value;
+         hits += map->find( key_of( next( state ) % entries ), value ) ? 1 : 0;
+      }
+      ctl->hits += hits;
+      _exit( EXIT_SUCCESS );
+   }
+   bench::spin_until( [&](){ return( ctl->ready.load() == readers + 1 ); } );
+   const auto start( bench::now() );
+   ctl->go = 1;
+   for( std::uint64_t i( 0 ); i < readers; i++ )
+   {
+      int status( 0 );
+      wait( &status );
+   }
+   const auto elapsed( bench::now() - start );
+   ctl->stop = 1;
+   int status( 0 );
+   wait( &status );
+   const auto secs( static_cast< double >( elapsed ) / 1e9 );
+   std::printf( "%-8s %8llu %16.0f %16.0f %12.0f %8.2f%%\n",
+                page == shm::page_t::normal ? "4K" : "2M",
+                static_cast< unsigned long long >( readers ),
+                count * readers / secs,
+                count / secs,
+                ctl->updates.load() / secs,
+                100.0 * ctl->hits.load() / ( static_cast< double >( count ) * readers ) );
+   shm::close( key, &mem, nbytes, false, true );
+}
+
+int
+main( int argc, char **argv )
+{
+   const auto count( bench::iterations( argc, argv, 10000000 ) );
+   const auto ncpus( static_cast< std::uint64_t >( sysconf( _SC_NPROCESSORS_ONLN ) ) );
+   const auto most( std::min< std::uint64_t >(
+      argc > 2 ? std::strtoull( argv[ 2 ], nullptr, 10 ) : std::max< std::uint64_t >( ncpus - 1, 1 ),
+      max_readers ) );
+   const auto entries( argc > 3 ? std::strtoull( argv[ 3 ], nullptr, 10 ) : std::uint64_t( 1 ) << 20 );
+   std::printf( "%llu lookups per reader, %llu entries, %llu cpus\n",
+                static_cast< unsigned long long >( count ),
+                static_cast< unsigned long long >( entries ),
+                static_cast< unsigned long long >( ncpus ) );
+   std::printf( "%-8s %8s %16s %16s %12s %9s\n",
+                "page", "readers", "lookups/s", "per reader/s", "updates/s", "hits" );
+   const auto cpus( bench::cpu_order( false ) );
+   for( const auto page : { shm::page_t::normal, shm::page_t::huge_2MB } )
+   {
+      for( std::uint64_t n( 1 ); n <= most; n *= 2 )
+      {
+         run( cpus, count, n, entries, page );
+      }
+   }
+   return( EXIT_SUCCESS );
+}
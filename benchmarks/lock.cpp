@@ -0,0 +1,242 @@
+/**
+ * lock.cpp - acquisitions per second of the process-shared locks in
+ * shm_lock.hpp against pthread_mutex with PTHREAD_PROCESS_SHARED
+ * (plain and robust), as the number of processes taking the lock
+ * grows. Every process takes the lock, bumps a shared counter and
+ * lets go, in a loop. For the shm locks contended is the share of
+ * acquisitions that had to wait and p99 is the upper edge of the
+ * wait histogram bucket holding the 99th percentile wait, both read
+ * from lock_stats. rwlock-r is the rwlock with every process
+ * reading.
+ * usage: lock_bench [acquisitions per process] [max processes]
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include <pthread.h>
+#include <shm>
+#include <shm_lock.hpp>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "bench.hpp"
+
+static constexpr std::uint64_t max_processes = 64;
+
+enum class kind
+{
+   pthread,
+   pthread_robust,
+   robust_mutex,
+   ticket_lock,
+   rwlock_write,
+   rwlock_read
+};
+
+static const char *names[] = { "pthread", "pthread-rob", "robust_mutex", "ticket_lock", "rwlock-w", "rwlock-r" };
+
+struct shared
+{
+   alignas( SHM_CACHE_LINE_SIZE ) pthread_mutex_t pmutex;
+   shm::robust_mutex             mutex;
+   shm::ticket_lock              ticket;
+   shm::rwlock                   rw;
+   alignas( SHM_CACHE_LINE_SIZE ) std::uint64_t counter;
+   alignas( SHM_CACHE_LINE_SIZE ) std::atomic< std::uint32_t > ready;
+   std::atomic< std::uint32_t > go;
+};
+
+static void critical( shared *s, const kind k )
+{
+   switch( k )
+   {
+      case( kind::pthread ):
+      case( kind::pthread_robust ):
+      {
+         pthread_mutex_lock( &s->pmutex );
+         s->counter++;
+         pthread_mutex_unlock( &s->pmutex );
+      }
+      break;
+      case( kind::robust_mutex ):
+      {
+         s->mutex.lock();
+         s->counter++;
+         s->mutex.unlock();
+      }
+      break;
+      case( kind::ticket_lock ):
+      {
+         s->ticket.lock();
+         s->counter++;
+         s->ticket.unlock();
+      }
+      break;
+      case( kind::rwlock_write ):
+      {
+         s->rw.write_lock();
+         s->counter++;
+         s->rw.write_unlock();
+      }
+      break;
+      case( kind::rwlock_read ):
+      {
+         s->rw.read_lock();
+         const volatile std::uint64_t seen( s->counter );
+         (void) seen;
+         s->rw.read_unlock();
+      }
+      break;
+   }
+}
+
+static const shm::lock_stats* stats_of( shared *s, const kind k )
+{
+   switch( k )
+   {
+      case( kind::robust_mutex ):
+         return( &s->mutex.stats() );
+      case( kind::ticket_lock ):
+         return( &s->ticket.stats() );
+      case( kind::rwlock_write ):
+         return( &s->rw.write_stats() );
+      case( kind::rwlock_read ):
+         return( &s->rw.read_stats() );
+      default:
+         return( nullptr );
+   }
+}
+
+/** p99 - upper edge of the histogram bucket holding the 99th percentile **/
+static unsigned long long p99( const shm::lock_stats &stats )
+{
+   const auto target( stats.contended() - stats.contended() / 100 );
+   std::uint64_t seen( 0 );
+   for( std::size_t i( 0 ); i < shm::lock_stats::buckets; i++ )
+   {
+      seen += stats.waits( i );
+      if( seen >= target && seen > 0 )
+      {
+         return( 1ULL << ( i + 1 ) );
+      }
+   }
+   return( 0 );
+}
+
+static void run( const std::vector< int > &cpus,
+                 const std::uint64_t count,
+                 const std::uint64_t processes,
+                 const kind k )
+{
+   shm_key_t key;
+   shm::gen_key( key, 44 );
+   void *mem( shm::init( key, sizeof( shared ), false, nullptr ) );
+   auto *s( new ( mem ) shared() );
+   pthread_mutexattr_t attr;
+   pthread_mutexattr_init( &attr );
+   pthread_mutexattr_setpshared( &attr, PTHREAD_PROCESS_SHARED );
+   if( k == kind::pthread_robust )
+   {
+      pthread_mutexattr_setrobust( &attr, PTHREAD_MUTEX_ROBUST );
+   }
+   pthread_mutex_init( &s->pmutex, &attr );
+   pthread_mutexattr_destroy( &attr );
+   s->counter = 0;
+   s->ready   = 0;
+   s->go      = 0;
+
+   for( std::uint64_t id( 0 ); id < processes; id++ )
+   {
+      if( fork() != 0 )
+      {
+         continue;
+      }
+      bench::pin( cpus[ id % cpus.size() ] );
+      s->ready++;
+      bench::spin_until( [&](){ return( s->go.load() != 0 ); } );
+      for( std::uint64_t i( 0 ); i < count; i++ )
+      {
+         critical( s, k );
+      }
+      _exit( EXIT_SUCCESS );
+   }
+   bench::spin_until( [&](){ return( s->ready.load() == processes ); } );
+   const auto start( bench::now() );
+   s->go = 1;
+   for( std::uint64_t i( 0 ); i < processes; i++ )
+   {
+      int status( 0 );
+      wait( &status );
+   }
+   const auto elapsed( bench::now() - start );
+   const auto *stats( stats_of( s, k ) );
+   if( stats != nullptr )
+   {
+      std::printf( "%-13s %10llu %14.0f %10.2f%% %12llu\n",
+                   names[ static_cast< int >( k ) ],
+                   static_cast< unsigned long long >( processes ),
+                   count * processes / ( static_cast< double >( elapsed ) / 1e9 ),
+                   100.0 * stats->contended() / static_cast< double >( stats->acquired() ),
+                   p99( *stats ) );
+   }
+   else
+   {
+      std::printf( "%-13s %10llu %14.0f %11s %12s\n",
+                   names[ static_cast< int >( k ) ],
+                   static_cast< unsigned long long >( processes ),
+                   count * processes / ( static_cast< double >( elapsed ) / 1e9 ),
+                   "-",
+                   "-" );
+   }
+   pthread_mutex_destroy( &s->pmutex );
+   shm::close( key, &mem, sizeof( shared ), false, true );
+}
+
+int
+main( int argc, char **argv )
+{
+   const auto count( bench::iterations( argc, argv, 1000000 ) );
+   const auto ncpus( static_cast< std::uint64_t >( sysconf( _SC_NPROCESSORS_ONLN ) ) );
+   const auto most( std::min< std::uint64_t >(
+      argc > 2 ? std::strtoull( argv[ 2 ], nullptr, 10 ) : ncpus,
+      max_processes ) );
+   std::printf( "%llu acquisitions per process, %llu cpus\n",
+                static_cast< unsigned long long >( count ),
+                static_cast< unsigned long long >( ncpus ) );
+   std::printf( "%-13s %10s %14s %11s %12s\n", "lock", "processes", "acquires/s", "contended", "p99wait(ns)" );
+   const auto cpus( bench::cpu_order( false ) );
+   for( const auto k : { kind::pthread,
+                         kind::pthread_robust,
+                         kind::robust_mutex,
+                         kind::ticket_lock,
+                         kind::rwlock_write,
+                         kind::rwlock_read } )
+   {
+      for( std::uint64_t n( 1 ); n <= most; n *= 2 )
+      {
+         run( cpus, count, n, k );
+      }
+   }
+   return( EXIT_SUCCESS );
+}
@@ -0,0 +1,152 @@
+/**
+ * mpmc_queue.cpp - throughput of shm::mpmc_queue as the number of
+ * producer and consumer processes grows, each process pinned to its
+ * own core, either packed onto as few NUMA nodes as possible
+ * (compact) or spread round robin across nodes (spread).
+ * usage: mpmc_queue_bench [items] [max processes per side]
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include <shm>
+#include <shm_mpmc_queue.hpp>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "bench.hpp"
+
+using item_t  = std::uint64_t;
+using queue_t = shm::mpmc_queue< item_t >;
+
+static constexpr std::size_t capacity = 1 << 12;
+
+struct alignas( SHM_CACHE_LINE_SIZE ) control
+{
+   std::atomic< std::uint32_t > ready;
+   std::atomic< std::uint32_t > go;
+   alignas( SHM_CACHE_LINE_SIZE ) std::atomic< std::uint64_t > popped;
+};
+
+static std::uint64_t run( const std::vector< int > &cpus,
+                          const std::uint64_t count,
+                          const std::uint64_t producers,
+                          const std::uint64_t consumers )
+{
+   shm_key_t key;
+   shm::gen_key( key, 42 );
+   const auto queue_bytes( ( queue_t::required_bytes( capacity ) + SHM_CACHE_LINE_SIZE - 1 ) &
+                           ~std::size_t( SHM_CACHE_LINE_SIZE - 1 ) );
+   const auto nbytes( queue_bytes + sizeof( control ) );
+   void *mem( shm::init( key, nbytes, false, nullptr ) );
+   auto *q( queue_t::create( mem, capacity ) );
+   auto *ctl( new ( reinterpret_cast< char* >( mem ) + queue_bytes ) control() );
+   ctl->ready = 0;
+   ctl->go    = 0;
+   ctl->popped = 0;
+
+   const auto procs( producers + consumers );
+   for( std::uint64_t id( 0 ); id < procs; id++ )
+   {
+      if( fork() != 0 )
+      {
+         continue;
+      }
+      bench::pin( cpus[ id % cpus.size() ] );
+      ctl->ready++;
+      bench::spin_until( [&](){ return( ctl->go.load() != 0 ); } );
+      if( id < producers )
+      {
+         const auto share( count / producers + ( id == 0 ? count % producers : 0 ) );
+         for( std::uint64_t i( 0 ); i < share; i++ )
+         {
+            q->push( i );
+         }
+      }
+      else
+      {
+         item_t item;
+         while( ctl->popped.load( std::memory_order_relaxed ) < count )
+         {
+            if( q->try_pop( item ) )
+            {
+               ctl->popped.fetch_add( 1, std::memory_order_relaxed );
+            }
+         }
+      }
+      _exit( EXIT_SUCCESS );
+   }
+   bench::spin_until( [&](){ return( ctl->ready.load() == procs ); } );
+   const auto start( bench::now() );
+   ctl->go = 1;
+   for( std::uint64_t i( 0 ); i < procs; i++ )
+   {
+      int status( 0 );
+      wait( &status );
+   }
+   const auto elapsed( bench::now() - start );
+   shm::close( key, &mem, nbytes, false, true );
+   return( elapsed );
+}
+
+int
+main( int argc, char **argv )
+{
+   const auto count( bench::iterations( argc, argv, 4000000 ) );
+   const auto ncpus( static_cast< std::uint64_t >( sysconf( _SC_NPROCESSORS_ONLN ) ) );
+   const auto max_side( argc > 2 ? std::strtoull( argv[ 2 ], nullptr, 10 ) :
+                                   std::max< std::uint64_t >( ncpus / 2, 1 ) );
+   std::printf( "%llu items, %llu cpus, %d NUMA node(s)\n",
+                static_cast< unsigned long long >( count ),
+                static_cast< unsigned long long >( ncpus ),
+                bench::numa_nodes() );
+   std::printf( "%-10s %10s %10s %14s\n", "placement", "producers", "consumers", "items/s" );
+   for( const bool spread : { false, true } )
+   {
+      if( spread && bench::numa_nodes() == 1 )
+      {
+         break;
+      }
+      const auto cpus( bench::cpu_order( spread ) );
+      /** balanced, fan in and fan out **/
+      std::vector< std::pair< std::uint64_t, std::uint64_t > > shapes;
+      for( std::uint64_t n( 1 ); n <= max_side; n *= 2 )
+      {
+         shapes.emplace_back( n, n );
+         if( n > 1 )
+         {
+            shapes.emplace_back( n, 1 );
+            shapes.emplace_back( 1, n );
+         }
+      }
+      for( const auto &shape : shapes )
+      {
+         const auto elapsed( run( cpus, count, shape.first, shape.second ) );
+         std::printf( "%-10s %10llu %10llu %14.0f\n",
+                      spread ? "spread" : "compact",
+                      static_cast< unsigned long long >( shape.first ),
+                      static_cast< unsigned long long >( shape.second ),
+                      count / ( static_cast< double >( elapsed ) / 1e9 ) );
+      }
+   }
+   return( EXIT_SUCCESS );
+}
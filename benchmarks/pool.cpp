@@ -0,0 +1,154 @@
+/**
+ * pool.cpp - allocation throughput of shm::pool as the number of
+ * processes allocating and freeing from one pool grows, straight on
+ * the shared free list and through a per-process pool::cache, with
+ * packed and cache line slots. Each process holds a handful of slots
+ * at a time and writes to each one, allocs/s is the sum over all of
+ * them, one alloc and one free per count.
+ * usage: pool_bench [allocations per process] [max processes]
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include <shm>
+#include <shm_pool.hpp>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "bench.hpp"
+
+/** a small record, e.g., an order **/
+struct record
+{
+   std::uint64_t id;
+   std::uint64_t price;
+   std::uint32_t quantity;
+   std::uint32_t side;
+};
+
+using pool_t = shm::pool< record >;
+
+static constexpr std::size_t   slots         = 1 << 16;
+static constexpr std::uint64_t held          = 8;
+static constexpr std::uint64_t max_processes = 64;
+
+struct control
+{
+   alignas( SHM_CACHE_LINE_SIZE ) std::atomic< std::uint32_t > ready;
+   std::atomic< std::uint32_t > go;
+};
+
+static void run( const std::vector< int > &cpus,
+                 const std::uint64_t count,
+                 const std::uint64_t processes,
+                 const bool cached,
+                 const pool_t::align_t align )
+{
+   shm_key_t key;
+   shm::gen_key( key, 43 );
+   const auto pool_bytes( ( pool_t::required_bytes( slots, align ) + SHM_CACHE_LINE_SIZE - 1 ) &
+                          ~std::size_t( SHM_CACHE_LINE_SIZE - 1 ) );
+   const auto nbytes( pool_bytes + sizeof( control ) );
+   void *mem( shm::init( key, nbytes, false, nullptr ) );
+   auto *p( pool_t::create( mem, slots, align ) );
+   auto *ctl( new ( reinterpret_cast< char* >( mem ) + pool_bytes ) control() );
+   ctl->ready = 0;
+   ctl->go    = 0;
+
+   for( std::uint64_t id( 0 ); id < processes; id++ )
+   {
+      if( fork() != 0 )
+      {
+         continue;
+      }
+      bench::pin( cpus[ id % cpus.size() ] );
+      pool_t::cache c( p );
+      record *live[ held ];
+      ctl->ready++;
+      bench::spin_until( [&](){ return( ctl->go.load() != 0 ); } );
+      for( std::uint64_t i( 0 ); i < count; i += held )
+      {
+         for( std::uint64_t h( 0 ); h < held; h++ )
+         {
+            live[ h ] = cached ? c.allocate() : p->allocate();
+            live[ h ]->id = i + h;
+         }
+         for( std::uint64_t h( 0 ); h < held; h++ )
+         {
+            if( cached )
+            {
+               c.deallocate( live[ h ] );
+            }
+            else
+            {
+               p->deallocate( live[ h ] );
+            }
+         }
+      }
+      c.flush();
+      _exit( EXIT_SUCCESS );
+   }
+   bench::spin_until( [&](){ return( ctl->ready.load() == processes ); } );
+   const auto start( bench::now() );
+   ctl->go = 1;
+   for( std::uint64_t i( 0 ); i < processes; i++ )
+   {
+      int status( 0 );
+      wait( &status );
+   }
+   const auto elapsed( bench::now() - start );
+   std::printf( "%-8s %-10s %10llu %14.0f\n",
+                cached ? "cache" : "shared",
+                align == pool_t::align_t::cache_line ? "cache_line" : "natural",
+                static_cast< unsigned long long >( processes ),
+                count * processes / ( static_cast< double >( elapsed ) / 1e9 ) );
+   shm::close( key, &mem, nbytes, false, true );
+}
+
+int
+main( int argc, char **argv )
+{
+   const auto count( bench::iterations( argc, argv, 10000000 ) );
+   const auto ncpus( static_cast< std::uint64_t >( sysconf( _SC_NPROCESSORS_ONLN ) ) );
+   const auto most( std::min< std::uint64_t >(
+      argc > 2 ? std::strtoull( argv[ 2 ], nullptr, 10 ) : ncpus,
+      max_processes ) );
+   std::printf( "%llu allocations per process of %zuB, %llu cpus\n",
+                static_cast< unsigned long long >( count ),
+                sizeof( record ),
+                static_cast< unsigned long long >( ncpus ) );
+   std::printf( "%-8s %-10s %10s %14s\n", "path", "slots", "processes", "allocs/s" );
+   const auto cpus( bench::cpu_order( false ) );
+   for( const auto cached : { false, true } )
+   {
+      for( const auto align : { pool_t::align_t::natural, pool_t::align_t::cache_line } )
+      {
+         for( std::uint64_t n( 1 ); n <= most; n *= 2 )
+         {
+            run( cpus, count, n, cached, align );
+         }
+      }
+   }
+   return( EXIT_SUCCESS );
+}
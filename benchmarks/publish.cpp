@@ -0,0 +1,179 @@
+/**
+ * publish.cpp - reader throughput of the latest value primitives,
+ * shm::seqlock with a small record and shm::triple_buffer with a
+ * large frame, as the number of reader processes grows. One writer
+ * process publishes back to back, every reader copies out the
+ * newest value as fast as it can. Reads/s counts whole copies
+ * across all readers, retry is the share of attempts that came back
+ * torn and had to be repeated.
+ * usage: publish_bench [milliseconds per row] [max readers]
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include <shm>
+#include <shm_seqlock.hpp>
+#include <shm_triple_buffer.hpp>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "bench.hpp"
+
+/** a quote sized record **/
+struct record
+{
+   std::uint64_t words[ 6 ];
+};
+
+/** a frame sized record, 64KiB **/
+struct frame
+{
+   std::uint64_t words[ 8192 ];
+};
+
+static constexpr std::uint64_t max_readers = 64;
+
+struct alignas( SHM_CACHE_LINE_SIZE ) counts
+{
+   std::atomic< std::uint64_t > reads;
+   std::atomic< std::uint64_t > retries;
+};
+
+struct control
+{
+   alignas( SHM_CACHE_LINE_SIZE ) std::atomic< std::uint32_t > ready;
+   std::atomic< std::uint32_t > go;
+   std::atomic< std::uint32_t > stop;
+   counts                       reader[ max_readers ];
+};
+
+template < class Latest, class T >
+static void run( const char *name,
+                 const std::vector< int > &cpus,
+                 const std::uint64_t millis,
+                 const std::uint64_t readers )
+{
+   shm_key_t key;
+   shm::gen_key( key, 42 );
+   const auto latest_bytes( ( Latest::required_bytes() + SHM_CACHE_LINE_SIZE - 1 ) &
+                            ~std::size_t( SHM_CACHE_LINE_SIZE - 1 ) );
+   const auto nbytes( latest_bytes + sizeof( control ) );
+   void *mem( shm::init( key, nbytes, false, nullptr ) );
+   auto *latest( Latest::create( mem ) );
+   auto *ctl( new ( reinterpret_cast< char* >( mem ) + latest_bytes ) control() );
+   ctl->ready = 0;
+   ctl->go    = 0;
+   ctl->stop  = 0;
+   for( auto &one : ctl->reader )
+   {
+      one.reads   = 0;
+      one.retries = 0;
+   }
+
+   for( std::uint64_t id( 0 ); id < readers; id++ )
+   {
+      if( fork() != 0 )
+      {
+         continue;
+      }
+      bench::pin( cpus[ ( id + 1 ) % cpus.size() ] );
+      T *item( new T() );
+      std::uint64_t reads( 0 ), retries( 0 ), version( 0 );
+      ctl->ready++;
+      bench::spin_until( [&](){ return( ctl->go.load() != 0 ); } );
+      while( ctl->stop.load( std::memory_order_relaxed ) == 0 )
+      {
+         if( latest->try_read( *item, version ) )
+         {
+            reads++;
+         }
+         else
+         {
+            retries++;
+         }
+      }
+      ctl->reader[ id ].reads   = reads;
+      ctl->reader[ id ].retries = retries;
+      _exit( EXIT_SUCCESS );
+   }
+   bench::pin( cpus[ 0 ] );
+   T *item( new T() );
+   bench::spin_until( [&](){ return( ctl->ready.load() == readers ); } );
+   const auto start( bench::now() );
+   const auto end( start + millis * 1000000 );
+   ctl->go = 1;
+   std::uint64_t published( 0 );
+   while( bench::now() < end )
+   {
+      for( int i( 0 ); i < 64; i++ )
+      {
+         item->words[ 0 ] = ++published;
+         latest->publish( *item );
+      }
+   }
+   ctl->stop = 1;
+   for( std::uint64_t i( 0 ); i < readers; i++ )
+   {
+      int status( 0 );
+      wait( &status );
+   }
+   const auto secs( static_cast< double >( bench::now() - start ) / 1e9 );
+   std::uint64_t reads( 0 ), retries( 0 );
+   for( std::uint64_t id( 0 ); id < readers; id++ )
+   {
+      reads   += ctl->reader[ id ].reads;
+      retries += ctl->reader[ id ].retries;
+   }
+   std::printf( "%-16s %8llu %14.0f %14.0f %9.2f%%\n",
+                name,
+                static_cast< unsigned long long >( readers ),
+                published / secs,
+                reads / secs,
+                reads + retries == 0 ? 0.0 : 100.0 * retries / ( reads + retries ) );
+   delete( item );
+   shm::close( key, &mem, nbytes, false, true );
+}
+
+int
+main( int argc, char **argv )
+{
+   const auto millis( bench::iterations( argc, argv, 500 ) );
+   const auto ncpus( static_cast< std::uint64_t >( sysconf( _SC_NPROCESSORS_ONLN ) ) );
+   const auto most( std::min< std::uint64_t >(
+      argc > 2 ? std::strtoull( argv[ 2 ], nullptr, 10 ) : std::max< std::uint64_t >( ncpus - 1, 1 ),
+      max_readers ) );
+   std::printf( "%llu ms per row, %llu cpus\n",
+                static_cast< unsigned long long >( millis ),
+                static_cast< unsigned long long >( ncpus ) );
+   std::printf( "%-16s %8s %14s %14s %10s\n", "primitive", "readers", "publishes/s", "reads/s", "retry" );
+   const auto cpus( bench::cpu_order( false ) );
+   for( std::uint64_t n( 1 ); n <= most; n *= 2 )
+   {
+      run< shm::seqlock< record >, record >( "seqlock 48B", cpus, millis, n );
+   }
+   for( std::uint64_t n( 1 ); n <= most; n *= 2 )
+   {
+      run< shm::triple_buffer< frame >, frame >( "triple 64KiB", cpus, millis, n );
+   }
+   return( EXIT_SUCCESS );
+}
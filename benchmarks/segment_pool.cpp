@@ -0,0 +1,103 @@
+/**
+ * segment_pool.cpp - latency of getting a ready to use segment,
+ * made on the spot (gen_key + create with populate_write) versus
+ * taken from a shm::segment_pool whose background thread made it
+ * ahead of time, and of handing it back (close + unlink versus
+ * release to the pool). Rounds are paced so the pool keeps up,
+ * the hit rate is printed with the pool rows.
+ * usage: segment_pool_bench [rounds per row]
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <shm>
+#include <shm_segment.hpp>
+#include <shm_segment_pool.hpp>
+
+#include "bench.hpp"
+
+static void direct( const std::size_t nbytes, const std::uint64_t rounds )
+{
+   std::vector< std::uint64_t > get, put;
+   for( std::uint64_t i( 0 ); i < rounds; i++ )
+   {
+      auto start( bench::now() );
+      shm_key_t key;
+      shm::gen_key( key, 42 );
+      auto seg( shm::segment::create( key,
+                                      nbytes,
+                                      shm::page_t::normal,
+                                      shm::numa_policy(),
+                                      shm::populate_t::populate_write ) );
+      get.push_back( bench::now() - start );
+      start = bench::now();
+      seg.close( shm::release_t::none, true );
+      put.push_back( bench::now() - start );
+   }
+   const auto label( std::to_string( nbytes >> 10 ) + "KiB" );
+   bench::latency_row( ( "create " + label ).c_str(), get );
+   bench::latency_row( ( "close " + label ).c_str(), put );
+}
+
+static void pooled( const std::size_t nbytes, const std::uint64_t rounds )
+{
+   shm::segment_pool pool( { { nbytes, 16 } } );
+   pool.wait_ready();
+   std::vector< std::uint64_t > get, put;
+   for( std::uint64_t i( 0 ); i < rounds; i++ )
+   {
+      auto start( bench::now() );
+      auto seg( pool.acquire( nbytes ) );
+      get.push_back( bench::now() - start );
+      start = bench::now();
+      pool.release( std::move( seg ) );
+      put.push_back( bench::now() - start );
+      /** a request's worth of work, the pool refills meanwhile **/
+      if( ( i & 0x7 ) == 0x7 )
+      {
+         pool.wait_ready();
+      }
+   }
+   const auto label( std::to_string( nbytes >> 10 ) + "KiB" );
+   bench::latency_row( ( "acquire " + label ).c_str(), get );
+   bench::latency_row( ( "release " + label ).c_str(), put );
+   std::printf( "%-24s %11.1f%%\n", "hit rate", pool.get_stats().hit_rate() * 100.0 );
+}
+
+int
+main( int argc, char **argv )
+{
+   const auto rounds( bench::iterations( argc, argv, 400 ) );
+   bench::latency_header( "segment on demand" );
+   for( const std::size_t nbytes : { std::size_t( 1 ) << 16, std::size_t( 1 ) << 20 } )
+   {
+      direct( nbytes, rounds );
+   }
+   bench::latency_header( "segment pool" );
+   for( const std::size_t nbytes : { std::size_t( 1 ) << 16, std::size_t( 1 ) << 20 } )
+   {
+      pooled( nbytes, rounds );
+   }
+   return( EXIT_SUCCESS );
+}
@@ -0,0 +1,280 @@
+/**
+ * spsc_ring.cpp - throughput and round trip latency of
+ * shm::spsc_ring between two processes, compared against a
+ * pipe and a unix domain socket pair on the same machine.
+ * usage: spsc_ring_bench [items]
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include <shm>
+#include <shm_spsc_ring.hpp>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#include "bench.hpp"
+
+using item_t = std::uint64_t;
+using ring_t = shm::spsc_ring< item_t >;
+
+static constexpr std::size_t capacity   = 1 << 14;
+static constexpr std::size_t batch      = 64;
+
+/** segment holding a ring, owned by the parent **/
+struct ring_segment
+{
+   ring_segment() : nbytes( ring_t::required_bytes( capacity ) )
+   {
+      shm::gen_key( key, 42 );
+      mem  = shm::init( key, nbytes, false, nullptr );
+      ring = ring_t::create( mem, capacity );
+   }
+
+   ~ring_segment()
+   {
+      shm::close( key, &mem, nbytes, false, true );
+   }
+
+   shm_key_t   key;
+   std::size_t nbytes;
+   void        *mem    = nullptr;
+   ring_t      *ring   = nullptr;
+};
+
+static void wait_child( const pid_t child )
+{
+   int status( 0 );
+   waitpid( child, &status, 0 );
+   if( ! WIFEXITED( status ) || WEXITSTATUS( status ) != EXIT_SUCCESS )
+   {
+      std::fprintf( stderr, "benchmark child failed\n" );
+      exit( EXIT_FAILURE );
+   }
+}
+
+/** read_full/write_full - move exactly n bytes over a stream fd **/
+static void read_full( const int fd, void *buffer, const std::size_t n )
+{
+   auto *out( reinterpret_cast< char* >( buffer ) );
+   std::size_t done( 0 );
+   while( done < n )
+   {
+      const auto ret( read( fd, out + done, n - done ) );
+      if( ret <= 0 )
+      {
+         std::perror( "read" );
+         _exit( EXIT_FAILURE );
+      }
+      done += ret;
+   }
+}
+
+static void write_full( const int fd, const void *buffer, const std::size_t n )
+{
+   const auto *in( reinterpret_cast< const char* >( buffer ) );
+   std::size_t done( 0 );
+   while( done < n )
+   {
+      const auto ret( write( fd, in + done, n - done ) );
+      if( ret <= 0 )
+      {
+         std::perror( "write" );
+         _exit( EXIT_FAILURE );
+      }
+      done += ret;
+   }
+}
+
+static std::uint64_t ring_throughput( const std::uint64_t count )
+{
+   ring_segment seg;
+   const auto child( fork() );
+   if( child == 0 )
+   {
+      bench::pin( 1 );
+      item_t buffer[ batch ];
+      std::uint64_t received( 0 );
+      while( received < count )
+      {
+         const auto n( seg.ring->pop( buffer, batch ) );
+         if( n == 0 )
+         {
+            std::this_thread::yield();
+         }
+         received += n;
+      }
+      _exit( EXIT_SUCCESS );
+   }
+   bench::pin( 0 );
+   item_t buffer[ batch ];
+   const auto start( bench::now() );
+   std::uint64_t sent( 0 );
+   while( sent < count )
+   {
+      for( std::size_t i( 0 ); i < batch; i++ )
+      {
+         buffer[ i ] = sent + i;
+      }
+      const auto n( seg.ring->push( buffer, std::min< std::uint64_t >( batch, count - sent ) ) );
+      if( n == 0 )
+      {
+         std::this_thread::yield();
+      }
+      sent += n;
+   }
+   wait_child( child );
+   return( bench::now() - start );
+}
+
+/** fds[ 0 ] is read by the child, fds[ 1 ] written by the parent **/
+static std::uint64_t fd_throughput( const int fds[ 2 ], const std::uint64_t count )
+{
+   const auto child( fork() );
+   if( child == 0 )
+   {
+      bench::pin( 1 );
+      item_t buffer[ batch ];
+      std::uint64_t received( 0 );
+      while( received < count )
+      {
+         const auto n( std::min< std::uint64_t >( batch, count - received ) );
+         read_full( fds[ 0 ], buffer, n * sizeof( item_t ) );
+         received += n;
+      }
+      _exit( EXIT_SUCCESS );
+   }
+   bench::pin( 0 );
+   item_t buffer[ batch ];
+   const auto start( bench::now() );
+   std::uint64_t sent( 0 );
+   while( sent < count )
+   {
+      const auto n( std::min< std::uint64_t >( batch, count - sent ) );
+      for( std::size_t i( 0 ); i < n; i++ )
+      {
+         buffer[ i ] = sent + i;
+      }
+      write_full( fds[ 1 ], buffer, n * sizeof( item_t ) );
+      sent += n;
+   }
+   wait_child( child );
+   return( bench::now() - start );
+}
+
+static std::vector< std::uint64_t > ring_latency( const std::uint64_t rounds )
+{
+   ring_segment ping, pong;
+   const auto child( fork() );
+   if( child == 0 )
+   {
+      bench::pin( 1 );
+      item_t item;
+      for( std::uint64_t i( 0 ); i < rounds; i++ )
+      {
+         bench::spin_until( [&](){ return( ping.ring->pop( item ) ); } );
+         bench::spin_until( [&](){ return( pong.ring->push( item ) ); } );
+      }
+      _exit( EXIT_SUCCESS );
+   }
+   bench::pin( 0 );
+   std::vector< std::uint64_t > samples( rounds );
+   item_t item( 0 );
+   for( std::uint64_t i( 0 ); i < rounds; i++ )
+   {
+      const auto start( bench::now() );
+      bench::spin_until( [&](){ return( ping.ring->push( i ) ); } );
+      bench::spin_until( [&](){ return( pong.ring->pop( item ) ); } );
+      samples[ i ] = bench::now() - start;
+   }
+   wait_child( child );
+   return( samples );
+}
+
+/**
+ * fd_latency - parent writes on to_child[ 1 ], child echoes
+ * back on from_child[ 1 ].
+ */
+static std::vector< std::uint64_t > fd_latency( const int to_child[ 2 ],
+                                                const int from_child[ 2 ],
+                                                const std::uint64_t rounds )
+{
+   const auto child( fork() );
+   if( child == 0 )
+   {
+      bench::pin( 1 );
+      item_t item;
+      for( std::uint64_t i( 0 ); i < rounds; i++ )
+      {
+         read_full( to_child[ 0 ], &item, sizeof( item ) );
+         write_full( from_child[ 1 ], &item, sizeof( item ) );
+      }
+      _exit( EXIT_SUCCESS );
+   }
+   bench::pin( 0 );
+   std::vector< std::uint64_t > samples( rounds );
+   item_t item( 0 );
+   for( std::uint64_t i( 0 ); i < rounds; i++ )
+   {
+      const auto start( bench::now() );
+      write_full( to_child[ 1 ], &i, sizeof( i ) );
+      read_full( from_child[ 0 ], &item, sizeof( item ) );
+      samples[ i ] = bench::now() - start;
+   }
+   wait_child( child );
+   return( samples );
+}
+
+int
+main( int argc, char **argv )
+{
+   const auto count( bench::iterations( argc, argv, 10000000 ) );
+   const auto rounds( std::max< std::uint64_t >( count / 100, 1000 ) );
+
+   int pipe_fds[ 2 ], pipe_back[ 2 ], sock_fds[ 2 ];
+   if( pipe( pipe_fds ) != 0 || pipe( pipe_back ) != 0 ||
+       socketpair( AF_UNIX, SOCK_STREAM, 0, sock_fds ) != 0 )
+   {
+      std::perror( "failed to create pipe/socket" );
+      return( EXIT_FAILURE );
+   }
+   /** socket pairs are bidirectional, both ends read and write **/
+   const int sock_to[ 2 ]     = { sock_fds[ 1 ], sock_fds[ 0 ] };
+   const int sock_from[ 2 ]   = { sock_fds[ 0 ], sock_fds[ 1 ] };
+
+   std::printf( "%llu items of %zu bytes, batches of %zu\n",
+                static_cast< unsigned long long >( count ), sizeof( item_t ), batch );
+   bench::throughput_header( "throughput" );
+   bench::throughput_row( "shm::spsc_ring", count, sizeof( item_t ), ring_throughput( count ) );
+   bench::throughput_row( "pipe", count, sizeof( item_t ), fd_throughput( pipe_fds, count ) );
+   bench::throughput_row( "unix socket", count, sizeof( item_t ), fd_throughput( sock_to, count ) );
+
+   std::printf( "\n%llu round trips of one item\n", static_cast< unsigned long long >( rounds ) );
+   bench::latency_header( "round trip" );
+   auto ring_samples( ring_latency( rounds ) );
+   bench::latency_row( "shm::spsc_ring", ring_samples );
+   auto pipe_samples( fd_latency( pipe_fds, pipe_back, rounds ) );
+   bench::latency_row( "pipe", pipe_samples );
+   auto sock_samples( fd_latency( sock_to, sock_from, rounds ) );
+   bench::latency_row( "unix socket", sock_samples );
+   return( EXIT_SUCCESS );
+}
@@ -0,0 +1,131 @@
+/**
+ * wake.cpp - wake up latency of shm::semaphore across processes
+ * for each wait policy, the time from post() in one process to
+ * wait() returning in another, and how much cpu the waiting
+ * process burned per wake up. Each round the poster sleeps
+ * for gap before posting so that blocking policies actually block.
+ * usage: wake_bench [wake ups per run]
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+#include <shm>
+#include <shm_futex.hpp>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "bench.hpp"
+
+struct control
+{
+   shm::semaphore                ping;
+   shm::semaphore                pong;
+   std::atomic< std::uint64_t >  posted_at;
+   /** followed by one latency sample per round **/
+};
+
+/** busy waits so the gap is the same on every platform **/
+static void delay( const std::uint64_t ns )
+{
+   const auto until( bench::now() + ns );
+   while( bench::now() < until )
+   {
+      shm::futex::relax();
+   }
+}
+
+static double child_cpu_ns()
+{
+   struct rusage usage;
+   getrusage( RUSAGE_CHILDREN, &usage );
+   return( ( usage.ru_utime.tv_sec + usage.ru_stime.tv_sec ) * 1e9 +
+           ( usage.ru_utime.tv_usec + usage.ru_stime.tv_usec ) * 1e3 );
+}
+
+static void run( const char *name,
+                 const shm::wait_policy &policy,
+                 const std::uint64_t rounds,
+                 const std::uint64_t gap )
+{
+   shm_key_t key;
+   shm::gen_key( key, 42 );
+   const auto nbytes( sizeof( control ) + rounds * sizeof( std::uint64_t ) );
+   void *mem( shm::init( key, nbytes, false, nullptr ) );
+   auto *ctl( new ( mem ) control() );
+   auto *samples( reinterpret_cast< std::uint64_t* >( ctl + 1 ) );
+
+   const auto cpu_before( child_cpu_ns() );
+   if( fork() == 0 )
+   {
+      bench::pin( 1 );
+      for( std::uint64_t i( 0 ); i < rounds; i++ )
+      {
+         ctl->ping.wait( policy );
+         samples[ i ] = bench::now() - ctl->posted_at.load( std::memory_order_relaxed );
+         ctl->pong.post();
+      }
+      _exit( EXIT_SUCCESS );
+   }
+   bench::pin( 0 );
+   for( std::uint64_t i( 0 ); i < rounds; i++ )
+   {
+      delay( gap );
+      ctl->posted_at.store( bench::now(), std::memory_order_relaxed );
+      ctl->ping.post();
+      ctl->pong.wait( shm::wait_policy( shm::wait_policy::spin ) );
+   }
+   int status( 0 );
+   wait( &status );
+   const auto cpu( child_cpu_ns() - cpu_before );
+
+   std::vector< std::uint64_t > latencies( samples, samples + rounds );
+   const auto label( std::string( name ) + " gap " + std::to_string( gap / 1000 ) + "us" );
+   bench::latency_row( label.c_str(), latencies );
+   std::printf( "%-24s %12.0f\n", "  waiter cpu/wake(ns)", cpu / rounds );
+   shm::close( key, &mem, nbytes, false, true );
+}
+
+int
+main( int argc, char **argv )
+{
+   const auto rounds( bench::iterations( argc, argv, 20000 ) );
+   const std::pair< const char*, shm::wait_policy > policies[] =
+   {
+      { "spin",           shm::wait_policy( shm::wait_policy::spin ) },
+      { "block",          shm::wait_policy( shm::wait_policy::block ) },
+      { "adaptive 256",   shm::wait_policy( shm::wait_policy::adaptive, 256 ) },
+      { "adaptive 4k",    shm::wait_policy( shm::wait_policy::adaptive, 4096 ) },
+      { "adaptive 64k",   shm::wait_policy( shm::wait_policy::adaptive, 65536 ) }
+   };
+   bench::latency_header( "semaphore wake up" );
+   for( const std::uint64_t gap : { 0ULL, 20000ULL, 200000ULL } )
+   {
+      for( const auto &policy : policies )
+      {
+         run( policy.first, policy.second, gap == 0 ? rounds : rounds / 10, gap );
+      }
+   }
+   return( EXIT_SUCCESS );
+}
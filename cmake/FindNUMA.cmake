@@ -32,9 +32,17 @@ else( NUMA_LIBRARY AND NUMA_INCLUDE_DIRS )
 # get machine type
 ##
     execute_process( COMMAND uname -m COMMAND tr -d '\n' OUTPUT_VARIABLE ARCHITECTURE )
-    execute_process( COMMAND ${CMAKE_CURRENT_SOURCE_DIR}/scripts/findnodes.pl
-                     COMMAND tr -d '\n' 
-                     OUTPUT_VARIABLE HASNUMA )
+    ##
+    # more than one node directory in sysfs means NUMA, the same
+    # place shm::topology looks at run time
+    ##
+    file( GLOB NUMA_NODE_DIRS "/sys/devices/system/node/node[0-9]*" )
+    list( LENGTH NUMA_NODE_DIRS NUMA_NODE_COUNT )
+    if( NUMA_NODE_COUNT GREATER 1 )
+        set( HASNUMA 1 )
+    else( NUMA_NODE_COUNT GREATER 1 )
+        set( HASNUMA 0 )
+    endif( NUMA_NODE_COUNT GREATER 1 )
     if( HASNUMA EQUAL 0 )
         ## no NUMA
         message( STATUS "no NUMA needed" )
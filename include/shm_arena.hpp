@@ -0,0 +1,221 @@
+/**
+ * shm_arena.hpp -
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * @author: Jonathan Beard
+ * @version: Oct 18 2026
+ */
+#ifndef _SHM_ARENA_HPP_
+#define _SHM_ARENA_HPP_  1
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include <shm>
+
+/**
+ * arena - general purpose allocator that manages a segment from
+ * shm::init from the inside, so many variable sized objects can
+ * share one segment. All of the metadata lives in a header at the
+ * start of the segment and every reference is an offset from that
+ * header, so any process that has the segment mapped (at any
+ * address) can allocate and free.
+ *
+ * Requests are rounded up to one of a fixed set of size classes
+ * (four per power of two, 16B minimum), each class has a lock-free
+ * free list, and fresh memory is carved off the end of the used
+ * region. Both allocate and deallocate are O(1). Freed blocks stay
+ * in their class, they aren't coalesced.
+ *
+ * Calling allocate/deallocate on the arena directly always goes to
+ * the shared free lists, use an arena::cache per thread to batch
+ * that traffic through a small private stash of blocks per class.
+ *
+ * Typical use:
+ * void *mem = shm::init( key, nbytes );
+ * auto *a   = shm::arena::create( mem, nbytes );
+ * ...other processes...
+ * auto *a   = shm::arena::attach( shm::open( key ) );
+ * shm::arena::cache c( a );
+ * void *p   = c.allocate( 100 );
+ * c.deallocate( p );
+ */
+class shm::arena
+{
+public:
+   class cache;
+
+   /** every pointer returned is aligned to this **/
+   static constexpr std::size_t alignment = 16;
+
+   arena( const arena &other ) = delete;
+   arena& operator = ( const arena &other ) = delete;
+
+   /**
+    * create - builds an arena at mem that manages nbytes,
+    * mem should come from shm::init( key, nbytes ).
+    * @param   mem - start of the segment
+    * @param   nbytes - size of the segment
+    * @return  arena* - same address as mem
+    */
+   static arena* create( void *mem, const std::size_t nbytes );
+
+   /**
+    * attach - returns the arena that another process built at
+    * mem, throws or returns nullptr if mem doesn't hold one.
+    */
+   static arena* attach( void *mem );
+
+   /**
+    * allocate - returns nbytes from the shared free lists, throws
+    * bad_shm_alloc or returns nullptr when the segment is full.
+    */
+   void* allocate( const std::size_t nbytes );
+
+   /**
+    * deallocate - returns ptr, which may have come from any
+    * process attached to this arena, to its free list.
+    */
+   void deallocate( void *ptr );
+
+   /** usable_size - bytes actually available at ptr **/
+   static std::size_t usable_size( const void *ptr );
+
+   /**
+    * offset_of/at - convert between pointers, which are only good
+    * in this process, and offsets, which are good in all of them.
+    */
+   std::size_t offset_of( const void *ptr ) const
+   {
+      return( reinterpret_cast< const char* >( ptr ) -
+              reinterpret_cast< const char* >( this ) );
+   }
+
+   void* at( const std::size_t offset )
+   {
+      return( reinterpret_cast< char* >( this ) + offset );
+   }
+
+   /**
+    * set_root/root - one well known object per arena, e.g., the
+    * container the other processes should start from, so they
+    * don't need an offset passed out of band. root is nullptr
+    * until someone sets it.
+    */
+   void set_root( void *ptr )
+   {
+      root_.store( ptr == nullptr ? 0 : offset_of( ptr ), std::memory_order_release );
+   }
+
+   void* root()
+   {
+      const auto offset( root_.load( std::memory_order_acquire ) );
+      return( offset == 0 ? nullptr : at( offset ) );
+   }
+
+   /** capacity - bytes managed, including this header **/
+   std::size_t capacity() const
+   {
+      return( capacity_ );
+   }
+
+   /** carved - bytes handed out at least once, freed or not **/
+   std::size_t carved() const
+   {
+      return( top.load( std::memory_order_relaxed ) );
+   }
+
+private:
+   static constexpr std::uint32_t   class_count     = 144;
+
+   explicit arena( const std::size_t nbytes );
+
+   static std::uint32_t size_class( const std::size_t nbytes );
+   static std::size_t   class_size( const std::uint32_t size_class );
+
+   /** lock-free free list primitives, all in offsets **/
+   std::uint64_t  pop( const std::uint32_t size_class );
+   void           push( const std::uint32_t size_class,
+                        const std::uint64_t first,
+                        const std::uint64_t last );
+   std::uint64_t  carve( const std::uint32_t size_class, const std::size_t count );
+   std::uint64_t  get_block( const std::uint32_t size_class );
+   std::uint32_t  class_of( const void *ptr ) const;
+   void*          user_ptr( const std::uint64_t block );
+   std::uint64_t& next_of( const std::uint64_t block );
+
+   /** read-mostly after create **/
+   alignas( SHM_CACHE_LINE_SIZE ) const std::uint64_t magic;
+   const std::uint64_t capacity_;
+   std::atomic< std::uint64_t > root_;
+
+   /** offset of the first byte never handed out **/
+   alignas( SHM_CACHE_LINE_SIZE ) std::atomic< std::uint64_t > top;
+
+   /** [ tag : 24 ][ block offset / 16 : 40 ], zero offset is empty **/
+   struct alignas( SHM_CACHE_LINE_SIZE ) free_list
+   {
+      std::atomic< std::uint64_t > head;
+   } free_lists[ class_count ];
+};
+
+/**
+ * arena::cache - private stash of blocks in front of an arena,
+ * allocations and frees of the smaller classes go through a small
+ * magazine per class and only touch the shared free lists a batch
+ * at a time. A cache isn't thread safe, make one per thread.
+ * Blocks sitting in a cache when its process dies are lost to the
+ * other processes, call flush() or let the destructor run.
+ */
+class shm::arena::cache
+{
+public:
+   explicit cache( arena *a );
+   ~cache();
+
+   cache( const cache &other ) = delete;
+   cache& operator = ( const cache &other ) = delete;
+
+   void* allocate( const std::size_t nbytes );
+   void  deallocate( void *ptr );
+
+   /** flush - hands every cached block back to the arena **/
+   void  flush();
+
+   arena* get_arena()
+   {
+      return( a );
+   }
+
+private:
+   static constexpr std::size_t     magazine_size      = 32;
+   /** blocks larger than this always go to the arena **/
+   static constexpr std::size_t     max_cached_bytes   = 1 << 15;
+
+   struct magazine
+   {
+      std::uint32_t count = 0;
+      std::uint64_t blocks[ magazine_size ];
+   };
+
+   void spill( const std::uint32_t size_class, const std::size_t count );
+
+   arena                   *a;
+   std::vector< magazine > magazines;
+};
+
+#endif /* END _SHM_ARENA_HPP_ */
@@ -0,0 +1,446 @@
+/**
+ * shm_broadcast_ring.hpp -
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * @author: Jonathan Beard
+ * @version: Oct 18 2026
+ */
+#ifndef _SHM_BROADCAST_RING_HPP_
+#define _SHM_BROADCAST_RING_HPP_  1
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <shm>
+
+/**
+ * broadcast_ring - one producer, many consumers, every consumer
+ * sees every item, one copy of the stream in one segment. Each
+ * reader subscribes for a cursor of its own (on its own cache
+ * line), readers never write anything the producer or the other
+ * readers read on the fast path. Every slot carries a sequence
+ * number, like a seqlock, so a reader can tell an item that isn't
+ * there yet from one that was overwritten while it was copying it.
+ *
+ * What happens to a reader that falls a full ring behind is picked
+ * at create:
+ *  backpressure - the producer waits for the slowest subscribed
+ *                 reader, nothing is lost. A reader that dies
+ *                 without unsubscribing is reaped (kill( pid, 0 ))
+ *                 once the producer is stuck on it, so processes
+ *                 need to be in the same pid namespace.
+ *  lapped       - the producer never waits, a reader that was
+ *                 overwritten gets status::lapped, is moved up to
+ *                 the oldest item still in the ring and lost()
+ *                 counts what it missed.
+ * Subscribing and unsubscribing never stop the producer. A reader
+ * starts with the next item pushed after it subscribed, with
+ * backpressure a reader that subscribes while the ring is full may
+ * still be lapped once before the producer sees its cursor.
+ *
+ * Typical use:
+ * void *mem = shm::init( key, shm::broadcast_ring< T >::required_bytes( n, readers ) );
+ * auto *ring = shm::broadcast_ring< T >::create( mem, n, readers );
+ * ring->push( item );
+ * ...other processes...
+ * auto *ring = shm::broadcast_ring< T >::attach( shm::open( key ) );
+ * const auto id( ring->subscribe() );
+ * while( ring->try_pop( id, item ) != shm::broadcast_ring< T >::status::ok ) ...
+ * ring->unsubscribe( id );
+ */
+template < class T > class shm::broadcast_ring
+{
+public:
+   static_assert( std::is_trivially_copyable< T >::value,
+                  "broadcast_ring elements are copied between processes as bytes" );
+   static_assert( alignof( T ) <= SHM_CACHE_LINE_SIZE,
+                  "broadcast_ring elements can't be aligned wider than a cache line" );
+   static_assert( ATOMIC_LLONG_LOCK_FREE == 2,
+                  "broadcast_ring needs address-free 64b atomics to work across processes" );
+
+   enum class policy_t : std::uint8_t
+   {
+      backpressure = 0,
+      lapped
+   };
+
+   enum class status : std::uint8_t
+   {
+      ok = 0,
+      /** nothing new yet **/
+      empty,
+      /** items were overwritten before they were read, see lost() **/
+      lapped
+   };
+
+   broadcast_ring( const broadcast_ring &other ) = delete;
+   broadcast_ring& operator = ( const broadcast_ring &other ) = delete;
+
+   /**
+    * required_bytes - number of bytes a segment needs to hold
+    * a ring of at least capacity items and max_readers cursors.
+    * @param   capacity - requested number of items, rounded up
+    * to a power of two.
+    * @param   max_readers - readers that can be subscribed at once
+    * @return  std::size_t - bytes to pass to shm::init
+    */
+   static std::size_t required_bytes( const std::size_t capacity,
+                                      const std::size_t max_readers )
+   {
+      return( sizeof( broadcast_ring ) +
+              max_readers * sizeof( cursor ) +
+              round_capacity( capacity ) * sizeof( slot ) );
+   }
+
+   /**
+    * create - builds a ring at mem, which should come from
+    * shm::init with at least required_bytes( capacity, max_readers )
+    * bytes. Only one process should call create, the rest attach.
+    * @return  broadcast_ring* - the ring, same address as mem
+    */
+   static broadcast_ring* create( void              *mem,
+                                  const std::size_t capacity,
+                                  const std::size_t max_readers,
+                                  const policy_t    policy = policy_t::backpressure )
+   {
+      return( new ( mem ) broadcast_ring( round_capacity( capacity ), max_readers, policy ) );
+   }
+
+   /**
+    * attach - returns the ring that another process built at mem,
+    * throws or returns nullptr if mem doesn't hold a ring of this
+    * type.
+    */
+   static broadcast_ring* attach( void *mem )
+   {
+      auto *ring( reinterpret_cast< broadcast_ring* >( mem ) );
+      if( mem == nullptr ||
+          ring->magic != ring_magic ||
+          ring->item_size != sizeof( T ) )
+      {
+#if USE_CPP_EXCEPTIONS==1
+         throw invalid_segment_exception( "segment doesn't hold a broadcast_ring of this type" );
+#else
+         return( nullptr );
+#endif
+      }
+      return( ring );
+   }
+
+   /**
+    * try_push - producer side, copies item into the ring. There can
+    * only be one producer at a time.
+    * @return bool - false if backpressure is on and the slowest
+    *                reader is a full ring behind
+    */
+   bool try_push( const T &item )
+   {
+      const auto pos( producer.write.load( std::memory_order_relaxed ) );
+      if( policy == policy_t::backpressure && pos - producer.min_cache >= capacity_ )
+      {
+         producer.min_cache = slowest( pos );
+         if( pos - producer.min_cache >= capacity_ )
+         {
+            return( false );
+         }
+      }
+      auto &s( slots()[ pos & mask ] );
+      s.seq.store( 2 * pos + 1, std::memory_order_relaxed );
+      /** the odd sequence is visible before any of the item **/
+      std::atomic_thread_fence( std::memory_order_release );
+      std::memcpy( &s.data, &item, sizeof( T ) );
+      s.seq.store( 2 * pos + 2, std::memory_order_release );
+      producer.write.store( pos + 1, std::memory_order_release );
+      return( true );
+   }
+
+   /**
+    * push - spins (yielding) until item fits, reaping readers that
+    * died while subscribed every so often.
+    */
+   void push( const T &item )
+   {
+      for( std::uint32_t spins( 1 ); ! try_push( item ); spins++ )
+      {
+         if( ( spins % probe_after ) == 0 )
+         {
+            reap();
+         }
+         std::this_thread::yield();
+      }
+   }
+
+   /**
+    * subscribe - claims a cursor for the calling process, it reads
+    * items pushed from now on.
+    * @return  std::int32_t - reader id, -1 if max_readers are
+    *                         already subscribed
+    */
+   std::int32_t subscribe()
+   {
+      for( std::uint64_t id( 0 ); id < max_readers; id++ )
+      {
+         auto &c( cursors()[ id ] );
+         std::uint32_t expected( free_cursor );
+         if( c.state.load( std::memory_order_relaxed ) != free_cursor ||
+             ! c.state.compare_exchange_strong( expected, claimed_cursor ) )
+         {
+            continue;
+         }
+         c.pid.store( getpid(), std::memory_order_relaxed );
+         c.lost  = 0;
+         c.read.store( producer.write.load( std::memory_order_acquire ),
+                       std::memory_order_relaxed );
+         /** cursor is set before the producer can take it into account **/
+         c.state.store( active_cursor, std::memory_order_release );
+         return( static_cast< std::int32_t >( id ) );
+      }
+      return( -1 );
+   }
+
+   /** unsubscribe - hands the cursor back, the producer stops waiting on it **/
+   void unsubscribe( const std::int32_t id )
+   {
+      cursors()[ id ].state.store( free_cursor, std::memory_order_release );
+   }
+
+   /**
+    * try_pop - reader side, copies out the next item for reader id.
+    * @return  status - ok with item filled in, empty, or lapped (the
+    *                   reader was moved up, call again)
+    */
+   status try_pop( const std::int32_t id, T &item )
+   {
+      auto &c( cursors()[ id ] );
+      const auto pos( c.read.load( std::memory_order_relaxed ) );
+      const auto &s( slots()[ pos & mask ] );
+      const auto before( s.seq.load( std::memory_order_acquire ) );
+      if( before != 2 * pos + 2 )
+      {
+         if( before < 2 * pos + 2 )
+         {
+            return( status::empty );
+         }
+         return( overrun( c, pos ) );
+      }
+      std::memcpy( &item, &s.data, sizeof( T ) );
+      /** the copy is done before the sequence is checked again **/
+      std::atomic_thread_fence( std::memory_order_acquire );
+      if( s.seq.load( std::memory_order_relaxed ) != before )
+      {
+         return( overrun( c, pos ) );
+      }
+      c.read.store( pos + 1, std::memory_order_release );
+      return( status::ok );
+   }
+
+   /** pop - spins (yielding) until reader id gets an item **/
+   void pop( const std::int32_t id, T &item )
+   {
+      while( try_pop( id, item ) != status::ok )
+      {
+         std::this_thread::yield();
+      }
+   }
+
+   /** lost - items reader id missed by being lapped **/
+   std::uint64_t lost( const std::int32_t id ) const
+   {
+      return( cursors()[ id ].lost );
+   }
+
+   /** backlog - approximate number of items reader id hasn't read **/
+   std::size_t backlog( const std::int32_t id ) const
+   {
+      return( producer.write.load( std::memory_order_acquire ) -
+              cursors()[ id ].read.load( std::memory_order_acquire ) );
+   }
+
+   /** readers - number of subscribed readers **/
+   std::size_t readers() const
+   {
+      std::size_t out( 0 );
+      for( std::uint64_t id( 0 ); id < max_readers; id++ )
+      {
+         if( cursors()[ id ].state.load( std::memory_order_acquire ) == active_cursor )
+         {
+            out++;
+         }
+      }
+      return( out );
+   }
+
+   /**
+    * reap - unsubscribes readers whose process is gone, push calls
+    * it when it has been stuck for a while.
+    * @return  std::size_t - number of readers reaped
+    */
+   std::size_t reap()
+   {
+      std::size_t out( 0 );
+      for( std::uint64_t id( 0 ); id < max_readers; id++ )
+      {
+         auto &c( cursors()[ id ] );
+         if( c.state.load( std::memory_order_acquire ) != active_cursor )
+         {
+            continue;
+         }
+         const auto pid( c.pid.load( std::memory_order_relaxed ) );
+         if( kill( pid, 0 ) == 0 || errno != ESRCH )
+         {
+            continue;
+         }
+         std::uint32_t expected( active_cursor );
+         if( c.state.compare_exchange_strong( expected, free_cursor ) )
+         {
+            out++;
+         }
+      }
+      return( out );
+   }
+
+   std::size_t capacity() const
+   {
+      return( capacity_ );
+   }
+
+private:
+   static constexpr std::uint64_t ring_magic      = 0x6263737472696e67ULL;
+   static constexpr std::uint32_t free_cursor     = 0;
+   static constexpr std::uint32_t claimed_cursor  = 1;
+   static constexpr std::uint32_t active_cursor   = 2;
+   /** failed pushes before checking for dead readers **/
+   static constexpr std::uint32_t probe_after     = 1024;
+
+   /** written only by the reader that holds it **/
+   struct alignas( SHM_CACHE_LINE_SIZE ) cursor
+   {
+      std::atomic< std::uint64_t > read;
+      std::atomic< std::uint32_t > state;
+      std::atomic< pid_t >         pid;
+      std::uint64_t                lost;
+   };
+
+   /** seq is 2 * pos + 2 once the item for pos is whole, odd while it's written **/
+   struct slot
+   {
+      std::atomic< std::uint64_t > seq;
+      T                            data;
+   };
+
+   broadcast_ring( const std::size_t capacity,
+                   const std::size_t max_readers,
+                   const policy_t    policy ) : magic( ring_magic ),
+                                                item_size( sizeof( T ) ),
+                                                capacity_( capacity ),
+                                                mask( capacity - 1 ),
+                                                max_readers( max_readers ),
+                                                policy( policy )
+   {
+      for( std::size_t id( 0 ); id < max_readers; id++ )
+      {
+         auto *c( new ( &cursors()[ id ] ) cursor() );
+         c->read.store( 0, std::memory_order_relaxed );
+         c->state.store( free_cursor, std::memory_order_relaxed );
+         c->pid.store( 0, std::memory_order_relaxed );
+         c->lost = 0;
+      }
+      for( std::size_t i( 0 ); i < capacity; i++ )
+      {
+         new ( &slots()[ i ].seq ) std::atomic< std::uint64_t >( 0 );
+      }
+      producer.write.store( 0, std::memory_order_relaxed );
+      producer.min_cache = 0;
+      std::atomic_thread_fence( std::memory_order_release );
+   }
+
+   static std::size_t round_capacity( const std::size_t capacity )
+   {
+      std::size_t out( 1 );
+      while( out < capacity )
+      {
+         out <<= 1;
+      }
+      return( out );
+   }
+
+   cursor* cursors() const
+   {
+      return( reinterpret_cast< cursor* >(
+         reinterpret_cast< char* >( const_cast< broadcast_ring* >( this ) ) + sizeof( broadcast_ring ) ) );
+   }
+
+   slot* slots() const
+   {
+      return( reinterpret_cast< slot* >(
+         reinterpret_cast< char* >( cursors() ) + max_readers * sizeof( cursor ) ) );
+   }
+
+   /** slowest - cursor of the slowest subscribed reader, pos if there are none **/
+   std::uint64_t slowest( const std::uint64_t pos ) const
+   {
+      auto out( pos );
+      for( std::uint64_t id( 0 ); id < max_readers; id++ )
+      {
+         const auto &c( cursors()[ id ] );
+         if( c.state.load( std::memory_order_acquire ) != active_cursor )
+         {
+            continue;
+         }
+         const auto read( c.read.load( std::memory_order_acquire ) );
+         if( read < out )
+         {
+            out = read;
+         }
+      }
+      return( out );
+   }
+
+   /** overrun - moves reader c at pos up to the oldest item still in the ring **/
+   status overrun( cursor &c, const std::uint64_t pos )
+   {
+      const auto write( producer.write.load( std::memory_order_acquire ) );
+      /** the slot for write - capacity may be being overwritten right now **/
+      const auto oldest( write + 1 > capacity_ ? write + 1 - capacity_ : 0 );
+      const auto next( oldest > pos ? oldest : pos + 1 );
+      c.lost += next - pos;
+      c.read.store( next, std::memory_order_release );
+      return( status::lapped );
+   }
+
+   /** read-only after create **/
+   alignas( SHM_CACHE_LINE_SIZE ) const std::uint64_t magic;
+   const std::uint64_t  item_size;
+   const std::uint64_t  capacity_;
+   const std::uint64_t  mask;
+   const std::uint64_t  max_readers;
+   const policy_t       policy;
+
+   /** written only by the producer **/
+   struct alignas( SHM_CACHE_LINE_SIZE )
+   {
+      std::atomic< std::uint64_t > write;
+      std::uint64_t                min_cache;
+   } producer;
+};
+
+#endif /* END _SHM_BROADCAST_RING_HPP_ */
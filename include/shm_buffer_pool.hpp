@@ -0,0 +1,227 @@
+/**
+ * shm_buffer_pool.hpp -
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * @author: Jonathan Beard
+ * @version: Oct 18 2026
+ */
+#ifndef _SHM_BUFFER_POOL_HPP_
+#define _SHM_BUFFER_POOL_HPP_  1
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <sys/types.h>
+
+#include <shm>
+
+/**
+ * buffer_pool - fixed size, reference counted buffers inside a
+ * segment from shm::init, for handing large payloads between
+ * processes without copying them. Processes pass a small
+ * descriptor (pool id, buffer offset, length) through any of the
+ * rings instead of the bytes, and the reference travels with it.
+ * The last reference to be released puts the buffer back on a
+ * lock-free free list (tagged index, so no ABA).
+ *
+ * Every process joins the pool for a client id, the pool counts
+ * references per client and buffer. A client whose process died
+ * has its references dropped by reclaim() (allocate calls it when
+ * the pool runs dry), so a crashed holder can't leak buffers, not
+ * even ones it had sent but nobody had adopted yet. Liveness is
+ * checked with kill( pid, 0 ), so processes need to be in the same
+ * pid namespace.
+ *
+ * Typical use:
+ * void *mem = shm::init( key, shm::buffer_pool::required_bytes( 1 << 20, 64 ) );
+ * auto *pool = shm::buffer_pool::create( mem, 1 << 20, 64 );
+ * const auto me( pool->join() );
+ * shm::buffer_pool::descriptor d;
+ * pool->allocate( me, d );
+ * ...fill pool->data( d ), set d.length, push d through a ring...
+ * ...other process...
+ * auto *pool = shm::buffer_pool::attach( shm::open( key ) );
+ * const auto me( pool->join() );
+ * ...pop d from the ring...
+ * if( pool->adopt( me, d ) ) { use pool->data( d ); pool->release( me, d ); }
+ */
+class shm::buffer_pool
+{
+public:
+   /** processes that can be joined at once **/
+   static constexpr std::size_t max_clients = 64;
+
+   /**
+    * descriptor - names one reference to a buffer, trivially
+    * copyable so it can go through spsc_ring, mpmc_queue etc.
+    * owner is the client the reference belongs to, generation
+    * tells a buffer apart from its earlier uses.
+    */
+   struct descriptor
+   {
+      std::uint32_t pool_id;
+      std::uint32_t index;
+      std::uint32_t generation;
+      std::uint32_t owner;
+      std::uint64_t offset;
+      std::uint64_t length;
+   };
+
+   buffer_pool( const buffer_pool &other ) = delete;
+   buffer_pool& operator = ( const buffer_pool &other ) = delete;
+
+   /**
+    * required_bytes - bytes a segment needs to hold count buffers
+    * of buffer_size bytes (rounded up to a cache line), buffers
+    * start page aligned.
+    */
+   static std::size_t required_bytes( const std::size_t buffer_size,
+                                      const std::size_t count );
+
+   /**
+    * create - builds a pool at mem, which should come from
+    * shm::init with at least required_bytes( buffer_size, count ).
+    * pool_id is copied into every descriptor, so a process using
+    * more than one pool can tell whose a descriptor is. Only one
+    * process should call create, the rest attach.
+    * @return  buffer_pool* - same address as mem
+    */
+   static buffer_pool* create( void              *mem,
+                               const std::size_t buffer_size,
+                               const std::size_t count,
+                               const std::uint32_t pool_id = 0 );
+
+   /**
+    * attach - returns the pool that another process built at mem,
+    * throws or returns nullptr if mem doesn't hold one.
+    */
+   static buffer_pool* attach( void *mem );
+
+   /**
+    * join - claims a client id for the calling process.
+    * @return  std::int32_t - client id, -1 if max_clients are taken
+    */
+   std::int32_t join();
+
+   /**
+    * leave - drops every reference client still holds and hands
+    * the id back.
+    */
+   void leave( const std::int32_t client );
+
+   /**
+    * allocate - a free buffer with one reference, owned by client.
+    * out.length is the buffer size.
+    * @return  bool - false if every buffer is in use
+    */
+   bool allocate( const std::int32_t client, descriptor &out );
+
+   /**
+    * retain - one more reference for client, e.g., to send the
+    * same buffer to several readers, each copy of the descriptor
+    * sent carries one reference. d.owner is set to client.
+    * @return  bool - false if d is stale or client holds too many
+    */
+   bool retain( const std::int32_t client, descriptor &d );
+
+   /**
+    * adopt - receiver side, moves the reference d carries from its
+    * owner to client, d.owner is set to client.
+    * @return  bool - false if the buffer was reclaimed in the
+    *                 meantime (the sender died), don't touch it
+    */
+   bool adopt( const std::int32_t client, descriptor &d );
+
+   /**
+    * release - drops one of client's references to d, the last
+    * one frees the buffer.
+    */
+   void release( const std::int32_t client, const descriptor &d );
+
+   /**
+    * reclaim - drops the references of every client whose process
+    * is gone and frees their ids.
+    * @return  std::size_t - number of buffers that became free
+    */
+   std::size_t reclaim();
+
+   /** data - the bytes of the buffer d refers to **/
+   void* data( const descriptor &d )
+   {
+      return( reinterpret_cast< char* >( this ) + d.offset );
+   }
+
+   /** references - number of references to d's buffer, all clients **/
+   std::uint32_t references( const descriptor &d ) const;
+
+   std::size_t buffer_size() const
+   {
+      return( buffer_size_ );
+   }
+
+   std::size_t count() const
+   {
+      return( count_ );
+   }
+
+   /** available - approximate number of free buffers **/
+   std::size_t available() const
+   {
+      return( available_.load( std::memory_order_relaxed ) );
+   }
+
+private:
+   /** per buffer bookkeeping, held counts are per client **/
+   struct alignas( SHM_CACHE_LINE_SIZE ) meta
+   {
+      std::atomic< std::uint32_t > refs;
+      std::atomic< std::uint32_t > generation;
+      std::atomic< std::uint32_t > next;
+      std::atomic< std::uint8_t >  held[ max_clients ];
+   };
+
+   buffer_pool( const std::size_t   buffer_size,
+                const std::size_t   count,
+                const std::uint32_t pool_id );
+
+   static std::size_t data_offset( const std::size_t count );
+   static std::size_t stride( const std::size_t buffer_size );
+
+   meta& meta_of( const std::uint32_t index ) const;
+
+   /** lock-free free list, [ tag : 32 ][ index + 1 : 32 ], 0 is empty **/
+   std::uint32_t  pop();
+   void           push( const std::uint32_t index );
+
+   /** drop - takes n references off index, frees it at zero **/
+   bool           drop( const std::uint32_t index, const std::uint32_t n );
+   /** sweep - drops every reference client holds **/
+   std::size_t    sweep( const std::uint32_t client );
+   bool           valid( const std::int32_t client, const descriptor &d ) const;
+
+   /** read-only after create **/
+   alignas( SHM_CACHE_LINE_SIZE ) const std::uint64_t magic;
+   const std::uint64_t  buffer_size_;
+   const std::uint64_t  count_;
+   const std::uint64_t  stride_;
+   const std::uint32_t  pool_id_;
+
+   alignas( SHM_CACHE_LINE_SIZE ) std::atomic< std::uint64_t > head;
+   std::atomic< std::uint64_t > available_;
+
+   /** pid of each client, 0 if free **/
+   alignas( SHM_CACHE_LINE_SIZE ) std::atomic< pid_t > clients[ max_clients ];
+};
+
+#endif /* END _SHM_BUFFER_POOL_HPP_ */
@@ -0,0 +1,523 @@
+/**
+ * shm_concurrent_map.hpp -
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * @author: Jonathan Beard
+ * @version: Oct 18 2026
+ */
+#ifndef _SHM_CONCURRENT_MAP_HPP_
+#define _SHM_CONCURRENT_MAP_HPP_  1
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <type_traits>
+
+#if defined( __SSE2__ )
+#include <emmintrin.h>
+#endif
+
+#include <shm>
+
+/**
+ * concurrent_map - fixed size, open addressing hash map in one
+ * segment from shm::init that any number of processes read and
+ * update at once, for lookup tables too big to keep a copy of in
+ * every process. Lookups are wait-free (a bounded probe, no retries,
+ * no stores), inserts and erases are lock-free.
+ *
+ * Keys and values are trivially copyable and at most 8 bytes each,
+ * every slot is one atomic word for each; for bigger values store an
+ * index, e.g., into a shm::pool. Keys are compared bytewise, so no
+ * padding in them. One key value is reserved to mark empty slots,
+ * all bits set unless given to create. Hash has to give the same
+ * answer in every process (no hashing addresses).
+ *
+ * Slots come in groups of 16 with one control byte each, kept apart
+ * from the slots so a group's bytes are one 16 byte vector: empty,
+ * or 7 bits of the key's hash while the entry is live. A lookup
+ * compares the whole group at once (SSE2 where there is one) and
+ * only touches slots whose tag matched.
+ *
+ * A key keeps its slot for good, erase marks it dead and a later
+ * insert of the same key brings it back, so keys that keep changing
+ * fill the table up, size it for every key it will ever see. Size
+ * it with some headroom too (around 1.25x), probes get long near
+ * full. For a big table back the segment with huge pages,
+ * shm::init( key, bytes, true, nullptr, shm::page_t::huge_2MB ).
+ *
+ * Typical use:
+ * void *mem = shm::init( key, shm::concurrent_map< std::uint64_t, std::uint64_t >::required_bytes( n ) );
+ * auto *map = shm::concurrent_map< std::uint64_t, std::uint64_t >::create( mem, n );
+ * map->insert( id, offset );
+ * ...other processes...
+ * auto *map = shm::concurrent_map< std::uint64_t, std::uint64_t >::attach( shm::open( key ) );
+ * std::uint64_t offset;
+ * if( map->find( id, offset ) ) { ... }
+ */
+template < class K, class V, class Hash > class shm::concurrent_map
+{
+public:
+   static_assert( std::is_trivially_copyable< K >::value &&
+                  std::is_trivially_copyable< V >::value,
+                  "concurrent_map keys and values are copied bytewise" );
+   static_assert( sizeof( K ) <= sizeof( std::uint64_t ) &&
+                  sizeof( V ) <= sizeof( std::uint64_t ),
+                  "concurrent_map keys and values have to fit in one atomic word" );
+   static_assert( ATOMIC_LLONG_LOCK_FREE == 2,
+                  "concurrent_map needs address-free 64b atomics to work across processes" );
+
+   /** slots per group, one control byte each **/
+   static constexpr std::size_t group_size = 16;
+
+   enum class result : std::uint8_t
+   {
+      inserted = 0,
+      /** the key was there, insert_or_assign replaced its value **/
+      exists,
+      full,
+      /** the key is the one reserved for empty slots **/
+      invalid_key
+   };
+
+   concurrent_map( const concurrent_map &other ) = delete;
+   concurrent_map& operator = ( const concurrent_map &other ) = delete;
+
+   /**
+    * required_bytes - bytes a segment needs for at least capacity
+    * slots, rounded up to a power of two number of groups.
+    * @return  std::size_t - bytes to pass to shm::init
+    */
+   static std::size_t required_bytes( const std::size_t capacity )
+   {
+      const auto groups( groups_for( capacity ) );
+      return( slot_offset( groups ) + groups * group_size * sizeof( slot ) );
+   }
+
+   /**
+    * create - builds an empty map at mem, which should come from
+    * shm::init with at least required_bytes( capacity ) bytes.
+    * reserved can't be inserted, it marks empty slots. Only one
+    * process should call create, the rest attach.
+    * @return  concurrent_map* - same address as mem
+    */
+   static concurrent_map* create( void *mem,
+                                  const std::size_t capacity,
+                                  const K &reserved = all_ones() )
+   {
+      if( mem == nullptr || capacity == 0 )
+      {
+#if USE_CPP_EXCEPTIONS==1
+         throw bad_shm_alloc( "concurrent_map needs a segment and a capacity" );
+#else
+         return( nullptr );
+#endif
+      }
+      const auto groups( groups_for( capacity ) );
+      /** empty is all zero, control bytes and slots **/
+      std::memset( mem, 0, required_bytes( capacity ) );
+      return( new ( mem ) concurrent_map( groups, reserved ) );
+   }
+
+   /**
+    * attach - returns the map that another process built at mem,
+    * throws or returns nullptr if mem doesn't hold a map with these
+    * key and value sizes.
+    */
+   static concurrent_map* attach( void *mem )
+   {
+      auto *map( reinterpret_cast< concurrent_map* >( mem ) );
+      if( mem == nullptr ||
+          map->magic != map_magic ||
+          map->key_size != sizeof( K ) ||
+          map->value_size != sizeof( V ) )
+      {
+#if USE_CPP_EXCEPTIONS==1
+         throw invalid_segment_exception( "segment doesn't hold a concurrent_map of this type" );
+#else
+         return( nullptr );
+#endif
+      }
+      return( map );
+   }
+
+   /**
+    * find - wait-free, copies the value of key to out.
+    * @return  bool - false if key isn't in the map
+    */
+   bool find( const K &key, V &out ) const
+   {
+      const slot *s( lookup( key ) );
+      if( s == nullptr )
+      {
+         return( false );
+      }
+      out = from_word< V >( s->value.load( std::memory_order_relaxed ) );
+      return( true );
+   }
+
+   bool contains( const K &key ) const
+   {
+      return( lookup( key ) != nullptr );
+   }
+
+   /**
+    * insert - adds key if it isn't there. Of several processes
+    * inserting the same key at once exactly one gets inserted.
+    * @return  result - inserted, exists, full or invalid_key
+    */
+   result insert( const K &key, const V &value )
+   {
+      return( put( key, value, false ) );
+   }
+
+   /**
+    * insert_or_assign - same as insert, but replaces the value of
+    * a key that is already there (result exists). Racing an insert
+    * of the same key that hasn't finished, the insert's value wins.
+    */
+   result insert_or_assign( const K &key, const V &value )
+   {
+      return( put( key, value, true ) );
+   }
+
+   /**
+    * erase - removes key, of several processes erasing the same key
+    * at once exactly one gets true.
+    */
+   bool erase( const K &key )
+   {
+      slot *s( const_cast< slot* >( lookup( key ) ) );
+      if( s == nullptr )
+      {
+         return( false );
+      }
+      const auto index( static_cast< std::size_t >( s - slots() ) );
+      const auto h( hash( key ) );
+      auto expected( live_tag( h ) );
+      if( ! ctrl()[ index ].compare_exchange_strong( expected,
+                                                     dead_tag( h ),
+                                                     std::memory_order_acq_rel ) )
+      {
+         return( false );
+      }
+      size_.fetch_sub( 1, std::memory_order_relaxed );
+      return( true );
+   }
+
+   /** size - approximate number of live entries **/
+   std::size_t size() const
+   {
+      const auto n( size_.load( std::memory_order_relaxed ) );
+      return( n < 0 ? 0 : static_cast< std::size_t >( n ) );
+   }
+
+   std::size_t capacity() const
+   {
+      return( groups_ * group_size );
+   }
+
+private:
+   static constexpr std::uint64_t map_magic = 0x73686d636d617031ULL;
+
+   /** control bytes, live is 0x80 | 7 bits of tag, dead 0x40 | 6 bits **/
+   static constexpr std::uint8_t empty   = 0x00;
+   static constexpr std::uint8_t writing = 0x01;
+
+   /** keys are stored xor the reserved key, so empty slots are zero **/
+   struct slot
+   {
+      std::atomic< std::uint64_t > key;
+      std::atomic< std::uint64_t > value;
+   };
+
+   concurrent_map( const std::size_t groups, const K &reserved ) : magic( map_magic ),
+                                                                   key_size( sizeof( K ) ),
+                                                                   value_size( sizeof( V ) ),
+                                                                   groups_( groups ),
+                                                                   reserved_( to_word( reserved ) )
+   {
+      size_.store( 0, std::memory_order_relaxed );
+      std::atomic_thread_fence( std::memory_order_release );
+   }
+
+   static K all_ones()
+   {
+      K out;
+      std::memset( &out, 0xff, sizeof( K ) );
+      return( out );
+   }
+
+   static std::size_t groups_for( const std::size_t capacity )
+   {
+      std::size_t groups( 1 );
+      while( groups * group_size < capacity )
+      {
+         groups <<= 1;
+      }
+      return( groups );
+   }
+
+   static std::size_t ctrl_offset()
+   {
+      return( ( sizeof( concurrent_map ) + SHM_CACHE_LINE_SIZE - 1 ) & ~std::size_t( SHM_CACHE_LINE_SIZE - 1 ) );
+   }
+
+   static std::size_t slot_offset( const std::size_t groups )
+   {
+      return( ( ctrl_offset() + groups * group_size + SHM_CACHE_LINE_SIZE - 1 ) &
+              ~std::size_t( SHM_CACHE_LINE_SIZE - 1 ) );
+   }
+
+   template < class T > static std::uint64_t to_word( const T &in )
+   {
+      std::uint64_t out( 0 );
+      std::memcpy( &out, &in, sizeof( T ) );
+      return( out );
+   }
+
+   template < class T > static T from_word( const std::uint64_t in )
+   {
+      T out;
+      std::memcpy( &out, &in, sizeof( T ) );
+      return( out );
+   }
+
+   /** hash - std::hash of an integer is itself, mix it (murmur3 finalizer) **/
+   static std::uint64_t hash( const K &key )
+   {
+      auto h( static_cast< std::uint64_t >( Hash()( key ) ) );
+      h ^= h >> 33;
+      h *= 0xff51afd7ed558ccdULL;
+      h ^= h >> 33;
+      h *= 0xc4ceb9fe1a85ec53ULL;
+      h ^= h >> 33;
+      return( h );
+   }
+
+   static std::uint8_t live_tag( const std::uint64_t h )
+   {
+      return( static_cast< std::uint8_t >( 0x80 | ( h & 0x7f ) ) );
+   }
+
+   static std::uint8_t dead_tag( const std::uint64_t h )
+   {
+      return( static_cast< std::uint8_t >( 0x40 | ( h & 0x3f ) ) );
+   }
+
+   /**
+    * match - bit i set where byte i of the group equals byte. A
+    * plain load of all 16, every hit is confirmed with an atomic
+    * load before anything is read from its slot.
+    */
+   static std::uint32_t match( const std::atomic< std::uint8_t > *group, const std::uint8_t byte )
+   {
+      const auto *bytes( reinterpret_cast< const std::uint8_t* >( group ) );
+#if defined( __SSE2__ )
+      const auto v( _mm_loadu_si128( reinterpret_cast< const __m128i* >( bytes ) ) );
+      return( static_cast< std::uint32_t >(
+         _mm_movemask_epi8( _mm_cmpeq_epi8( v, _mm_set1_epi8( static_cast< char >( byte ) ) ) ) ) );
+#else
+      std::uint32_t out( 0 );
+      for( std::size_t i( 0 ); i < group_size; i++ )
+      {
+         out |= static_cast< std::uint32_t >( bytes[ i ] == byte ) << i;
+      }
+      return( out );
+#endif
+   }
+
+   /**
+    * candidates - bit i set where byte i of the group is empty,
+    * writing, live or dead with key's tag, i.e., where key could
+    * be. One load for all four, a byte going from empty to live
+    * between two loads would be in neither match.
+    */
+   static std::uint32_t candidates( const std::atomic< std::uint8_t > *group,
+                                    const std::uint8_t                live,
+                                    const std::uint8_t                dead )
+   {
+#if defined( __SSE2__ )
+      const auto v( _mm_loadu_si128( reinterpret_cast< const __m128i* >( group ) ) );
+      const auto hit( _mm_or_si128(
+         _mm_or_si128( _mm_cmpeq_epi8( v, _mm_set1_epi8( static_cast< char >( live ) ) ),
+                       _mm_cmpeq_epi8( v, _mm_set1_epi8( static_cast< char >( dead ) ) ) ),
+         _mm_or_si128( _mm_cmpeq_epi8( v, _mm_set1_epi8( static_cast< char >( writing ) ) ),
+                       _mm_cmpeq_epi8( v, _mm_set1_epi8( static_cast< char >( empty ) ) ) ) ) );
+      return( static_cast< std::uint32_t >( _mm_movemask_epi8( hit ) ) );
+#else
+      std::uint32_t out( 0 );
+      for( std::size_t i( 0 ); i < group_size; i++ )
+      {
+         const auto byte( group[ i ].load( std::memory_order_relaxed ) );
+         out |= static_cast< std::uint32_t >( byte == live || byte == dead ||
+                                              byte == writing || byte == empty ) << i;
+      }
+      return( out );
+#endif
+   }
+
+   std::atomic< std::uint8_t >* ctrl() const
+   {
+      return( reinterpret_cast< std::atomic< std::uint8_t >* >(
+         reinterpret_cast< char* >( const_cast< concurrent_map* >( this ) ) + ctrl_offset() ) );
+   }
+
+   slot* slots() const
+   {
+      return( reinterpret_cast< slot* >(
+         reinterpret_cast< char* >( const_cast< concurrent_map* >( this ) ) + slot_offset( groups_ ) ) );
+   }
+
+   /** ends - group g has a slot no key ever took, probes stop here **/
+   bool ends( const std::size_t g ) const
+   {
+      for( auto hits( match( ctrl() + g * group_size, empty ) ); hits != 0; hits &= hits - 1 )
+      {
+         const auto index( g * group_size + static_cast< std::size_t >( __builtin_ctz( hits ) ) );
+         if( slots()[ index ].key.load( std::memory_order_acquire ) == 0 )
+         {
+            return( true );
+         }
+      }
+      return( false );
+   }
+
+   /** lookup - the live slot holding key, nullptr if there isn't one **/
+   const slot* lookup( const K &key ) const
+   {
+      const auto stored( to_word( key ) ^ reserved_ );
+      if( stored == 0 )
+      {
+         return( nullptr );
+      }
+      const auto h( hash( key ) );
+      const auto tag( live_tag( h ) );
+      const auto mask( groups_ - 1 );
+      auto g( ( h >> 7 ) & mask );
+      for( std::size_t probes( 0 ); probes < groups_; probes++, g = ( g + 1 ) & mask )
+      {
+         for( auto hits( match( ctrl() + g * group_size, tag ) ); hits != 0; hits &= hits - 1 )
+         {
+            const auto index( g * group_size + static_cast< std::size_t >( __builtin_ctz( hits ) ) );
+            if( ctrl()[ index ].load( std::memory_order_acquire ) == tag &&
+                slots()[ index ].key.load( std::memory_order_relaxed ) == stored )
+            {
+               return( &slots()[ index ] );
+            }
+         }
+         if( ends( g ) )
+         {
+            return( nullptr );
+         }
+      }
+      return( nullptr );
+   }
+
+   result put( const K &key, const V &value, const bool assign )
+   {
+      const auto stored( to_word( key ) ^ reserved_ );
+      if( stored == 0 )
+      {
+         return( result::invalid_key );
+      }
+      const auto h( hash( key ) );
+      const auto live( live_tag( h ) );
+      const auto dead( dead_tag( h ) );
+      const auto mask( groups_ - 1 );
+      auto g( ( h >> 7 ) & mask );
+      for( std::size_t probes( 0 ); probes < groups_; probes++, g = ( g + 1 ) & mask )
+      {
+         const auto *group( ctrl() + g * group_size );
+         /**
+          * slots in order, every inserter of a key walks the same
+          * ones and a key word is only ever set once, so they all
+          * meet at the same slot
+          */
+         for( auto hits( candidates( group, live, dead ) ); hits != 0; hits &= hits - 1 )
+         {
+            const auto index( g * group_size + static_cast< std::size_t >( __builtin_ctz( hits ) ) );
+            auto &s( slots()[ index ] );
+            auto current( s.key.load( std::memory_order_acquire ) );
+            if( current == 0 )
+            {
+               if( s.key.compare_exchange_strong( current, stored, std::memory_order_acq_rel ) )
+               {
+                  /** the control byte is ours until it's live **/
+                  s.value.store( to_word( value ), std::memory_order_relaxed );
+                  ctrl()[ index ].store( live, std::memory_order_release );
+                  size_.fetch_add( 1, std::memory_order_relaxed );
+                  return( result::inserted );
+               }
+            }
+            if( current == stored )
+            {
+               return( existing( index, live, dead, value, assign ) );
+            }
+         }
+      }
+      return( result::full );
+   }
+
+   /** existing - key already has the slot at index **/
+   result existing( const std::size_t  index,
+                    const std::uint8_t live,
+                    const std::uint8_t dead,
+                    const V            &value,
+                    const bool         assign )
+   {
+      auto &c( ctrl()[ index ] );
+      auto &s( slots()[ index ] );
+      for( ;; )
+      {
+         auto current( c.load( std::memory_order_acquire ) );
+         if( current == live )
+         {
+            if( assign )
+            {
+               s.value.store( to_word( value ), std::memory_order_release );
+            }
+            return( result::exists );
+         }
+         if( current == dead )
+         {
+            /** bring it back, losing this CAS means somebody else did **/
+            if( c.compare_exchange_strong( current, writing, std::memory_order_acq_rel ) )
+            {
+               s.value.store( to_word( value ), std::memory_order_relaxed );
+               c.store( live, std::memory_order_release );
+               size_.fetch_add( 1, std::memory_order_relaxed );
+               return( result::inserted );
+            }
+            continue;
+         }
+         /** another insert of key hasn't finished, it wins **/
+         return( result::exists );
+      }
+   }
+
+   /** read-only after create **/
+   alignas( SHM_CACHE_LINE_SIZE ) const std::uint64_t magic;
+   const std::uint32_t  key_size;
+   const std::uint32_t  value_size;
+   const std::uint64_t  groups_;
+   const std::uint64_t  reserved_;
+
+   alignas( SHM_CACHE_LINE_SIZE ) std::atomic< std::int64_t > size_;
+};
+
+#endif /* END _SHM_CONCURRENT_MAP_HPP_ */
@@ -0,0 +1,358 @@
+/**
+ * shm_futex.hpp -
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * @author: Jonathan Beard
+ * @version: Oct 18 2026
+ */
+#ifndef _SHM_FUTEX_HPP_
+#define _SHM_FUTEX_HPP_  1
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#include <shm>
+
+/**
+ * wait_policy - how a waiter spends its time before the thing it's
+ * waiting on happens.
+ *  spin     - never sleeps, lowest wake latency, burns the core
+ *  block    - sleeps in the kernel right away, no cpu while idle
+ *  adaptive - spins for up to spin_budget rounds then sleeps, each
+ *             primitive remembers how long recent waits took and
+ *             shortens the spin when spinning hasn't been paying off
+ */
+class shm::wait_policy
+{
+public:
+   enum mode_t : std::uint8_t
+   {
+      spin = 0,
+      block,
+      adaptive
+   };
+
+   static constexpr std::uint32_t default_spin_budget = 4096;
+
+   constexpr wait_policy( const mode_t mode = adaptive,
+                          const std::uint32_t spin_budget = default_spin_budget ) :
+      mode( mode ),
+      spin_budget( spin_budget )
+   {
+   }
+
+   mode_t          mode;
+   std::uint32_t   spin_budget;
+};
+
+/**
+ * futex - thin wrapper around FUTEX_WAIT/FUTEX_WAKE on a 32b word,
+ * the word has to be in a segment for it to work across processes
+ * (these are the shared, not the process private, futex ops). On
+ * platforms without futexes wait sleeps briefly and wake does
+ * nothing, everything built on top re-checks its condition so that
+ * is slower but still correct.
+ */
+class shm::futex
+{
+public:
+   futex()  = delete;
+   ~futex() = delete;
+
+   static_assert( sizeof( std::atomic< std::uint32_t > ) == sizeof( std::uint32_t ),
+                  "futex words have to be plain 32b integers" );
+
+   /**
+    * wait - sleeps while word == expected, returns on a wake,
+    * a signal, or if word already differs, callers re-check.
+    */
+   static void wait( std::atomic< std::uint32_t > &word, const std::uint32_t expected );
+
+   /**
+    * wait_for - same as wait but gives up after timeout_ns, for
+    * waiters that have to look around now and then (e.g., whether
+    * the owner of a lock is still alive).
+    */
+   static void wait_for( std::atomic< std::uint32_t > &word,
+                         const std::uint32_t expected,
+                         const std::uint64_t timeout_ns );
+
+   /** wake - wakes up to count processes waiting on word **/
+   static void wake( std::atomic< std::uint32_t > &word, const std::uint32_t count );
+
+   static void wake_all( std::atomic< std::uint32_t > &word );
+
+   /** relax - cpu hint for the body of a spin loop **/
+   static void relax()
+   {
+#if defined( __x86_64__ ) || defined( __i386__ )
+      __builtin_ia32_pause();
+#elif defined( __aarch64__ )
+      asm volatile( "yield" ::: "memory" );
+#endif
+   }
+
+   /**
+    * spin - spins on ready following policy, returns true as soon
+    * as ready does, false when it's time to block. spin mode never
+    * returns false. hint is the primitive's memory of how long
+    * recent spins took (adaptive only).
+    */
+   template < class Ready >
+   static bool spin( Ready &&ready,
+                     const wait_policy &policy,
+                     std::atomic< std::uint32_t > &hint )
+   {
+      if( ready() )
+      {
+         return( true );
+      }
+      switch( policy.mode )
+      {
+         case( wait_policy::block ):
+         {
+            return( false );
+         }
+         case( wait_policy::spin ):
+         {
+            for( std::uint32_t spins( 1 ); ! ready(); spins++ )
+            {
+               relax();
+               /** let whoever we're waiting on run if we share a core **/
+               if( ( spins & 0x3ff ) == 0 )
+               {
+                  std::this_thread::yield();
+               }
+            }
+            return( true );
+         }
+         default:
+         {
+            const auto limit( std::min( policy.spin_budget,
+                                        hint.load( std::memory_order_relaxed ) + min_spins ) );
+            for( std::uint32_t spins( 1 ); spins <= limit; spins++ )
+            {
+               relax();
+               if( ready() )
+               {
+                  /** it paid off, allow twice as long next time **/
+                  hint.store( std::min( policy.spin_budget, 2 * spins ),
+                              std::memory_order_relaxed );
+                  return( true );
+               }
+            }
+            hint.store( limit / 2, std::memory_order_relaxed );
+            return( false );
+         }
+      }
+   }
+
+private:
+   /** adaptive never spins less than this, a wake may be in flight **/
+   static constexpr std::uint32_t min_spins = 64;
+};
+
+/**
+ * event - manual reset flag, set() releases every current and future
+ * waiter until reset(). set() only makes a system call when some
+ * process is actually blocked. Construct in place inside a segment
+ * (all zero memory is an unset event).
+ */
+class shm::event
+{
+public:
+   event() = default;
+
+   event( const event &other ) = delete;
+   event& operator = ( const event &other ) = delete;
+
+   void set()
+   {
+      state.store( 1, std::memory_order_seq_cst );
+      if( waiters.load( std::memory_order_seq_cst ) != 0 )
+      {
+         futex::wake_all( state );
+      }
+   }
+
+   void reset()
+   {
+      state.store( 0, std::memory_order_release );
+   }
+
+   bool is_set() const
+   {
+      return( state.load( std::memory_order_acquire ) != 0 );
+   }
+
+   void wait( const wait_policy &policy = wait_policy() )
+   {
+      if( futex::spin( [&](){ return( is_set() ); }, policy, hint ) )
+      {
+         return;
+      }
+      waiters.fetch_add( 1, std::memory_order_seq_cst );
+      while( state.load( std::memory_order_seq_cst ) == 0 )
+      {
+         futex::wait( state, 0 );
+      }
+      waiters.fetch_sub( 1, std::memory_order_relaxed );
+   }
+
+private:
+   std::atomic< std::uint32_t > state   = { 0 };
+   std::atomic< std::uint32_t > waiters = { 0 };
+   std::atomic< std::uint32_t > hint    = { 0 };
+};
+
+/**
+ * semaphore - counting semaphore, post() only makes a system call
+ * when some process is blocked in wait(). Construct in place inside
+ * a segment (all zero memory is a semaphore with a count of zero).
+ */
+class shm::semaphore
+{
+public:
+   explicit semaphore( const std::uint32_t initial = 0 ) : count( initial ) {}
+
+   semaphore( const semaphore &other ) = delete;
+   semaphore& operator = ( const semaphore &other ) = delete;
+
+   void post( const std::uint32_t n = 1 )
+   {
+      count.fetch_add( n, std::memory_order_seq_cst );
+      if( waiters.load( std::memory_order_seq_cst ) != 0 )
+      {
+         futex::wake( count, n );
+      }
+   }
+
+   bool try_wait()
+   {
+      auto current( count.load( std::memory_order_relaxed ) );
+      while( current != 0 )
+      {
+         if( count.compare_exchange_weak( current,
+                                          current - 1,
+                                          std::memory_order_acquire,
+                                          std::memory_order_relaxed ) )
+         {
+            return( true );
+         }
+      }
+      return( false );
+   }
+
+   void wait( const wait_policy &policy = wait_policy() )
+   {
+      if( futex::spin( [&](){ return( try_wait() ); }, policy, hint ) )
+      {
+         return;
+      }
+      waiters.fetch_add( 1, std::memory_order_seq_cst );
+      while( ! try_wait() )
+      {
+         futex::wait( count, 0 );
+      }
+      waiters.fetch_sub( 1, std::memory_order_relaxed );
+   }
+
+   std::uint32_t value() const
+   {
+      return( count.load( std::memory_order_relaxed ) );
+   }
+
+private:
+   std::atomic< std::uint32_t > count;
+   std::atomic< std::uint32_t > waiters = { 0 };
+   std::atomic< std::uint32_t > hint    = { 0 };
+};
+
+/**
+ * condition - waits for a predicate over other shared state to
+ * become true, there is no mutex, the process that changes the
+ * state calls notify_one/notify_all afterwards. Every notify bumps
+ * a sequence number, a waiter that checked the predicate before the
+ * bump sleeps on the old number and so can't miss it. Construct in
+ * place inside a segment (all zero memory is fine).
+ *
+ * Typical use:
+ * waiter:   cond->wait( [&](){ return( q->size() > 0 ); } );
+ * notifier: q->push( x ); cond->notify_one();
+ */
+class shm::condition
+{
+public:
+   condition() = default;
+
+   condition( const condition &other ) = delete;
+   condition& operator = ( const condition &other ) = delete;
+
+   void notify_one()
+   {
+      notify( 1 );
+   }
+
+   void notify_all()
+   {
+      notify( 0 );
+   }
+
+   template < class Pred >
+   void wait( Pred &&pred, const wait_policy &policy = wait_policy() )
+   {
+      if( futex::spin( pred, policy, hint ) )
+      {
+         return;
+      }
+      waiters.fetch_add( 1, std::memory_order_seq_cst );
+      for( ;; )
+      {
+         const auto seen( sequence.load( std::memory_order_seq_cst ) );
+         if( pred() )
+         {
+            break;
+         }
+         futex::wait( sequence, seen );
+      }
+      waiters.fetch_sub( 1, std::memory_order_relaxed );
+   }
+
+private:
+   /** count of zero wakes everyone **/
+   void notify( const std::uint32_t count )
+   {
+      std::atomic_thread_fence( std::memory_order_seq_cst );
+      sequence.fetch_add( 1, std::memory_order_seq_cst );
+      if( waiters.load( std::memory_order_seq_cst ) != 0 )
+      {
+         if( count == 0 )
+         {
+            futex::wake_all( sequence );
+         }
+         else
+         {
+            futex::wake( sequence, count );
+         }
+      }
+   }
+
+   std::atomic< std::uint32_t > sequence   = { 0 };
+   std::atomic< std::uint32_t > waiters    = { 0 };
+   std::atomic< std::uint32_t > hint       = { 0 };
+};
+
+#endif /* END _SHM_FUTEX_HPP_ */
@@ -0,0 +1,196 @@
+/**
+ * shm_growth.hpp -
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * @author: Jonathan Beard
+ * @version: Oct 18 2026
+ */
+#ifndef _SHM_GROWTH_HPP_
+#define _SHM_GROWTH_HPP_  1
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstddef>
+#include <new>
+
+#include <shm>
+
+/**
+ * growth - header at the start of a segment that can grow. The
+ * process that owns the segment grows it with shm::resize and
+ * bumps the generation, everyone else compares the generation to
+ * the one they last saw whenever it suits them (e.g., once per
+ * batch) and remaps only then, nobody has to stop. Until they do
+ * their old mapping stays valid, the segment never shrinks under
+ * them. One process grows the segment.
+ *
+ * Typical use:
+ * void *mem = shm::init( key, shm::growth::required_bytes( n ) );
+ * shm::growth::create( mem, shm::growth::required_bytes( n ) );
+ * shm::growth::grow( key, &mem, shm::growth::required_bytes( 2 * n ) );
+ * ...other process...
+ * void *mem = shm::open( key );
+ * std::uint64_t seen( shm::growth::attach( mem )->generation() );
+ * auto *header = shm::growth::refresh( &mem, seen );
+ */
+class shm::growth
+{
+public:
+   static_assert( ATOMIC_LLONG_LOCK_FREE == 2,
+                  "growth needs address-free 64b atomics to work across processes" );
+
+   growth( const growth &other ) = delete;
+   growth& operator = ( const growth &other ) = delete;
+
+   /**
+    * required_bytes - segment size (for shm::init or grow) that
+    * leaves data_bytes after the header.
+    */
+   static constexpr std::size_t required_bytes( const std::size_t data_bytes )
+   {
+      return( sizeof( growth ) + data_bytes );
+   }
+
+   /**
+    * create - builds the header at mem, the start of a segment of
+    * nbytes (what was passed to shm::init).
+    */
+   static growth* create( void *mem, const std::size_t nbytes )
+   {
+      return( new ( mem ) growth( nbytes ) );
+   }
+
+   /**
+    * attach - returns the header another process built at mem.
+    * @return  growth* - throws or returns nullptr if mem doesn't
+    *                    start with one
+    */
+   static growth* attach( void *mem )
+   {
+      auto *header( reinterpret_cast< growth* >( mem ) );
+      if( mem == nullptr || header->magic != growth_magic )
+      {
+#if USE_CPP_EXCEPTIONS==1
+         throw invalid_segment_exception( "segment doesn't start with a growth header" );
+#else
+         return( nullptr );
+#endif
+      }
+      return( header );
+   }
+
+   /**
+    * grow - owner side, resizes the segment behind key to nbytes,
+    * remaps *ptr and then publishes the new size and generation.
+    * @param   key - key of the segment
+    * @param   ptr - start of the owner's mapping, updated if the
+    *                mapping moved
+    * @param   nbytes - new segment size, no smaller than size()
+    * @return  growth* - header in the new mapping, nullptr with
+    *                    errno set if it couldn't grow
+    */
+   template < class Backend = shm::default_backend >
+   static growth* grow( const typename Backend::key_type &key,
+                        void                             **ptr,
+                        const std::size_t                nbytes )
+   {
+      auto *header( attach( *ptr ) );
+      if( header == nullptr )
+      {
+         errno = EINVAL;
+         return( nullptr );
+      }
+      if( nbytes < header->size() )
+      {
+         errno = EINVAL;
+         return( nullptr );
+      }
+      if( ! shm::resize< Backend >( key, ptr, nbytes ) )
+      {
+         return( nullptr );
+      }
+      header = reinterpret_cast< growth* >( *ptr );
+      header->bytes.store( nbytes, std::memory_order_relaxed );
+      header->gen.fetch_add( 1, std::memory_order_release );
+      return( header );
+   }
+
+   /**
+    * refresh - attacher side, remaps *ptr if the generation moved
+    * past seen and the mapping is now too small, then updates seen.
+    * Costs one load when nothing changed.
+    * @param   ptr - start of this process' mapping, updated if
+    *                the mapping moved
+    * @param   seen - generation this mapping is good for
+    * @return  growth* - header in the current mapping, nullptr
+    *                    with errno set if the remap failed
+    */
+   static growth* refresh( void **ptr, std::uint64_t &seen )
+   {
+      auto *header( reinterpret_cast< growth* >( *ptr ) );
+      const auto now( header->gen.load( std::memory_order_acquire ) );
+      if( now == seen )
+      {
+         return( header );
+      }
+      const auto nbytes( header->bytes.load( std::memory_order_relaxed ) );
+      if( shm::get_mapped_size( *ptr ) < nbytes && ! shm::remap( ptr, nbytes ) )
+      {
+         return( nullptr );
+      }
+      seen = now;
+      return( reinterpret_cast< growth* >( *ptr ) );
+   }
+
+   /** generation - bumped once per grow **/
+   std::uint64_t generation() const
+   {
+      return( gen.load( std::memory_order_acquire ) );
+   }
+
+   /** size - segment size as of the last grow, header included **/
+   std::size_t size() const
+   {
+      return( bytes.load( std::memory_order_acquire ) );
+   }
+
+   /** data - first byte after the header, cache line aligned **/
+   void* data()
+   {
+      return( reinterpret_cast< char* >( this ) + sizeof( growth ) );
+   }
+
+   /** data_bytes - bytes after the header as of the last grow **/
+   std::size_t data_bytes() const
+   {
+      return( size() - sizeof( growth ) );
+   }
+
+private:
+   static constexpr std::uint64_t growth_magic = 0x67726f7774686864ULL;
+
+   explicit growth( const std::size_t nbytes ) : magic( growth_magic )
+   {
+      gen.store( 0, std::memory_order_relaxed );
+      bytes.store( nbytes, std::memory_order_relaxed );
+      std::atomic_thread_fence( std::memory_order_release );
+   }
+
+   alignas( SHM_CACHE_LINE_SIZE ) const std::uint64_t magic;
+   std::atomic< std::uint64_t >  gen;
+   std::atomic< std::uint64_t >  bytes;
+};
+
+#endif /* END _SHM_GROWTH_HPP_ */
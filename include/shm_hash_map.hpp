@@ -0,0 +1,383 @@
+/**
+ * shm_hash_map.hpp -
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * @author: Jonathan Beard
+ * @version: Oct 18 2026
+ */
+#ifndef _SHM_HASH_MAP_HPP_
+#define _SHM_HASH_MAP_HPP_  1
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <shm>
+#include <shm_arena.hpp>
+#include <shm_offset_ptr.hpp>
+
+/**
+ * hash_map - open addressing (linear probing, backward shift
+ * deletes so there are no tombstones) map whose table comes from
+ * an shm::arena, same rules as shm::vector: the map has to live in
+ * the arena's segment to be used by other processes and isn't
+ * thread safe. Keys and values may hold offset_ptrs, e.g.,
+ * shm::hash_map< shm::string, shm::vector< int > >.
+ *
+ * Hash has to give the same answer in every process, so nothing
+ * that hashes an address. find/erase take anything Hash and
+ * KeyEqual accept, std::hash< shm::string > takes const char* and
+ * std::string and std::equal_to<> compares them.
+ *
+ * Without exceptions, the calls that allocate report failure
+ * (nullptr/false) when the arena is full and leave the map as it was.
+ */
+template < class K, class V, class Hash, class KeyEqual > class shm::hash_map
+{
+public:
+   using key_type       = K;
+   using mapped_type    = V;
+   using size_type      = std::size_t;
+
+   struct value_type
+   {
+      template < class KK, class... Args >
+      value_type( KK &&key, Args&&... args ) : first( std::forward< KK >( key ) ),
+                                               second( std::forward< Args >( args )... )
+      {
+      }
+
+      value_type( value_type &&other ) = default;
+
+      K first;
+      V second;
+   };
+
+   static_assert( alignof( value_type ) <= arena::alignment,
+                  "hash_map entries can't be aligned wider than the arena's blocks" );
+
+   template < bool Const > class basic_iterator
+   {
+   public:
+      using entry_t = typename std::conditional< Const, const value_type, value_type >::type;
+
+      basic_iterator( entry_t *entries, const std::uint8_t *used,
+                      const size_type index, const size_type capacity ) : entries( entries ),
+                                                                          used( used ),
+                                                                          index( index ),
+                                                                          capacity( capacity )
+      {
+         skip();
+      }
+
+      entry_t& operator * () const { return( entries[ index ] ); }
+      entry_t* operator -> () const { return( &entries[ index ] ); }
+
+      basic_iterator& operator ++ ()
+      {
+         index++;
+         skip();
+         return( *this );
+      }
+
+      bool operator == ( const basic_iterator &other ) const { return( index == other.index ); }
+      bool operator != ( const basic_iterator &other ) const { return( index != other.index ); }
+
+   private:
+      void skip()
+      {
+         while( index < capacity && used[ index ] == 0 )
+         {
+            index++;
+         }
+      }
+
+      entry_t              *entries;
+      const std::uint8_t   *used;
+      size_type            index;
+      size_type            capacity;
+   };
+
+   using iterator       = basic_iterator< false >;
+   using const_iterator = basic_iterator< true >;
+
+   explicit hash_map( arena *a ) : a( a ) {}
+
+   hash_map( const hash_map &other ) = delete;
+   hash_map& operator = ( const hash_map &other ) = delete;
+
+   hash_map( hash_map &&other ) noexcept : a( other.a ),
+                                           entries( other.entries ),
+                                           size_( other.size_ ),
+                                           capacity_( other.capacity_ ),
+                                           shift( other.shift )
+   {
+      other.forget();
+   }
+
+   hash_map& operator = ( hash_map &&other ) noexcept
+   {
+      if( this != &other )
+      {
+         release();
+         a           = other.a;
+         entries     = other.entries;
+         size_       = other.size_;
+         capacity_   = other.capacity_;
+         shift       = other.shift;
+         other.forget();
+      }
+      return( *this );
+   }
+
+   ~hash_map()
+   {
+      release();
+   }
+
+   size_type size() const noexcept     { return( size_ ); }
+   size_type capacity() const noexcept { return( capacity_ ); }
+   bool empty() const noexcept         { return( size_ == 0 ); }
+   arena* get_arena() const noexcept   { return( a.get() ); }
+
+   iterator begin()              { return( iterator( table(), used(), 0, capacity_ ) ); }
+   iterator end()                { return( iterator( table(), used(), capacity_, capacity_ ) ); }
+   const_iterator begin() const  { return( const_iterator( table(), used(), 0, capacity_ ) ); }
+   const_iterator end() const    { return( const_iterator( table(), used(), capacity_, capacity_ ) ); }
+
+   /**
+    * find - returns the value stored under key or nullptr.
+    */
+   template < class Q > V* find( const Q &key )
+   {
+      const auto index( lookup( key ) );
+      return( index == capacity_ ? nullptr : &table()[ index ].second );
+   }
+
+   template < class Q > const V* find( const Q &key ) const
+   {
+      const auto index( lookup( key ) );
+      return( index == capacity_ ? nullptr : &table()[ index ].second );
+   }
+
+   template < class Q > bool contains( const Q &key ) const
+   {
+      return( lookup( key ) != capacity_ );
+   }
+
+   /**
+    * try_emplace - builds V from args under key if key isn't
+    * already there.
+    * @return pair - value now stored under key and true if it was
+    * inserted, ( nullptr, false ) if the arena is full
+    */
+   template < class KK, class... Args > std::pair< V*, bool > try_emplace( KK &&key, Args&&... args )
+   {
+      const auto index( lookup( key ) );
+      if( index != capacity_ )
+      {
+         return( std::make_pair( &table()[ index ].second, false ) );
+      }
+      if( ( size_ + 1 ) * 8 > capacity_ * 7 && ! reserve( capacity_ == 0 ? 8 : capacity_ * 2 ) )
+      {
+         return( std::make_pair( nullptr, false ) );
+      }
+      const auto slot( free_slot( key ) );
+      auto *entry( new ( &table()[ slot ] ) value_type( std::forward< KK >( key ),
+                                                         std::forward< Args >( args )... ) );
+      used()[ slot ] = 1;
+      size_++;
+      return( std::make_pair( &entry->second, true ) );
+   }
+
+   template < class KK, class VV > std::pair< V*, bool > insert( KK &&key, VV &&value )
+   {
+      return( try_emplace( std::forward< KK >( key ), std::forward< VV >( value ) ) );
+   }
+
+   /**
+    * erase - removes key, later entries of the same probe run are
+    * shifted back so lookups never have to skip holes.
+    * @return bool - false if key wasn't there
+    */
+   template < class Q > bool erase( const Q &key )
+   {
+      auto hole( lookup( key ) );
+      if( hole == capacity_ )
+      {
+         return( false );
+      }
+      auto *t( table() );
+      auto *u( used() );
+      const auto mask( capacity_ - 1 );
+      t[ hole ].~value_type();
+      u[ hole ] = 0;
+      for( auto next( ( hole + 1 ) & mask ); u[ next ] != 0; next = ( next + 1 ) & mask )
+      {
+         const auto home( slot_of( t[ next ].first ) );
+         /** only move it if the hole is between its home and here **/
+         if( ( ( next - home ) & mask ) >= ( ( next - hole ) & mask ) )
+         {
+            new ( &t[ hole ] ) value_type( std::move( t[ next ] ) );
+            t[ next ].~value_type();
+            u[ hole ] = 1;
+            u[ next ] = 0;
+            hole      = next;
+         }
+      }
+      size_--;
+      return( true );
+   }
+
+   void clear()
+   {
+      auto *t( table() );
+      auto *u( used() );
+      for( size_type i( 0 ); i < capacity_; i++ )
+      {
+         if( u[ i ] != 0 )
+         {
+            t[ i ].~value_type();
+            u[ i ] = 0;
+         }
+      }
+      size_ = 0;
+   }
+
+   /**
+    * reserve - grows the table to at least n slots (rounded up to a
+    * power of two), rehashing everything already in it.
+    * @return bool - false if the arena is out of space
+    */
+   bool reserve( const size_type n )
+   {
+      if( n <= capacity_ )
+      {
+         return( true );
+      }
+      size_type slots( 8 );
+      std::uint32_t bits( 3 );
+      while( slots < n )
+      {
+         slots <<= 1;
+         bits++;
+      }
+      auto *fresh( reinterpret_cast< value_type* >(
+         a->allocate( slots * sizeof( value_type ) + slots ) ) );
+      if( fresh == nullptr )
+      {
+         return( false );
+      }
+      std::memset( reinterpret_cast< std::uint8_t* >( fresh + slots ), 0, slots );
+      auto *old( table() );
+      auto *old_used( used() );
+      const auto old_capacity( capacity_ );
+      entries     = fresh;
+      capacity_   = slots;
+      shift       = 64 - bits;
+      for( size_type i( 0 ); i < old_capacity; i++ )
+      {
+         if( old_used[ i ] != 0 )
+         {
+            const auto slot( free_slot( old[ i ].first ) );
+            new ( &table()[ slot ] ) value_type( std::move( old[ i ] ) );
+            used()[ slot ] = 1;
+            old[ i ].~value_type();
+         }
+      }
+      a->deallocate( old );
+      return( true );
+   }
+
+private:
+   value_type* table() const noexcept
+   {
+      return( entries.get() );
+   }
+
+   /** one byte per slot right after the entries, non-zero is full **/
+   std::uint8_t* used() const noexcept
+   {
+      return( reinterpret_cast< std::uint8_t* >( table() + capacity_ ) );
+   }
+
+   /** fibonacci hashing, spreads out weak hashes like std::hash< int > **/
+   template < class Q > size_type slot_of( const Q &key ) const
+   {
+      const auto h( static_cast< std::uint64_t >( Hash()( key ) ) );
+      return( static_cast< size_type >( ( h * 0x9e3779b97f4a7c15ULL ) >> shift ) );
+   }
+
+   /** lookup - slot holding key or capacity_ if it isn't here **/
+   template < class Q > size_type lookup( const Q &key ) const
+   {
+      if( size_ == 0 )
+      {
+         return( capacity_ );
+      }
+      const auto *t( table() );
+      const auto *u( used() );
+      const auto mask( capacity_ - 1 );
+      for( auto i( slot_of( key ) ); u[ i ] != 0; i = ( i + 1 ) & mask )
+      {
+         if( KeyEqual()( t[ i ].first, key ) )
+         {
+            return( i );
+         }
+      }
+      return( capacity_ );
+   }
+
+   /** free_slot - first empty slot of key's probe run **/
+   template < class Q > size_type free_slot( const Q &key ) const
+   {
+      const auto *u( used() );
+      const auto mask( capacity_ - 1 );
+      auto i( slot_of( key ) );
+      while( u[ i ] != 0 )
+      {
+         i = ( i + 1 ) & mask;
+      }
+      return( i );
+   }
+
+   void forget() noexcept
+   {
+      entries     = nullptr;
+      size_       = 0;
+      capacity_   = 0;
+   }
+
+   void release()
+   {
+      if( entries )
+      {
+         clear();
+         a->deallocate( table() );
+         forget();
+      }
+   }
+
+   offset_ptr< arena >        a;
+   offset_ptr< value_type >   entries;
+   size_type                  size_       = 0;
+   size_type                  capacity_   = 0;
+   std::uint32_t              shift       = 64;
+};
+
+#endif /* END _SHM_HASH_MAP_HPP_ */
@@ -0,0 +1,340 @@
+/**
+ * shm_lock.hpp -
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * @author: Jonathan Beard
+ * @version: Oct 18 2026
+ */
+#ifndef _SHM_LOCK_HPP_
+#define _SHM_LOCK_HPP_  1
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <sys/types.h>
+
+#include <shm>
+#include <shm_futex.hpp>
+
+/**
+ * Process-shared locks that live inside a segment and survive the
+ * death of a process holding them. Each one records the thread id
+ * of its holder, a waiter that has been stuck for a while checks
+ * whether that thread still exists (kill( tid, 0 )) and takes the
+ * lock over if it doesn't, reporting owner_died so the new holder
+ * knows the protected data may be half updated. Thread ids are only
+ * meaningful inside one pid namespace, a holder whose process is a
+ * zombie counts as alive until its parent reaps it, and a dead
+ * holder's id that gets reused before anybody looks keeps the lock
+ * held.
+ *
+ * All three are constructed in place inside a segment, all zero
+ * memory is an unlocked lock with empty statistics.
+ */
+
+/**
+ * lock_stats - contention counters kept by each lock. Only
+ * acquisitions that had to wait read the clock, their wait times go
+ * in a log2 histogram, bucket i counts waits of [ 2^i, 2^(i+1) ) ns.
+ */
+class shm::lock_stats
+{
+public:
+   static constexpr std::size_t buckets = 32;
+
+   lock_stats() = default;
+
+   lock_stats( const lock_stats &other ) = delete;
+   lock_stats& operator = ( const lock_stats &other ) = delete;
+
+   /** acquired - successful acquisitions, contended or not **/
+   std::uint64_t acquired() const
+   {
+      return( acquired_.load( std::memory_order_relaxed ) );
+   }
+
+   /** contended - acquisitions that had to wait **/
+   std::uint64_t contended() const
+   {
+      return( contended_.load( std::memory_order_relaxed ) );
+   }
+
+   /** wait_ns - total time spent waiting by contended acquisitions **/
+   std::uint64_t wait_ns() const
+   {
+      return( wait_ns_.load( std::memory_order_relaxed ) );
+   }
+
+   /** owner_deaths - holders (or readers) found dead and recovered from **/
+   std::uint64_t owner_deaths() const
+   {
+      return( deaths.load( std::memory_order_relaxed ) );
+   }
+
+   /** waits - contended acquisitions in bucket, the last one is open ended **/
+   std::uint64_t waits( const std::size_t bucket ) const
+   {
+      return( bucket < buckets ? histogram[ bucket ].load( std::memory_order_relaxed ) : 0 );
+   }
+
+   /** reset - zeroes everything, counts in flight may be lost **/
+   void reset();
+
+private:
+   friend class robust_mutex;
+   friend class rwlock;
+   friend class ticket_lock;
+
+   /**
+    * record - one acquisition, since is when the wait started or 0
+    * if there wasn't one. exclusive callers hold the lock so they
+    * skip the atomic read-modify-writes.
+    */
+   void record( const std::uint64_t since, const bool exclusive );
+   void died();
+
+   std::atomic< std::uint64_t > acquired_   = { 0 };
+   std::atomic< std::uint64_t > contended_  = { 0 };
+   std::atomic< std::uint64_t > wait_ns_    = { 0 };
+   std::atomic< std::uint64_t > deaths      = { 0 };
+   std::atomic< std::uint64_t > histogram[ buckets ] = {};
+};
+
+/**
+ * robust_mutex - futex mutex, the word holds the holder's thread id
+ * plus waiter and owner died bits, the same layout as a kernel
+ * robust futex. Uncontended lock and unlock are a single CAS and
+ * exchange. Owner death follows pthread robust mutexes: lock()
+ * returns owner_died to whoever takes the lock over, call
+ * consistent() once the data is repaired, unlocking without it
+ * leaves the mutex not_recoverable for good.
+ */
+class shm::robust_mutex
+{
+public:
+   enum class status : std::uint8_t
+   {
+      ok = 0,
+      busy,
+      owner_died,
+      not_recoverable
+   };
+
+   robust_mutex() = default;
+
+   robust_mutex( const robust_mutex &other ) = delete;
+   robust_mutex& operator = ( const robust_mutex &other ) = delete;
+
+   /**
+    * lock - acquires, waiting as policy says. Returns ok or
+    * owner_died with the lock held, not_recoverable without it.
+    */
+   status lock( const wait_policy &policy = wait_policy() );
+
+   /** try_lock - ok, busy or not_recoverable, doesn't check for a dead holder **/
+   status try_lock();
+
+   /** consistent - marks the data repaired after owner_died **/
+   void consistent();
+
+   void unlock();
+
+   /** owner - thread id of the holder, 0 if there isn't one **/
+   pid_t owner() const;
+
+   const lock_stats& stats() const
+   {
+      return( stats_ );
+   }
+
+   lock_stats& stats()
+   {
+      return( stats_ );
+   }
+
+private:
+   /** try_acquire - true when done, out says how **/
+   bool try_acquire( const std::uint32_t me,
+                     const std::uint32_t bits,
+                     status &out,
+                     const bool probe );
+
+   alignas( SHM_CACHE_LINE_SIZE ) std::atomic< std::uint32_t > word = { 0 };
+   std::atomic< std::uint32_t > hint = { 0 };
+
+   alignas( SHM_CACHE_LINE_SIZE ) lock_stats stats_;
+};
+
+/**
+ * rwlock - reader-writer lock that favors readers, a reader only
+ * waits for a writer that is already in, never for one that is
+ * waiting, so writers wait for a moment without readers. Every
+ * reader holds a slot with its thread id, each on its own cache
+ * line so readers don't contend, and a writer stuck behind a reader
+ * that died clears its slot. A writer that dies holding the lock
+ * makes the next read_lock and write_lock return owner_died until a
+ * writer gets in and unlocks, a writer is expected to repair the
+ * data before it does. With max_readers readers in, more wait.
+ */
+class shm::rwlock
+{
+public:
+   using status = robust_mutex::status;
+
+   static constexpr std::size_t max_readers = 32;
+
+   rwlock() = default;
+
+   rwlock( const rwlock &other ) = delete;
+   rwlock& operator = ( const rwlock &other ) = delete;
+
+   /** read_lock - ok or owner_died, shared with other readers **/
+   status read_lock( const wait_policy &policy = wait_policy() );
+
+   /** try_read_lock - busy if a writer is in or every slot is taken **/
+   status try_read_lock();
+
+   void read_unlock();
+
+   /** write_lock - ok or owner_died, exclusive **/
+   status write_lock( const wait_policy &policy = wait_policy() );
+
+   /** try_write_lock - busy if anybody holds the lock **/
+   status try_write_lock();
+
+   void write_unlock();
+
+   /** readers - approximate number of readers holding the lock **/
+   std::size_t readers() const;
+
+   const lock_stats& read_stats() const
+   {
+      return( read_stats_ );
+   }
+
+   const lock_stats& write_stats() const
+   {
+      return( write_stats_ );
+   }
+
+   lock_stats& read_stats()
+   {
+      return( read_stats_ );
+   }
+
+   lock_stats& write_stats()
+   {
+      return( write_stats_ );
+   }
+
+private:
+   struct alignas( SHM_CACHE_LINE_SIZE ) slot
+   {
+      std::atomic< pid_t > tid = { 0 };
+   };
+
+   /** claim - takes a reader slot for me, false if none is free **/
+   bool claim( const pid_t me );
+   void unclaim( const pid_t me );
+   /** drained - true if no reader holds a slot, probe reclaims dead ones **/
+   bool drained( const bool probe );
+   /** wait_writer - waits while a writer is in, returns the writer word **/
+   std::uint32_t wait_writer( const wait_policy &policy, std::uint64_t &since );
+   /** gone - true if no writer is in, probe recovers from a dead one **/
+   bool gone( std::uint32_t &w, const bool probe );
+   /** take - becomes the one writer, not yet in **/
+   bool take( const std::uint32_t me,
+              const std::uint32_t bits,
+              std::uint32_t &died,
+              const bool probe );
+
+   /** holder tid with waiter, owner died and writer in bits **/
+   alignas( SHM_CACHE_LINE_SIZE ) std::atomic< std::uint32_t > writer = { 0 };
+   /** bumped by readers leaving while a writer sleeps on it **/
+   std::atomic< std::uint32_t > leaving  = { 0 };
+   std::atomic< std::uint32_t > sleeping = { 0 };
+   std::atomic< std::uint32_t > hint     = { 0 };
+
+   slot slots[ max_readers ];
+
+   alignas( SHM_CACHE_LINE_SIZE ) lock_stats read_stats_;
+   alignas( SHM_CACHE_LINE_SIZE ) lock_stats write_stats_;
+};
+
+/**
+ * ticket_lock - fair lock, processes get in in the order they
+ * arrived. Each waiter records its ticket and thread id in one of
+ * max_waiters slots, if the holder of the current ticket died (or
+ * died before its turn came) the next waiter moves the lock past it
+ * and gets owner_died. Beyond max_waiters queued processes, or if
+ * one is killed in the instant between taking its ticket and
+ * recording it, a death isn't recovered from.
+ */
+class shm::ticket_lock
+{
+public:
+   using status = robust_mutex::status;
+
+   static constexpr std::size_t max_waiters = 64;
+
+   ticket_lock() = default;
+
+   ticket_lock( const ticket_lock &other ) = delete;
+   ticket_lock& operator = ( const ticket_lock &other ) = delete;
+
+   /** lock - ok or owner_died, in arrival order **/
+   status lock( const wait_policy &policy = wait_policy() );
+
+   /** try_lock - busy unless the lock is free with nobody queued **/
+   status try_lock();
+
+   void unlock();
+
+   /** queued - processes holding or waiting for the lock **/
+   std::uint32_t queued() const
+   {
+      return( ( next.load( std::memory_order_relaxed ) -
+                ( serving.load( std::memory_order_relaxed ) & ~std::uint32_t( 1 ) ) ) / 2 );
+   }
+
+   const lock_stats& stats() const
+   {
+      return( stats_ );
+   }
+
+   lock_stats& stats()
+   {
+      return( stats_ );
+   }
+
+private:
+   /** turn - true once ticket is served, probe skips dead holders **/
+   bool turn( const std::uint32_t ticket, const bool probe );
+   status served( const std::uint64_t since );
+
+   /** tickets are even, they step by two **/
+   alignas( SHM_CACHE_LINE_SIZE ) std::atomic< std::uint32_t > next = { 0 };
+
+   /** ticket being served, the low bit set if its holder inherited from a dead one **/
+   alignas( SHM_CACHE_LINE_SIZE ) std::atomic< std::uint32_t > serving  = { 0 };
+   std::atomic< std::uint32_t > sleepers = { 0 };
+   std::atomic< std::uint32_t > hint     = { 0 };
+
+   /** [ ticket : 32 ][ tid : 32 ] of recent tickets **/
+   alignas( SHM_CACHE_LINE_SIZE ) std::atomic< std::uint64_t > holders[ max_waiters ] = {};
+
+   alignas( SHM_CACHE_LINE_SIZE ) lock_stats stats_;
+};
+
+#endif /* END _SHM_LOCK_HPP_ */
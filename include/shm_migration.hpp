@@ -0,0 +1,150 @@
+/**
+ * shm_migration.hpp -
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * @author: Jonathan Beard
+ * @version: Oct 18 2026
+ */
+#ifndef _SHM_MIGRATION_HPP_
+#define _SHM_MIGRATION_HPP_  1
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <shm>
+
+/**
+ * migration - moves the pages of a mapping to one NUMA node, a
+ * chunk of pages at a time. Each chunk first asks the kernel where
+ * its pages are and then moves only the ones that aren't on the
+ * target yet, so memory use is bounded by the chunk size no matter
+ * how big the mapping is and a cancel takes effect within a chunk.
+ * run() works on the calling thread, start() on a background one
+ * that wait() joins, progress() can be polled from anywhere.
+ *
+ * Typical use:
+ * shm::migration m( ptr, nbytes, node );
+ * m.start();
+ * ...do something else, maybe m.cancel()...
+ * const auto &r( m.wait() );
+ */
+class shm::migration
+{
+public:
+   /** pages per chunk, 512 base pages is 2MiB **/
+   static constexpr std::size_t default_chunk_pages = 512;
+
+   /** what happened to each page of the range **/
+   struct result
+   {
+      /** pages moved to the target, indexed by the node they were on **/
+      std::vector< std::size_t >  moved_from;
+      /** pages that were on the target already **/
+      std::size_t                 already_there  = 0;
+      /** pages nobody has touched yet, nothing to move **/
+      std::size_t                 not_present    = 0;
+      /** pages the kernel couldn't move (busy, pinned, no memory) **/
+      std::size_t                 failed         = 0;
+      /** pages never looked at because of cancel() **/
+      std::size_t                 skipped        = 0;
+      bool                        cancelled      = false;
+      /** errno of a call that failed outright, 0 otherwise **/
+      int                         error          = 0;
+
+      std::size_t moved() const
+      {
+         std::size_t total( 0 );
+         for( const auto pages : moved_from )
+         {
+            total += pages;
+         }
+         return( total );
+      }
+   };
+
+   /**
+    * migration - nothing moves until run() or start().
+    * @param   ptr - start of the range, aligned to the page size of
+    *                the mapping (see shm::get_page_size)
+    * @param   nbytes - length of the range
+    * @param   target_node - NUMA node the pages should end up on
+    * @param   chunk_pages - pages handled per step
+    * @exception page_alignment_exception if ptr isn't aligned,
+    *            without exceptions the result's error is EINVAL
+    */
+   migration( void               *ptr,
+              const std::size_t  nbytes,
+              const int          target_node,
+              const std::size_t  chunk_pages = default_chunk_pages );
+
+   /** cancels and waits for a background migration **/
+   ~migration();
+
+   migration( const migration &other ) = delete;
+   migration& operator = ( const migration &other ) = delete;
+
+   /**
+    * run - migrates the whole range on the calling thread.
+    * @return  bool - false if run() or start() was already called,
+    *                 a migration only goes once
+    */
+   bool run();
+
+   /** start - migrates the whole range on a background thread, false as for run **/
+   bool start();
+
+   /** cancel - stops after the chunk in flight, safe from any thread **/
+   void cancel();
+
+   /** bytes_done - how much of the range has been handled so far **/
+   std::size_t bytes_done() const;
+
+   /** progress - bytes_done as a fraction of the range, 0 to 1 **/
+   double progress() const;
+
+   bool done() const;
+
+   /** wait - joins the background thread (if any), returns the result **/
+   const result& wait();
+
+private:
+   /** migrate_all - body of run and of start's thread **/
+   void migrate_all();
+   void migrate_chunk( const std::size_t first, const std::size_t count );
+
+   char                          *base;
+   std::size_t                   page_size;
+   std::size_t                   num_pages;
+   int                           target;
+   std::size_t                   chunk_pages;
+
+   std::atomic< std::size_t >    pages_done  = { 0 };
+   std::atomic< bool >           stop        = { false };
+   std::atomic< bool >           finished    = { false };
+   /** set by the first run() or start(), both back off after that **/
+   std::atomic< bool >           started     = { false };
+   std::thread                   worker;
+   result                        out;
+
+   /** reused for every chunk, chunk_pages long **/
+   std::vector< void* >          pages;
+   std::vector< int >            nodes;
+   std::vector< int >            status;
+   std::vector< int >            source;
+};
+
+#endif /* END _SHM_MIGRATION_HPP_ */
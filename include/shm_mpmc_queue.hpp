@@ -0,0 +1,429 @@
+/**
+ * shm_mpmc_queue.hpp -
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * @author: Jonathan Beard
+ * @version: Oct 18 2026
+ */
+#ifndef _SHM_MPMC_QUEUE_HPP_
+#define _SHM_MPMC_QUEUE_HPP_  1
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <shm>
+
+/**
+ * mpmc_queue - bounded multi-producer, multi-consumer FIFO built
+ * inside of a segment from shm::init. Each slot carries a sequence
+ * number that says which position it is ready for (Vyukov's bounded
+ * queue), there are no locks.
+ *
+ * Unlike the textbook version a slot is claimed before the shared
+ * position is advanced, the claim is a marker in the sequence word
+ * that records producer/consumer, the position and the pid of the
+ * claimer. Anyone who runs into a marker helps advance the shared
+ * position, and if the claimer's process is gone the slot is
+ * released, so a process that dies mid push/pop doesn't wedge the
+ * queue. The item it was pushing or popping is lost. Liveness is
+ * checked with kill( pid, 0 ) so processes need to be in the same
+ * pid namespace.
+ *
+ * Typical use:
+ * void *mem = shm::init( key, shm::mpmc_queue< T >::required_bytes( n ) );
+ * auto *q   = shm::mpmc_queue< T >::create( mem, n );
+ * ...other processes...
+ * auto *q   = shm::mpmc_queue< T >::attach( shm::open( key ) );
+ */
+template < class T > class shm::mpmc_queue
+{
+public:
+   static_assert( std::is_trivially_copyable< T >::value,
+                  "mpmc_queue elements are copied between processes as bytes" );
+   static_assert( alignof( T ) <= SHM_CACHE_LINE_SIZE,
+                  "mpmc_queue elements can't be aligned wider than a cache line" );
+   static_assert( ATOMIC_LLONG_LOCK_FREE == 2,
+                  "mpmc_queue needs address-free 64b atomics to work across processes" );
+
+   mpmc_queue( const mpmc_queue &other ) = delete;
+   mpmc_queue& operator = ( const mpmc_queue &other ) = delete;
+
+   /**
+    * required_bytes - number of bytes a segment needs to hold
+    * a queue of at least capacity items.
+    * @param   capacity - requested number of items, rounded up
+    * to a power of two (minimum 2).
+    * @return  std::size_t - bytes to pass to shm::init
+    */
+   static std::size_t required_bytes( const std::size_t capacity )
+   {
+      return( sizeof( mpmc_queue ) + round_capacity( capacity ) * sizeof( slot ) );
+   }
+
+   /**
+    * create - builds a queue at mem, which should come from
+    * shm::init with at least required_bytes( capacity ) bytes.
+    * Only one process should call create, the rest attach.
+    */
+   static mpmc_queue* create( void *mem, const std::size_t capacity )
+   {
+      return( new ( mem ) mpmc_queue( round_capacity( capacity ) ) );
+   }
+
+   /**
+    * attach - returns the queue that another process built at
+    * mem, throws or returns nullptr if mem doesn't hold a queue
+    * of this type.
+    */
+   static mpmc_queue* attach( void *mem )
+   {
+      auto *q( reinterpret_cast< mpmc_queue* >( mem ) );
+      if( mem == nullptr ||
+          q->magic != queue_magic ||
+          q->item_size != sizeof( T ) )
+      {
+#if USE_CPP_EXCEPTIONS==1
+         throw invalid_segment_exception( "segment doesn't hold an mpmc_queue of this type" );
+#else
+         return( nullptr );
+#endif
+      }
+      return( q );
+   }
+
+   /**
+    * begin_push - claims the next free slot for this process
+    * and returns it so the item can be built in place. Must be
+    * followed by commit_push( ticket ).
+    * @param   ticket - set to the claimed position
+    * @return  T* - slot to write, nullptr if the queue is full
+    */
+   T* begin_push( std::uint64_t &ticket )
+   {
+      for( ;; )
+      {
+         const auto pos( enqueue_pos.load( std::memory_order_acquire ) );
+         auto &s( slots()[ pos & mask ] );
+         auto seq( s.seq.load( std::memory_order_acquire ) );
+         if( seq == pos )
+         {
+            if( s.seq.compare_exchange_strong( seq, marker( producer_bit, pos ) ) )
+            {
+               help_advance( enqueue_pos, pos );
+               ticket = pos;
+               return( &s.data );
+            }
+         }
+         else if( is_marker( seq ) )
+         {
+            if( ( seq & producer_bit ) != 0 && marker_matches( seq, pos ) )
+            {
+               /** 
+                * another producer has pos, help it along, if it died
+                * the consumer that gets stuck on pos cleans up
+                */
+               help_advance( enqueue_pos, pos );
+            }
+            else if( ( seq & producer_bit ) != 0 && marker_matches( seq, pos - capacity_ ) )
+            {
+               /** last lap's producer is still writing this slot, or died in it **/
+               if( ! recover_if_dead( s, seq, pos - capacity_ ) )
+               {
+                  return( nullptr );
+               }
+            }
+            else if( ( seq & producer_bit ) == 0 && marker_matches( seq, pos - capacity_ ) )
+            {
+               /** last lap's consumer is still reading this slot **/
+               if( ! recover_if_dead( s, seq, pos - capacity_ ) )
+               {
+                  return( nullptr );
+               }
+            }
+         }
+         else if( static_cast< std::int64_t >( seq - pos ) < 0 )
+         {
+            /** slot still holds last lap's item, full **/
+            return( nullptr );
+         }
+         else
+         {
+            /** slot is past pos, our copy of enqueue_pos is stale **/
+            help_advance( enqueue_pos, pos );
+         }
+      }
+   }
+
+   /** commit_push - publishes the slot claimed by begin_push **/
+   void commit_push( const std::uint64_t ticket )
+   {
+      slots()[ ticket & mask ].seq.store( ticket + 1, std::memory_order_release );
+   }
+
+   /**
+    * begin_pop - claims the oldest item for this process, the
+    * slot stays valid until commit_pop( ticket ).
+    * @param   ticket - set to the claimed position
+    * @return  T* - item to read, nullptr if the queue is empty
+    */
+   T* begin_pop( std::uint64_t &ticket )
+   {
+      for( ;; )
+      {
+         const auto pos( dequeue_pos.load( std::memory_order_acquire ) );
+         auto &s( slots()[ pos & mask ] );
+         auto seq( s.seq.load( std::memory_order_acquire ) );
+         if( seq == pos + 1 )
+         {
+            if( s.seq.compare_exchange_strong( seq, marker( 0, pos ) ) )
+            {
+               help_advance( dequeue_pos, pos );
+               ticket = pos;
+               return( &s.data );
+            }
+         }
+         else if( is_marker( seq ) )
+         {
+            if( ( seq & producer_bit ) != 0 && marker_matches( seq, pos ) )
+            {
+               /** item is being written, unless the writer died **/
+               if( ! recover_if_dead( s, seq, pos ) )
+               {
+                  return( nullptr );
+               }
+            }
+            else if( ( seq & producer_bit ) == 0 && marker_matches( seq, pos ) )
+            {
+               /** 
+                * another consumer has pos, help it along, if it died
+                * the producer that gets stuck on the slot cleans up
+                */
+               help_advance( dequeue_pos, pos );
+            }
+            else if( ( seq & producer_bit ) == 0 && marker_matches( seq, pos - capacity_ ) )
+            {
+               /** last lap's consumer is still reading, nothing for pos yet **/
+               return( nullptr );
+            }
+         }
+         else if( static_cast< std::int64_t >( seq - ( pos + 1 ) ) < 0 )
+         {
+            /** nothing has been written for pos yet, empty **/
+            return( nullptr );
+         }
+         else
+         {
+            /** slot is past pos (consumed or skipped), stale copy **/
+            help_advance( dequeue_pos, pos );
+         }
+      }
+   }
+
+   /** commit_pop - hands the slot claimed by begin_pop back to producers **/
+   void commit_pop( const std::uint64_t ticket )
+   {
+      slots()[ ticket & mask ].seq.store( ticket + capacity_, std::memory_order_release );
+   }
+
+   /**
+    * try_push - copies item into the queue.
+    * @return bool - false if the queue is full
+    */
+   bool try_push( const T &item )
+   {
+      std::uint64_t ticket( 0 );
+      auto *out( begin_push( ticket ) );
+      if( out == nullptr )
+      {
+         return( false );
+      }
+      std::memcpy( out, &item, sizeof( T ) );
+      commit_push( ticket );
+      return( true );
+   }
+
+   /**
+    * try_pop - copies the oldest item out of the queue.
+    * @return bool - false if the queue is empty
+    */
+   bool try_pop( T &item )
+   {
+      std::uint64_t ticket( 0 );
+      const auto *in( begin_pop( ticket ) );
+      if( in == nullptr )
+      {
+         return( false );
+      }
+      std::memcpy( &item, in, sizeof( T ) );
+      commit_pop( ticket );
+      return( true );
+   }
+
+   /** push - spins (yielding) until item fits **/
+   void push( const T &item )
+   {
+      while( ! try_push( item ) )
+      {
+         std::this_thread::yield();
+      }
+   }
+
+   /** pop - spins (yielding) until an item is available **/
+   void pop( T &item )
+   {
+      while( ! try_pop( item ) )
+      {
+         std::this_thread::yield();
+      }
+   }
+
+   /** size - approximate number of items in the queue **/
+   std::size_t size() const
+   {
+      const auto out( static_cast< std::int64_t >(
+         enqueue_pos.load( std::memory_order_acquire ) -
+         dequeue_pos.load( std::memory_order_acquire ) ) );
+      return( out < 0 ? 0 : static_cast< std::size_t >( out ) );
+   }
+
+   std::size_t capacity() const
+   {
+      return( capacity_ );
+   }
+
+private:
+   static constexpr std::uint64_t queue_magic   = 0x6d706d6371756575ULL;
+   /**
+    * marker layout, sequence numbers never get near bit 62:
+    * [63] claimed, [62] producer, [61:22] position, [21:0] pid
+    */
+   static constexpr std::uint64_t claim_bit     = 1ULL << 63;
+   static constexpr std::uint64_t producer_bit  = 1ULL << 62;
+   static constexpr std::uint32_t pid_bits      = 22;
+   static constexpr std::uint64_t pid_mask      = ( 1ULL << pid_bits ) - 1;
+   static constexpr std::uint64_t pos_mask      = ( 1ULL << 40 ) - 1;
+   /** failed attempts on one marker before checking its owner **/
+   static constexpr std::uint32_t probe_after   = 1024;
+
+   struct slot
+   {
+      std::atomic< std::uint64_t > seq;
+      T                            data;
+   };
+
+   explicit mpmc_queue( const std::size_t capacity ) : magic( queue_magic ),
+                                                       item_size( sizeof( T ) ),
+                                                       capacity_( capacity ),
+                                                       mask( capacity - 1 )
+   {
+      for( std::size_t i( 0 ); i < capacity; i++ )
+      {
+         new ( &slots()[ i ].seq ) std::atomic< std::uint64_t >( i );
+      }
+      enqueue_pos.store( 0, std::memory_order_relaxed );
+      dequeue_pos.store( 0, std::memory_order_relaxed );
+      std::atomic_thread_fence( std::memory_order_release );
+   }
+
+   static std::size_t round_capacity( const std::size_t capacity )
+   {
+      std::size_t out( 2 );
+      while( out < capacity )
+      {
+         out <<= 1;
+      }
+      return( out );
+   }
+
+   slot* slots()
+   {
+      return( reinterpret_cast< slot* >( reinterpret_cast< char* >( this ) + sizeof( mpmc_queue ) ) );
+   }
+
+   static std::uint64_t marker( const std::uint64_t role, const std::uint64_t pos )
+   {
+      return( claim_bit | role | ( ( pos & pos_mask ) << pid_bits ) |
+              ( static_cast< std::uint64_t >( getpid() ) & pid_mask ) );
+   }
+
+   static bool is_marker( const std::uint64_t seq )
+   {
+      return( ( seq & claim_bit ) != 0 );
+   }
+
+   static bool marker_matches( const std::uint64_t seq, const std::uint64_t pos )
+   {
+      return( ( ( seq >> pid_bits ) & pos_mask ) == ( pos & pos_mask ) );
+   }
+
+   /** help_advance - moves index from pos to pos + 1 if nobody has yet **/
+   static void help_advance( std::atomic< std::uint64_t > &index, std::uint64_t pos )
+   {
+      index.compare_exchange_strong( pos, pos + 1 );
+   }
+
+   /**
+    * recover_if_dead - if the process that left marker in s for
+    * pos is gone, make sure both positions are past pos and hand
+    * the slot to the next lap's producer.
+    * @return bool - true if the slot was released
+    */
+   bool recover_if_dead( slot &s, std::uint64_t marker, const std::uint64_t pos )
+   {
+      /**
+       * a live claimer finishes in nanoseconds, so only pay for the
+       * syscall once the same marker has blocked us for a while.
+       */
+      thread_local std::uint64_t last_marker( 0 );
+      thread_local std::uint32_t times_seen( 0 );
+      if( marker != last_marker )
+      {
+         last_marker = marker;
+         times_seen  = 0;
+         return( false );
+      }
+      if( ++times_seen < probe_after )
+      {
+         return( false );
+      }
+      times_seen = 0;
+      const auto pid( static_cast< pid_t >( marker & pid_mask ) );
+      if( kill( pid, 0 ) == 0 || errno != ESRCH )
+      {
+         return( false );
+      }
+      help_advance( enqueue_pos, pos );
+      help_advance( dequeue_pos, pos );
+      return( s.seq.compare_exchange_strong( marker, pos + capacity_ ) );
+   }
+
+   /** read-only after create **/
+   alignas( SHM_CACHE_LINE_SIZE ) const std::uint64_t magic;
+   const std::uint64_t  item_size;
+   const std::uint64_t  capacity_;
+   const std::uint64_t  mask;
+
+   alignas( SHM_CACHE_LINE_SIZE ) std::atomic< std::uint64_t > enqueue_pos;
+   alignas( SHM_CACHE_LINE_SIZE ) std::atomic< std::uint64_t > dequeue_pos;
+};
+
+#endif /* END _SHM_MPMC_QUEUE_HPP_ */
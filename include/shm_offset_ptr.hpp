@@ -0,0 +1,197 @@
+/**
+ * shm_offset_ptr.hpp -
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * @author: Jonathan Beard
+ * @version: Oct 18 2026
+ */
+#ifndef _SHM_OFFSET_PTR_HPP_
+#define _SHM_OFFSET_PTR_HPP_  1
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include <shm>
+
+/**
+ * offset_ptr - pointer that stores the distance from itself to
+ * its target instead of an address. As long as the offset_ptr and
+ * what it points to are in the same segment it stays valid no
+ * matter where each process maps that segment, so these can be
+ * stored in shared memory where a raw pointer can't.
+ *
+ * Copying one recomputes the offset for the new location, which
+ * means an offset_ptr has to be copied/moved with its constructors
+ * (never memcpy'd) and can't be used inside a trivially copied
+ * element of spsc_ring/mpmc_queue. An offset of one is null, a
+ * real target is never one byte away from its pointer.
+ */
+template < class T > class shm::offset_ptr
+{
+public:
+   using element_type      = T;
+   using pointer           = T*;
+   using reference         = typename std::add_lvalue_reference< T >::type;
+   using difference_type   = std::ptrdiff_t;
+
+   offset_ptr() noexcept = default;
+
+   offset_ptr( std::nullptr_t ) noexcept {}
+
+   offset_ptr( T *ptr ) noexcept
+   {
+      set( ptr );
+   }
+
+   offset_ptr( const offset_ptr &other ) noexcept
+   {
+      set( other.get() );
+   }
+
+   template < class U,
+              class = typename std::enable_if< std::is_convertible< U*, T* >::value >::type >
+   offset_ptr( const offset_ptr< U > &other ) noexcept
+   {
+      set( other.get() );
+   }
+
+   offset_ptr& operator = ( const offset_ptr &other ) noexcept
+   {
+      set( other.get() );
+      return( *this );
+   }
+
+   offset_ptr& operator = ( T *ptr ) noexcept
+   {
+      set( ptr );
+      return( *this );
+   }
+
+   offset_ptr& operator = ( std::nullptr_t ) noexcept
+   {
+      offset = null_offset;
+      return( *this );
+   }
+
+   T* get() const noexcept
+   {
+      if( offset == null_offset )
+      {
+         return( nullptr );
+      }
+      return( reinterpret_cast< T* >(
+         const_cast< char* >( reinterpret_cast< const char* >( this ) ) + offset ) );
+   }
+
+   reference operator * () const noexcept
+   {
+      return( *get() );
+   }
+
+   T* operator -> () const noexcept
+   {
+      return( get() );
+   }
+
+   reference operator [] ( const std::ptrdiff_t index ) const noexcept
+   {
+      return( get()[ index ] );
+   }
+
+   explicit operator bool () const noexcept
+   {
+      return( offset != null_offset );
+   }
+
+   offset_ptr& operator += ( const std::ptrdiff_t n ) noexcept
+   {
+      set( get() + n );
+      return( *this );
+   }
+
+   offset_ptr& operator -= ( const std::ptrdiff_t n ) noexcept
+   {
+      set( get() - n );
+      return( *this );
+   }
+
+   offset_ptr& operator ++ () noexcept
+   {
+      return( *this += 1 );
+   }
+
+   offset_ptr& operator -- () noexcept
+   {
+      return( *this -= 1 );
+   }
+
+   /**
+    * the binary operators hand back raw pointers, a temporary
+    * offset_ptr would live on the stack and be useless to store.
+    */
+   T* operator + ( const std::ptrdiff_t n ) const noexcept
+   {
+      return( get() + n );
+   }
+
+   T* operator - ( const std::ptrdiff_t n ) const noexcept
+   {
+      return( get() - n );
+   }
+
+   std::ptrdiff_t operator - ( const offset_ptr &other ) const noexcept
+   {
+      return( get() - other.get() );
+   }
+
+   friend bool operator == ( const offset_ptr &lhs, const offset_ptr &rhs ) noexcept
+   {
+      return( lhs.get() == rhs.get() );
+   }
+
+   friend bool operator != ( const offset_ptr &lhs, const offset_ptr &rhs ) noexcept
+   {
+      return( lhs.get() != rhs.get() );
+   }
+
+   friend bool operator < ( const offset_ptr &lhs, const offset_ptr &rhs ) noexcept
+   {
+      return( lhs.get() < rhs.get() );
+   }
+
+   friend bool operator == ( const offset_ptr &lhs, std::nullptr_t ) noexcept
+   {
+      return( ! lhs );
+   }
+
+   friend bool operator != ( const offset_ptr &lhs, std::nullptr_t ) noexcept
+   {
+      return( static_cast< bool >( lhs ) );
+   }
+
+private:
+   static constexpr std::ptrdiff_t null_offset = 1;
+
+   void set( T *ptr ) noexcept
+   {
+      offset = ( ptr == nullptr ? null_offset :
+                 reinterpret_cast< const char* >( ptr ) -
+                 reinterpret_cast< const char* >( this ) );
+   }
+
+   std::ptrdiff_t offset = null_offset;
+};
+
+#endif /* END _SHM_OFFSET_PTR_HPP_ */
@@ -0,0 +1,108 @@
+/**
+ * shm_placement.hpp -
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * @author: Jonathan Beard
+ * @version: Oct 18 2026
+ */
+#ifndef _SHM_PLACEMENT_HPP_
+#define _SHM_PLACEMENT_HPP_  1
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <shm>
+
+/**
+ * placement - decides which NUMA node a segment should live on
+ * given where the threads that use it run. The cost of a thread
+ * on node c reaching memory on node m comes from the firmware's
+ * distance table (shm::topology, 10 is local) until measure()
+ * runs a short latency and bandwidth benchmark between every pair
+ * of nodes, either way the matrix is computed once per process
+ * and cached.
+ *
+ * Typical use:
+ * const auto node( shm::placement::best_node(
+ *    shm::placement::thread_weights( 0 ) ) );
+ */
+class shm::placement
+{
+public:
+   placement()  = delete;
+   ~placement() = delete;
+
+   /** costs - node to node access costs, indexed [ cpu_node ][ mem_node ] **/
+   struct matrix
+   {
+      /** highest node id + 1, node ids can have holes **/
+      std::size_t             nodes = 0;
+      /** firmware distances, 10 is local, 0 if either node doesn't exist **/
+      std::vector< int >      distance;
+      /** measured, empty until measure() runs **/
+      std::vector< double >   latency_ns;
+      std::vector< double >   bandwidth_mbs;
+      /**
+       * lowest latency and highest bandwidth of any measured pair,
+       * set by measure(), cost() uses the distances while they're 0
+       */
+      double                  best_latency_ns    = 0.0;
+      double                  best_bandwidth_mbs = 0.0;
+      /** memory on this node can be allocated by this process **/
+      std::vector< bool >     has_memory;
+
+      /**
+       * cost - relative cost of a thread on cpu_node using memory on
+       * mem_node, 10 is the best pair. Measured latency and
+       * bandwidth count half each when there are measurements,
+       * otherwise this is the distance. Unusable pairs cost
+       * infinity.
+       */
+      double cost( const int cpu_node, const int mem_node ) const;
+   };
+
+   /** costs - the cached matrix, distances only unless measure() ran **/
+   static matrix costs();
+
+   /**
+    * measure - times a dependent load chain (latency) and a
+    * streaming read (bandwidth) over bytes of memory on every node
+    * from a thread on every node with cpus, then caches the result
+    * for costs(). Takes roughly nodes^2 * 50ms, run it at start up.
+    * @param   bytes - working set per pair, bigger than the LLC
+    * @return  matrix - the new costs
+    */
+   static matrix measure( const std::size_t bytes = std::size_t( 64 ) << 20 );
+
+   /**
+    * best_node - the node with memory that minimizes the weighted
+    * sum of access costs, weights[ n ] is how much of the work
+    * runs on node n (e.g., its number of threads there).
+    * @param   weights - indexed by node, missing entries are zero
+    * @param   costs - cost matrix, the cached one by default
+    * @return  int - node id, 0 without NUMA
+    */
+   static int best_node( const std::vector< double > &weights );
+   static int best_node( const std::vector< double > &weights, const matrix &costs );
+
+   /**
+    * thread_weights - weights for best_node from a thread's
+    * affinity mask, the number of allowed cpus on each node.
+    * @param   thread_id - thread to look at, 0 for the caller
+    */
+   static std::vector< double > thread_weights( const pid_t thread_id );
+};
+
+#endif /* END _SHM_PLACEMENT_HPP_ */
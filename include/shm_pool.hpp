@@ -0,0 +1,435 @@
+/**
+ * shm_pool.hpp -
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * @author: Jonathan Beard
+ * @version: Oct 18 2026
+ */
+#ifndef _SHM_POOL_HPP_
+#define _SHM_POOL_HPP_  1
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <new>
+#include <sstream>
+#include <utility>
+
+#include <shm>
+
+/**
+ * pool - slab of fixed size slots for objects of type T, laid out
+ * in one segment from shm::init, for when a general allocator like
+ * arena is more than the objects need. Free slots are kept on one
+ * lock-free list of slot indices, the head carries a tag that
+ * changes on every update so a slot that is popped and pushed back
+ * under a CAS doesn't fool it (ABA). Links live next to, not in,
+ * the slots, so a slot's bytes are only ever touched by whoever
+ * holds it.
+ *
+ * Slots are either packed (natural) or each on its own cache lines
+ * (cache_line), the latter keeps objects written by different
+ * processes from sharing a line. Allocating on the pool directly
+ * always goes to the shared list, a pool::cache per thread batches
+ * that traffic through a private magazine.
+ *
+ * Typical use:
+ * void *mem = shm::init( key, shm::pool< order >::required_bytes( n ) );
+ * auto *orders = shm::pool< order >::create( mem, n );
+ * ...other processes...
+ * auto *orders = shm::pool< order >::attach( shm::open( key ) );
+ * shm::pool< order >::cache c( orders );
+ * order *o = c.make( 42 );
+ * ...pass orders->index_of( o ) to another process...
+ * c.destroy( o );
+ */
+template < class T > class shm::pool
+{
+public:
+   class cache;
+
+   static_assert( alignof( T ) <= SHM_CACHE_LINE_SIZE,
+                  "pool slots can't be aligned wider than a cache line" );
+   static_assert( ATOMIC_LLONG_LOCK_FREE == 2,
+                  "pool needs address-free 64b atomics to work across processes" );
+
+   enum class align_t : std::uint8_t
+   {
+      /** slots packed at alignof( T ) **/
+      natural = 0,
+      /** every slot starts on a cache line and has its lines to itself **/
+      cache_line
+   };
+
+   /** index of no slot **/
+   static constexpr std::uint32_t npos = 0xffffffff;
+
+   pool( const pool &other ) = delete;
+   pool& operator = ( const pool &other ) = delete;
+
+   /**
+    * required_bytes - bytes a segment needs to hold count slots.
+    * @return  std::size_t - bytes to pass to shm::init
+    */
+   static std::size_t required_bytes( const std::size_t count,
+                                      const align_t     align = align_t::natural )
+   {
+      return( slot_offset( count ) + count * stride( align ) );
+   }
+
+   /**
+    * create - builds a pool of count slots at mem, which should
+    * come from shm::init with at least required_bytes( count, align )
+    * bytes. Only one process should call create, the rest attach.
+    * @return  pool* - same address as mem
+    */
+   static pool* create( void *mem, const std::size_t count, const align_t align = align_t::natural )
+   {
+      if( mem == nullptr || count == 0 || count >= npos )
+      {
+#if USE_CPP_EXCEPTIONS==1
+         std::stringstream ss;
+         ss << "pool can't hold (" << count << ") slots";
+         throw bad_shm_alloc( ss.str() );
+#else
+         return( nullptr );
+#endif
+      }
+      return( new ( mem ) pool( count, align ) );
+   }
+
+   /**
+    * attach - returns the pool that another process built at mem,
+    * throws or returns nullptr if mem doesn't hold a pool of this
+    * type.
+    */
+   static pool* attach( void *mem )
+   {
+      auto *p( reinterpret_cast< pool* >( mem ) );
+      if( mem == nullptr ||
+          p->magic != pool_magic ||
+          p->item_size != sizeof( T ) )
+      {
+#if USE_CPP_EXCEPTIONS==1
+         throw invalid_segment_exception( "segment doesn't hold a pool of this type" );
+#else
+         return( nullptr );
+#endif
+      }
+      return( p );
+   }
+
+   /**
+    * allocate - storage for one T from the shared list, nothing is
+    * constructed. Throws bad_shm_alloc or returns nullptr when every
+    * slot is taken.
+    */
+   T* allocate()
+   {
+      const auto index( pop() );
+      if( index == npos )
+      {
+         return( exhausted() );
+      }
+      return( at( index ) );
+   }
+
+   /** deallocate - returns ptr, from any process, to the shared list **/
+   void deallocate( T *ptr )
+   {
+      if( ptr == nullptr )
+      {
+         return;
+      }
+      const auto index( index_of( ptr ) );
+      push( index, index );
+   }
+
+   /** make - allocate and construct a T from args **/
+   template < class... Args > T* make( Args&&... args )
+   {
+      T *out( allocate() );
+      if( out == nullptr )
+      {
+         return( nullptr );
+      }
+      return( new ( out ) T( std::forward< Args >( args )... ) );
+   }
+
+   /** destroy - destruct and deallocate ptr **/
+   void destroy( T *ptr )
+   {
+      if( ptr == nullptr )
+      {
+         return;
+      }
+      ptr->~T();
+      deallocate( ptr );
+   }
+
+   /**
+    * index_of/at - convert between pointers, which are only good
+    * in this process, and slot indices, which are good in all of them.
+    */
+   std::uint32_t index_of( const T *ptr ) const
+   {
+      return( static_cast< std::uint32_t >(
+         ( reinterpret_cast< const char* >( ptr ) - slots() ) / stride_ ) );
+   }
+
+   T* at( const std::uint32_t index ) const
+   {
+      return( reinterpret_cast< T* >( slots() + index * stride_ ) );
+   }
+
+   std::size_t capacity() const
+   {
+      return( capacity_ );
+   }
+
+   /** slot_size - bytes between the start of two slots **/
+   std::size_t slot_size() const
+   {
+      return( stride_ );
+   }
+
+private:
+   static constexpr std::uint64_t pool_magic  = 0x73686d706f6f6c31ULL;
+   /** free list head layout, [ tag : 32 ][ index + 1 : 32 ], 0 is empty **/
+   static constexpr std::uint64_t index_mask  = 0xffffffffULL;
+
+   pool( const std::size_t count, const align_t align ) : magic( pool_magic ),
+                                                          item_size( sizeof( T ) ),
+                                                          capacity_( count ),
+                                                          stride_( stride( align ) )
+   {
+      /** every slot starts free, chained in order **/
+      for( std::size_t i( 0 ); i < count; i++ )
+      {
+         new ( &links()[ i ] ) std::atomic< std::uint32_t >(
+            static_cast< std::uint32_t >( i + 1 < count ? i + 2 : 0 ) );
+      }
+      head.store( 1, std::memory_order_relaxed );
+      std::atomic_thread_fence( std::memory_order_release );
+   }
+
+   static std::size_t round_up( const std::size_t bytes, const std::size_t to )
+   {
+      return( ( bytes + to - 1 ) / to * to );
+   }
+
+   static std::size_t stride( const align_t align )
+   {
+      return( round_up( sizeof( T ), align == align_t::cache_line ?
+                                     SHM_CACHE_LINE_SIZE :
+                                     alignof( T ) ) );
+   }
+
+   /** slots start on a cache line after the links **/
+   static std::size_t slot_offset( const std::size_t count )
+   {
+      return( round_up( sizeof( pool ) + count * sizeof( std::atomic< std::uint32_t > ),
+                        SHM_CACHE_LINE_SIZE ) );
+   }
+
+   std::atomic< std::uint32_t >* links() const
+   {
+      return( reinterpret_cast< std::atomic< std::uint32_t >* >(
+         reinterpret_cast< char* >( const_cast< pool* >( this ) ) + sizeof( pool ) ) );
+   }
+
+   char* slots() const
+   {
+      return( reinterpret_cast< char* >( const_cast< pool* >( this ) ) + slot_offset( capacity_ ) );
+   }
+
+   T* exhausted()
+   {
+#if USE_CPP_EXCEPTIONS==1
+      std::stringstream ss;
+      ss << "pool is out of slots, all (" << capacity_ << ") are taken";
+      throw bad_shm_alloc( ss.str() );
+#else
+      return( nullptr );
+#endif
+   }
+
+   std::uint32_t pop()
+   {
+      auto old_head( head.load( std::memory_order_acquire ) );
+      for( ;; )
+      {
+         const auto first( old_head & index_mask );
+         if( first == 0 )
+         {
+            return( npos );
+         }
+         /**
+          * first may be popped and pushed back under us, its link
+          * is still a valid read and the tag makes the CAS fail.
+          */
+         const auto next( links()[ first - 1 ].load( std::memory_order_relaxed ) );
+         const auto new_head( ( ( ( old_head >> 32 ) + 1 ) << 32 ) | next );
+         if( head.compare_exchange_weak( old_head,
+                                         new_head,
+                                         std::memory_order_acq_rel,
+                                         std::memory_order_acquire ) )
+         {
+            return( static_cast< std::uint32_t >( first - 1 ) );
+         }
+      }
+   }
+
+   /** push - puts the chain first..last (linked through links) on the list **/
+   void push( const std::uint32_t first, const std::uint32_t last )
+   {
+      auto old_head( head.load( std::memory_order_relaxed ) );
+      for( ;; )
+      {
+         links()[ last ].store( static_cast< std::uint32_t >( old_head & index_mask ),
+                                std::memory_order_relaxed );
+         const auto new_head( ( ( ( old_head >> 32 ) + 1 ) << 32 ) | ( first + 1 ) );
+         if( head.compare_exchange_weak( old_head,
+                                         new_head,
+                                         std::memory_order_release,
+                                         std::memory_order_relaxed ) )
+         {
+            return;
+         }
+      }
+   }
+
+   /** read-only after create **/
+   alignas( SHM_CACHE_LINE_SIZE ) const std::uint64_t magic;
+   const std::uint64_t  item_size;
+   const std::uint64_t  capacity_;
+   const std::uint64_t  stride_;
+
+   alignas( SHM_CACHE_LINE_SIZE ) std::atomic< std::uint64_t > head;
+};
+
+/**
+ * pool::cache - private magazine of free slots in front of a pool,
+ * allocations and frees only touch the shared list half a magazine
+ * at a time, and a batch of frees goes back with a single CAS. A
+ * cache isn't thread safe, make one per thread. Slots sitting in a
+ * cache when its process dies are lost to the other processes, call
+ * flush() or let the destructor run.
+ */
+template < class T > class shm::pool< T >::cache
+{
+public:
+   static constexpr std::size_t magazine_size = 64;
+
+   explicit cache( pool *p ) : p( p )
+   {
+   }
+
+   ~cache()
+   {
+      flush();
+   }
+
+   cache( const cache &other ) = delete;
+   cache& operator = ( const cache &other ) = delete;
+
+   T* allocate()
+   {
+      if( count == 0 )
+      {
+         /** refill half a magazine **/
+         while( count < magazine_size / 2 )
+         {
+            const auto index( p->pop() );
+            if( index == npos )
+            {
+               break;
+            }
+            slots[ count++ ] = index;
+         }
+         if( count == 0 )
+         {
+            return( p->exhausted() );
+         }
+      }
+      return( p->at( slots[ --count ] ) );
+   }
+
+   void deallocate( T *ptr )
+   {
+      if( ptr == nullptr )
+      {
+         return;
+      }
+      if( count == magazine_size )
+      {
+         spill( magazine_size / 2 );
+      }
+      slots[ count++ ] = p->index_of( ptr );
+   }
+
+   template < class... Args > T* make( Args&&... args )
+   {
+      T *out( allocate() );
+      if( out == nullptr )
+      {
+         return( nullptr );
+      }
+      return( new ( out ) T( std::forward< Args >( args )... ) );
+   }
+
+   void destroy( T *ptr )
+   {
+      if( ptr == nullptr )
+      {
+         return;
+      }
+      ptr->~T();
+      deallocate( ptr );
+   }
+
+   /** flush - hands every cached slot back to the pool **/
+   void flush()
+   {
+      spill( count );
+   }
+
+   pool* get_pool()
+   {
+      return( p );
+   }
+
+private:
+   /** spill - the top n cached slots go back as one chain **/
+   void spill( const std::size_t n )
+   {
+      if( n == 0 )
+      {
+         return;
+      }
+      const auto first( count - n );
+      for( auto i( first ); i + 1 < count; i++ )
+      {
+         p->links()[ slots[ i ] ].store( slots[ i + 1 ] + 1, std::memory_order_relaxed );
+      }
+      p->push( slots[ first ], slots[ count - 1 ] );
+      count = first;
+   }
+
+   pool           *p;
+   std::size_t    count = 0;
+   std::uint32_t  slots[ magazine_size ];
+};
+
+#endif /* END _SHM_POOL_HPP_ */
@@ -0,0 +1,259 @@
+/**
+ * shm_segment.hpp -
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * @author: Jonathan Beard
+ * @version: Oct 18 2026
+ */
+#ifndef _SHM_SEGMENT_HPP_
+#define _SHM_SEGMENT_HPP_  1
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <sys/types.h>
+
+#include <shm>
+
+/**
+ * segment - owns one mapping of a segment, the static calls are a
+ * thin layer on top of it (init/open make one and release() it).
+ * It keeps what the mapping was made with: key, backend, length,
+ * page size and the descriptor (or SystemV id), so closing can't
+ * be handed the wrong length or backend and resize doesn't have to
+ * open the key again. The destructor unmaps, a segment made with
+ * create() also unlinks unless unlink_on_close( false ) was called.
+ * Moving hands the mapping over, copying isn't allowed.
+ *
+ * Typical use:
+ * auto seg( shm::segment::create( key, nbytes ) );
+ * auto *data = seg.as< float >();
+ * seg.resize( 2 * nbytes );
+ * ...other process...
+ * auto seg( shm::segment::open( key ) );
+ *
+ * A mirrored ring, records are never split at the wrap:
+ * auto seg( shm::segment::create_mirrored( key, 1 << 20, sizeof( control ) ) );
+ * auto *ring = reinterpret_cast< char* >( seg.ring() );
+ * std::memcpy( ring + head % seg.ring_size(), record, len );
+ */
+class shm::segment
+{
+public:
+   enum class backend_t : std::uint8_t
+   {
+      posix = 0,
+      sysv,
+      memfd
+   };
+
+   /** empty, operator bool is false **/
+   segment() = default;
+
+   segment( segment &&other ) noexcept;
+   segment& operator = ( segment &&other ) noexcept;
+
+   segment( const segment &other ) = delete;
+   segment& operator = ( const segment &other ) = delete;
+
+   /** close( release_t::none ), unlinking if this segment owns the key **/
+   ~segment();
+
+   /**
+    * create - same as shm::init, the segment owns the key.
+    * @return  segment - throws on failure, without exceptions it's
+    *                    empty with errno set
+    */
+   template < class Backend = shm::default_backend >
+   static segment create( const typename Backend::key_type &key,
+                          const std::size_t                nbytes,
+                          const page_t                     page     = page_t::normal,
+                          const numa_policy                &numa    = numa_policy(),
+                          const populate_t                 populate = populate_t::none,
+                          void                             *ptr     = nullptr );
+
+   /**
+    * open - same as shm::open, the segment doesn't own the key.
+    * @return  segment - throws on failure, without exceptions it's
+    *                    empty with errno set
+    */
+   template < class Backend = shm::default_backend >
+   static segment open( const typename Backend::key_type &key );
+
+   /**
+    * create_mirrored - a segment for a ring buffer, header_bytes
+    * followed by ring_bytes that are mapped twice back to back, so
+    * ring()[ i ] and ring()[ i + ring_size() ] are the same byte and
+    * any span up to ring_size() starting inside the first copy is
+    * contiguous, no splitting at the wrap. The guard page comes
+    * after the second copy. Both lengths are rounded up to whole
+    * pages, ptr is a placement hint as for create. POSIX and memfd
+    * only, SystemV can't map part of a segment (ENOTSUP). Such a
+    * segment can't be resized or remapped (ENOTSUP).
+    * @return  segment - throws on failure, without exceptions it's
+    *                    empty with errno set
+    */
+   template < class Backend = shm::default_backend >
+   static segment create_mirrored( const typename Backend::key_type &key,
+                                   const std::size_t                ring_bytes,
+                                   const std::size_t                header_bytes = 0,
+                                   const page_t                     page         = page_t::normal,
+                                   void                             *ptr         = nullptr );
+
+   /**
+    * open_mirrored - maps a segment made by create_mirrored the
+    * same way, header_bytes has to match what it was made with.
+    */
+   template < class Backend = shm::default_backend >
+   static segment open_mirrored( const typename Backend::key_type &key,
+                                 const std::size_t                header_bytes = 0,
+                                 void                             *ptr         = nullptr );
+
+   explicit operator bool () const
+   {
+      return( addr != nullptr );
+   }
+
+   void* get() const
+   {
+      return( addr );
+   }
+
+   template < class T > T* as() const
+   {
+      return( reinterpret_cast< T* >( addr ) );
+   }
+
+   /** size - usable bytes mapped, whole pages, guard page not counted **/
+   std::size_t size() const
+   {
+      return( alloc_bytes - page_bytes );
+   }
+
+   std::size_t page_size() const
+   {
+      return( page_bytes );
+   }
+
+   /** ring - first copy of the ring of a mirrored segment, else nullptr **/
+   void* ring() const
+   {
+      return( ring_bytes == 0 ? 
+              nullptr : 
+              reinterpret_cast< char* >( addr ) + size() - 2 * ring_bytes );
+   }
+
+   /** ring_size - bytes in one copy of the ring, 0 if not mirrored **/
+   std::size_t ring_size() const
+   {
+      return( ring_bytes );
+   }
+
+   backend_t backend() const
+   {
+      return( kind );
+   }
+
+   /** fd - descriptor of a POSIX or memfd segment, -1 for SystemV **/
+   int fd() const
+   {
+      return( kind == backend_t::sysv ? -1 : handle );
+   }
+
+   /** shmid - id of a SystemV segment, -1 for the others **/
+   int shmid() const
+   {
+      return( kind == backend_t::sysv ? handle : -1 );
+   }
+
+   /**
+    * key - copies the key this segment was made with, to hand to
+    * other processes (shm::send_key for memfd).
+    * @return  bool - false with errno set to EINVAL if the segment
+    *                 is empty or Backend isn't its backend
+    */
+   template < class Backend = shm::default_backend >
+   bool key( typename Backend::key_type &dst ) const;
+
+   /**
+    * unlink_on_close - whether the destructor unlinks the key, on
+    * for segments from create(), off for ones from open().
+    */
+   void unlink_on_close( const bool unlink )
+   {
+      owner = unlink;
+   }
+
+   /**
+    * resize - shm::resize on the descriptor this segment holds,
+    * the same limits apply (memfd only grows, SystemV can't).
+    * @return  bool - true if successful, false with errno set
+    */
+   bool resize( const std::size_t nbytes );
+
+   /** remap - shm::remap, after another process resized the segment **/
+   bool remap( const std::size_t nbytes );
+
+   /** discard - shm::discard within this segment **/
+   bool discard( const std::size_t offset, const std::size_t len );
+
+   /** numa_placement - shm::get_numa_placement over the whole segment **/
+   std::vector< std::size_t > numa_placement() const;
+
+   /** move_to_tid_numa - shm::move_to_tid_numa over the whole segment **/
+   bool move_to_tid_numa( const pid_t thread_id );
+
+   /**
+    * close - drops the contents the way release asks, unmaps and
+    * unlinks if asked to, the segment is empty afterwards.
+    * @return  bool - true if successful
+    */
+   bool close( const release_t release = release_t::none, const bool unlink = false );
+
+   /**
+    * release - gives up the mapping without unmapping it, the
+    * descriptor is closed and the key is left alone. The mapping
+    * is then closed with the static shm::close.
+    * @return  void* - start of the mapping, nullptr if empty
+    */
+   void* release();
+
+private:
+   /** mirrors seg in place, header and ring in whole pages **/
+   static bool mirror( segment           &seg, 
+                       const std::size_t header_bytes, 
+                       const std::size_t ring_bytes,
+                       void              *ptr );
+
+   void reset();
+
+   /** close( release_t::none, owner ), errors are dropped **/
+   void drop() noexcept;
+
+   void                 *addr          = nullptr;
+   std::size_t          alloc_bytes    = 0;
+   std::size_t          page_bytes     = 0;
+   int                  handle         = -1;
+   /** length of one copy of the ring, 0 if not mirrored **/
+   std::size_t          ring_bytes     = 0;
+   /** handle is a descriptor we have to close **/
+   bool                 handle_owned   = false;
+   bool                 owner          = false;
+   backend_t            kind           = backend_t::posix;
+   /** POSIX and memfd keys are names, SystemV keys are numbers **/
+   char                 name[ shm_key_length ] = { 0 };
+   key_t                id             = 0;
+};
+
+#endif /* END _SHM_SEGMENT_HPP_ */
@@ -0,0 +1,249 @@
+/**
+ * shm_segment_pool.hpp -
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * @author: Jonathan Beard
+ * @version: Oct 18 2026
+ */
+#ifndef _SHM_SEGMENT_POOL_HPP_
+#define _SHM_SEGMENT_POOL_HPP_  1
+
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <shm>
+#include <shm_segment.hpp>
+
+/**
+ * segment_pool - keeps segments of a few sizes created and
+ * populated ahead of time, so getting one costs a lock and a move
+ * instead of gen_key, shm_open, ftruncate, mmap and the page faults.
+ * A background thread tops every size class back up to its depth
+ * and closes the segments handed back, so neither happens on the
+ * caller's thread. Each segment gets its own key (segment::key).
+ * SystemV has only max_keys keys per working directory (ftok), and
+ * they are shared with every pool in the process, past that many
+ * live segments creating one fails with EEXIST.
+ * An acquire that finds its class empty, or is bigger than every
+ * class, makes the segment on the spot and counts a miss.
+ *
+ * Typical use:
+ * shm::segment_pool pool( { { 1 << 16, 32 }, { 1 << 20, 8 } } );
+ * auto seg( pool.acquire( 40000 ) );   // from the 64KiB class
+ * ...
+ * pool.release( std::move( seg ) );
+ */
+class shm::segment_pool
+{
+public:
+   /** distinct SystemV keys the pools of a process draw from **/
+   static constexpr std::uint32_t max_keys = 255;
+
+   /** size_class - bytes per segment and how many to keep ready **/
+   struct size_class
+   {
+      size_class( const std::size_t bytes, const std::size_t depth ) :
+         bytes( bytes ),
+         depth( depth )
+      {
+      }
+
+      std::size_t bytes;
+      std::size_t depth;
+   };
+
+   /**
+    * options - how the pooled segments are made, they are populated
+    * by default since that is most of the cost being hidden.
+    * recycle puts released segments back in their class (zeroed on
+    * the background thread) instead of closing them, only safe if
+    * no other process still maps a segment when it's released.
+    */
+   struct options
+   {
+      page_t         page       = page_t::normal;
+      numa_policy    numa       = numa_policy();
+      populate_t     populate   = populate_t::populate_write;
+      bool           recycle    = false;
+   };
+
+   struct stats
+   {
+      /** acquires served from the pool **/
+      std::uint64_t  hits       = 0;
+      /** acquires that had to make a segment themselves **/
+      std::uint64_t  misses     = 0;
+      /** segments made by the background thread **/
+      std::uint64_t  created    = 0;
+      /** released segments put back in the pool **/
+      std::uint64_t  recycled   = 0;
+      /** background creates that failed **/
+      std::uint64_t  failed     = 0;
+
+      double hit_rate() const
+      {
+         const auto total( hits + misses );
+         return( total == 0 ? 0.0 : static_cast< double >( hits ) / total );
+      }
+   };
+
+   /**
+    * segment_pool - starts the background thread, which fills the
+    * classes right away (see wait_ready).
+    * @param   classes - size classes, any order
+    * @param   opts - how segments are made
+    * @param   backend - backend tag (e.g., shm::memfd()), the
+    *                    default backend if left out
+    */
+   template < class Backend = shm::default_backend >
+   segment_pool( std::vector< size_class > classes,
+                 const options             &opts    = options(),
+                 const Backend             backend  = Backend() ) : opts( opts )
+   {
+      (void) backend;
+      make = [ this ]( const std::size_t nbytes ) -> segment
+      {
+         /** a key somebody else is using, SystemV's often are, is skipped **/
+         for( std::uint32_t tries( 1 ); ; tries++ )
+         {
+            /** SystemV keys only use the low 8 bits, and not 0 **/
+            typename Backend::key_type key;
+            shm::gen_key< Backend >( key, static_cast< int >( next_serial() % max_keys + 1 ) );
+#if USE_CPP_EXCEPTIONS==1
+            try
+            {
+               return( segment::create< Backend >( key,
+                                                   nbytes,
+                                                   this->opts.page,
+                                                   this->opts.numa,
+                                                   this->opts.populate ) );
+            }
+            catch( const shm_already_exists & )
+            {
+               if( tries == max_keys )
+               {
+                  throw;
+               }
+            }
+#else
+            auto seg( segment::create< Backend >( key,
+                                                  nbytes,
+                                                  this->opts.page,
+                                                  this->opts.numa,
+                                                  this->opts.populate ) );
+            if( seg || errno != EEXIST || tries == max_keys )
+            {
+               return( seg );
+            }
+#endif
+         }
+      };
+      start( std::move( classes ) );
+   }
+
+   /** stops the background thread, closes every pooled segment **/
+   ~segment_pool();
+
+   segment_pool( const segment_pool &other ) = delete;
+   segment_pool& operator = ( const segment_pool &other ) = delete;
+
+   /**
+    * acquire - a segment of at least nbytes from the smallest class
+    * that fits.
+    * @return  segment - on a miss, whatever segment::create returns
+    */
+   segment acquire( const std::size_t nbytes );
+
+   /**
+    * release - hands seg to the background thread, which closes
+    * (and unlinks) it or recycles it, see options.
+    */
+   void release( segment &&seg );
+
+   /**
+    * wait_ready - blocks until every class is at its depth.
+    * @return  bool - false if the background thread failed to make
+    *                 a segment first (see stats::failed)
+    */
+   bool wait_ready();
+
+   /** ready - segments waiting in class index (as sorted by size) **/
+   std::size_t ready( const std::size_t index ) const;
+
+   /** classes - number of size classes **/
+   std::size_t classes() const
+   {
+      return( buckets.size() );
+   }
+
+   /** get_stats - whole pool **/
+   stats get_stats() const;
+
+   /** get_stats - one class, misses for sizes past every class aren't in any **/
+   stats get_stats( const std::size_t index ) const;
+
+private:
+   struct alignas( SHM_CACHE_LINE_SIZE ) bucket
+   {
+      /** plain new only aligns to 16 bytes before C++17 **/
+      static void* operator new( const std::size_t nbytes );
+      static void  operator delete( void *ptr );
+
+      std::size_t                      bytes    = 0;
+      std::size_t                      depth    = 0;
+      mutable std::mutex               lock;
+      std::vector< segment >           ready;
+      std::atomic< std::uint64_t >     hits     = { 0 };
+      std::atomic< std::uint64_t >     misses   = { 0 };
+      std::atomic< std::uint64_t >     created  = { 0 };
+      std::atomic< std::uint64_t >     recycled = { 0 };
+      std::atomic< std::uint64_t >     failed   = { 0 };
+   };
+
+   /** next_serial - key serial, counted across every pool in the process **/
+   static std::uint32_t next_serial();
+
+   void start( std::vector< size_class > classes );
+   void run();
+   /** fill - tops up every class, false if a create failed **/
+   bool fill();
+   void recycle( segment &&seg );
+   bool full() const;
+
+   options                                   opts;
+   std::function< segment( std::size_t ) >   make;
+   std::vector< std::unique_ptr< bucket > >  buckets;
+   std::atomic< std::uint64_t >              oversize = { 0 };
+
+   /** everything below is shared with the background thread **/
+   std::mutex                                work_lock;
+   std::condition_variable                   work;
+   std::condition_variable                   filled;
+   std::vector< segment >                    returned;
+   std::atomic< bool >                       wanted   = { true };
+   /** the last fill failed, it retries after the idle wait **/
+   std::atomic< bool >                       stalled  = { false };
+   std::atomic< bool >                       stop     = { false };
+   std::thread                               filler;
+};
+
+#endif /* END _SHM_SEGMENT_POOL_HPP_ */
@@ -0,0 +1,197 @@
+/**
+ * shm_seqlock.hpp -
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * @author: Jonathan Beard
+ * @version: Oct 18 2026
+ */
+#ifndef _SHM_SEQLOCK_HPP_
+#define _SHM_SEQLOCK_HPP_  1
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <type_traits>
+
+#include <shm>
+#include <shm_futex.hpp>
+
+/**
+ * seqlock - latest value publication for small records, one
+ * writer and any number of readers in any process. The writer
+ * makes the sequence odd, copies the record in and makes it even
+ * again, it never waits on readers. Readers copy the record out
+ * and retry if the sequence moved while they copied (a torn
+ * read), they never block the writer. Only the newest record is
+ * kept, readers that fall behind simply skip updates. The
+ * sequence and record share cache lines so a read that doesn't
+ * retry moves as few lines as the record needs. For records
+ * bigger than a few cache lines use triple_buffer, a reader
+ * copying a big record here retries on every publish.
+ *
+ * Typical use:
+ * void *mem = shm::init( key, shm::seqlock< quote >::required_bytes() );
+ * auto *latest = shm::seqlock< quote >::create( mem );
+ * latest->publish( q );
+ * ...other process...
+ * auto *latest = shm::seqlock< quote >::attach( shm::open( key ) );
+ * quote q;
+ * const auto version( latest->read( q ) );
+ */
+template < class T > class shm::seqlock
+{
+public:
+   static_assert( std::is_trivially_copyable< T >::value,
+                  "seqlock records are copied between processes as bytes" );
+   static_assert( alignof( T ) <= SHM_CACHE_LINE_SIZE,
+                  "seqlock records can't be aligned wider than a cache line" );
+   static_assert( ATOMIC_LLONG_LOCK_FREE == 2,
+                  "seqlock needs address-free 64b atomics to work across processes" );
+
+   seqlock( const seqlock &other ) = delete;
+   seqlock& operator = ( const seqlock &other ) = delete;
+
+   /** required_bytes - bytes to pass to shm::init **/
+   static std::size_t required_bytes()
+   {
+      return( sizeof( seqlock ) );
+   }
+
+   /**
+    * create - builds a seqlock at mem, which should come from
+    * shm::init with at least required_bytes(). The record reads as
+    * zero until the first publish. Only one process should call
+    * create, the rest attach.
+    * @param   mem - start of the segment
+    * @return  seqlock* - same address as mem
+    */
+   static seqlock* create( void *mem )
+   {
+      return( new ( mem ) seqlock() );
+   }
+
+   /**
+    * attach - returns the seqlock that another process built at
+    * mem, e.g., the pointer returned by shm::open.
+    * @param   mem - start of the segment
+    * @return  seqlock* - throws or returns nullptr if mem doesn't
+    * hold a seqlock of this type.
+    */
+   static seqlock* attach( void *mem )
+   {
+      auto *lock( reinterpret_cast< seqlock* >( mem ) );
+      if( mem == nullptr ||
+          lock->magic != seqlock_magic ||
+          lock->item_size != sizeof( T ) )
+      {
+#if USE_CPP_EXCEPTIONS==1
+         throw invalid_segment_exception( "segment doesn't hold a seqlock of this type" );
+#else
+         return( nullptr );
+#endif
+      }
+      return( lock );
+   }
+
+   /**
+    * publish - writer side, replaces the record with item. There
+    * can only be one writer at a time.
+    */
+   void publish( const T &item )
+   {
+      const auto seq( shared.seq.load( std::memory_order_relaxed ) );
+      shared.seq.store( seq + 1, std::memory_order_relaxed );
+      /** the odd sequence is visible before any of the record **/
+      std::atomic_thread_fence( std::memory_order_release );
+      std::memcpy( &shared.value, &item, sizeof( T ) );
+      shared.seq.store( seq + 2, std::memory_order_release );
+   }
+
+   /**
+    * try_read - reader side, one attempt at copying the record
+    * out.
+    * @param   out - the record, only meaningful on success
+    * @param   version - number of publishes out is from, 0 if
+    *                    nothing was published yet
+    * @return  bool - false if the writer was in the middle of a
+    *                 publish, out may be torn
+    */
+   bool try_read( T &out, std::uint64_t &version ) const
+   {
+      const auto before( shared.seq.load( std::memory_order_acquire ) );
+      if( ( before & 0x1 ) != 0 )
+      {
+         return( false );
+      }
+      std::memcpy( &out, &shared.value, sizeof( T ) );
+      /** the copy is done before the sequence is checked again **/
+      std::atomic_thread_fence( std::memory_order_acquire );
+      if( shared.seq.load( std::memory_order_relaxed ) != before )
+      {
+         return( false );
+      }
+      version = before >> 1;
+      return( true );
+   }
+
+   /**
+    * read - reader side, retries until it gets a record that
+    * wasn't torn.
+    * @return  std::uint64_t - version of out, see try_read
+    */
+   std::uint64_t read( T &out ) const
+   {
+      std::uint64_t version( 0 );
+      while( ! try_read( out, version ) )
+      {
+         shm::futex::relax();
+      }
+      return( version );
+   }
+
+   /**
+    * version - number of publishes so far, readers compare it with
+    * what they last read to skip copying a record they already have.
+    */
+   std::uint64_t version() const
+   {
+      return( shared.seq.load( std::memory_order_acquire ) >> 1 );
+   }
+
+private:
+   static constexpr std::uint64_t seqlock_magic = 0x7365716c6f636b31ULL;
+
+   seqlock() : magic( seqlock_magic ),
+               item_size( sizeof( T ) )
+   {
+      std::memset( &shared.value, 0x0, sizeof( T ) );
+      shared.seq.store( 0, std::memory_order_relaxed );
+      std::atomic_thread_fence( std::memory_order_release );
+   }
+
+   /** read-only after create **/
+   alignas( SHM_CACHE_LINE_SIZE ) const std::uint64_t magic;
+   const std::uint64_t  item_size;
+
+   /** even while the record is whole, odd during a publish **/
+   struct alignas( SHM_CACHE_LINE_SIZE )
+   {
+      std::atomic< std::uint64_t > seq;
+      T                            value;
+   } shared;
+};
+
+#endif /* END _SHM_SEQLOCK_HPP_ */
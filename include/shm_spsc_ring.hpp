@@ -0,0 +1,263 @@
+/**
+ * shm_spsc_ring.hpp -
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * @author: Jonathan Beard
+ * @version: Oct 18 2026
+ */
+#ifndef _SHM_SPSC_RING_HPP_
+#define _SHM_SPSC_RING_HPP_  1
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <type_traits>
+
+#include <shm>
+
+/**
+ * spsc_ring - lock-free single producer, single consumer FIFO
+ * that is built inside of a segment from shm::init, so that the
+ * producer and consumer can be in different processes. The
+ * producer and consumer indices sit on their own cache lines,
+ * each side keeps a copy of the other side's index on its own
+ * line so that it only has to touch the shared line when the
+ * ring looks full (producer) or empty (consumer).
+ *
+ * Typical use:
+ * void *mem = shm::init( key, shm::spsc_ring< T >::required_bytes( n ) );
+ * auto *ring = shm::spsc_ring< T >::create( mem, n );
+ * ...other process...
+ * auto *ring = shm::spsc_ring< T >::attach( shm::open( key ) );
+ */
+template < class T > class shm::spsc_ring
+{
+public:
+   static_assert( std::is_trivially_copyable< T >::value,
+                  "spsc_ring elements are copied between processes as bytes" );
+   static_assert( alignof( T ) <= SHM_CACHE_LINE_SIZE,
+                  "spsc_ring elements can't be aligned wider than a cache line" );
+   static_assert( ATOMIC_LLONG_LOCK_FREE == 2,
+                  "spsc_ring needs address-free 64b atomics to work across processes" );
+
+   spsc_ring( const spsc_ring &other ) = delete;
+   spsc_ring& operator = ( const spsc_ring &other ) = delete;
+
+   /**
+    * required_bytes - number of bytes a segment needs to hold
+    * a ring of at least capacity items.
+    * @param   capacity - requested number of items, rounded up
+    * to a power of two.
+    * @return  std::size_t - bytes to pass to shm::init
+    */
+   static std::size_t required_bytes( const std::size_t capacity )
+   {
+      return( sizeof( spsc_ring ) + round_capacity( capacity ) * sizeof( T ) );
+   }
+
+   /**
+    * create - builds a ring at mem, which should come from
+    * shm::init with at least required_bytes( capacity ) bytes.
+    * Only one process should call create, the rest attach.
+    * @param   mem - start of the segment
+    * @param   capacity - number of items, rounded up to a power
+    * of two.
+    * @return  spsc_ring* - the ring, same address as mem
+    */
+   static spsc_ring* create( void *mem, const std::size_t capacity )
+   {
+      return( new ( mem ) spsc_ring( round_capacity( capacity ) ) );
+   }
+
+   /**
+    * attach - returns the ring that another process built at mem,
+    * e.g., the pointer returned by shm::open.
+    * @param   mem - start of the segment
+    * @return  spsc_ring* - ring, throws or returns nullptr if mem
+    * doesn't hold a ring of this type.
+    */
+   static spsc_ring* attach( void *mem )
+   {
+      auto *ring( reinterpret_cast< spsc_ring* >( mem ) );
+      if( mem == nullptr ||
+          ring->magic != ring_magic ||
+          ring->item_size != sizeof( T ) )
+      {
+#if USE_CPP_EXCEPTIONS==1
+         throw invalid_segment_exception( "segment doesn't hold an spsc_ring of this type" );
+#else
+         return( nullptr );
+#endif
+      }
+      return( ring );
+   }
+
+   /**
+    * push - producer side, copies item into the ring.
+    * @return bool - false if the ring is full
+    */
+   bool push( const T &item )
+   {
+      return( push( &item, 1 ) == 1 );
+   }
+
+   /**
+    * push - producer side, copies up to n items into the ring
+    * and makes them visible to the consumer all at once.
+    * @return std::size_t - number of items pushed, 0 if full
+    */
+   std::size_t push( const T *items, std::size_t n )
+   {
+      const auto write( producer.write.load( std::memory_order_relaxed ) );
+      if( capacity_ - ( write - producer.read_cache ) < n )
+      {
+         producer.read_cache = consumer.read.load( std::memory_order_acquire );
+         const auto free_slots( capacity_ - ( write - producer.read_cache ) );
+         if( free_slots < n )
+         {
+            n = free_slots;
+         }
+      }
+      if( n == 0 )
+      {
+         return( 0 );
+      }
+      copy_in( write, items, n );
+      producer.write.store( write + n, std::memory_order_release );
+      return( n );
+   }
+
+   /**
+    * pop - consumer side, copies the oldest item out of the ring.
+    * @return bool - false if the ring is empty
+    */
+   bool pop( T &item )
+   {
+      return( pop( &item, 1 ) == 1 );
+   }
+
+   /**
+    * pop - consumer side, copies out up to n of the oldest items
+    * and hands their slots back to the producer all at once.
+    * @return std::size_t - number of items popped, 0 if empty
+    */
+   std::size_t pop( T *items, std::size_t n )
+   {
+      const auto read( consumer.read.load( std::memory_order_relaxed ) );
+      if( consumer.write_cache - read < n )
+      {
+         consumer.write_cache = producer.write.load( std::memory_order_acquire );
+         const auto avail( consumer.write_cache - read );
+         if( avail < n )
+         {
+            n = avail;
+         }
+      }
+      if( n == 0 )
+      {
+         return( 0 );
+      }
+      copy_out( read, items, n );
+      consumer.read.store( read + n, std::memory_order_release );
+      return( n );
+   }
+
+   /** size - approximate number of items in the ring **/
+   std::size_t size() const
+   {
+      return( producer.write.load( std::memory_order_acquire ) -
+              consumer.read.load( std::memory_order_acquire ) );
+   }
+
+   bool empty() const
+   {
+      return( size() == 0 );
+   }
+
+   std::size_t capacity() const
+   {
+      return( capacity_ );
+   }
+
+private:
+   static constexpr std::uint64_t ring_magic = 0x73707363726e6731ULL;
+
+   explicit spsc_ring( const std::size_t capacity ) : magic( ring_magic ),
+                                                      item_size( sizeof( T ) ),
+                                                      capacity_( capacity ),
+                                                      mask( capacity - 1 )
+   {
+      producer.write.store( 0, std::memory_order_relaxed );
+      producer.read_cache = 0;
+      consumer.read.store( 0, std::memory_order_relaxed );
+      consumer.write_cache = 0;
+      std::atomic_thread_fence( std::memory_order_release );
+   }
+
+   static std::size_t round_capacity( const std::size_t capacity )
+   {
+      std::size_t out( 1 );
+      while( out < capacity )
+      {
+         out <<= 1;
+      }
+      return( out );
+   }
+
+   T* slots()
+   {
+      return( reinterpret_cast< T* >( reinterpret_cast< char* >( this ) + sizeof( spsc_ring ) ) );
+   }
+
+   /** copy n items starting at index, splitting at the wrap point **/
+   void copy_in( const std::uint64_t index, const T *items, const std::size_t n )
+   {
+      const auto start( index & mask );
+      const auto first( n < capacity_ - start ? n : capacity_ - start );
+      std::memcpy( &slots()[ start ], items, first * sizeof( T ) );
+      std::memcpy( slots(), items + first, ( n - first ) * sizeof( T ) );
+   }
+
+   void copy_out( const std::uint64_t index, T *items, const std::size_t n )
+   {
+      const auto start( index & mask );
+      const auto first( n < capacity_ - start ? n : capacity_ - start );
+      std::memcpy( items, &slots()[ start ], first * sizeof( T ) );
+      std::memcpy( items + first, slots(), ( n - first ) * sizeof( T ) );
+   }
+
+   /** read-only after create **/
+   alignas( SHM_CACHE_LINE_SIZE ) const std::uint64_t magic;
+   const std::uint64_t  item_size;
+   const std::uint64_t  capacity_;
+   const std::uint64_t  mask;
+
+   /** written only by the producer **/
+   struct alignas( SHM_CACHE_LINE_SIZE )
+   {
+      std::atomic< std::uint64_t > write;
+      std::uint64_t                read_cache;
+   } producer;
+
+   /** written only by the consumer **/
+   struct alignas( SHM_CACHE_LINE_SIZE )
+   {
+      std::atomic< std::uint64_t > read;
+      std::uint64_t                write_cache;
+   } consumer;
+};
+
+#endif /* END _SHM_SPSC_RING_HPP_ */
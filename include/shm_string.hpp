@@ -0,0 +1,199 @@
+/**
+ * shm_string.hpp -
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * @author: Jonathan Beard
+ * @version: Oct 18 2026
+ */
+#ifndef _SHM_STRING_HPP_
+#define _SHM_STRING_HPP_  1
+
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <string>
+
+#include <shm>
+#include <shm_arena.hpp>
+#include <shm_offset_ptr.hpp>
+
+/**
+ * string - byte string whose characters come from an shm::arena,
+ * same rules as shm::vector: the string has to live in the arena's
+ * segment to be used by other processes and isn't thread safe. The
+ * characters are always nul terminated so c_str() is free.
+ *
+ * Compares with, and hashes the same as, const char* and
+ * std::string so that shm::hash_map< shm::string, V > can be
+ * searched without building a shm::string first.
+ *
+ * Without exceptions, the calls that allocate return false when
+ * the arena is full and leave the string as it was.
+ */
+class shm::string
+{
+public:
+   using size_type   = std::size_t;
+
+   explicit string( arena *a );
+   string( arena *a, const char *str );
+   string( arena *a, const char *str, const size_type len );
+   string( arena *a, const std::string &str );
+
+   string( const string &other ) = delete;
+   string& operator = ( const string &other ) = delete;
+
+   string( string &&other ) noexcept;
+   string& operator = ( string &&other ) noexcept;
+
+   ~string();
+
+   const char* c_str() const noexcept
+   {
+      return( chars ? chars.get() : "" );
+   }
+
+   const char* data() const noexcept  { return( c_str() ); }
+   const char* begin() const noexcept { return( c_str() ); }
+   const char* end() const noexcept   { return( c_str() + size_ ); }
+
+   char& operator [] ( const size_type index ) noexcept
+   {
+      return( chars[ index ] );
+   }
+
+   char operator [] ( const size_type index ) const noexcept
+   {
+      return( c_str()[ index ] );
+   }
+
+   size_type size() const noexcept     { return( size_ ); }
+   size_type length() const noexcept   { return( size_ ); }
+   size_type capacity() const noexcept { return( capacity_ ); }
+   bool empty() const noexcept         { return( size_ == 0 ); }
+   arena* get_arena() const noexcept   { return( a.get() ); }
+
+   /** str - copy into process local memory **/
+   std::string str() const
+   {
+      return( std::string( c_str(), size_ ) );
+   }
+
+   bool reserve( const size_type n );
+   bool assign( const char *str, const size_type len );
+   bool append( const char *str, const size_type len );
+
+   bool append( const char *str )
+   {
+      return( append( str, std::strlen( str ) ) );
+   }
+
+   bool append( const std::string &str )
+   {
+      return( append( str.data(), str.size() ) );
+   }
+
+   bool push_back( const char c )
+   {
+      return( append( &c, 1 ) );
+   }
+
+   string& operator += ( const char *str )
+   {
+      append( str );
+      return( *this );
+   }
+
+   string& operator += ( const std::string &str )
+   {
+      append( str );
+      return( *this );
+   }
+
+   void clear() noexcept;
+
+   /** compare - same sign convention as std::string::compare **/
+   int compare( const char *str, const size_type len ) const noexcept;
+
+   /** hash - FNV-1a of the bytes, doesn't depend on the mapping **/
+   static std::size_t hash( const char *str, const size_type len ) noexcept;
+
+private:
+   offset_ptr< arena >  a;
+   offset_ptr< char >   chars;
+   size_type            size_       = 0;
+   size_type            capacity_   = 0;
+};
+
+inline bool operator == ( const shm::string &lhs, const shm::string &rhs ) noexcept
+{
+   return( lhs.compare( rhs.c_str(), rhs.size() ) == 0 );
+}
+
+inline bool operator == ( const shm::string &lhs, const char *rhs ) noexcept
+{
+   return( lhs.compare( rhs, std::strlen( rhs ) ) == 0 );
+}
+
+inline bool operator == ( const char *lhs, const shm::string &rhs ) noexcept
+{
+   return( rhs == lhs );
+}
+
+inline bool operator == ( const shm::string &lhs, const std::string &rhs ) noexcept
+{
+   return( lhs.compare( rhs.data(), rhs.size() ) == 0 );
+}
+
+inline bool operator == ( const std::string &lhs, const shm::string &rhs ) noexcept
+{
+   return( rhs == lhs );
+}
+
+template < class U > inline bool operator != ( const shm::string &lhs, const U &rhs ) noexcept
+{
+   return( ! ( lhs == rhs ) );
+}
+
+inline bool operator < ( const shm::string &lhs, const shm::string &rhs ) noexcept
+{
+   return( lhs.compare( rhs.c_str(), rhs.size() ) < 0 );
+}
+
+namespace std
+{
+/**
+ * hash< shm::string > - also takes const char* and std::string,
+ * shm::hash_map uses that to look up keys it doesn't have to copy.
+ */
+template <> struct hash< shm::string >
+{
+   std::size_t operator () ( const shm::string &str ) const noexcept
+   {
+      return( shm::string::hash( str.c_str(), str.size() ) );
+   }
+
+   std::size_t operator () ( const char *str ) const noexcept
+   {
+      return( shm::string::hash( str, std::strlen( str ) ) );
+   }
+
+   std::size_t operator () ( const std::string &str ) const noexcept
+   {
+      return( shm::string::hash( str.data(), str.size() ) );
+   }
+};
+} /** end namespace std **/
+
+#endif /* END _SHM_STRING_HPP_ */
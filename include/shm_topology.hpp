@@ -0,0 +1,106 @@
+/**
+ * shm_topology.hpp -
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * @author: Jonathan Beard
+ * @version: Oct 18 2026
+ */
+#ifndef _SHM_TOPOLOGY_HPP_
+#define _SHM_TOPOLOGY_HPP_  1
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <shm>
+
+/**
+ * topology - the machine as sysfs describes it: NUMA nodes, the
+ * cpus on each, the distances between them and the cpus that
+ * share a last level cache. Read once on first use and cached for
+ * the life of the process, free memory is the exception and is
+ * read again on every call. Doesn't need libnuma, on a kernel
+ * without NUMA (or off Linux) it reports a single node 0 with
+ * every online cpu.
+ *
+ * Typical use, one structure per last level cache:
+ * for( const auto &group : shm::topology::llc_groups() ){ ... }
+ */
+class shm::topology
+{
+public:
+   topology()  = delete;
+   ~topology() = delete;
+
+   struct node
+   {
+      int                  id = 0;
+      /** online cpus on this node, ascending **/
+      std::vector< int >   cpus;
+      /** MemTotal, 0 for a cpu only node **/
+      std::size_t          total_bytes = 0;
+      /** distance[ other id ], 10 is local, 0 if other isn't a node **/
+      std::vector< int >   distance;
+   };
+
+   struct cache_group
+   {
+      /** cpus sharing the cache, ascending **/
+      std::vector< int >   cpus;
+      /** cache level, e.g., 3 **/
+      int                  level = 0;
+      std::size_t          bytes = 0;
+      /** node of the first cpu **/
+      int                  node  = 0;
+   };
+
+   /** nodes - online nodes in ascending id order, never empty **/
+   static const std::vector< node >& nodes();
+
+   /** max_node - highest node id, ids can have holes **/
+   static int max_node();
+
+   /**
+    * distance - firmware distance from node from to node to,
+    * 10 is local, 0 if either isn't an online node.
+    */
+   static int distance( const int from, const int to );
+
+   /** cpus - online cpus, ascending **/
+   static const std::vector< int >& cpus();
+
+   /** node_of_cpu - node the cpu belongs to, -1 if it isn't online **/
+   static int node_of_cpu( const int cpu );
+
+   /**
+    * llc_groups - one entry per last level cache with the cpus
+    * that share it, handy to size per core or per cache structures.
+    */
+   static const std::vector< cache_group >& llc_groups();
+
+   /**
+    * free_memory - MemFree of node, not cached.
+    * @param   node - node id
+    * @return  std::size_t - bytes, 0 if node isn't online
+    */
+   static std::size_t free_memory( const int node );
+
+   /**
+    * parse_list - turns a sysfs list ("0-3,8,10-11") into its
+    * members, ascending.
+    */
+   static std::vector< int > parse_list( const char *list );
+};
+
+#endif /* END _SHM_TOPOLOGY_HPP_ */
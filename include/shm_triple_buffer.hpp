@@ -0,0 +1,240 @@
+/**
+ * shm_triple_buffer.hpp -
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * @author: Jonathan Beard
+ * @version: Oct 18 2026
+ */
+#ifndef _SHM_TRIPLE_BUFFER_HPP_
+#define _SHM_TRIPLE_BUFFER_HPP_  1
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <type_traits>
+
+#include <shm>
+#include <shm_futex.hpp>
+
+/**
+ * triple_buffer - latest value publication for large frames, one
+ * writer and any number of readers in any process. The writer
+ * fills the oldest of three buffers, in place if it likes, and
+ * then points readers at it, it never waits on readers. Readers
+ * copy out whichever buffer is newest. Each buffer carries its own
+ * sequence, so a copy only has to be retried if the writer came
+ * back around to that same buffer while it was being copied, i.e.,
+ * finished two more frames, where a single seqlock would tear on
+ * every publish during a long copy. Only the newest frame is kept,
+ * readers that fall behind skip frames.
+ *
+ * Typical use:
+ * void *mem = shm::init( key, shm::triple_buffer< frame >::required_bytes() );
+ * auto *frames = shm::triple_buffer< frame >::create( mem );
+ * frame *next = frames->begin();
+ * ...fill in next...
+ * frames->commit();
+ * ...other process...
+ * auto *frames = shm::triple_buffer< frame >::attach( shm::open( key ) );
+ * frames->read( *mine );
+ */
+template < class T > class shm::triple_buffer
+{
+public:
+   static_assert( std::is_trivially_copyable< T >::value,
+                  "triple_buffer frames are copied between processes as bytes" );
+   static_assert( alignof( T ) <= SHM_CACHE_LINE_SIZE,
+                  "triple_buffer frames can't be aligned wider than a cache line" );
+   static_assert( ATOMIC_LLONG_LOCK_FREE == 2,
+                  "triple_buffer needs address-free 64b atomics to work across processes" );
+
+   triple_buffer( const triple_buffer &other ) = delete;
+   triple_buffer& operator = ( const triple_buffer &other ) = delete;
+
+   /** required_bytes - bytes to pass to shm::init **/
+   static std::size_t required_bytes()
+   {
+      return( sizeof( triple_buffer ) );
+   }
+
+   /**
+    * create - builds a triple_buffer at mem, which should come
+    * from shm::init with at least required_bytes(). Frames read
+    * as zero until the first commit. Only one process should call
+    * create, the rest attach.
+    * @param   mem - start of the segment
+    * @return  triple_buffer* - same address as mem
+    */
+   static triple_buffer* create( void *mem )
+   {
+      return( new ( mem ) triple_buffer() );
+   }
+
+   /**
+    * attach - returns the triple_buffer that another process built
+    * at mem, e.g., the pointer returned by shm::open.
+    * @param   mem - start of the segment
+    * @return  triple_buffer* - throws or returns nullptr if mem
+    * doesn't hold a triple_buffer of this type.
+    */
+   static triple_buffer* attach( void *mem )
+   {
+      auto *buffer( reinterpret_cast< triple_buffer* >( mem ) );
+      if( mem == nullptr ||
+          buffer->magic != triple_magic ||
+          buffer->item_size != sizeof( T ) )
+      {
+#if USE_CPP_EXCEPTIONS==1
+         throw invalid_segment_exception( "segment doesn't hold a triple_buffer of this type" );
+#else
+         return( nullptr );
+#endif
+      }
+      return( buffer );
+   }
+
+   /**
+    * begin - writer side, the buffer the next frame goes in. Its
+    * contents are whatever was there three frames ago. Readers
+    * that land on it retry until commit. There can only be one
+    * writer at a time.
+    * @return  T* - fill it in, then call commit
+    */
+   T* begin()
+   {
+      auto &slot( slots[ writer.next ] );
+      const auto seq( slot.seq.load( std::memory_order_relaxed ) );
+      slot.seq.store( seq + 1, std::memory_order_relaxed );
+      /** the odd sequence is visible before any of the frame **/
+      std::atomic_thread_fence( std::memory_order_release );
+      return( &slot.value );
+   }
+
+   /** commit - writer side, makes the frame from begin the newest **/
+   void commit()
+   {
+      auto &slot( slots[ writer.next ] );
+      writer.version++;
+      slot.version.store( writer.version, std::memory_order_relaxed );
+      slot.seq.store( slot.seq.load( std::memory_order_relaxed ) + 1,
+                      std::memory_order_release );
+      latest.store( writer.next, std::memory_order_release );
+      writer.next = ( writer.next + 1 ) % buffers;
+   }
+
+   /** publish - writer side, begin, copy frame in, commit **/
+   void publish( const T &frame )
+   {
+      std::memcpy( begin(), &frame, sizeof( T ) );
+      commit();
+   }
+
+   /**
+    * try_read - reader side, one attempt at copying the newest
+    * frame out.
+    * @param   out - the frame, only meaningful on success
+    * @param   version - number of commits out is from, 0 if
+    *                    nothing was committed yet
+    * @return  bool - false if the writer lapped this copy, out
+    *                 may be torn
+    */
+   bool try_read( T &out, std::uint64_t &version ) const
+   {
+      const auto &slot( slots[ latest.load( std::memory_order_acquire ) ] );
+      const auto before( slot.seq.load( std::memory_order_acquire ) );
+      if( ( before & 0x1 ) != 0 )
+      {
+         return( false );
+      }
+      const auto copied( slot.version.load( std::memory_order_relaxed ) );
+      std::memcpy( &out, &slot.value, sizeof( T ) );
+      /** the copy is done before the sequence is checked again **/
+      std::atomic_thread_fence( std::memory_order_acquire );
+      if( slot.seq.load( std::memory_order_relaxed ) != before )
+      {
+         return( false );
+      }
+      version = copied;
+      return( true );
+   }
+
+   /**
+    * read - reader side, retries until it gets a frame that
+    * wasn't torn.
+    * @return  std::uint64_t - version of out, see try_read
+    */
+   std::uint64_t read( T &out ) const
+   {
+      std::uint64_t version( 0 );
+      while( ! try_read( out, version ) )
+      {
+         shm::futex::relax();
+      }
+      return( version );
+   }
+
+   /**
+    * version - number of commits so far, readers compare it with
+    * what they last read to skip copying a frame they already have.
+    */
+   std::uint64_t version() const
+   {
+      return( slots[ latest.load( std::memory_order_acquire ) ].version.load(
+                 std::memory_order_relaxed ) );
+   }
+
+private:
+   static constexpr std::uint64_t triple_magic = 0x7472706c62756631ULL;
+   static constexpr std::uint32_t buffers      = 3;
+
+   triple_buffer() : magic( triple_magic ),
+                     item_size( sizeof( T ) )
+   {
+      for( auto &slot : slots )
+      {
+         std::memset( &slot.value, 0x0, sizeof( T ) );
+         slot.seq.store( 0, std::memory_order_relaxed );
+         slot.version.store( 0, std::memory_order_relaxed );
+      }
+      latest.store( 0, std::memory_order_relaxed );
+      writer.next    = 1;
+      writer.version = 0;
+      std::atomic_thread_fence( std::memory_order_release );
+   }
+
+   /** read-only after create **/
+   alignas( SHM_CACHE_LINE_SIZE ) const std::uint64_t magic;
+   const std::uint64_t  item_size;
+   /** index of the newest frame, written only by the writer **/
+   std::atomic< std::uint32_t > latest;
+
+   /** only ever touched by the writer **/
+   struct alignas( SHM_CACHE_LINE_SIZE )
+   {
+      std::uint32_t next;
+      std::uint64_t version;
+   } writer;
+
+   /** seq is even while the frame is whole, odd between begin and commit **/
+   struct alignas( SHM_CACHE_LINE_SIZE ) slot_t
+   {
+      std::atomic< std::uint64_t > seq;
+      std::atomic< std::uint64_t > version;
+      alignas( SHM_CACHE_LINE_SIZE ) T value;
+   } slots[ buffers ];
+};
+
+#endif /* END _SHM_TRIPLE_BUFFER_HPP_ */
@@ -0,0 +1,232 @@
+/**
+ * shm_vector.hpp -
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * @author: Jonathan Beard
+ * @version: Oct 18 2026
+ */
+#ifndef _SHM_VECTOR_HPP_
+#define _SHM_VECTOR_HPP_  1
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <shm>
+#include <shm_arena.hpp>
+#include <shm_offset_ptr.hpp>
+
+/**
+ * vector - growable array whose storage comes from an shm::arena,
+ * the vector itself has to live in the same segment (allocated from
+ * the arena or placed in the arena's segment some other way) for
+ * other processes to use it. Elements may themselves hold
+ * offset_ptrs (e.g., shm::string), they're moved with their move
+ * constructors when the vector grows.
+ *
+ * Not thread safe, use a lock (or build it before the readers
+ * attach) if more than one process touches it.
+ *
+ * Typical use:
+ * auto *v = new ( a->allocate( sizeof( shm::vector< int > ) ) ) shm::vector< int >( a );
+ * a->set_root( v );
+ * ...other process...
+ * auto *v = reinterpret_cast< shm::vector< int >* >( a->root() );
+ *
+ * Without exceptions, the calls that allocate return false when
+ * the arena is full and leave the vector as it was.
+ */
+template < class T > class shm::vector
+{
+public:
+   using value_type     = T;
+   using size_type      = std::size_t;
+   using iterator       = T*;
+   using const_iterator = const T*;
+
+   static_assert( alignof( T ) <= arena::alignment,
+                  "vector elements can't be aligned wider than the arena's blocks" );
+
+   explicit vector( arena *a ) : a( a ) {}
+
+   vector( const vector &other ) = delete;
+   vector& operator = ( const vector &other ) = delete;
+
+   vector( vector &&other ) noexcept : a( other.a ),
+                                       elements( other.elements ),
+                                       size_( other.size_ ),
+                                       capacity_( other.capacity_ )
+   {
+      other.elements  = nullptr;
+      other.size_     = 0;
+      other.capacity_ = 0;
+   }
+
+   vector& operator = ( vector &&other ) noexcept
+   {
+      if( this != &other )
+      {
+         release();
+         a               = other.a;
+         elements        = other.elements;
+         size_           = other.size_;
+         capacity_       = other.capacity_;
+         other.elements  = nullptr;
+         other.size_     = 0;
+         other.capacity_ = 0;
+      }
+      return( *this );
+   }
+
+   ~vector()
+   {
+      release();
+   }
+
+   T* data() noexcept                  { return( elements.get() ); }
+   const T* data() const noexcept      { return( elements.get() ); }
+   iterator begin() noexcept           { return( data() ); }
+   iterator end() noexcept             { return( data() + size_ ); }
+   const_iterator begin() const noexcept { return( data() ); }
+   const_iterator end() const noexcept   { return( data() + size_ ); }
+
+   T& operator [] ( const size_type index ) noexcept
+   {
+      return( data()[ index ] );
+   }
+
+   const T& operator [] ( const size_type index ) const noexcept
+   {
+      return( data()[ index ] );
+   }
+
+   T& front() noexcept { return( data()[ 0 ] ); }
+   T& back() noexcept  { return( data()[ size_ - 1 ] ); }
+
+   size_type size() const noexcept     { return( size_ ); }
+   size_type capacity() const noexcept { return( capacity_ ); }
+   bool empty() const noexcept         { return( size_ == 0 ); }
+   arena* get_arena() const noexcept   { return( a.get() ); }
+
+   /**
+    * reserve - makes room for at least n elements.
+    * @return bool - false if the arena is out of space
+    */
+   bool reserve( const size_type n )
+   {
+      if( n <= capacity_ )
+      {
+         return( true );
+      }
+      auto *fresh( reinterpret_cast< T* >( a->allocate( n * sizeof( T ) ) ) );
+      if( fresh == nullptr )
+      {
+         return( false );
+      }
+      T *old( data() );
+      for( size_type i( 0 ); i < size_; i++ )
+      {
+         new ( fresh + i ) T( std::move( old[ i ] ) );
+         old[ i ].~T();
+      }
+      a->deallocate( old );
+      elements  = fresh;
+      /** the size class may have given us a bit more **/
+      capacity_ = arena::usable_size( fresh ) / sizeof( T );
+      return( true );
+   }
+
+   template < class... Args > bool emplace_back( Args&&... args )
+   {
+      if( size_ == capacity_ )
+      {
+         /** args may point into the storage we're about to move **/
+         T value( std::forward< Args >( args )... );
+         if( ! reserve( capacity_ == 0 ? 4 : capacity_ * 2 ) )
+         {
+            return( false );
+         }
+         new ( data() + size_ ) T( std::move( value ) );
+         size_++;
+         return( true );
+      }
+      new ( data() + size_ ) T( std::forward< Args >( args )... );
+      size_++;
+      return( true );
+   }
+
+   bool push_back( const T &value )
+   {
+      return( emplace_back( value ) );
+   }
+
+   bool push_back( T &&value )
+   {
+      return( emplace_back( std::move( value ) ) );
+   }
+
+   void pop_back()
+   {
+      size_--;
+      data()[ size_ ].~T();
+   }
+
+   /** resize - default constructs new elements, T must allow that **/
+   bool resize( const size_type n )
+   {
+      if( ! reserve( n ) )
+      {
+         return( false );
+      }
+      while( size_ < n )
+      {
+         new ( data() + size_ ) T();
+         size_++;
+      }
+      while( size_ > n )
+      {
+         pop_back();
+      }
+      return( true );
+   }
+
+   void clear()
+   {
+      while( size_ > 0 )
+      {
+         pop_back();
+      }
+   }
+
+private:
+   void release()
+   {
+      clear();
+      if( elements )
+      {
+         a->deallocate( data() );
+         elements  = nullptr;
+         capacity_ = 0;
+      }
+   }
+
+   offset_ptr< arena >  a;
+   offset_ptr< T >      elements;
+   size_type            size_       = 0;
+   size_type            capacity_   = 0;
+};
+
+#endif /* END _SHM_VECTOR_HPP_ */
@@ -18,26 +18,60 @@
  * @version: September 7 2021
  */
 #include <shm>
+#include <shm_migration.hpp>
+#include <shm_placement.hpp>
+#include <shm_segment.hpp>
+#include <shm_topology.hpp>
 #include <fcntl.h>
 /**
  * this is needed for mprotect on both the POSIX
- * and SystemV implementations 
+ * and SystemV implementations
  */
 #include <sys/mman.h>
 
-#if( _USE_SYSTEMV_SHM_ == 1)
+/** every backend is built in, the SystemV one needs these **/
 #include <sys/shm.h>
 #include <sys/ipc.h>
+/** older glibc headers only carry SHM_HUGETLB **/
+#if __linux
+#ifndef SHM_HUGE_SHIFT
+#define SHM_HUGE_SHIFT 26
+#endif
+#ifndef SHM_HUGE_2MB
+#define SHM_HUGE_2MB ( 21 << SHM_HUGE_SHIFT )
+#endif
+#ifndef SHM_HUGE_1GB
+#define SHM_HUGE_1GB ( 30 << SHM_HUGE_SHIFT )
+#endif
+/** older glibc headers don't carry the hugetlb memfd flags **/
+#ifndef MFD_HUGETLB
+#define MFD_HUGETLB 0x0004U
+#endif
+#ifndef MFD_HUGE_2MB
+#define MFD_HUGE_2MB ( 21U << 26 )
+#endif
+#ifndef MFD_HUGE_1GB
+#define MFD_HUGE_1GB ( 30U << 26 )
+#endif
+/** older headers don't carry the populate advice, Linux 5.14 **/
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 23
+#endif
 #endif
 
 #include <sys/stat.h>
 #include <sys/types.h>
+/** for handing keys (or memfd descriptors) to other processes **/
+#include <sys/socket.h>
+#include <sys/uio.h>
 #ifndef _GNU_SOURCE
 #define _GNU_SOURCE 1
 #endif
 #include <sched.h>
 #include <stdlib.h>
+#include <algorithm>
 #include <cstring>
+#include <cstdio>
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -52,6 +86,14 @@
 #include <limits>
 #include <random>
 #include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 #if __APPLE__
 #include <malloc/malloc.h>
@@ -61,16 +103,19 @@
 /** might need to install numactl-dev **/
 #include <sys/sysinfo.h>
 #include <malloc.h>
+/** for finding hugetlbfs mounts and their page size **/
+#include <mntent.h>
+#include <sys/vfs.h>
 
 #if PLATFORM_HAS_NUMA == 1
 #include <numaif.h>
 #include <numa.h>
-#endif 
+#endif
 
 #endif
 
 
-#ifndef UNUSED 
+#ifndef UNUSED
 #ifdef __clang__
 #define UNUSED( x ) (void)(x)
 #else
@@ -89,396 +134,2571 @@ SHMException::SHMException( const std::string &&message ) : SHMException( messag
 {
 }
 
-const char* 
+const char*
 SHMException::what() const noexcept
 {
     return( message.c_str() );
 };
 #endif
 
-
-void 
-shm::gen_key( shm_key_t &key, const int proj_id )
+/**
+ * alloc_size - number of bytes actually mapped for a request
+ * of nbytes, rounded up to whole pages of page_size plus one
+ * extra page for the guard.
+ */
+static std::size_t
+alloc_size( const std::size_t nbytes, const std::size_t page_size )
 {
-#if _USE_POSIX_SHM_ == 1
-    //string key
-    UNUSED( proj_id );
-    static std::random_device rd;
-    static std::mt19937 gen( rd() );
-    static std::uniform_int_distribution<> distrib( 0, std::numeric_limits< int >::max() );
-    const auto val = distrib( gen );
-    shm_key_t val_key;
-    std::memset(    val_key, 
-                    '\0', 
-                    shm_key_length );
+    return( ( ( nbytes + page_size - 1 ) / page_size + 1 ) * page_size );
+}
 
-    std::snprintf( val_key, 
-                   shm_key_length,
-                   "%d",
-                   val );
+static std::size_t
+base_page_size()
+{
+    return( static_cast< std::size_t >( sysconf( _SC_PAGESIZE ) ) );
+}
 
-    shm::key_copy( key, val_key );
-    return;
-#elif _USE_SYSTEMV_SHM_ == 1
-    //integer key
-    char *path = getcwd( nullptr, 0 );
-    if( path == nullptr )
-    {
-        std::perror( "failed to get cwd, switching to guns, a.k.a. root dir (/)" );
-        key = ftok( "/", proj_id);
-    }
-    else
+static std::size_t
+requested_page_size( const shm::page_t page )
+{
+    switch( page )
     {
-        key = ftok( path, proj_id);
+        case( shm::page_t::huge_2MB ):
+            return( std::size_t( 1 ) << 21 );
+        case( shm::page_t::huge_1GB ):
+            return( std::size_t( 1 ) << 30 );
+        default:
+            return( base_page_size() );
     }
-    return;
-#endif
 }
 
+/**
+ * page size and length (guard page included) of every mapping
+ * init and open made, keyed on start address so that close 
+ * unmaps the full length, get_page_size can answer for opened 
+ * segments and remap knows what it is remapping.
+ */
+struct mapping
+{
+    std::size_t page_size   = 0;
+    std::size_t alloc_bytes = 0;
+    /** mapped twice by mirror_mapping, can't be remapped **/
+    bool        mirrored    = false;
+};
+static std::mutex                                   page_registry_mutex;
+static std::map< std::uintptr_t, mapping >          page_registry;
 
-bool      
-shm::key_copy( shm_key_t               &dst_key,
-               const   shm_key_t        src_key )
+static void
+record_mapping( void              *ptr, 
+                const std::size_t page_size, 
+                const std::size_t alloc_bytes,
+                const bool        mirrored = false )
 {
-#if _USE_POSIX_SHM_ == 1
-    //string key
-    std::memset( dst_key, '\0', shm_key_length );
-    std::strncpy(   (char*) dst_key,
-                    src_key,
-                    shm_key_length );
-    return( true );                    
-#elif _USE_SYSTEMV_SHM_ == 1
-    dst_key = src_key;
+    std::lock_guard< std::mutex > lock( page_registry_mutex );
+    auto &entry( page_registry[ reinterpret_cast< std::uintptr_t >( ptr ) ] );
+    entry.page_size   = page_size;
+    entry.alloc_bytes = alloc_bytes;
+    entry.mirrored    = mirrored;
+}
+
+/** find_mapping - false if init or open didn't return ptr **/
+static bool
+find_mapping( void *ptr, mapping &out )
+{
+    std::lock_guard< std::mutex > lock( page_registry_mutex );
+    const auto found( page_registry.find( reinterpret_cast< std::uintptr_t >( ptr ) ) );
+    if( found == page_registry.end() )
+    {
+        return( false );
+    }
+    out = (*found).second;
     return( true );
-#else
-    //not implemented
-    return( false );
-#endif
 }
 
-void*
-shm::init( const shm_key_t     &key,
-           const std::size_t   nbytes,
-           const bool zero   /* zero mem */,
-           void   *ptr )
+static void
+forget_mapping( void *ptr )
+{
+    std::lock_guard< std::mutex > lock( page_registry_mutex );
+    page_registry.erase( reinterpret_cast< std::uintptr_t >( ptr ) );
+}
+
+/**
+ * mapping cache - with shm::cache_mappings on, open hands out one
+ * mapping per key and counts references to it, close only unmaps
+ * on the last one. The cache is split in shards on the key, so
+ * different keys never share a lock, and hits on the same key take
+ * their shard's lock shared, threads opening the same hot key only
+ * contend on the reference count.
+ */
+struct cache_key
 {
-    auto handle_open_failure = [&]( const shm_key_t &key ) -> void*
+    cache_key()
     {
-#if USE_CPP_EXCEPTIONS==1      
-        std::stringstream ss;
-#endif
-        if( errno == EEXIST )
+        std::memset( name, '\0', shm_key_length );
+    }
+
+    bool operator == ( const cache_key &other ) const
+    {
+        return( backend == other.backend &&
+                id == other.id &&
+                std::memcmp( name, other.name, shm_key_length ) == 0 );
+    }
+
+    std::uint8_t  backend = 0;
+    key_t         id      = 0;
+    char          name[ shm_key_length ];
+};
+
+struct cache_key_hash
+{
+    /** FNV-1a **/
+    std::size_t operator()( const cache_key &key ) const
+    {
+        std::uint64_t hash( 0xcbf29ce484222325ULL );
+        auto mix = [ &hash ]( const std::uint8_t byte )
         {
-#if USE_CPP_EXCEPTIONS==1      
-            ss << "SHM Handle already exists \"" << key << "\" already exists, please use open\n";
-            throw shm_already_exists( ss.str() );
-#else            
-            return( (void*)-1 );
-#endif            
+            hash = ( hash ^ byte ) * 0x100000001b3ULL;
+        };
+        for( const auto c : key.name )
+        {
+            mix( static_cast< std::uint8_t >( c ) );
         }
-        else 
+        for( std::size_t i( 0 ); i < sizeof( key_t ); i++ )
         {
-#if USE_CPP_EXCEPTIONS==1      
-            ss << "Failed to open shm with file descriptor \"" << 
-               key << "\", error code returned: ";
-            ss << std::strerror( errno );
-            throw bad_shm_alloc( ss.str() ); 
-#else
-            return( nullptr );
-#endif
+            mix( static_cast< std::uint8_t >( static_cast< std::uint64_t >( key.id ) >> ( 8 * i ) ) );
         }
-    };
+        mix( key.backend );
+        return( static_cast< std::size_t >( hash ) );
+    }
+};
 
-    if( nbytes == 0 )
+struct cache_entry
+{
+    void                        *ptr = nullptr;
+    std::atomic< std::size_t >  refs = { 1 };
+};
+
+struct alignas( SHM_CACHE_LINE_SIZE ) cache_shard
+{
+    std::shared_timed_mutex                                     lock;
+    std::unordered_map< cache_key,
+                        std::unique_ptr< cache_entry >,
+                        cache_key_hash >                        by_key;
+    /** entries whose key was unlinked while still in use, by address **/
+    std::unordered_map< std::uintptr_t,
+                        std::unique_ptr< cache_entry > >        orphans;
+};
+
+static constexpr std::size_t      cache_shards = 64;
+static cache_shard                mapping_cache[ cache_shards ];
+static std::atomic< bool >        cache_enabled = { false };
+/** entries in every shard, close skips the cache while it's 0 **/
+static std::atomic< std::size_t > cache_live    = { 0 };
+
+/** string keys (POSIX, memfd) **/
+static void
+fill_cache_key( cache_key &out, const char *key )
+{
+    std::strncpy( out.name, key, shm_key_length - 1 );
+}
+
+/** SystemV keys **/
+static void
+fill_cache_key( cache_key &out, const key_t key )
+{
+    out.id = key;
+}
+
+template < class Backend >
+static cache_key
+make_cache_key( const typename Backend::key_type &key )
+{
+    cache_key out;
+    out.backend = std::is_same< Backend, shm::sysv >::value  ? 1 :
+                  std::is_same< Backend, shm::memfd >::value ? 2 : 0;
+    fill_cache_key( out, key );
+    return( out );
+}
+
+static cache_shard&
+shard_of( const cache_key &key )
+{
+    return( mapping_cache[ cache_key_hash()( key ) % cache_shards ] );
+}
+
+/** cache_find - the cached mapping for key with a reference taken, nullptr if none **/
+static void*
+cache_find( const cache_key &key )
+{
+    auto &shard( shard_of( key ) );
+    std::shared_lock< std::shared_timed_mutex > lock( shard.lock );
+    const auto found( shard.by_key.find( key ) );
+    if( found == shard.by_key.end() )
     {
-#if USE_CPP_EXCEPTIONS==1      
-       throw bad_shm_alloc( "nbytes cannot be zero when allocating memory!" );
-#else
         return( nullptr );
-#endif
     }
-    
-    /** 
-     * NOTE: 
-     * - actual allocation size should be alloc_bytes,
-     * user has no idea so we'll re-calc this at the  end
-     * when we unmap the data.
-     * - This is the same out that is returned at the end
-     * for ease of keeping track of code between the two
-     * different versions. 
-     */
-    void *out( nullptr );
-    
+    (*found).second->refs.fetch_add( 1, std::memory_order_relaxed );
+    return( (*found).second->ptr );
+}
 
-    /**
-     * NOTE: this is largely for truncation purposes,
-     * but this is also needed as a sanity check and 
-     * some off the values are needed elsewhere so let's
-     * do this before we go into POSIX/SystemV specific 
-     * code. 
-     */
-    const auto num_phys_pages( sysconf( _SC_PHYS_PAGES ) );
-    const auto page_size( sysconf( _SC_PAGE_SIZE ) );
-    const auto total_possible_bytes( num_phys_pages * page_size );
-    if( nbytes > total_possible_bytes )
-    {
-    
-#if USE_CPP_EXCEPTIONS==1      
-         std::stringstream errstr;
-         errstr << "You've tried to allocate too many bytes (" << nbytes << "),"
-             << " the total possible is (" << total_possible_bytes << ")\n";
-         throw bad_shm_alloc( errstr.str() ); 
-#else
-         //errno should be set (hopefully)
-         return( nullptr );
-#endif
-    }
-    /** get allocations size including extra dummy page **/
-    const auto alloc_bytes( 
-       static_cast< std::size_t >( 
-          std::ceil(  
-             static_cast< float >( nbytes) / 
-            static_cast< float >( page_size ) ) + 1 /** one extra page for guard **/ ) * page_size 
-    );
-    
-#if _USE_POSIX_SHM_ == 1
-    int fd( shm::failure  );
-    //stupid hack to get around platforms that are
-    //using LD_PRELOAD, e.g., dynamic binary tools
-    struct stat st;
-    std::stringstream path;
-    path << "/dev/shm/" << key;
-    if( stat( path.str().c_str(), &st ) == 0 )
+/**
+ * cache_insert - caches ptr, a fresh mapping of key. If another
+ * thread cached one first a reference to theirs is returned and
+ * the caller unmaps its own.
+ */
+static void*
+cache_insert( const cache_key &key, void *ptr )
+{
+    auto &shard( shard_of( key ) );
+    std::unique_lock< std::shared_timed_mutex > lock( shard.lock );
+    auto &slot( shard.by_key[ key ] );
+    if( slot )
     {
-#if USE_CPP_EXCEPTIONS==1      
-        std::stringstream ss;
-#endif
-#if USE_CPP_EXCEPTIONS==1      
-            ss << "SHM Handle already exists \"" << key << "\" already exists, please use open\n";
-            throw shm_already_exists( ss.str() );
-#else            
-            return( (void*)-1 );
-#endif            
+        slot->refs.fetch_add( 1, std::memory_order_relaxed );
+        return( slot->ptr );
     }
-    
-    /* set read/write set create if not exists */
-    const std::int32_t flags( O_RDWR | O_CREAT | O_EXCL );
-    /* set read/write by user */
-    const mode_t mode( S_IWUSR | S_IRUSR );
-    fd  = shm_open( key, 
-                    flags, 
-                    mode );
-    if( fd == failure )
+    slot.reset( new cache_entry() );
+    slot->ptr = ptr;
+    cache_live.fetch_add( 1, std::memory_order_relaxed );
+    return( ptr );
+}
+
+enum class cache_result : std::uint8_t
+{
+    not_cached = 0,
+    still_used,
+    last
+};
+
+/**
+ * cache_unlink - takes key out of the index, whatever mapping of it
+ * the caller holds, so the name can be used for a new segment while
+ * the old mapping drains. Its references stay with it as an orphan.
+ */
+static void
+cache_unlink( const cache_key &key )
+{
+    if( cache_live.load( std::memory_order_relaxed ) == 0 )
     {
-        //if using exceptions you won't return
-        return( handle_open_failure( key ) );
+        return;
     }
-    
-    if( ftruncate( fd, alloc_bytes ) != shm::success )
+    auto &shard( shard_of( key ) );
+    std::unique_lock< std::shared_timed_mutex > lock( shard.lock );
+    const auto by_key( shard.by_key.find( key ) );
+    if( by_key == shard.by_key.end() )
     {
-#if USE_CPP_EXCEPTIONS==1      
-       std::stringstream ss;
-       ss << "Failed to truncate shm for file descriptor (" << fd << ") ";
-       ss << "with number of bytes (" << nbytes << ").  Error code returned: ";
-       ss << std::strerror( errno );
-       shm_unlink( key );
-       throw bad_shm_alloc( ss.str() );
-#else
-       shm_unlink( key );
-       return( nullptr );
-#endif
+        return;
     }
+    const auto address( reinterpret_cast< std::uintptr_t >( (*by_key).second->ptr ) );
+    shard.orphans[ address ] = std::move( (*by_key).second );
+    shard.by_key.erase( by_key );
+}
 
-    /** 
-     * NOTE: might be useful to change page size to something larger than default
-     * for some applications. We'll add that as a future option, however, for now
-     * I'll leave the note here.
-     * flags = MAP_HUGETLB | MAP_ANONYMOUS | MAP_HUGE_2MB
-     * flags = MAP_HUGETLB | MAP_ANONYMOUS | MAP_HUGE_1GB
-     * we'll need to make sure huge pages are installed/enabled first
-     * for ubuntu + apt:
-     * apt-get install hugepages
-     * you'll need to set it up, some good info if you don't know what you're 
-     * doing is here: https://kerneltalks.com/services/what-is-huge-pages-in-linux/
-     * you'll likely need to reboot to clear out any funky kernel states, once you're done,
-     * write a test program and make sure that you're allocating, the command:
-     * hugeadm --explain 
-     * should tell you what's set up and in use.
-     */
-    out = mmap( ptr, 
-                alloc_bytes, 
-                ( PROT_READ | PROT_WRITE ), 
-                MAP_SHARED, 
-                fd, 
-                0 );
-    if( out == MAP_FAILED )
-    {
-#if USE_CPP_EXCEPTIONS==1      
-       std::stringstream ss;
-       ss << "Failed to mmap shm region with the following error: " << 
-         std::strerror( errno ) << ",\n" << "unlinking.";
-       shm_unlink( key );
-       throw bad_shm_alloc( ss.str() );
-#else
-       shm_unlink( key );
-       return( nullptr );
-#endif
-    }
-/**
- * ###### END POSIX SECTION ######
- */
-#elif _USE_SYSTEMV_SHM_ == 1
 /**
- * ###### START SYSTEM-V SECTION  ######
+ * cache_release - drops a reference to ptr, a mapping of key. Only
+ * the last one gets last back and unmaps.
  */
-    /** first time you try to open it **/
-    const auto shmid = 
-        shmget( key, alloc_bytes, IPC_CREAT | IPC_EXCL | S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP );
-    if( shmid == shm::failure ) 
+static cache_result
+cache_release( const cache_key &key, void *ptr )
+{
+    if( cache_live.load( std::memory_order_relaxed ) == 0 )
     {
-        //if using exceptions, you won't return from this
-        return( handle_open_failure( key ) );
+        return( cache_result::not_cached );
     }
-
-    out  = shmat( shmid, nullptr, 0 );
-    if( out == (void*)-1 )
+    auto &shard( shard_of( key ) );
+    const auto address( reinterpret_cast< std::uintptr_t >( ptr ) );
+    auto find = [ & ]() -> cache_entry*
     {
-#if USE_CPP_EXCEPTIONS==1      
-       std::stringstream ss;
-       ss << "Failed to mmap shm region with the following error: " << 
-         std::strerror( errno ) << ",\n" << "unlinking.";
-       throw bad_shm_alloc( ss.str() );
-#else
-       return( nullptr );
-#endif
+        const auto by_key( shard.by_key.find( key ) );
+        if( by_key != shard.by_key.end() && (*by_key).second->ptr == ptr )
+        {
+            return( (*by_key).second.get() );
+        }
+        const auto orphan( shard.orphans.find( address ) );
+        if( orphan != shard.orphans.end() )
+        {
+            return( (*orphan).second.get() );
+        }
+        return( nullptr );
+    };
+    {
+        /** the common case, not the last reference, shared only **/
+        std::shared_lock< std::shared_timed_mutex > lock( shard.lock );
+        auto *entry( find() );
+        if( entry == nullptr )
+        {
+            return( cache_result::not_cached );
+        }
+        auto refs( entry->refs.load( std::memory_order_relaxed ) );
+        while( refs > 1 )
+        {
+            if( entry->refs.compare_exchange_weak( refs, refs - 1, std::memory_order_acq_rel ) )
+            {
+                return( cache_result::still_used );
+            }
+        }
     }
+    std::unique_lock< std::shared_timed_mutex > lock( shard.lock );
+    /** we hold a reference, it's still there, maybe orphaned since **/
+    auto *entry( find() );
+    const auto left( entry->refs.fetch_sub( 1, std::memory_order_acq_rel ) - 1 );
+    const auto by_key( shard.by_key.find( key ) );
+    const bool indexed( by_key != shard.by_key.end() && (*by_key).second.get() == entry );
+    if( left == 0 )
+    {
+        if( indexed )
+        {
+            shard.by_key.erase( by_key );
+        }
+        else
+        {
+            shard.orphans.erase( address );
+        }
+        cache_live.fetch_sub( 1, std::memory_order_relaxed );
+        return( cache_result::last );
+    }
+    return( cache_result::still_used );
+}
 
-
-#endif /** end switch between posix/sysV **/    
-    if( zero )
+#if __linux
+/**
+ * hugetlbfs_mounts - returns the mount point and page size of
+ * every hugetlbfs file system, empty if none are mounted.
+ */
+static std::vector< std::pair< std::string, std::size_t > >
+hugetlbfs_mounts()
+{
+    std::vector< std::pair< std::string, std::size_t > > out;
+    FILE *mounts( setmntent( "/proc/mounts", "r" ) );
+    if( mounts == nullptr )
     {
-       /* everything theoretically went well, lets initialize to zero */
-       std::memset( out, 0x0, nbytes );
+        return( out );
     }
-    char *temp( reinterpret_cast< char* >( out ) );
-    /** we allocate one extra page **/
-    if( mprotect( (void*) &temp[ alloc_bytes - page_size ],
-                   page_size, 
-                   PROT_NONE ) != 0 )
+    struct mntent *ent( nullptr );
+    while( ( ent = getmntent( mounts ) ) != nullptr )
     {
-#if DEBUG   
-      perror( "Error, failed to set page protection, not fatal just dangerous." );
-#endif      
-   }
-   return( out );
+        if( std::strcmp( ent->mnt_type, "hugetlbfs" ) != 0 )
+        {
+            continue;
+        }
+        struct statfs fs;
+        if( statfs( ent->mnt_dir, &fs ) == 0 )
+        {
+            out.emplace_back( ent->mnt_dir,
+                              static_cast< std::size_t >( fs.f_bsize ) );
+        }
+    }
+    endmntent( mounts );
+    return( out );
 }
 
-
-
-void*
-shm::open( const shm_key_t &key )
+/**
+ * kernel_page_size - the page size the kernel maps addr with, the
+ * KernelPageSize of its /proc/self/smaps entry, 0 if it can't tell.
+ * For segments whose backing doesn't say, e.g., SystemV SHM_HUGETLB.
+ */
+static std::size_t
+kernel_page_size( const void *addr )
 {
-   /**
-    * just like with init, use same output
-    * pointer stack location for both. 
-    */
-   void *out( nullptr );
-    
-    auto handle_open_failure = [&]( const shm_key_t &key ) -> void*
+    FILE *smaps( std::fopen( "/proc/self/smaps", "r" ) );
+    if( smaps == nullptr )
     {
-#if USE_CPP_EXCEPTIONS==1      
-        std::stringstream ss;
-        ss << 
-            "Failed to open shm with key \"" << key << "\", with the following error code (";
-        ss << std::strerror( errno ) << ")"; 
+        return( 0 );
+    }
+    const auto target( reinterpret_cast< std::uintptr_t >( addr ) );
+    /** a path can't split a line, PATH_MAX fits **/
+    char line[ PATH_MAX + 256 ];
+    bool inside( false );
+    std::size_t out( 0 );
+    while( std::fgets( line, sizeof( line ), smaps ) != nullptr )
+    {
+        unsigned long start( 0 );
+        unsigned long end( 0 );
+        if( std::sscanf( line, "%lx-%lx ", &start, &end ) == 2 )
+        {
+            inside = target >= start && target < end;
+            continue;
+        }
+        unsigned long kb( 0 );
+        if( inside && std::sscanf( line, "KernelPageSize: %lu kB", &kb ) == 1 )
+        {
+            out = static_cast< std::size_t >( kb ) << 10;
+            break;
+        }
+    }
+    std::fclose( smaps );
+    return( out );
+}
+#endif
+
+/**
+ * numa_binding - a numa_policy turned into mbind arguments,
+ * mode MPOL_DEFAULT means leave the segment alone.
+ */
+struct numa_binding
+{
+    int                          mode = 0;
+    std::vector< unsigned long > mask;
+};
+
+/**
+ * numa_prepare - checks policy and builds its mbind arguments,
+ * false with errno EINVAL if it names a node this process can't
+ * allocate on. Without NUMA support node 0 is the only node.
+ */
+static bool
+numa_prepare( const shm::numa_policy &policy, numa_binding &binding )
+{
+    if( policy.mode == shm::numa_policy::none )
+    {
+        return( true );
+    }
+#if __linux && ( PLATFORM_HAS_NUMA == 1 )
+    if( numa_available() != -1 )
+    {
+        auto nodes( policy.nodes );
+        struct bitmask *allowed( numa_get_mems_allowed() );
+        if( nodes.empty() && policy.mode == shm::numa_policy::interleave )
+        {
+            for( int node( 0 ); node <= numa_max_node(); node++ )
+            {
+                if( numa_bitmask_isbitset( allowed, node ) )
+                {
+                    nodes.push_back( node );
+                }
+            }
+        }
+        /** preferred takes a single node **/
+        if( policy.mode == shm::numa_policy::preferred && nodes.size() > 1 )
+        {
+            nodes.resize( 1 );
+        }
+        bool valid( ! nodes.empty() );
+        const auto bits_per_long( sizeof( unsigned long ) * CHAR_BIT );
+        binding.mask.assign( numa_max_possible_node() / bits_per_long + 1, 0 );
+        for( const auto node : nodes )
+        {
+            if( node < 0 || node > numa_max_node() || 
+                ! numa_bitmask_isbitset( allowed, node ) )
+            {
+                valid = false;
+                break;
+            }
+            binding.mask[ node / bits_per_long ] |= 1UL << ( node % bits_per_long );
+        }
+        numa_bitmask_free( allowed );
+        if( ! valid )
+        {
+            errno = EINVAL;
+            return( false );
+        }
+        switch( policy.mode )
+        {
+            case( shm::numa_policy::bind ):
+                binding.mode = MPOL_BIND;
+                break;
+            case( shm::numa_policy::preferred ):
+                binding.mode = MPOL_PREFERRED;
+                break;
+            default:
+                binding.mode = MPOL_INTERLEAVE;
+                break;
+        }
+        return( true );
+    }
+#endif
+    /** one node, anything that only names it is a no-op **/
+    for( const auto node : policy.nodes )
+    {
+        if( node != 0 )
+        {
+            errno = EINVAL;
+            return( false );
+        }
+    }
+    return( true );
+}
+
+/**
+ * numa_apply - sets binding on the len bytes at ptr, has to run
+ * before the pages are touched, pages that already exist aren't
+ * moved.
+ */
+static bool
+numa_apply( void *ptr, const std::size_t len, const numa_binding &binding )
+{
+#if __linux && ( PLATFORM_HAS_NUMA == 1 )
+    if( binding.mode == 0 )
+    {
+        return( true );
+    }
+    const auto maxnode( binding.mask.size() * sizeof( unsigned long ) * CHAR_BIT + 1 );
+    return( mbind( ptr, len, binding.mode, binding.mask.data(), maxnode, 0 ) == 0 );
+#else
+    UNUSED( ptr );
+    UNUSED( len );
+    UNUSED( binding );
+    return( true );
+#endif
+}
+
+/**
+ * populate_flag - MAP_POPULATE for the backends to add to their
+ * mmap flags when populate asks for it. Pages populated before
+ * the transparent huge page advice would all be base pages, so
+ * then (or without MAP_POPULATE) populate is cleared and init
+ * populates after the advice instead.
+ */
+static int
+populate_flag( bool &populate, const bool advise_thp )
+{
+#ifdef MAP_POPULATE
+    if( populate && ! advise_thp )
+    {
+        return( MAP_POPULATE );
+    }
+#else
+    UNUSED( advise_thp );
+#endif
+    populate = false;
+    return( 0 );
+}
+
+/**
+ * touch_pages - write faults every page in [ base, base + len ),
+ * the add of zero leaves whatever is there alone, the segment is
+ * already visible to anyone with the key.
+ */
+static void
+touch_pages( char *base, const std::size_t len, const std::size_t page_size )
+{
+    auto *bytes( reinterpret_cast< volatile char* >( base ) );
+    for( std::size_t offset( 0 ); offset < len; offset += page_size )
+    {
+        __atomic_fetch_add( bytes + offset, 0, __ATOMIC_RELAXED );
+    }
+}
+
+/**
+ * populate_write - faults in len bytes at ptr with one call,
+ * kernels older than 5.14 don't know the advice and get the
+ * pages touched instead.
+ */
+static bool
+populate_write( void *ptr, const std::size_t len, const std::size_t page_size )
+{
+#if __linux
+    if( madvise( ptr, len, MADV_POPULATE_WRITE ) == 0 )
+    {
+        return( true );
+    }
+    if( errno != EINVAL )
+    {
+        return( false );
+    }
+#endif
+    touch_pages( reinterpret_cast< char* >( ptr ), len, page_size );
+    return( true );
+}
+
+/**
+ * first_touch - splits len bytes at ptr into contiguous shares,
+ * one per worker thread, each pinned to a cpu this process may
+ * use. Workers are spread over the nodes in proportion to their
+ * cpus and a node's workers get neighboring shares, so without a
+ * NUMA policy every node ends up with a contiguous piece of the
+ * segment. Small segments aren't worth a thread.
+ */
+static void
+first_touch( void *ptr, const std::size_t len, const std::size_t page_size )
+{
+    constexpr std::size_t min_share( 4 << 20 );
+    std::vector< int > cpus;
+#if __linux
+    const auto num_cpus( get_nprocs_conf() );
+    cpu_set_t *allowed( CPU_ALLOC( num_cpus ) );
+    const auto allowed_size( CPU_ALLOC_SIZE( num_cpus ) );
+    CPU_ZERO_S( allowed_size, allowed );
+    const bool have_mask( sched_getaffinity( 0, allowed_size, allowed ) == 0 );
+    for( const auto &node : shm::topology::nodes() )
+    {
+        for( const auto cpu : node.cpus )
+        {
+            if( ! have_mask || ( cpu < num_cpus && CPU_ISSET_S( cpu, allowed_size, allowed ) ) )
+            {
+                cpus.push_back( cpu );
+            }
+        }
+    }
+    CPU_FREE( allowed );
+#endif
+    const auto pages( ( len + page_size - 1 ) / page_size );
+    const auto workers( std::max( std::size_t( 1 ),
+                        std::min( { cpus.size(), len / min_share, pages } ) ) );
+    char *base( reinterpret_cast< char* >( ptr ) );
+    if( workers == 1 )
+    {
+        touch_pages( base, len, page_size );
+        return;
+    }
+    std::vector< std::thread > threads;
+    threads.reserve( workers );
+    std::size_t first( 0 );
+    for( std::size_t worker( 0 ); worker < workers; worker++ )
+    {
+        /** evenly spaced through the node ordered cpus **/
+        const auto cpu( cpus[ worker * cpus.size() / workers ] );
+        const auto count( pages / workers + ( worker < pages % workers ? 1 : 0 ) );
+        const auto offset( first * page_size );
+        const auto bytes( std::min( count * page_size, len - offset ) );
+        threads.emplace_back( [ = ]()
+        {
+#if __linux
+            cpu_set_t *mine( CPU_ALLOC( cpu + 1 ) );
+            const auto mine_size( CPU_ALLOC_SIZE( cpu + 1 ) );
+            CPU_ZERO_S( mine_size, mine );
+            CPU_SET_S( cpu, mine_size, mine );
+            /** not fatal, the pages still get touched **/
+            if( sched_setaffinity( 0, mine_size, mine ) != 0 )
+            {
+#if DEBUG
+                perror( "Failed to pin first touch worker, not fatal." );
+#endif
+            }
+            CPU_FREE( mine );
+#else
+            UNUSED( cpu );
+#endif
+            touch_pages( base + offset, bytes, page_size );
+        } );
+        first += count;
+    }
+    for( auto &thread : threads )
+    {
+        thread.join();
+    }
+}
+
+/**
+ * remove_pages - frees the pages behind len bytes at ptr
+ * (MADV_REMOVE), the range has to be whole pages of the mapping.
+ * errno is EINVAL when the mapping (or platform) can't do it.
+ */
+static bool
+remove_pages( void *ptr, const std::size_t len )
+{
+#if defined( MADV_REMOVE )
+    return( madvise( ptr, len, MADV_REMOVE ) == 0 );
+#else
+    UNUSED( ptr );
+    UNUSED( len );
+    errno = EINVAL;
+    return( false );
+#endif
+}
+
+/** unsupported - errno says the call can't work here, not that it failed **/
+static bool
+unsupported( const int error )
+{
+    return( error == EINVAL || error == ENOTSUP || error == EOPNOTSUPP || error == ENOSYS );
+}
+
+/**
+ * init_failure - what init does when a backend can't create the
+ * segment, errno is EEXIST when the key is already in use.
+ */
+template < class Key >
+static void*
+init_failure( const Key &key )
+{
+#if USE_CPP_EXCEPTIONS==1
+    std::stringstream ss;
+#else
+    UNUSED( key );
+#endif
+    if( errno == EEXIST )
+    {
+#if USE_CPP_EXCEPTIONS==1
+        ss << "SHM Handle already exists \"" << key << "\" already exists, please use open\n";
+        throw shm_already_exists( ss.str() );
+#else
+        return( (void*)-1 );
+#endif
+    }
+    else
+    {
+#if USE_CPP_EXCEPTIONS==1
+        ss << "Failed to open shm with file descriptor \"" <<
+           key << "\", error code returned: ";
+        ss << std::strerror( errno );
         throw bad_shm_alloc( ss.str() );
 #else
         return( nullptr );
 #endif
+    }
+}
 
-    };
-#if _USE_POSIX_SHM_ == 1
-   int fd( shm::failure );
-   const int flags( O_RDWR | O_CREAT );
-   mode_t mode( 0 );
-   fd = shm_open( key, 
-                  flags, 
-                  mode ); 
-   if( fd == failure )
-   {
-        return( handle_open_failure( key ) );
-   }
+/** open_failure - what open does when the key can't be found **/
+template < class Key >
+static void*
+open_failure( const Key &key )
+{
+#if USE_CPP_EXCEPTIONS==1
+    std::stringstream ss;
+    ss <<
+        "Failed to open shm with key \"" << key << "\", with the following error code (";
+    ss << std::strerror( errno ) << ")";
+    throw bad_shm_alloc( ss.str() );
+#else
+    UNUSED( key );
+    return( nullptr );
+#endif
+}
+
+/** unlink_failure - what close does when unlinking fails **/
+static void
+unlink_failure()
+{
+#if USE_CPP_EXCEPTIONS==1
+    switch( errno )
+    {
+       case( ENOENT ):
+       {
+           throw invalid_key_exception( "Invalid file descriptor specified" );
+       }
+       break;
+       default:
+       {
+           throw invalid_key_exception( "Undefined error, check error codes" );
+       }
+    }
+#endif
+}
+
+/**
+ * map_fd - maps the whole file behind fd for open, shared by the
+ * descriptor based backends. release is called before any
+ * failure, an empty file is a key that was never init'd.
+ * hugetlbfs reports its page size as the block size, page_size
+ * is raised to match. alloc_bytes is the length mapped.
+ */
+template < class Key, class Release >
+static void*
+map_fd( const Key      &key, 
+        const int      fd, 
+        Release        &&release, 
+        std::size_t    &page_size,
+        std::size_t    &alloc_bytes )
+{
    struct stat st;
-   std::memset( &st, 
-                0x0, 
+   std::memset( &st,
+                0x0,
                 sizeof( struct stat ) );
    /* stat the file to get the size */
-   if( fstat( fd, &st ) != shm::success )
+   if( fstat( fd, &st ) != 0 )
    {
-#if USE_CPP_EXCEPTIONS==1      
+#if USE_CPP_EXCEPTIONS==1
       std::stringstream ss;
       ss << "Failed to stat shm region with the following error: " << std::strerror( errno ) << ",\n";
       ss << "unlinking.";
-      shm_unlink( key );
+      release();
+      throw bad_shm_alloc( ss.str() );
+#else
+      release();
+      return( nullptr );
+#endif
+   }
+   if( st.st_size == 0 )
+   {
+      release();
+      errno = ENOENT;
+      return( open_failure( key ) );
+   }
+#if __linux
+   struct statfs fs;
+   if( fstatfs( fd, &fs ) == 0 &&
+       static_cast< std::size_t >( fs.f_bsize ) > page_size )
+   {
+      page_size = static_cast< std::size_t >( fs.f_bsize );
+   }
+#endif
+   alloc_bytes = static_cast< std::size_t >( st.st_size );
+   void *out( mmap( nullptr,
+                    alloc_bytes,
+                    (PROT_READ | PROT_WRITE),
+                    MAP_SHARED,
+                    fd,
+                    0 ) );
+   if( out == MAP_FAILED )
+   {
+#if USE_CPP_EXCEPTIONS==1
+      std::stringstream ss;
+      ss << "Failed to mmap shm region with the following error: " << std::strerror( errno ) << ",\n";
+      ss << "unlinking.";
+      release();
       throw bad_shm_alloc( ss.str() );
 #else
-      shm_unlink( key );
+      release();
       return( nullptr );
 #endif
    }
-   out = mmap( nullptr, 
-               st.st_size, 
-               (PROT_READ | PROT_WRITE), 
-               MAP_SHARED, 
-               fd, 
-               0 );
-   if( out == MAP_FAILED )
+   return( out );
+}
+
+/**
+ * unmap - munmap for the descriptor based backends, the full
+ * length including the guard page.
+ */
+static void
+unmap( void **ptr, const std::size_t nbytes )
+{
+   if( ptr == nullptr )
+   {
+      return;
+   }
+   /** 
+    * get allocations size including extra guard page, what was
+    * actually mapped wins, the segment may have been resized 
+    */
+   mapping known;
+   const auto alloc_bytes( find_mapping( *ptr, known ) ? 
+                           known.alloc_bytes : 
+                           alloc_size( nbytes, shm::get_page_size( *ptr ) ) );
+   if( ( *ptr != nullptr ) && ( munmap( *ptr, alloc_bytes ) != 0 ) )
+   {
+#if DEBUG
+      perror( "Failed to unmap shared memory, attempting to close!!" );
+#endif
+   }
+   forget_mapping( *ptr );
+   *ptr = nullptr;
+}
+
+/** string keys (POSIX, memfd) **/
+static void
+copy_string_key( char *dst_key, const char *src_key )
+{
+    std::memset( dst_key, '\0', shm_key_length );
+    std::strncpy(   dst_key,
+                    src_key,
+                    shm_key_length - 1 );
+}
+
+/**
+ * send_key_bytes/recv_key_bytes - keys that mean the same thing
+ * in every process are simply sent as bytes.
+ */
+template < class Key >
+static bool
+send_key_bytes( const int socket, const Key &key )
+{
+    struct msghdr msg;
+    std::memset( &msg, 0x0, sizeof( msg ) );
+    struct iovec iov = { const_cast< void* >( static_cast< const void* >( &key ) ),
+                         sizeof( Key ) };
+    msg.msg_iov         = &iov;
+    msg.msg_iovlen      = 1;
+    return( sendmsg( socket, &msg, 0 ) == static_cast< ssize_t >( sizeof( Key ) ) );
+}
+
+template < class Key >
+static bool
+recv_key_bytes( const int socket, Key &key )
+{
+    struct msghdr msg;
+    std::memset( &msg, 0x0, sizeof( msg ) );
+    unsigned char payload[ sizeof( Key ) ];
+    struct iovec iov = { payload, sizeof( payload ) };
+    msg.msg_iov         = &iov;
+    msg.msg_iovlen      = 1;
+    if( recvmsg( socket, &msg, MSG_WAITALL ) != static_cast< ssize_t >( sizeof( payload ) ) )
+    {
+        return( false );
+    }
+    std::memcpy( &key, payload, sizeof( Key ) );
+    return( true );
+}
+
+/**
+ * backend_ops - one specialization per backend. The shm:: entry
+ * points do everything the backends have in common (argument
+ * checks, zeroing, the guard page, page size bookkeeping) and
+ * call these for the rest:
+ *  gen_key( key, proj_id )
+ *  key_copy( dst, src )
+ *  send_key( socket, key ), recv_key( socket, key )
+ *  create( key, nbytes, ptr, page, page_size, advise_thp ) - makes
+ *      and maps the segment, page_size and advise_thp come in as
+ *      requested and go out as what was actually used. Failures
+ *      go through init_failure or throw.
+ *  open( key, page_size ) - maps an existing segment
+ *  close( key, ptr, nbytes, unlink ) - unmaps and optionally
+ *      removes the segment
+ */
+#define SHM_BACKEND_OPS( BACKEND )                                        \
+template <> struct shm::backend_ops< BACKEND >                            \
+{                                                                         \
+    using key_type = BACKEND::key_type;                                   \
+    static void  gen_key( key_type &key, const int proj_id );             \
+    static bool  key_copy( key_type &dst_key, const key_type src_key );   \
+    static bool  send_key( const int socket, const key_type &key );       \
+    static bool  recv_key( const int socket, key_type &key );             \
+    static void* create( const key_type     &key,                         \
+                         const std::size_t  nbytes,                       \
+                         void               *ptr,                         \
+                         const shm::page_t  page,                         \
+                         std::size_t        &page_size,                   \
+                         bool               &advise_thp,                  \
+                         bool               &populate,                    \
+                         int                &handle,                      \
+                         bool               &owned );                     \
+    static bool  allocate( const key_type     &key,                       \
+                           const int          mode,                       \
+                           const std::size_t  offset,                     \
+                           const std::size_t  len );                      \
+    static bool  truncate( const key_type &key, const std::size_t bytes );\
+    static void* open( const key_type     &key,                           \
+                       std::size_t        &page_size,                     \
+                       std::size_t        &alloc_bytes,                   \
+                       int                &handle,                        \
+                       bool               &owned );                       \
+    static bool  close( const key_type     &key,                          \
+                        void               **ptr,                         \
+                        const std::size_t  nbytes,                        \
+                        const bool         unlink );                      \
+}
+
+SHM_BACKEND_OPS( shm::posix );
+SHM_BACKEND_OPS( shm::sysv );
+SHM_BACKEND_OPS( shm::memfd );
+
+/**
+ * ###### START POSIX SECTION ######
+ */
+#if __linux
+/**
+ * hugetlbfs_init - creates and maps a segment of alloc_bytes
+ * on the hugetlbfs mount with the given page size. Returns
+ * nullptr if there is no such mount or if the kernel can't back
+ * the mapping (e.g., no huge pages reserved), errno is EEXIST
+ * only when the key is already in use.
+ */
+static void*
+hugetlbfs_init( const shm::posix::key_type  &key,
+                const std::size_t           alloc_bytes,
+                const std::size_t           page_size,
+                void                        *ptr,
+                const int                   map_flags,
+                int                         &handle )
+{
+    std::string path;
+    for( const auto &mount : hugetlbfs_mounts() )
+    {
+        if( mount.second == page_size )
+        {
+            path = mount.first + "/" + key;
+            break;
+        }
+    }
+    if( path.empty() )
+    {
+        errno = ENOENT;
+        return( nullptr );
+    }
+    const int fd( ::open( path.c_str(), O_RDWR | O_CREAT | O_EXCL, S_IWUSR | S_IRUSR ) );
+    if( fd == -1 )
+    {
+        return( nullptr );
+    }
+    void *out( nullptr );
+    if( ftruncate( fd, alloc_bytes ) == 0 )
+    {
+        out = mmap( ptr,
+                    alloc_bytes,
+                    ( PROT_READ | PROT_WRITE ),
+                    MAP_SHARED | map_flags,
+                    fd,
+                    0 );
+    }
+    if( out == nullptr || out == MAP_FAILED )
+    {
+        ::close( fd );
+        unlink( path.c_str() );
+        errno = ENOMEM;
+        return( nullptr );
+    }
+    handle = fd;
+    return( out );
+}
+#endif
+
+/**
+ * posix_unlink - unlinks key from /dev/shm, or from whichever
+ * hugetlbfs mount holds it.
+ */
+static int
+posix_unlink( const shm::posix::key_type &key )
+{
+    if( shm_unlink( key ) == 0 )
+    {
+        return( 0 );
+    }
+#if __linux
+    if( errno == ENOENT )
+    {
+        for( const auto &mount : hugetlbfs_mounts() )
+        {
+            const auto path( mount.first + "/" + key );
+            if( unlink( path.c_str() ) == 0 )
+            {
+                return( 0 );
+            }
+        }
+        errno = ENOENT;
+    }
+#endif
+    return( -1 );
+}
+
+/**
+ * posix_open_existing - descriptor for a segment that init made,
+ * same lookup as open (hugetlbfs first) without creating it.
+ */
+static int
+posix_open_existing( const shm::posix::key_type &key )
+{
+#if __linux
+    for( const auto &mount : hugetlbfs_mounts() )
+    {
+        const auto path( mount.first + "/" + key );
+        const int fd( ::open( path.c_str(), O_RDWR ) );
+        if( fd != -1 )
+        {
+            return( fd );
+        }
+    }
+#endif
+    return( shm_open( key, O_RDWR, 0 ) );
+}
+
+void
+shm::backend_ops< shm::posix >::gen_key( key_type &key, const int proj_id )
+{
+    //string key
+    UNUSED( proj_id );
+    static std::random_device rd;
+    static std::mt19937 gen( rd() );
+    static std::uniform_int_distribution<> distrib( 0, std::numeric_limits< int >::max() );
+    /** pools make keys from their own thread **/
+    static std::mutex gen_mutex;
+    int val( 0 );
+    {
+        std::lock_guard< std::mutex > lock( gen_mutex );
+        val = distrib( gen );
+    }
+    key_type val_key;
+    std::memset(    val_key,
+                    '\0',
+                    shm_key_length );
+
+    std::snprintf( val_key,
+                   shm_key_length,
+                   "%d",
+                   val );
+
+    copy_string_key( key, val_key );
+}
+
+bool
+shm::backend_ops< shm::posix >::key_copy( key_type &dst_key, const key_type src_key )
+{
+    copy_string_key( dst_key, src_key );
+    return( true );
+}
+
+bool
+shm::backend_ops< shm::posix >::send_key( const int socket, const key_type &key )
+{
+    return( send_key_bytes( socket, key ) );
+}
+
+bool
+shm::backend_ops< shm::posix >::recv_key( const int socket, key_type &key )
+{
+    if( ! recv_key_bytes( socket, key ) )
+    {
+        return( false );
+    }
+    key[ shm_key_length - 1 ] = '\0';
+    return( true );
+}
+
+void*
+shm::backend_ops< shm::posix >::create( const key_type     &key,
+                                        const std::size_t  nbytes,
+                                        void               *ptr,
+                                        const shm::page_t  page,
+                                        std::size_t        &page_size,
+                                        bool               &advise_thp,
+                                        bool               &populate,
+                                        int                &handle,
+                                        bool               &owned )
+{
+    UNUSED( page );
+    void *out( nullptr );
+    if( page_size != base_page_size() )
+    {
+#if __linux
+        out = hugetlbfs_init( key,
+                              alloc_size( nbytes, page_size ),
+                              page_size,
+                              ptr,
+                              populate_flag( populate, advise_thp ),
+                              handle );
+        if( out == nullptr && errno == EEXIST )
+        {
+            //if using exceptions you won't return
+            return( init_failure( key ) );
+        }
+#endif
+        if( out == nullptr )
+        {
+            page_size  = base_page_size();
+            advise_thp = true;
+        }
+    }
+    if( out != nullptr )
+    {
+        owned = true;
+        return( out );
+    }
+    /** get allocations size including extra guard page **/
+    const auto alloc_bytes( alloc_size( nbytes, page_size ) );
+
+    int fd( shm::failure  );
+    //stupid hack to get around platforms that are
+    //using LD_PRELOAD, e.g., dynamic binary tools
+    struct stat st;
+    std::stringstream path;
+    path << "/dev/shm/" << key;
+    if( stat( path.str().c_str(), &st ) == 0 )
+    {
+        errno = EEXIST;
+        return( init_failure( key ) );
+    }
+
+    /* set read/write set create if not exists */
+    const std::int32_t flags( O_RDWR | O_CREAT | O_EXCL );
+    /* set read/write by user */
+    const mode_t mode( S_IWUSR | S_IRUSR );
+    fd  = shm_open( key,
+                    flags,
+                    mode );
+    if( fd == failure )
+    {
+        //if using exceptions you won't return
+        return( init_failure( key ) );
+    }
+
+    if( ftruncate( fd, alloc_bytes ) != shm::success )
+    {
+#if USE_CPP_EXCEPTIONS==1
+       std::stringstream ss;
+       ss << "Failed to truncate shm for file descriptor (" << fd << ") ";
+       ss << "with number of bytes (" << nbytes << ").  Error code returned: ";
+       ss << std::strerror( errno );
+       ::close( fd );
+       shm_unlink( key );
+       throw bad_shm_alloc( ss.str() );
+#else
+       ::close( fd );
+       shm_unlink( key );
+       return( nullptr );
+#endif
+    }
+
+    out = mmap( ptr,
+                alloc_bytes,
+                ( PROT_READ | PROT_WRITE ),
+                MAP_SHARED | populate_flag( populate, advise_thp ),
+                fd,
+                0 );
+    if( out == MAP_FAILED )
+    {
+       ::close( fd );
+#if USE_CPP_EXCEPTIONS==1
+       std::stringstream ss;
+       ss << "Failed to mmap shm region with the following error: " <<
+         std::strerror( errno ) << ",\n" << "unlinking.";
+       shm_unlink( key );
+       throw bad_shm_alloc( ss.str() );
+#else
+       shm_unlink( key );
+       return( nullptr );
+#endif
+    }
+    /** the mapping holds its own reference, the descriptor is the caller's **/
+    handle = fd;
+    owned  = true;
+    return( out );
+}
+
+bool
+shm::backend_ops< shm::posix >::allocate( const key_type     &key,
+                                          const int          mode,
+                                          const std::size_t  offset,
+                                          const std::size_t  len )
+{
+#if __linux
+   const int fd( posix_open_existing( key ) );
+   if( fd == failure )
+   {
+      return( false );
+   }
+   const auto ret( fallocate( fd, mode, offset, len ) );
+   const auto fallocate_errno( errno );
+   ::close( fd );
+   errno = fallocate_errno;
+   return( ret == shm::success );
+#else
+   UNUSED( key );
+   UNUSED( mode );
+   UNUSED( offset );
+   UNUSED( len );
+   errno = ENOTSUP;
+   return( false );
+#endif
+}
+
+bool
+shm::backend_ops< shm::posix >::truncate( const key_type &key, const std::size_t bytes )
+{
+   const int fd( posix_open_existing( key ) );
+   if( fd == failure )
+   {
+      return( false );
+   }
+   const auto ret( ftruncate( fd, bytes ) );
+   const auto truncate_errno( errno );
+   ::close( fd );
+   errno = truncate_errno;
+   return( ret == shm::success );
+}
+
+void*
+shm::backend_ops< shm::posix >::open( const key_type     &key,
+                                      std::size_t        &page_size,
+                                      std::size_t        &alloc_bytes,
+                                      int                &handle,
+                                      bool               &owned )
+{
+   int fd( shm::failure );
+#if __linux
+   /** segments on a hugetlbfs mount take precedence over /dev/shm **/
+   for( const auto &mount : hugetlbfs_mounts() )
+   {
+      const auto path( mount.first + "/" + key );
+      fd = ::open( path.c_str(), O_RDWR );
+      if( fd != failure )
+      {
+         break;
+      }
+   }
+#endif
+   if( fd == failure )
+   {
+      const int flags( O_RDWR | O_CREAT );
+      mode_t mode( 0 );
+      fd = shm_open( key,
+                     flags,
+                     mode );
+   }
+   if( fd == failure )
+   {
+      return( open_failure( key ) );
+   }
+   /** on failure past this point POSIX removes the broken segment **/
+   void *out( map_fd( key,
+                      fd,
+                      [&](){ ::close( fd ); posix_unlink( key ); },
+                      page_size,
+                      alloc_bytes ) );
+   if( out != nullptr )
+   {
+      /** the caller closes it or keeps it **/
+      handle = fd;
+      owned  = true;
+   }
+   return( out );
+}
+
+bool
+shm::backend_ops< shm::posix >::close( const key_type     &key,
+                                       void               **ptr,
+                                       const std::size_t  nbytes,
+                                       const bool         unlink )
+{
+   unmap( ptr, nbytes );
+   if( unlink && posix_unlink( key ) != 0 )
+   {
+      unlink_failure();
+   }
+   return( true );
+}
+/**
+ * ###### END POSIX SECTION ######
+ */
+
+/**
+ * ###### START SYSTEM-V SECTION  ######
+ */
+void
+shm::backend_ops< shm::sysv >::gen_key( key_type &key, const int proj_id )
+{
+    //integer key
+    char *path = getcwd( nullptr, 0 );
+    if( path == nullptr )
+    {
+        std::perror( "failed to get cwd, switching to guns, a.k.a. root dir (/)" );
+        key = ftok( "/", proj_id);
+    }
+    else
+    {
+        key = ftok( path, proj_id);
+        free( path );
+    }
+}
+
+bool
+shm::backend_ops< shm::sysv >::key_copy( key_type &dst_key, const key_type src_key )
+{
+    dst_key = src_key;
+    return( true );
+}
+
+bool
+shm::backend_ops< shm::sysv >::send_key( const int socket, const key_type &key )
+{
+    return( send_key_bytes( socket, key ) );
+}
+
+bool
+shm::backend_ops< shm::sysv >::recv_key( const int socket, key_type &key )
+{
+    return( recv_key_bytes( socket, key ) );
+}
+
+void*
+shm::backend_ops< shm::sysv >::create( const key_type     &key,
+                                       const std::size_t  nbytes,
+                                       void               *ptr,
+                                       const shm::page_t  page,
+                                       std::size_t        &page_size,
+                                       bool               &advise_thp,
+                                       bool               &populate,
+                                       int                &handle,
+                                       bool               &owned )
+{
+    UNUSED( ptr );
+    UNUSED( page );
+    /** shmat can't populate, init does it **/
+    populate = false;
+    const int shm_flags( IPC_CREAT | IPC_EXCL | S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP );
+    int shmid( shm::failure );
+    if( page_size != base_page_size() )
+    {
+#if __linux
+        const int huge_flags( SHM_HUGETLB |
+            ( page == shm::page_t::huge_1GB ? SHM_HUGE_1GB : SHM_HUGE_2MB ) );
+        /** first time you try to open it **/
+        shmid = shmget( key, alloc_size( nbytes, page_size ), shm_flags | huge_flags );
+        if( shmid == shm::failure && errno == EEXIST )
+        {
+            //if using exceptions, you won't return from this
+            return( init_failure( key ) );
+        }
+#endif
+        if( shmid == shm::failure )
+        {
+            page_size  = base_page_size();
+            advise_thp = true;
+        }
+    }
+    /** get allocations size including extra guard page **/
+    const auto alloc_bytes( alloc_size( nbytes, page_size ) );
+    if( shmid == shm::failure )
+    {
+        /** first time you try to open it **/
+        shmid = shmget( key, alloc_bytes, shm_flags );
+    }
+    if( shmid == shm::failure )
+    {
+        //if using exceptions, you won't return from this
+        return( init_failure( key ) );
+    }
+
+    void *out( shmat( shmid, nullptr, 0 ) );
+    if( out == (void*)-1 )
+    {
+#if USE_CPP_EXCEPTIONS==1
+       std::stringstream ss;
+       ss << "Failed to mmap shm region with the following error: " <<
+         std::strerror( errno ) << ",\n" << "unlinking.";
+       throw bad_shm_alloc( ss.str() );
+#else
+       return( nullptr );
+#endif
+    }
+    /** nothing to close, the id is all there is **/
+    handle = shmid;
+    owned  = false;
+    return( out );
+}
+
+bool
+shm::backend_ops< shm::sysv >::allocate( const key_type     &key,
+                                         const int          mode,
+                                         const std::size_t  offset,
+                                         const std::size_t  len )
+{
+    /** no file, callers fall back to working on the mapping **/
+    UNUSED( key );
+    UNUSED( mode );
+    UNUSED( offset );
+    UNUSED( len );
+    errno = ENOTSUP;
+    return( false );
+}
+
+bool
+shm::backend_ops< shm::sysv >::truncate( const key_type &key, const std::size_t bytes )
+{
+    /** a SystemV segment's size is fixed at shmget **/
+    UNUSED( key );
+    UNUSED( bytes );
+    errno = ENOTSUP;
+    return( false );
+}
+
+void*
+shm::backend_ops< shm::sysv >::open( const key_type     &key,
+                                     std::size_t        &page_size,
+                                     std::size_t        &alloc_bytes,
+                                     int                &handle,
+                                     bool               &owned )
+{
+//STEP1 shmget
+    const auto shmid =
+        shmget( key, sizeof(int), S_IRUSR | S_IWUSR );
+    if( shmid == shm::failure )
+    {
+        //if using exceptions, you won't return from this
+        return( open_failure( key ) );
+    }
+//STEP2 shmat
+    void *out( shmat(shmid, nullptr, 0) );
+    if( out == (void*)-1 )
+    {
+#if USE_CPP_EXCEPTIONS==1
+        std::stringstream ss;
+        ss << "Failed to SHM attach the shm region with the following error ("
+            <<  std::strerror( errno ) << ").";
+        throw bad_shm_alloc( ss.str() );
+#else
+        return( nullptr );
+#endif
+    }
+    /** the kernel knows the size even though shmget didn't need it **/
+    struct shmid_ds ds;
+    if( shmctl( shmid, IPC_STAT, &ds ) == shm::success )
+    {
+        alloc_bytes = ds.shm_segsz;
+    }
+#if __linux
+    /** nothing in the id says SHM_HUGETLB, the mapping does **/
+    const auto kernel( kernel_page_size( out ) );
+    if( kernel != 0 )
+    {
+        page_size = kernel;
+    }
+#endif
+    handle = shmid;
+    owned  = false;
+    return( out );
+}
+
+bool
+shm::backend_ops< shm::sysv >::close( const key_type     &key,
+                                      void               **ptr,
+                                      const std::size_t  nbytes,
+                                      const bool         unlink )
+{
+    UNUSED( nbytes );
+    /**
+     * we could have gotten here b/c something failed and the
+     * user code is now calling close on an invalid shm seg.
+     * so let's stat first to be sure.
+     */
+     const auto shmid =
+         shmget( key, sizeof(int), S_IRUSR | S_IWUSR );
+     if( shmid == shm::failure )
+     {
+#if USE_CPP_EXCEPTIONS==1
+        if( errno == ENOENT )
+        {
+            throw invalid_key_exception( "SHM key doesn't exist" );
+        }
+#else
+        return( true );
+#endif
+     }
+    /**
+     * NOTE: This may not work quite perfectly b/c
+     * if there are M communicating pairs and you
+     * call this and only one happens to be detached,
+     * then this may cause the segment to be deleted.
+     */
+    if(unlink /** only do this once **/  && shmctl(shmid, IPC_RMID, nullptr) == -1)
+    {
+#if USE_CPP_EXCEPTIONS==1
+       if( errno == EINVAL || errno == EIDRM )
+       {
+          throw invalid_key_exception( "Invalid SHM key" );
+       }
+       std::stringstream ss;
+       ss << "Failed to set the SystemV memory region to exit on detach, non-fatal error ("
+         << std::strerror( errno ) << ")\n";
+       throw bad_shm_alloc( ss.str() );
+#else
+       return( false );
+#endif
+    }
+     //else we're here, and it exists
+     if( ptr == nullptr || *ptr == nullptr )
+     {
+        /** nothing attached, only unlinking **/
+        return( true );
+     }
+     if( shmdt( *ptr ) == shm::failure )
+     {
+#if USE_CPP_EXCEPTIONS==1
+        std::stringstream ss;
+        ss << "Failed to detach SHM with error code ("
+            <<  std::strerror( errno ) << ").";
+        throw invalid_key_exception( ss.str() );
+#else
+        return( false );
+#endif
+     }
+     forget_mapping( *ptr );
+     *ptr = nullptr;
+     return( true );
+}
+/**
+ * ###### END SYSTEM-V SECTION ######
+ */
+
+/**
+ * ###### START MEMFD SECTION ######
+ */
+#if __linux
+/**
+ * memfd_parse_key - splits a "<pid>/<fd>" key, false if key
+ * isn't one.
+ */
+static bool
+memfd_parse_key( const shm::memfd::key_type &key, pid_t &pid, int &fd )
+{
+    char *end( nullptr );
+    const auto key_pid( std::strtol( key, &end, 10 ) );
+    if( end == key || *end != '/' || key_pid <= 0 )
+    {
+        return( false );
+    }
+    const char *fd_str( end + 1 );
+    const auto key_fd( std::strtol( fd_str, &end, 10 ) );
+    if( end == fd_str || *end != '\0' || key_fd < 0 )
+    {
+        return( false );
+    }
+    pid = static_cast< pid_t >( key_pid );
+    fd  = static_cast< int >( key_fd );
+    return( true );
+}
+
+static void
+memfd_make_key( shm::memfd::key_type &key, const int fd )
+{
+    std::memset( key, '\0', shm_key_length );
+    std::snprintf( key,
+                   shm_key_length,
+                   "%d/%d",
+                   static_cast< int >( getpid() ),
+                   fd );
+}
+
+/**
+ * memfd_open_fd - returns a descriptor for the file key names
+ * that this process can use. Keys made by this process are used
+ * as is, keys made by another process are opened through its
+ * /proc entry (owned is set, the caller has to close that one),
+ * and if the creator is gone a forked child falls back to the
+ * descriptor it inherited. -1 with errno set on failure.
+ */
+static int
+memfd_open_fd( const shm::memfd::key_type &key, bool &owned )
+{
+    owned = false;
+    pid_t pid( 0 );
+    int   fd( -1 );
+    if( ! memfd_parse_key( key, pid, fd ) )
+    {
+        errno = EINVAL;
+        return( -1 );
+    }
+    if( pid == getpid() )
+    {
+        return( fcntl( fd, F_GETFD ) == -1 ? -1 : fd );
+    }
+    std::stringstream path;
+    path << "/proc/" << pid << "/fd/" << fd;
+    const int proc_fd( ::open( path.str().c_str(), O_RDWR | O_CLOEXEC ) );
+    if( proc_fd != -1 )
+    {
+        owned = true;
+        return( proc_fd );
+    }
+    /** only sealable files, don't map whatever else has that number **/
+    if( fcntl( fd, F_GET_SEALS ) != -1 )
+    {
+        return( fd );
+    }
+    errno = ENOENT;
+    return( -1 );
+}
+
+void
+shm::backend_ops< shm::memfd >::gen_key( key_type &key, const int proj_id )
+{
+    /** the name only shows up in /proc/<pid>/fd, it needn't be unique **/
+    std::stringstream name;
+    name << "shm-" << proj_id;
+    const int fd( memfd_create( name.str().c_str(), MFD_CLOEXEC | MFD_ALLOW_SEALING ) );
+    if( fd == shm::failure )
+    {
+        std::perror( "failed to create memfd, key left empty" );
+        std::memset( key, '\0', shm_key_length );
+        return;
+    }
+    memfd_make_key( key, fd );
+}
+
+bool
+shm::backend_ops< shm::memfd >::key_copy( key_type &dst_key, const key_type src_key )
+{
+    copy_string_key( dst_key, src_key );
+    return( true );
+}
+
+bool
+shm::backend_ops< shm::memfd >::send_key( const int socket, const key_type &key )
+{
+    struct msghdr msg;
+    std::memset( &msg, 0x0, sizeof( msg ) );
+    bool owned( false );
+    const int fd( memfd_open_fd( key, owned ) );
+    if( fd == failure )
+    {
+        return( false );
+    }
+    /** one byte of payload, the descriptor rides along **/
+    char payload( 'k' );
+    struct iovec iov = { &payload, sizeof( payload ) };
+    union
+    {
+        char            buffer[ CMSG_SPACE( sizeof( int ) ) ];
+        struct cmsghdr  align;
+    } control;
+    std::memset( &control, 0x0, sizeof( control ) );
+    msg.msg_control     = control.buffer;
+    msg.msg_controllen  = sizeof( control.buffer );
+    auto *cmsg( CMSG_FIRSTHDR( &msg ) );
+    cmsg->cmsg_level    = SOL_SOCKET;
+    cmsg->cmsg_type     = SCM_RIGHTS;
+    cmsg->cmsg_len      = CMSG_LEN( sizeof( int ) );
+    std::memcpy( CMSG_DATA( cmsg ), &fd, sizeof( int ) );
+    msg.msg_iov         = &iov;
+    msg.msg_iovlen      = 1;
+    const auto sent( sendmsg( socket, &msg, 0 ) );
+    if( owned )
+    {
+        const auto send_errno( errno );
+        ::close( fd );
+        errno = send_errno;
+    }
+    return( sent == static_cast< ssize_t >( sizeof( payload ) ) );
+}
+
+bool
+shm::backend_ops< shm::memfd >::recv_key( const int socket, key_type &key )
+{
+    struct msghdr msg;
+    std::memset( &msg, 0x0, sizeof( msg ) );
+    char payload( '\0' );
+    struct iovec iov = { &payload, sizeof( payload ) };
+    union
+    {
+        char            buffer[ CMSG_SPACE( sizeof( int ) ) ];
+        struct cmsghdr  align;
+    } control;
+    msg.msg_control     = control.buffer;
+    msg.msg_controllen  = sizeof( control.buffer );
+    msg.msg_iov         = &iov;
+    msg.msg_iovlen      = 1;
+    if( recvmsg( socket, &msg, MSG_CMSG_CLOEXEC ) != sizeof( payload ) )
+    {
+        return( false );
+    }
+    auto *cmsg( CMSG_FIRSTHDR( &msg ) );
+    if( cmsg == nullptr ||
+        cmsg->cmsg_level != SOL_SOCKET ||
+        cmsg->cmsg_type != SCM_RIGHTS )
+    {
+        errno = EBADMSG;
+        return( false );
+    }
+    int fd( failure );
+    std::memcpy( &fd, CMSG_DATA( cmsg ), sizeof( int ) );
+    memfd_make_key( key, fd );
+    return( true );
+}
+
+void*
+shm::backend_ops< shm::memfd >::create( const key_type     &key,
+                                        const std::size_t  nbytes,
+                                        void               *ptr,
+                                        const shm::page_t  page,
+                                        std::size_t        &page_size,
+                                        bool               &advise_thp,
+                                        bool               &populate,
+                                        int                &handle,
+                                        bool               &owned )
+{
+    void *out( nullptr );
+    const int fd( memfd_open_fd( key, owned ) );
+    if( fd == failure )
+    {
+        //if using exceptions you won't return
+        return( init_failure( key ) );
+    }
+    /** descriptors we opened through /proc are ours to close **/
+    auto release_fd = [&]()
+    {
+        if( owned )
+        {
+            ::close( fd );
+        }
+    };
+    struct stat st;
+    std::memset( &st, 0x0, sizeof( struct stat ) );
+    if( fstat( fd, &st ) != shm::success || st.st_size != 0 )
+    {
+        /** a size means init already ran on this key **/
+        if( st.st_size != 0 )
+        {
+            errno = EEXIST;
+        }
+        release_fd();
+        //if using exceptions you won't return
+        return( init_failure( key ) );
+    }
+    /**
+     * huge pages need a hugetlb memfd, it takes over the descriptor
+     * number the key names (only if that one is ours) so the key
+     * stays valid.
+     */
+    if( page_size != base_page_size() && ! owned )
+    {
+        const int huge_fd( memfd_create( "shm",
+            MFD_CLOEXEC | MFD_ALLOW_SEALING | MFD_HUGETLB |
+            ( page == shm::page_t::huge_1GB ? MFD_HUGE_1GB : MFD_HUGE_2MB ) ) );
+        if( huge_fd != failure )
+        {
+            const auto huge_bytes( alloc_size( nbytes, page_size ) );
+            if( ftruncate( huge_fd, huge_bytes ) == shm::success )
+            {
+                out = mmap( ptr,
+                            huge_bytes,
+                            ( PROT_READ | PROT_WRITE ),
+                            MAP_SHARED | populate_flag( populate, advise_thp ),
+                            huge_fd,
+                            0 );
+            }
+            if( out == MAP_FAILED )
+            {
+                out = nullptr;
+            }
+            if( out != nullptr && dup3( huge_fd, fd, O_CLOEXEC ) == failure )
+            {
+                munmap( out, huge_bytes );
+                out = nullptr;
+            }
+            ::close( huge_fd );
+        }
+    }
+    if( out == nullptr && page_size != base_page_size() )
+    {
+        page_size  = base_page_size();
+        advise_thp = true;
+    }
+    /** get allocations size including extra guard page **/
+    const auto alloc_bytes( alloc_size( nbytes, page_size ) );
+    if( out == nullptr )
+    {
+        if( ftruncate( fd, alloc_bytes ) != shm::success )
+        {
+#if USE_CPP_EXCEPTIONS==1
+           std::stringstream ss;
+           ss << "Failed to truncate memfd (" << key << ") ";
+           ss << "with number of bytes (" << nbytes << ").  Error code returned: ";
+           ss << std::strerror( errno );
+           release_fd();
+           throw bad_shm_alloc( ss.str() );
+#else
+           release_fd();
+           return( nullptr );
+#endif
+        }
+        out = mmap( ptr,
+                    alloc_bytes,
+                    ( PROT_READ | PROT_WRITE ),
+                    MAP_SHARED | populate_flag( populate, advise_thp ),
+                    fd,
+                    0 );
+        if( out == MAP_FAILED )
+        {
+            /** back to empty so the key can be init'd again **/
+            const auto mmap_errno( errno );
+            if( ftruncate( fd, 0 ) != shm::success )
+            {
+#if DEBUG
+               perror( "Failed to reset memfd size after failed mmap." );
+#endif
+            }
+            release_fd();
+#if USE_CPP_EXCEPTIONS==1
+           std::stringstream ss;
+           ss << "Failed to mmap memfd region with the following error: " <<
+             std::strerror( mmap_errno );
+           throw bad_shm_alloc( ss.str() );
+#else
+           errno = mmap_errno;
+           return( nullptr );
+#endif
+        }
+    }
+    /**
+     * it can grow (shm::resize) but never shrink, no opener can
+     * fault past the end of the file (SIGBUS)
+     */
+    if( fcntl( fd, F_ADD_SEALS, F_SEAL_SHRINK ) != shm::success )
+    {
+#if DEBUG
+      perror( "Failed to seal memfd, not fatal." );
+#endif
+    }
+    /** the caller closes it if it's ours, the key's own stays open **/
+    handle = fd;
+    return( out );
+}
+
+bool
+shm::backend_ops< shm::memfd >::allocate( const key_type     &key,
+                                          const int          mode,
+                                          const std::size_t  offset,
+                                          const std::size_t  len )
+{
+   bool owned( false );
+   const int fd( memfd_open_fd( key, owned ) );
+   if( fd == failure )
+   {
+      return( false );
+   }
+   const auto ret( fallocate( fd, mode, offset, len ) );
+   const auto fallocate_errno( errno );
+   if( owned )
+   {
+      ::close( fd );
+   }
+   errno = fallocate_errno;
+   return( ret == shm::success );
+}
+
+bool
+shm::backend_ops< shm::memfd >::truncate( const key_type &key, const std::size_t bytes )
+{
+   bool owned( false );
+   const int fd( memfd_open_fd( key, owned ) );
+   if( fd == failure )
+   {
+      return( false );
+   }
+   const auto ret( ftruncate( fd, bytes ) );
+   const auto truncate_errno( errno );
+   if( owned )
+   {
+      ::close( fd );
+   }
+   errno = truncate_errno;
+   return( ret == shm::success );
+}
+
+void*
+shm::backend_ops< shm::memfd >::open( const key_type     &key,
+                                      std::size_t        &page_size,
+                                      std::size_t        &alloc_bytes,
+                                      int                &handle,
+                                      bool               &owned )
+{
+   const int fd( memfd_open_fd( key, owned ) );
+   if( fd == failure )
+   {
+      return( open_failure( key ) );
+   }
+   /** the key's own descriptor stays open, it is the segment **/
+   auto release_fd = [&]()
+   {
+      if( owned )
+      {
+         ::close( fd );
+      }
+   };
+   void *out( map_fd( key, fd, release_fd, page_size, alloc_bytes ) );
+   if( out != nullptr )
+   {
+      handle = fd;
+   }
+   return( out );
+}
+
+bool
+shm::backend_ops< shm::memfd >::close( const key_type     &key,
+                                       void               **ptr,
+                                       const std::size_t  nbytes,
+                                       const bool         unlink )
+{
+   unmap( ptr, nbytes );
+   if( unlink )
+   {
+      /**
+       * nothing to unlink, the file goes away with its last
+       * descriptor and mapping, drop ours if the key names one
+       */
+      pid_t pid( 0 );
+      int   fd( -1 );
+      bool unlinked( memfd_parse_key( key, pid, fd ) );
+      if( unlinked && pid == getpid() )
+      {
+         unlinked = ( ::close( fd ) == 0 );
+      }
+      if( ! unlinked )
+      {
+         errno = ENOENT;
+         unlink_failure();
+      }
+   }
+   return( true );
+}
+#else /** no memfd_create outside of Linux **/
+void
+shm::backend_ops< shm::memfd >::gen_key( key_type &key, const int proj_id )
+{
+    UNUSED( proj_id );
+    std::memset( key, '\0', shm_key_length );
+}
+
+bool
+shm::backend_ops< shm::memfd >::key_copy( key_type &dst_key, const key_type src_key )
+{
+    copy_string_key( dst_key, src_key );
+    return( true );
+}
+
+bool
+shm::backend_ops< shm::memfd >::send_key( const int socket, const key_type &key )
+{
+    UNUSED( socket );
+    UNUSED( key );
+    errno = ENOSYS;
+    return( false );
+}
+
+bool
+shm::backend_ops< shm::memfd >::recv_key( const int socket, key_type &key )
+{
+    UNUSED( socket );
+    UNUSED( key );
+    errno = ENOSYS;
+    return( false );
+}
+
+void*
+shm::backend_ops< shm::memfd >::create( const key_type     &key,
+                                        const std::size_t  nbytes,
+                                        void               *ptr,
+                                        const shm::page_t  page,
+                                        std::size_t        &page_size,
+                                        bool               &advise_thp,
+                                        bool               &populate,
+                                        int                &handle,
+                                        bool               &owned )
+{
+    UNUSED( nbytes );
+    UNUSED( ptr );
+    UNUSED( page );
+    UNUSED( page_size );
+    UNUSED( advise_thp );
+    UNUSED( populate );
+    UNUSED( handle );
+    UNUSED( owned );
+    errno = ENOSYS;
+    return( init_failure( key ) );
+}
+
+bool
+shm::backend_ops< shm::memfd >::allocate( const key_type     &key,
+                                          const int          mode,
+                                          const std::size_t  offset,
+                                          const std::size_t  len )
+{
+    UNUSED( key );
+    UNUSED( mode );
+    UNUSED( offset );
+    UNUSED( len );
+    errno = ENOSYS;
+    return( false );
+}
+
+bool
+shm::backend_ops< shm::memfd >::truncate( const key_type &key, const std::size_t bytes )
+{
+    UNUSED( key );
+    UNUSED( bytes );
+    errno = ENOSYS;
+    return( false );
+}
+
+void*
+shm::backend_ops< shm::memfd >::open( const key_type     &key,
+                                      std::size_t        &page_size,
+                                      std::size_t        &alloc_bytes,
+                                      int                &handle,
+                                      bool               &owned )
+{
+    UNUSED( page_size );
+    UNUSED( alloc_bytes );
+    UNUSED( handle );
+    UNUSED( owned );
+    errno = ENOSYS;
+    return( open_failure( key ) );
+}
+
+bool
+shm::backend_ops< shm::memfd >::close( const key_type     &key,
+                                       void               **ptr,
+                                       const std::size_t  nbytes,
+                                       const bool         unlink )
+{
+    UNUSED( key );
+    UNUSED( unlink );
+    unmap( ptr, nbytes );
+    return( true );
+}
+#endif
+/**
+ * ###### END MEMFD SECTION ######
+ */
+
+
+template < class Backend >
+void
+shm::gen_key( typename Backend::key_type &key, const int proj_id )
+{
+    backend_ops< Backend >::gen_key( key, proj_id );
+}
+
+template < class Backend >
+bool
+shm::key_copy( typename Backend::key_type       &dst_key,
+               const typename Backend::key_type &src_key )
+{
+    return( backend_ops< Backend >::key_copy( dst_key, src_key ) );
+}
+
+template < class Backend >
+bool
+shm::send_key( const int socket, const typename Backend::key_type &key )
+{
+    return( backend_ops< Backend >::send_key( socket, key ) );
+}
+
+template < class Backend >
+bool
+shm::recv_key( const int socket, typename Backend::key_type &key )
+{
+    return( backend_ops< Backend >::recv_key( socket, key ) );
+}
+
+/**
+ * populate_segment - faults in the len bytes at ptr the way mode
+ * asks, false with errno set if the pages can't be had. Backends
+ * without a file to fallocate populate instead.
+ */
+template < class Backend >
+bool
+shm::populate_segment( const typename Backend::key_type  &key,
+                       void                              *ptr,
+                       const std::size_t                 len,
+                       const std::size_t                 page_size,
+                       const shm::populate_t             mode )
+{
+    switch( mode )
+    {
+        case( shm::populate_t::none ):
+            return( true );
+        case( shm::populate_t::fallocate ):
+        {
+            if( backend_ops< Backend >::allocate( key, 0, 0, len ) )
+            {
+                return( true );
+            }
+            if( ! unsupported( errno ) )
+            {
+                return( false );
+            }
+            return( populate_write( ptr, len, page_size ) );
+        }
+        case( shm::populate_t::first_touch ):
+            first_touch( ptr, len, page_size );
+            return( true );
+        default:
+            return( populate_write( ptr, len, page_size ) );
+    }
+}
+
+template < class Backend >
+void*
+shm::init_mapping( const typename Backend::key_type &key,
+                   const std::size_t        nbytes,
+                   void                     *ptr,
+                   const shm::page_t        page,
+                   const shm::numa_policy   &numa,
+                   const shm::populate_t    populate,
+                   backing                  &info )
+{
+    if( nbytes == 0 )
+    {
+#if USE_CPP_EXCEPTIONS==1
+       throw bad_shm_alloc( "nbytes cannot be zero when allocating memory!" );
+#else
+        return( nullptr );
+#endif
+    }
+
+    /**
+     * NOTE: this is largely for truncation purposes,
+     * but this is also needed as a sanity check and
+     * some off the values are needed elsewhere so let's
+     * do this before we go into backend specific
+     * code.
+     */
+    const auto num_phys_pages( sysconf( _SC_PHYS_PAGES ) );
+    const auto sys_page_size( sysconf( _SC_PAGE_SIZE ) );
+    const auto total_possible_bytes( num_phys_pages * sys_page_size );
+    if( nbytes > total_possible_bytes )
+    {
+
+#if USE_CPP_EXCEPTIONS==1
+         std::stringstream errstr;
+         errstr << "You've tried to allocate too many bytes (" << nbytes << "),"
+             << " the total possible is (" << total_possible_bytes << ")\n";
+         throw bad_shm_alloc( errstr.str() );
+#else
+         //errno should be set (hopefully)
+         return( nullptr );
+#endif
+    }
+    /**
+     * NOTE: huge pages need to be installed/enabled first,
+     * for ubuntu + apt:
+     * apt-get install hugepages
+     * you'll need to set it up, some good info if you don't know what you're
+     * doing is here: https://kerneltalks.com/services/what-is-huge-pages-in-linux/
+     * for POSIX you'll also need a hugetlbfs mount per page size, e.g.,
+     * mount -t hugetlbfs -o pagesize=1G none /dev/hugepages1G
+     * the command:
+     * hugeadm --explain
+     * should tell you what's set up and in use. If the requested
+     * page size can't be had we fall back to base pages and ask
+     * for transparent huge pages instead.
+     */
+    auto page_size( requested_page_size( page ) );
+    bool advise_thp( page == shm::page_t::transparent );
+
+    /** check the nodes before there's a segment to clean up **/
+    numa_binding binding;
+    if( ! numa_prepare( numa, binding ) )
+    {
+#if USE_CPP_EXCEPTIONS==1
+        std::stringstream ss;
+        ss << "Invalid NUMA policy for \"" << key << "\", the nodes have to be ones "
+           << "this process may allocate on.";
+        throw bad_shm_alloc( ss.str() );
+#else
+        return( nullptr );
+#endif
+    }
+
+    /** 
+     * MAP_POPULATE faults the pages before mbind can run, with a
+     * policy they are populated after it instead
+     */
+    bool map_populate( populate == shm::populate_t::map_populate && 
+                       binding.mode == 0 );
+
+    /**
+     * NOTE:
+     * - actual allocation size should be alloc_bytes,
+     * user has no idea so we'll re-calc this at the  end
+     * when we unmap the data.
+     */
+    info.handle = shm::failure;
+    info.owned  = false;
+    void *out( backend_ops< Backend >::create( key,
+                                               nbytes,
+                                               ptr,
+                                               page,
+                                               page_size,
+                                               advise_thp,
+                                               map_populate,
+                                               info.handle,
+                                               info.owned ) );
+    if( out == nullptr || out == (void*)-1 )
+    {
+        /** only without exceptions, errno is set **/
+        return( out );
+    }
+    /** the segment is gone if we fail past here, so is the descriptor **/
+    auto drop_handle = [&]()
+    {
+        if( info.owned )
+        {
+            ::close( info.handle );
+        }
+        info.handle = shm::failure;
+        info.owned  = false;
+    };
+    /** get allocations size including extra guard page **/
+    const auto alloc_bytes( alloc_size( nbytes, page_size ) );
+    /** nothing has touched the segment yet, placement goes first **/
+    if( ! numa_apply( out, alloc_bytes - page_size, binding ) )
+    {
+        const auto mbind_errno( errno );
+        drop_handle();
+        backend_ops< Backend >::close( key, &out, nbytes, true );
+        errno = mbind_errno;
+#if USE_CPP_EXCEPTIONS==1
+        std::stringstream ss;
+        ss << "Failed to apply the NUMA policy with the following error: " <<
+           std::strerror( mbind_errno ) << ", unlinked.";
+        throw bad_shm_alloc( ss.str() );
+#else
+        return( nullptr );
+#endif
+    }
+#ifdef MADV_HUGEPAGE
+    if( advise_thp &&
+        madvise( out, alloc_bytes - page_size, MADV_HUGEPAGE ) != shm::success )
+    {
+#if DEBUG
+      perror( "Failed to advise transparent huge pages, not fatal." );
+#endif
+    }
+#else
+    UNUSED( advise_thp );
+#endif
+    if( ! populate_segment< Backend >( key, 
+                                       out, 
+                                       alloc_bytes - page_size, 
+                                       page_size,
+                                       map_populate ? shm::populate_t::none : populate ) )
+    {
+        const auto populate_errno( errno );
+        drop_handle();
+        backend_ops< Backend >::close( key, &out, nbytes, true );
+        errno = populate_errno;
+#if USE_CPP_EXCEPTIONS==1
+        std::stringstream ss;
+        ss << "Failed to populate the segment with the following error: " <<
+           std::strerror( populate_errno ) << ", unlinked.";
+        throw bad_shm_alloc( ss.str() );
+#else
+        return( nullptr );
+#endif
+    }
+    record_mapping( out, page_size, alloc_bytes );
+    info.page_size   = page_size;
+    info.alloc_bytes = alloc_bytes;
+    char *temp( reinterpret_cast< char* >( out ) );
+    /** we allocate one extra page **/
+    if( mprotect( (void*) &temp[ alloc_bytes - page_size ],
+                   page_size,
+                   PROT_NONE ) != 0 )
+    {
+#if DEBUG
+      perror( "Error, failed to set page protection, not fatal just dangerous." );
+#endif
+   }
+   return( out );
+}
+
+template < class Backend >
+void*
+shm::init( const typename Backend::key_type &key,
+           const std::size_t   nbytes,
+           const bool zero   /* zero mem */,
+           void   *ptr,
+           const shm::page_t page,
+           const shm::numa_policy &numa,
+           const shm::populate_t populate )
+{
+    /** init only creates new objects, the kernel zeroes those **/
+    UNUSED( zero );
+    errno = 0;
+    auto seg( shm::segment::create< Backend >( key, nbytes, page, numa, populate, ptr ) );
+    if( ! seg && errno == EEXIST )
+    {
+        /** without exceptions, the key is taken, open it instead **/
+        return( (void*)-1 );
+    }
+    return( seg.release() );
+}
+
+template < class Backend >
+void*
+shm::open_mapping( const typename Backend::key_type &key, backing &info )
+{
+   info.page_size   = base_page_size();
+   info.alloc_bytes = 0;
+   info.handle      = shm::failure;
+   info.owned       = false;
+   void *out( backend_ops< Backend >::open( key, 
+                                            info.page_size, 
+                                            info.alloc_bytes,
+                                            info.handle,
+                                            info.owned ) );
+   if( out != nullptr && out != (void*)-1 )
+   {
+      record_mapping( out, info.page_size, info.alloc_bytes );
+   }
+   //if we're here, everything theoretically worked
+   return( out );
+}
+
+template < class Backend >
+void*
+shm::open( const typename Backend::key_type &key )
+{
+   if( ! cache_enabled.load( std::memory_order_relaxed ) )
+   {
+      return( shm::segment::open< Backend >( key ).release() );
+   }
+   const auto cached_key( make_cache_key< Backend >( key ) );
+   void *out( cache_find( cached_key ) );
+   if( out != nullptr )
+   {
+      return( out );
+   }
+   out = shm::segment::open< Backend >( key ).release();
+   if( out == nullptr || out == (void*)-1 )
+   {
+      return( out );
+   }
+   void *kept( cache_insert( cached_key, out ) );
+   if( kept != out )
+   {
+      /** lost the race to another thread, use theirs **/
+      backend_ops< Backend >::close( key, &out, shm::get_mapped_size( out ), false );
+   }
+   return( kept );
+}
+
+template < class Backend >
+bool
+shm::close( const typename Backend::key_type &key,
+            void **ptr,
+            const std::size_t nbytes,
+            const bool zero,
+            const bool unlink )
+{
+   return( shm::close< Backend >( key, 
+                                  ptr, 
+                                  nbytes, 
+                                  zero ? release_t::remove : release_t::none, 
+                                  unlink ) );
+}
+
+template < class Backend >
+bool
+shm::close( const typename Backend::key_type &key,
+            void **ptr,
+            const std::size_t nbytes,
+            const shm::release_t release,
+            const bool unlink )
+{
+   if( unlink )
+   {
+      /** the name goes away even if ptr isn't the cached mapping, or is nullptr **/
+      cache_unlink( make_cache_key< Backend >( key ) );
+   }
+   if( ( ptr != nullptr ) && ( *ptr != nullptr ) &&
+       cache_release( make_cache_key< Backend >( key ), *ptr ) == cache_result::still_used )
    {
-#if USE_CPP_EXCEPTIONS==1      
-      std::stringstream ss;
-      ss << "Failed to mmap shm region with the following error: " << std::strerror( errno ) << ",\n";
-      ss << "unlinking.";
-      shm_unlink( key );
-      throw bad_shm_alloc( ss.str() );
-#else
-      shm_unlink( key );
-      return( nullptr );
+      /** somebody else in this process still uses the mapping **/
+      *ptr = nullptr;
+      if( ! unlink )
+      {
+         return( true );
+      }
+      void *none( nullptr );
+      return( backend_ops< Backend >::close( key, &none, nbytes, true ) );
+   }
+   if( release != release_t::none && (ptr != nullptr) && ( *ptr != nullptr ) )
+   {
+      /** whole pages, the last one is partly past nbytes **/
+      const auto page_size( shm::get_page_size( *ptr ) );
+      const auto len( alloc_size( nbytes, page_size ) - page_size );
+      bool released( false );
+#if defined( FALLOC_FL_PUNCH_HOLE ) && defined( FALLOC_FL_KEEP_SIZE )
+      if( release == release_t::punch_hole )
+      {
+         released = backend_ops< Backend >::allocate( key, 
+                                                      FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, 
+                                                      0, 
+                                                      len );
+      }
 #endif
+      if( ! released && release != release_t::zero )
+      {
+         released = remove_pages( *ptr, len );
+      }
+      if( ! released )
+      {
+         std::memset( *ptr, 0x0, nbytes );
+      }
    }
-   /* close fd */
-   ::close( fd );
-   /* done, return mem */
-   return( out );
+   return( backend_ops< Backend >::close( key, ptr, nbytes, unlink ) );
+}
 
-/** END POSIX MEMORY **/
-#elif _USE_SYSTEMV_SHM_ == 1
-/** START SYSTEMV MEMORY **/
+template < class Backend >
+bool
+shm::resize( const typename Backend::key_type &key, 
+             void **ptr, 
+             const std::size_t nbytes )
+{
+   return( shm::resize_mapping( ptr, 
+                                nbytes, 
+                                [ & ]( const std::size_t bytes )
+                                {
+                                   return( backend_ops< Backend >::truncate( key, bytes ) );
+                                } ) );
+}
 
-//STEP1 shmget
-    const auto shmid = 
-        shmget( key, sizeof(int), S_IRUSR | S_IWUSR );
-    if( shmid == shm::failure ) 
-    {
-        //if using exceptions, you won't return from this
-        return( handle_open_failure( key ) );
-    }
-//STEP2 shmat
-    out = shmat(shmid, nullptr, 0);
-    if( out == (void*)-1 ) 
-    {
-#if USE_CPP_EXCEPTIONS==1      
-        std::stringstream ss;
-        ss << "Failed to SHM attach the shm region with the following error (" 
-            <<  std::strerror( errno ) << ").";
-        throw bad_shm_alloc( ss.str() );
-#else
-        return( nullptr );
-#endif
-    }
-/** END SYSTEMV MEMORY **/
-#endif
-    //if we're here, everything theoretically worked
-    return( out );
+/** every backend is built in **/
+#define SHM_INSTANTIATE( BACKEND )                                              \
+template void   shm::gen_key< BACKEND >( BACKEND::key_type&, const int );       \
+template bool   shm::key_copy< BACKEND >( BACKEND::key_type&,                   \
+                                          const BACKEND::key_type& );           \
+template bool   shm::send_key< BACKEND >( const int, const BACKEND::key_type& );\
+template bool   shm::recv_key< BACKEND >( const int, BACKEND::key_type& );      \
+template void*  shm::init< BACKEND >( const BACKEND::key_type&,                 \
+                                      const std::size_t,                        \
+                                      const bool,                               \
+                                      void*,                                    \
+                                      const shm::page_t,                        \
+                                      const shm::numa_policy&,                  \
+                                      const shm::populate_t );                  \
+template void*  shm::open< BACKEND >( const BACKEND::key_type& );               \
+template bool   shm::close< BACKEND >( const BACKEND::key_type&,                \
+                                       void**,                                  \
+                                       const std::size_t,                       \
+                                       const bool,                              \
+                                       const bool );                            \
+template bool   shm::close< BACKEND >( const BACKEND::key_type&,                \
+                                       void**,                                  \
+                                       const std::size_t,                       \
+                                       const shm::release_t,                    \
+                                       const bool );                            \
+template bool   shm::resize< BACKEND >( const BACKEND::key_type&,               \
+                                        void**,                                 \
+                                        const std::size_t );                    \
+template void*  shm::init_mapping< BACKEND >( const BACKEND::key_type&,         \
+                                              const std::size_t,                \
+                                              void*,                            \
+                                              const shm::page_t,                \
+                                              const shm::numa_policy&,          \
+                                              const shm::populate_t,            \
+                                              shm::backing& );                  \
+template void*  shm::open_mapping< BACKEND >( const BACKEND::key_type&,         \
+                                              shm::backing& )
+
+SHM_INSTANTIATE( shm::posix );
+SHM_INSTANTIATE( shm::sysv );
+SHM_INSTANTIATE( shm::memfd );
+
+/** the non-template calls use the backend picked at configure time **/
+void
+shm::gen_key( shm_key_t &key, const int proj_id )
+{
+    shm::gen_key< default_backend >( key, proj_id );
+}
+
+bool
+shm::key_copy( shm_key_t               &dst_key,
+               const   shm_key_t        src_key )
+{
+    return( backend_ops< default_backend >::key_copy( dst_key, src_key ) );
+}
+
+bool
+shm::send_key( const int socket, const shm_key_t &key )
+{
+    return( shm::send_key< default_backend >( socket, key ) );
+}
+
+bool
+shm::recv_key( const int socket, shm_key_t &key )
+{
+    return( shm::recv_key< default_backend >( socket, key ) );
+}
+
+void*
+shm::init( const shm_key_t     &key,
+           const std::size_t   nbytes,
+           const bool          zero,
+           void                *ptr,
+           const shm::page_t   page,
+           const numa_policy   &numa,
+           const populate_t    populate )
+{
+    return( shm::init< default_backend >( key, nbytes, zero, ptr, page, numa, populate ) );
+}
+
+void*
+shm::open( const shm_key_t &key )
+{
+    return( shm::open< default_backend >( key ) );
 }
 
 bool
@@ -488,110 +2708,320 @@ shm::close( const shm_key_t &key,
             const bool zero,
             const bool unlink )
 {
-   if( zero && (ptr != nullptr) && ( *ptr != nullptr ) )
+    return( shm::close< default_backend >( key, ptr, nbytes, zero, unlink ) );
+}
+
+bool
+shm::close( const shm_key_t &key,
+            void **ptr,
+            const std::size_t nbytes,
+            const release_t release,
+            const bool unlink )
+{
+    return( shm::close< default_backend >( key, ptr, nbytes, release, unlink ) );
+}
+
+std::size_t
+shm::get_page_size( void *ptr )
+{
+    mapping known;
+    if( find_mapping( ptr, known ) )
+    {
+        return( known.page_size );
+    }
+    return( base_page_size() );
+}
+
+bool
+shm::resize( const shm_key_t &key, void **ptr, const std::size_t nbytes )
+{
+    return( shm::resize< default_backend >( key, ptr, nbytes ) );
+}
+
+void
+shm::cache_mappings( const bool enable )
+{
+    cache_enabled.store( enable, std::memory_order_relaxed );
+}
+
+std::size_t
+shm::get_mapped_size( void *ptr )
+{
+    mapping known;
+    if( ! find_mapping( ptr, known ) )
+    {
+        return( 0 );
+    }
+    return( known.alloc_bytes - known.page_size );
+}
+
+bool
+shm::resize_mapping( void                                          **ptr,
+                     const std::size_t                             nbytes,
+                     const std::function< bool( std::size_t ) >    &truncate )
+{
+   mapping known;
+   if( ptr == nullptr || nbytes == 0 || ! find_mapping( *ptr, known ) )
    {
-      std::memset( *ptr, 0x0, nbytes );
+      errno = EINVAL;
+      return( false );
    }
-#if _USE_POSIX_SHM_ == 1
-   if( ptr != nullptr )
+   if( known.mirrored )
    {
-      /** get allocations size including extra dummy page **/
-      const auto page_size( sysconf( _SC_PAGESIZE ) );
-      const auto alloc_bytes( 
-         static_cast< std::size_t >( 
-            std::ceil(  
-               static_cast< float >( nbytes ) / 
-              static_cast< float >( page_size ) ) + 1 ) * page_size 
-      );
-      if( ( *ptr != nullptr ) && ( munmap( *ptr, alloc_bytes ) != shm::success ) )
-      {
-#if DEBUG   
-         perror( "Failed to unmap shared memory, attempting to close!!" );
-#endif
-      }
-      *ptr = nullptr;
+      errno = ENOTSUP;
+      return( false );
    }
-   if( unlink )
+   const auto alloc_bytes( alloc_size( nbytes, known.page_size ) );
+   if( alloc_bytes == known.alloc_bytes )
+   {
+      return( true );
+   }
+   /** grow the object before the mapping, shrink it after **/
+   if( alloc_bytes > known.alloc_bytes )
    {
-      if( shm_unlink( key ) != 0 )
+      if( ! truncate( alloc_bytes ) )
       {
-#if USE_CPP_EXCEPTIONS==1      
-         switch( errno )
-         {
-            case( ENOENT ):
-            {
-                throw invalid_key_exception( "Invalid file descriptor specified" );
-            }
-            break;
-            default:
-            {
-                throw invalid_key_exception( "Undefined error, check error codes" );
-            }
-         }
-#endif         
+         return( false );
+      }
+      if( ! shm::remap( ptr, nbytes ) )
+      {
+         const auto remap_errno( errno );
+         truncate( known.alloc_bytes );
+         errno = remap_errno;
+         return( false );
       }
+      return( true );
    }
-   //jump to return true if here. 
-/** END POSIX MEMORY IMPL **/
-#elif _USE_SYSTEMV_SHM_ == 1
-/** START SYSTEMV IMPL **/
-    /**
-     * we could have gotten here b/c something failed and the 
-     * user code is now calling close on an invalid shm seg. 
-     * so let's stat first to be sure. 
-     */
-     const auto shmid = 
-         shmget( key, sizeof(int), S_IRUSR | S_IWUSR );
-     if( shmid == shm::failure ) 
-     {
-#if USE_CPP_EXCEPTIONS==1
-        if( errno == ENOENT )
-        {
-            throw invalid_key_exception( "SHM key doesn't exist" );
-        }
-#else
+   if( ! shm::remap( ptr, nbytes ) )
+   {
+      return( false );
+   }
+   if( ! truncate( alloc_bytes ) )
+   {
+      /** the mapping already shrank, put it back **/
+      const auto truncate_errno( errno );
+      shm::remap( ptr, known.alloc_bytes - known.page_size );
+      errno = truncate_errno;
+      return( false );
+   }
+   return( true );
+}
+
+bool
+shm::remap( void **ptr, const std::size_t nbytes )
+{
+    mapping known;
+    if( ptr == nullptr || nbytes == 0 || ! find_mapping( *ptr, known ) )
+    {
+        errno = EINVAL;
+        return( false );
+    }
+    if( known.mirrored )
+    {
+        errno = ENOTSUP;
+        return( false );
+    }
+    const auto alloc_bytes( alloc_size( nbytes, known.page_size ) );
+    if( alloc_bytes == known.alloc_bytes )
+    {
         return( true );
-#endif
-     }
-    /**
-     * NOTE: This may not work quite perfectly b/c 
-     * if there are M communicating pairs and you 
-     * call this and only one happens to be detached,
-     * then this may cause the segment to be deleted.
-     */
-    if(unlink /** only do this once **/  && shmctl(shmid, IPC_RMID, nullptr) == -1) 
+    }
+#if __linux
+    char *base( reinterpret_cast< char* >( *ptr ) );
+    /** one protection for the whole range so mremap sees a single mapping **/
+    if( mprotect( base + known.alloc_bytes - known.page_size,
+                  known.page_size,
+                  PROT_READ | PROT_WRITE ) != shm::success )
     {
-#if USE_CPP_EXCEPTIONS==1
-       if( errno == EINVAL || errno == EIDRM )
-       {
-          throw invalid_key_exception( "Invalid SHM key" );
-       }
-       std::stringstream ss;
-       ss << "Failed to set the SystemV memory region to exit on detach, non-fatal error (" 
-         << std::strerror( errno ) << ")\n";
-       throw bad_shm_alloc( ss.str() );
-#else
-       return( false );
+        return( false );
+    }
+    void *out( mremap( *ptr, known.alloc_bytes, alloc_bytes, MREMAP_MAYMOVE ) );
+    if( out == MAP_FAILED )
+    {
+        const auto remap_errno( errno );
+        mprotect( base + known.alloc_bytes - known.page_size, known.page_size, PROT_NONE );
+        errno = remap_errno;
+        return( false );
+    }
+    char *temp( reinterpret_cast< char* >( out ) );
+    if( mprotect( (void*) &temp[ alloc_bytes - known.page_size ],
+                  known.page_size,
+                  PROT_NONE ) != shm::success )
+    {
+#if DEBUG
+      perror( "Error, failed to set page protection, not fatal just dangerous." );
 #endif
     }
-     //else we're here, and it exists
-     if( shmdt( *ptr ) == shm::failure ) 
-     {
-#if USE_CPP_EXCEPTIONS==1
-        std::stringstream ss;
-        ss << "Failed to detach SHM with error code (" 
-            <<  std::strerror( errno ) << ").";
-        throw invalid_key_exception( ss.str() );
+    forget_mapping( *ptr );
+    record_mapping( out, known.page_size, alloc_bytes );
+    *ptr = out;
+    return( true );
 #else
-        return( false );
+    errno = ENOSYS;
+    return( false );
 #endif
-     }
+}
 
-/** END SYSTEMV IMPL **/
-#endif
+std::size_t
+shm::requested_page_bytes( const page_t page )
+{
+    return( requested_page_size( page ) );
+}
+
+void*
+shm::mirror_mapping( void              *ptr,
+                     const int         fd,
+                     const std::size_t header_bytes,
+                     const std::size_t ring_bytes,
+                     void              *hint )
+{
+    mapping known;
+    if( ptr == nullptr || fd < 0 || ring_bytes == 0 || ! find_mapping( ptr, known ) )
+    {
+        errno = EINVAL;
+        return( nullptr );
+    }
+    const auto page_size( known.page_size );
+    if( header_bytes % page_size != 0 || ring_bytes % page_size != 0 ||
+        header_bytes + ring_bytes + page_size > known.alloc_bytes )
+    {
+        errno = EINVAL;
+        return( nullptr );
+    }
+    /** header, ring, ring again, guard **/
+    const auto alloc_bytes( header_bytes + 2 * ring_bytes + page_size );
+    /** 
+     * reserve the whole range first so nothing lands between the
+     * two copies, huge pages need it aligned so ask for one more
+     * page and trim
+     */
+    const auto slack( page_size > base_page_size() ? page_size : 0 );
+    void *reserved( mmap( hint,
+                          alloc_bytes + slack,
+                          PROT_NONE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                          -1,
+                          0 ) );
+    if( reserved == MAP_FAILED )
+    {
+        return( nullptr );
+    }
+    const auto start( reinterpret_cast< std::uintptr_t >( reserved ) );
+    const auto aligned( ( start + page_size - 1 ) / page_size * page_size );
+    if( aligned != start )
+    {
+        munmap( reserved, aligned - start );
+    }
+    if( start + slack != aligned )
+    {
+        munmap( reinterpret_cast< void* >( aligned + alloc_bytes ), start + slack - aligned );
+    }
+    char *base( reinterpret_cast< char* >( aligned ) );
+    /** the guard page stays the PROT_NONE reservation **/
+    if( mmap( base,
+              header_bytes + ring_bytes,
+              ( PROT_READ | PROT_WRITE ),
+              MAP_SHARED | MAP_FIXED,
+              fd,
+              0 ) == MAP_FAILED ||
+        mmap( base + header_bytes + ring_bytes,
+              ring_bytes,
+              ( PROT_READ | PROT_WRITE ),
+              MAP_SHARED | MAP_FIXED,
+              fd,
+              header_bytes ) == MAP_FAILED )
+    {
+        const auto map_errno( errno );
+        munmap( base, alloc_bytes );
+        errno = map_errno;
+        return( nullptr );
+    }
+    /** the object stays referenced by the new mappings **/
+    munmap( ptr, known.alloc_bytes );
+    forget_mapping( ptr );
+    record_mapping( base, page_size, alloc_bytes, true );
+    return( base );
+}
+
+bool
+shm::discard( void *ptr, const std::size_t offset, const std::size_t len )
+{
+    /** the range has to stay clear of the guard page, without overflowing **/
+    const auto mapped( ptr == nullptr ? 0 : shm::get_mapped_size( ptr ) );
+    if( mapped == 0 || offset > mapped || len > mapped - offset )
+    {
+        errno = EINVAL;
+        return( false );
+    }
+    char *base( reinterpret_cast< char* >( ptr ) );
+    const auto page_size( shm::get_page_size( ptr ) );
+    /** the whole pages inside the range, [ first, last ) **/
+    const auto first( ( offset + page_size - 1 ) / page_size * page_size );
+    const auto last( ( offset + len ) / page_size * page_size );
+    if( first >= last )
+    {
+        std::memset( base + offset, 0x0, len );
+        return( true );
+    }
+    if( ! remove_pages( base + first, last - first ) )
+    {
+        if( ! unsupported( errno ) )
+        {
+            return( false );
+        }
+        std::memset( base + first, 0x0, last - first );
+    }
+    std::memset( base + offset, 0x0, first - offset );
+    std::memset( base + last, 0x0, offset + len - last );
     return( true );
 }
 
+std::vector< std::size_t >
+shm::get_numa_placement( void *ptr, const std::size_t nbytes )
+{
+    std::vector< std::size_t > out;
+#if __linux && ( PLATFORM_HAS_NUMA == 1 )
+    if( ptr == nullptr || numa_available() == -1 )
+    {
+        return( out );
+    }
+    out.resize( numa_max_node() + 1, 0 );
+    const auto page_size( shm::get_page_size( ptr ) );
+    const auto num_pages( ( nbytes + page_size - 1 ) / page_size );
+    /** a chunk at a time so that big segments don't need big arrays **/
+    constexpr std::size_t chunk = 512;
+    void *pages [ chunk ];
+    int  status [ chunk ];
+    char *base( reinterpret_cast< char* >( ptr ) );
+    for( std::size_t first( 0 ); first < num_pages; first += chunk )
+    {
+        const auto count( std::min( chunk, num_pages - first ) );
+        for( std::size_t i( 0 ); i < count; i++ )
+        {
+            pages[ i ] = base + ( first + i ) * page_size;
+        }
+        /** no target nodes, just reports where each page is **/
+        if( move_pages( 0, count, pages, nullptr, status, 0 ) != 0 )
+        {
+            out.clear();
+            return( out );
+        }
+        for( std::size_t i( 0 ); i < count; i++ )
+        {
+            /** negative is an error, e.g., -ENOENT for untouched **/
+            if( status[ i ] >= 0 && static_cast< std::size_t >( status[ i ] ) < out.size() )
+            {
+                out[ status[ i ] ]++;
+            }
+        }
+    }
+#else
+    UNUSED( ptr );
+    UNUSED( nbytes );
+#endif
+    return( out );
+}
+
 bool
 shm::move_to_tid_numa( const pid_t thread_id,
                        void *ptr,
@@ -621,111 +3051,36 @@ shm::move_to_tid_numa( const pid_t thread_id,
       return( true );
    }
    /** first check to see if there is more than one numa node **/
-   const auto num_numa( numa_num_configured_nodes() );
-   if( num_numa == 1 )
+   if( shm::topology::nodes().size() == 1 )
    {
       /** no point in continuing **/
       return( true );
    }
 
-   /** RETURN VAL HERE */
-   bool moved( false );
-   /** get the numa node of the calling thread **/
-   const auto local_node( numa_node_of_cpu( sched_getcpu() ) );      
-   /** get numa node that 'pages' is on **/
    /**
-    * Note: only way I could figure out how to do this was get a cpu
-    * set, we'll check to see how many CPU's are in the CPU set of 
-    * the thread, then we'll see if all those CPU's are on the 
-    * same NUMA node, if they are then we'll check to see if the
-    * alloc is on the same node, otherwise we'll move the pages to that
-    * node.  The interesting case comes when there are multiple
-    * CPUs per set and multiple possible NUMA nodes to choose from.  The simple
-    * answer, the one I'm taking a the moment is that we can't 
-    * really decide in this function.  I think in the future it'd
-    * be good to have a profiler decide the shortest latency and
-    * highest bandwidth for long running programs at startup and 
-    * do some sort of graph matching.
+    * the node whose memory is cheapest to reach from every node
+    * the thread may run on, weighted by how many of its cpus are
+    * there. Averaging node ids instead would pick node 1 for a
+    * thread allowed on 0 and 3.
     */
-   cpu_set_t *cpuset( nullptr );
-   /** we want set to include all cpus **/
-   const auto num_cpus_alloc( get_nprocs_conf() );
-   std::size_t cpu_allocate_size( -1 );
-#if (__GLIBC_MINOR__ > 9 ) && (__GLIBC__ == 2)
-   cpuset = CPU_ALLOC( num_cpus_alloc );
-   assert( cpuset != nullptr );
-   cpu_allocate_size = CPU_ALLOC_SIZE( num_cpus_alloc );
-   CPU_ZERO_S( cpu_allocate_size, cpuset );
-#else
-   cpu_allocate_size = sizeof( cpu_set_t );
-   cpuset = reinterpret_cast< cpu_set_t* >( malloc( cpu_allocate_size ) );
-   assert( cpuset != nullptr );
-   CPU_ZERO( cpuset );
-#endif
-   /** now get affinity **/
-   if( sched_getaffinity( thread_id, cpu_allocate_size, cpuset ) != 0 )
-   {
-      perror( "Failed to get affinity for calling thread!" );
-      return( false );
-   }
-   /**
-    * NOTE: for the moment we're using an extremely simplistic
-    * distance metric, we should probably be using the numa_distance
-    * combined with the actual latancy/bandwidth between the 
-    * processor cores.
+   const auto target_node( 
+      shm::placement::best_node( shm::placement::thread_weights( thread_id ) ) );
+
+   /** 
+    * a chunk at a time, only pages that aren't on the target
+    * node yet are handed to the kernel
     */
-   auto numa_node_count( 0 );
-   auto denom( 0 );
-   for( auto p_index( 0 ); p_index < num_cpus_alloc; p_index++ )
+   shm::migration migration( ptr, nbytes, target_node );
+   migration.run();
+   const auto &result( migration.wait() );
+#if DEBUG
+   if( result.failed != 0 || result.error != 0 )
    {
-      if( CPU_ISSET( p_index /* cpu */, cpuset ) )
-      {
-         const auto ret_val( numa_node_of_cpu( p_index ) );
-         if( ret_val != -1 )
-         {
-            numa_node_count += ret_val;
-            denom++;
-         }
-      }
+      std::cerr << "failed to move " << result.failed << " pages, non-fatal error but results may vary.\n";
    }
-   const auto target_node( numa_node_count / denom );
-
-   /** we need to know how many pages we have **/
-   const auto num_pages(
-      static_cast< std::size_t >(
-      std::ceil( 
-      static_cast< float >( nbytes ) / static_cast< float >( page_size ) ) ) );
-   using int_t = std::int32_t;
-   int_t *mem_node  ( new int_t[ num_pages ] );
-   int_t *mem_status( new int_t[ num_pages ] );
-   void **page_ptr = (void**)malloc( sizeof( void* ) * num_pages );
-   char *temp_ptr( reinterpret_cast< char* >( ptr ) );
-   for( auto node_index( 0 ), 
-             page_index( 0 )                       /** init **/; 
-             node_index < num_pages                /** cond **/; 
-             node_index++, page_index += page_size /** incr **/)
-   {
-      mem_node  [ node_index ] = target_node;
-      mem_status[ node_index ] = -1;
-      page_ptr[ node_index ] = (void*)&temp_ptr[ page_index ];
-   }
-   if( move_pages(   thread_id /** thread we want to move for **/,
-                     num_pages /** total number of pages **/,
-                     page_ptr  /** pointers to the start of each page **/,
-                     mem_node  /** node we want to move to **/,
-                     mem_status/** status flags, check for debug **/,
-                     MPOL_MF_MOVE ) != 0 )
-   {
-#if DEBUG
-      perror( "failed to move pages, non-fatal error but results may vary.");
-      /** TODO, re-code all status flag checks..accidentally over wrote **/
 #endif
-      moved = false;
-   }
-   delete[]( mem_node );
-   delete[]( mem_status );
-   free( page_ptr );
-   return( moved );
+   /** true only if everything was already where it belongs **/
+   return( result.moved() == 0 && result.failed == 0 && result.error == 0 );
 #else /** no NUMA avail **/
    return( false );
 #endif
@@ -0,0 +1,381 @@
+/*
+ * shm_arena.cpp -
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author: Jonathan Beard
+ * @version: October 18 2026
+ */
+#include <shm>
+#include <shm_arena.hpp>
+#include <new>
+#include <sstream>
+
+static constexpr std::uint64_t arena_magic      = 0x73686d6172656e61ULL;
+static constexpr std::uint32_t block_magic      = 0x626c6b31;
+/** free list head word layout **/
+static constexpr std::uint32_t offset_bits      = 40;
+static constexpr std::uint64_t offset_mask      = ( 1ULL << offset_bits ) - 1;
+
+/**
+ * every block starts with this, the user pointer is right
+ * after it, next is only meaningful while the block is free.
+ */
+struct block_header
+{
+   std::uint32_t size_class;
+   std::uint32_t magic;
+   std::uint64_t next;
+};
+
+static_assert( sizeof( block_header ) == 16, "block header must keep user pointers 16B aligned" );
+
+shm::arena::arena( const std::size_t nbytes ) : magic( arena_magic ),
+                                                capacity_( nbytes ),
+                                                root_( 0 )
+{
+   top.store( ( sizeof( arena ) + alignment - 1 ) & ~( alignment - 1 ),
+              std::memory_order_relaxed );
+   for( auto &list : free_lists )
+   {
+      list.head.store( 0, std::memory_order_relaxed );
+   }
+   std::atomic_thread_fence( std::memory_order_release );
+}
+
+shm::arena*
+shm::arena::create( void *mem, const std::size_t nbytes )
+{
+   if( mem == nullptr || nbytes <= sizeof( arena ) )
+   {
+#if USE_CPP_EXCEPTIONS==1
+      std::stringstream ss;
+      ss << "arena needs more than " << sizeof( arena ) << " bytes, given (" << nbytes << ")";
+      throw bad_shm_alloc( ss.str() );
+#else
+      return( nullptr );
+#endif
+   }
+   return( new ( mem ) arena( nbytes ) );
+}
+
+shm::arena*
+shm::arena::attach( void *mem )
+{
+   auto *a( reinterpret_cast< arena* >( mem ) );
+   if( mem == nullptr || a->magic != arena_magic )
+   {
+#if USE_CPP_EXCEPTIONS==1
+      throw invalid_segment_exception( "segment doesn't hold an arena" );
+#else
+      return( nullptr );
+#endif
+   }
+   return( a );
+}
+
+/**
+ * size classes, 16B steps up to 64B, then four steps for every
+ * power of two, e.g., 80, 96, 112, 128, 160, 192, 224, 256, ...
+ */
+std::uint32_t
+shm::arena::size_class( const std::size_t nbytes )
+{
+   if( nbytes <= 64 )
+   {
+      return( nbytes <= 16 ? 0 : static_cast< std::uint32_t >( ( nbytes + 15 ) / 16 - 1 ) );
+   }
+   const auto log2( 63 - __builtin_clzll( nbytes - 1 ) );
+   const auto step( std::size_t( 1 ) << ( log2 - 2 ) );
+   const auto sub( ( nbytes - 1 - ( std::size_t( 1 ) << log2 ) ) / step );
+   return( static_cast< std::uint32_t >( 4 + ( log2 - 6 ) * 4 + sub ) );
+}
+
+std::size_t
+shm::arena::class_size( const std::uint32_t size_class )
+{
+   if( size_class < 4 )
+   {
+      return( ( size_class + 1 ) * 16 );
+   }
+   const auto log2( 6 + ( size_class - 4 ) / 4 );
+   const auto sub( ( size_class - 4 ) % 4 );
+   return( ( std::size_t( 1 ) << log2 ) + ( sub + 1 ) * ( std::size_t( 1 ) << ( log2 - 2 ) ) );
+}
+
+void*
+shm::arena::user_ptr( const std::uint64_t block )
+{
+   return( reinterpret_cast< char* >( this ) + block + sizeof( block_header ) );
+}
+
+std::uint64_t&
+shm::arena::next_of( const std::uint64_t block )
+{
+   return( reinterpret_cast< block_header* >( reinterpret_cast< char* >( this ) + block )->next );
+}
+
+std::uint32_t
+shm::arena::class_of( const void *ptr ) const
+{
+   const auto *header( reinterpret_cast< const block_header* >( ptr ) - 1 );
+   if( header->magic != block_magic || header->size_class >= class_count )
+   {
+#if USE_CPP_EXCEPTIONS==1
+      throw invalid_segment_exception( "pointer wasn't allocated from an arena" );
+#else
+      return( class_count );
+#endif
+   }
+   return( header->size_class );
+}
+
+std::size_t
+shm::arena::usable_size( const void *ptr )
+{
+   const auto *header( reinterpret_cast< const block_header* >( ptr ) - 1 );
+   return( class_size( header->size_class ) );
+}
+
+std::uint64_t
+shm::arena::pop( const std::uint32_t size_class )
+{
+   auto &head( free_lists[ size_class ].head );
+   auto old_head( head.load( std::memory_order_acquire ) );
+   for( ;; )
+   {
+      const auto block( ( old_head & offset_mask ) * alignment );
+      if( block == 0 )
+      {
+         return( 0 );
+      }
+      /**
+       * block may be popped and reused under us, the read is still
+       * of mapped memory and the tag makes the CAS below fail.
+       */
+      const auto next( __atomic_load_n( &next_of( block ), __ATOMIC_RELAXED ) );
+      const auto new_head( ( ( ( old_head >> offset_bits ) + 1 ) << offset_bits ) |
+                           ( next / alignment ) );
+      if( head.compare_exchange_weak( old_head,
+                                      new_head,
+                                      std::memory_order_acq_rel,
+                                      std::memory_order_acquire ) )
+      {
+         return( block );
+      }
+   }
+}
+
+void
+shm::arena::push( const std::uint32_t size_class,
+                  const std::uint64_t first,
+                  const std::uint64_t last )
+{
+   auto &head( free_lists[ size_class ].head );
+   auto old_head( head.load( std::memory_order_relaxed ) );
+   for( ;; )
+   {
+      __atomic_store_n( &next_of( last ),
+                        ( old_head & offset_mask ) * alignment,
+                        __ATOMIC_RELAXED );
+      const auto new_head( ( ( ( old_head >> offset_bits ) + 1 ) << offset_bits ) |
+                           ( first / alignment ) );
+      if( head.compare_exchange_weak( old_head,
+                                      new_head,
+                                      std::memory_order_release,
+                                      std::memory_order_relaxed ) )
+      {
+         return;
+      }
+   }
+}
+
+/**
+ * carve - takes up to count fresh blocks of size_class off the
+ * end of the used region, returns the first one with the rest
+ * chained through next (last one's next is zero), zero if full.
+ */
+std::uint64_t
+shm::arena::carve( const std::uint32_t size_class, std::size_t count )
+{
+   const auto block_bytes( sizeof( block_header ) + class_size( size_class ) );
+   auto old_top( top.load( std::memory_order_relaxed ) );
+   do
+   {
+      const auto avail( old_top < capacity_ ? ( capacity_ - old_top ) / block_bytes : 0 );
+      if( avail < count )
+      {
+         count = avail;
+      }
+      if( count == 0 )
+      {
+         return( 0 );
+      }
+   } while( ! top.compare_exchange_weak( old_top,
+                                         old_top + count * block_bytes,
+                                         std::memory_order_relaxed ) );
+   for( std::size_t i( 0 ); i < count; i++ )
+   {
+      const auto block( old_top + i * block_bytes );
+      auto *header( reinterpret_cast< block_header* >( reinterpret_cast< char* >( this ) + block ) );
+      header->size_class = size_class;
+      header->magic      = block_magic;
+      header->next       = ( i + 1 < count ? block + block_bytes : 0 );
+   }
+   return( old_top );
+}
+
+std::uint64_t
+shm::arena::get_block( const std::uint32_t size_class )
+{
+   const auto block( pop( size_class ) );
+   if( block != 0 )
+   {
+      return( block );
+   }
+   return( carve( size_class, 1 ) );
+}
+
+void*
+shm::arena::allocate( const std::size_t nbytes )
+{
+   const auto c( size_class( nbytes ) );
+   const auto block( c < class_count ? get_block( c ) : 0 );
+   if( block == 0 )
+   {
+#if USE_CPP_EXCEPTIONS==1
+      std::stringstream ss;
+      ss << "arena can't fit an allocation of (" << nbytes << ") bytes, "
+         << carved() << " of " << capacity() << " bytes already carved";
+      throw bad_shm_alloc( ss.str() );
+#else
+      return( nullptr );
+#endif
+   }
+   return( user_ptr( block ) );
+}
+
+void
+shm::arena::deallocate( void *ptr )
+{
+   if( ptr == nullptr )
+   {
+      return;
+   }
+   const auto c( class_of( ptr ) );
+   if( c >= class_count )
+   {
+      return;
+   }
+   const auto block( offset_of( ptr ) - sizeof( block_header ) );
+   push( c, block, block );
+}
+
+
+shm::arena::cache::cache( arena *a ) : a( a ),
+                                       magazines( size_class( max_cached_bytes ) + 1 )
+{
+}
+
+shm::arena::cache::~cache()
+{
+   flush();
+}
+
+void*
+shm::arena::cache::allocate( const std::size_t nbytes )
+{
+   const auto c( size_class( nbytes ) );
+   if( c >= magazines.size() )
+   {
+      return( a->allocate( nbytes ) );
+   }
+   auto &mag( magazines[ c ] );
+   if( mag.count == 0 )
+   {
+      /** refill half a magazine, recycled blocks first **/
+      while( mag.count < magazine_size / 2 )
+      {
+         const auto block( a->pop( c ) );
+         if( block == 0 )
+         {
+            break;
+         }
+         mag.blocks[ mag.count++ ] = block;
+      }
+      if( mag.count == 0 )
+      {
+         for( auto block( a->carve( c, magazine_size / 2 ) );
+              block != 0;
+              block = a->next_of( block ) )
+         {
+            mag.blocks[ mag.count++ ] = block;
+         }
+      }
+      if( mag.count == 0 )
+      {
+         /** out of space, let the arena report it **/
+         return( a->allocate( nbytes ) );
+      }
+   }
+   return( a->user_ptr( mag.blocks[ --mag.count ] ) );
+}
+
+void
+shm::arena::cache::deallocate( void *ptr )
+{
+   if( ptr == nullptr )
+   {
+      return;
+   }
+   const auto c( a->class_of( ptr ) );
+   if( c >= magazines.size() )
+   {
+      a->deallocate( ptr );
+      return;
+   }
+   auto &mag( magazines[ c ] );
+   if( mag.count == magazine_size )
+   {
+      spill( c, magazine_size / 2 );
+   }
+   mag.blocks[ mag.count++ ] = a->offset_of( ptr ) - sizeof( block_header );
+}
+
+/** spill - chains the newest count blocks and pushes them with one CAS **/
+void
+shm::arena::cache::spill( const std::uint32_t size_class, const std::size_t count )
+{
+   auto &mag( magazines[ size_class ] );
+   if( count == 0 || mag.count < count )
+   {
+      return;
+   }
+   const auto first( mag.count - count );
+   for( auto i( first ); i + 1 < mag.count; i++ )
+   {
+      a->next_of( mag.blocks[ i ] ) = mag.blocks[ i + 1 ];
+   }
+   a->push( size_class, mag.blocks[ first ], mag.blocks[ mag.count - 1 ] );
+   mag.count = first;
+}
+
+void
+shm::arena::cache::flush()
+{
+   for( std::uint32_t c( 0 ); c < magazines.size(); c++ )
+   {
+      spill( c, magazines[ c ].count );
+   }
+}
@@ -0,0 +1,373 @@
+/*
+ * shm_buffer_pool.cpp -
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author: Jonathan Beard
+ * @version: October 18 2026
+ */
+#include <shm>
+#include <shm_buffer_pool.hpp>
+#include <new>
+#include <sstream>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+
+static constexpr std::uint64_t pool_magic     = 0x73686d627566706cULL;
+/** buffers start on a boundary this big **/
+static constexpr std::size_t   data_alignment = 4096;
+/** free list head word layout **/
+static constexpr std::uint64_t index_mask     = 0xffffffffULL;
+static constexpr std::uint32_t no_buffer      = 0xffffffff;
+/** client slot of a dead process while its references are dropped **/
+static constexpr pid_t         reaping        = -1;
+static constexpr std::uint8_t  max_held       = 0xff;
+
+static std::size_t
+round_up( const std::size_t bytes, const std::size_t to )
+{
+   return( ( bytes + to - 1 ) / to * to );
+}
+
+/** decrement - takes one off count unless it's already zero **/
+static bool
+decrement( std::atomic< std::uint8_t > &count )
+{
+   auto old( count.load( std::memory_order_relaxed ) );
+   do
+   {
+      if( old == 0 )
+      {
+         return( false );
+      }
+   } while( ! count.compare_exchange_weak( old, old - 1, std::memory_order_acq_rel ) );
+   return( true );
+}
+
+std::size_t
+shm::buffer_pool::data_offset( const std::size_t count )
+{
+   return( round_up( sizeof( buffer_pool ) + count * sizeof( meta ), data_alignment ) );
+}
+
+std::size_t
+shm::buffer_pool::stride( const std::size_t buffer_size )
+{
+   return( round_up( buffer_size, SHM_CACHE_LINE_SIZE ) );
+}
+
+std::size_t
+shm::buffer_pool::required_bytes( const std::size_t buffer_size, const std::size_t count )
+{
+   return( data_offset( count ) + count * stride( buffer_size ) );
+}
+
+shm::buffer_pool::buffer_pool( const std::size_t   buffer_size,
+                               const std::size_t   count,
+                               const std::uint32_t pool_id ) : magic( pool_magic ),
+                                                               buffer_size_( buffer_size ),
+                                                               count_( count ),
+                                                               stride_( stride( buffer_size ) ),
+                                                               pool_id_( pool_id )
+{
+   for( std::size_t i( 0 ); i < count; i++ )
+   {
+      auto *m( new ( &meta_of( i ) ) meta() );
+      m->refs.store( 0, std::memory_order_relaxed );
+      m->generation.store( 0, std::memory_order_relaxed );
+      /** every buffer starts free, chained in order **/
+      m->next.store( i + 1 < count ? i + 2 : 0, std::memory_order_relaxed );
+      for( auto &held : m->held )
+      {
+         held.store( 0, std::memory_order_relaxed );
+      }
+   }
+   for( auto &client : clients )
+   {
+      client.store( 0, std::memory_order_relaxed );
+   }
+   head.store( 1, std::memory_order_relaxed );
+   available_.store( count, std::memory_order_relaxed );
+   std::atomic_thread_fence( std::memory_order_release );
+}
+
+shm::buffer_pool*
+shm::buffer_pool::create( void                *mem,
+                          const std::size_t   buffer_size,
+                          const std::size_t   count,
+                          const std::uint32_t pool_id )
+{
+   if( mem == nullptr || buffer_size == 0 || count == 0 || count >= no_buffer )
+   {
+#if USE_CPP_EXCEPTIONS==1
+      std::stringstream ss;
+      ss << "buffer_pool can't hold (" << count << ") buffers of (" << buffer_size << ") bytes";
+      throw bad_shm_alloc( ss.str() );
+#else
+      return( nullptr );
+#endif
+   }
+   return( new ( mem ) buffer_pool( buffer_size, count, pool_id ) );
+}
+
+shm::buffer_pool*
+shm::buffer_pool::attach( void *mem )
+{
+   auto *pool( reinterpret_cast< buffer_pool* >( mem ) );
+   if( mem == nullptr || pool->magic != pool_magic )
+   {
+#if USE_CPP_EXCEPTIONS==1
+      throw invalid_segment_exception( "segment doesn't hold a buffer_pool" );
+#else
+      return( nullptr );
+#endif
+   }
+   return( pool );
+}
+
+std::int32_t
+shm::buffer_pool::join()
+{
+   for( std::size_t id( 0 ); id < max_clients; id++ )
+   {
+      pid_t expected( 0 );
+      if( clients[ id ].load( std::memory_order_relaxed ) == 0 &&
+          clients[ id ].compare_exchange_strong( expected, getpid() ) )
+      {
+         return( static_cast< std::int32_t >( id ) );
+      }
+   }
+   return( -1 );
+}
+
+void
+shm::buffer_pool::leave( const std::int32_t client )
+{
+   if( client < 0 || static_cast< std::size_t >( client ) >= max_clients )
+   {
+      return;
+   }
+   sweep( static_cast< std::uint32_t >( client ) );
+   clients[ client ].store( 0, std::memory_order_release );
+}
+
+bool
+shm::buffer_pool::allocate( const std::int32_t client, descriptor &out )
+{
+   if( client < 0 || static_cast< std::size_t >( client ) >= max_clients )
+   {
+      return( false );
+   }
+   auto index( pop() );
+   if( index == no_buffer && reclaim() > 0 )
+   {
+      index = pop();
+   }
+   if( index == no_buffer )
+   {
+      return( false );
+   }
+   auto &m( meta_of( index ) );
+   m.held[ client ].store( 1, std::memory_order_relaxed );
+   m.refs.store( 1, std::memory_order_relaxed );
+   out.pool_id    = pool_id_;
+   out.index      = index;
+   out.generation = m.generation.fetch_add( 1, std::memory_order_acq_rel ) + 1;
+   out.owner      = static_cast< std::uint32_t >( client );
+   out.offset     = data_offset( count_ ) + index * stride_;
+   out.length     = buffer_size_;
+   available_.fetch_sub( 1, std::memory_order_relaxed );
+   return( true );
+}
+
+bool
+shm::buffer_pool::retain( const std::int32_t client, descriptor &d )
+{
+   if( ! valid( client, d ) )
+   {
+      return( false );
+   }
+   auto &held( meta_of( d.index ).held[ client ] );
+   const auto count( held.load( std::memory_order_relaxed ) );
+   /** only a holder can add a reference, the buffer can't be freed under it **/
+   if( count == 0 || count == max_held )
+   {
+      return( false );
+   }
+   meta_of( d.index ).refs.fetch_add( 1, std::memory_order_relaxed );
+   held.fetch_add( 1, std::memory_order_relaxed );
+   d.owner = static_cast< std::uint32_t >( client );
+   return( true );
+}
+
+bool
+shm::buffer_pool::adopt( const std::int32_t client, descriptor &d )
+{
+   if( ! valid( client, d ) || d.owner >= max_clients )
+   {
+      return( false );
+   }
+   if( d.owner == static_cast< std::uint32_t >( client ) )
+   {
+      return( true );
+   }
+   auto &m( meta_of( d.index ) );
+   if( m.held[ client ].load( std::memory_order_relaxed ) == max_held )
+   {
+      return( false );
+   }
+   /** ours first, so the reference is always counted for a live client **/
+   m.held[ client ].fetch_add( 1, std::memory_order_acq_rel );
+   if( ! decrement( m.held[ d.owner ] ) )
+   {
+      /** reclaimed with its dead owner **/
+      decrement( m.held[ client ] );
+      return( false );
+   }
+   d.owner = static_cast< std::uint32_t >( client );
+   return( true );
+}
+
+void
+shm::buffer_pool::release( const std::int32_t client, const descriptor &d )
+{
+   if( ! valid( client, d ) || ! decrement( meta_of( d.index ).held[ client ] ) )
+   {
+      return;
+   }
+   drop( d.index, 1 );
+}
+
+std::size_t
+shm::buffer_pool::reclaim()
+{
+   std::size_t freed( 0 );
+   for( std::size_t id( 0 ); id < max_clients; id++ )
+   {
+      auto pid( clients[ id ].load( std::memory_order_acquire ) );
+      if( pid <= 0 || kill( pid, 0 ) == 0 || errno != ESRCH )
+      {
+         continue;
+      }
+      /** one reclaimer per dead client, the id isn't reused until it's done **/
+      if( ! clients[ id ].compare_exchange_strong( pid, reaping ) )
+      {
+         continue;
+      }
+      freed += sweep( static_cast< std::uint32_t >( id ) );
+      clients[ id ].store( 0, std::memory_order_release );
+   }
+   return( freed );
+}
+
+std::uint32_t
+shm::buffer_pool::references( const descriptor &d ) const
+{
+   if( d.index >= count_ )
+   {
+      return( 0 );
+   }
+   return( meta_of( d.index ).refs.load( std::memory_order_acquire ) );
+}
+
+shm::buffer_pool::meta&
+shm::buffer_pool::meta_of( const std::uint32_t index ) const
+{
+   auto *base( reinterpret_cast< char* >( const_cast< buffer_pool* >( this ) ) + sizeof( buffer_pool ) );
+   return( reinterpret_cast< meta* >( base )[ index ] );
+}
+
+std::uint32_t
+shm::buffer_pool::pop()
+{
+   auto old_head( head.load( std::memory_order_acquire ) );
+   for( ;; )
+   {
+      const auto first( old_head & index_mask );
+      if( first == 0 )
+      {
+         return( no_buffer );
+      }
+      /**
+       * first may be popped and reused under us, next is still a
+       * valid read and the tag makes the CAS below fail.
+       */
+      const auto next( meta_of( first - 1 ).next.load( std::memory_order_relaxed ) );
+      const auto new_head( ( ( ( old_head >> 32 ) + 1 ) << 32 ) | next );
+      if( head.compare_exchange_weak( old_head,
+                                      new_head,
+                                      std::memory_order_acq_rel,
+                                      std::memory_order_acquire ) )
+      {
+         return( static_cast< std::uint32_t >( first - 1 ) );
+      }
+   }
+}
+
+void
+shm::buffer_pool::push( const std::uint32_t index )
+{
+   auto old_head( head.load( std::memory_order_relaxed ) );
+   for( ;; )
+   {
+      meta_of( index ).next.store( static_cast< std::uint32_t >( old_head & index_mask ),
+                                   std::memory_order_relaxed );
+      const auto new_head( ( ( ( old_head >> 32 ) + 1 ) << 32 ) | ( index + 1 ) );
+      if( head.compare_exchange_weak( old_head,
+                                      new_head,
+                                      std::memory_order_release,
+                                      std::memory_order_relaxed ) )
+      {
+         return;
+      }
+   }
+}
+
+bool
+shm::buffer_pool::drop( const std::uint32_t index, const std::uint32_t n )
+{
+   if( meta_of( index ).refs.fetch_sub( n, std::memory_order_acq_rel ) != n )
+   {
+      return( false );
+   }
+   push( index );
+   available_.fetch_add( 1, std::memory_order_relaxed );
+   return( true );
+}
+
+std::size_t
+shm::buffer_pool::sweep( const std::uint32_t client )
+{
+   std::size_t freed( 0 );
+   for( std::uint32_t index( 0 ); index < count_; index++ )
+   {
+      const auto n( meta_of( index ).held[ client ].exchange( 0, std::memory_order_acq_rel ) );
+      if( n != 0 && drop( index, n ) )
+      {
+         freed++;
+      }
+   }
+   return( freed );
+}
+
+bool
+shm::buffer_pool::valid( const std::int32_t client, const descriptor &d ) const
+{
+   return( client >= 0 &&
+           static_cast< std::size_t >( client ) < max_clients &&
+           d.pool_id == pool_id_ &&
+           d.index < count_ &&
+           meta_of( d.index ).generation.load( std::memory_order_acquire ) == d.generation );
+}
@@ -0,0 +1,104 @@
+/*
+ * shm_futex.cpp -
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author: Jonathan Beard
+ * @version: October 18 2026
+ */
+#include <shm>
+#include <shm_futex.hpp>
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <thread>
+#include <time.h>
+
+#if __linux
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+void
+shm::futex::wait( std::atomic< std::uint32_t > &word, const std::uint32_t expected )
+{
+#if __linux
+   /**
+    * not FUTEX_PRIVATE_FLAG, the waker is usually in another
+    * process, EAGAIN (word changed) and EINTR both just return.
+    */
+   syscall( SYS_futex,
+            reinterpret_cast< std::uint32_t* >( &word ),
+            FUTEX_WAIT,
+            expected,
+            nullptr,
+            nullptr,
+            0 );
+#else
+   if( word.load( std::memory_order_relaxed ) == expected )
+   {
+      std::this_thread::sleep_for( std::chrono::microseconds( 50 ) );
+   }
+#endif
+}
+
+void
+shm::futex::wait_for( std::atomic< std::uint32_t > &word,
+                       const std::uint32_t expected,
+                       const std::uint64_t timeout_ns )
+{
+#if __linux
+   /** FUTEX_WAIT takes a relative timeout **/
+   struct timespec timeout;
+   timeout.tv_sec  = static_cast< time_t >( timeout_ns / 1000000000 );
+   timeout.tv_nsec = static_cast< long >( timeout_ns % 1000000000 );
+   syscall( SYS_futex,
+            reinterpret_cast< std::uint32_t* >( &word ),
+            FUTEX_WAIT,
+            expected,
+            &timeout,
+            nullptr,
+            0 );
+#else
+   if( word.load( std::memory_order_relaxed ) == expected )
+   {
+      std::this_thread::sleep_for( std::chrono::nanoseconds(
+         std::min< std::uint64_t >( timeout_ns, 50000 ) ) );
+   }
+#endif
+}
+
+void
+shm::futex::wake( std::atomic< std::uint32_t > &word, const std::uint32_t count )
+{
+#if __linux
+   syscall( SYS_futex,
+            reinterpret_cast< std::uint32_t* >( &word ),
+            FUTEX_WAKE,
+            static_cast< int >( std::min< std::uint32_t >( count, INT_MAX ) ),
+            nullptr,
+            nullptr,
+            0 );
+#else
+   (void) word;
+   (void) count;
+#endif
+}
+
+void
+shm::futex::wake_all( std::atomic< std::uint32_t > &word )
+{
+   wake( word, INT_MAX );
+}
@@ -0,0 +1,693 @@
+/*
+ * shm_lock.cpp -
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author: Jonathan Beard
+ * @version: October 18 2026
+ */
+#include <shm>
+#include <shm_lock.hpp>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+/**
+ * lock word layout, the same bits as a kernel robust futex, tids
+ * fit well within the low bits (pid_max is at most 2^22)
+ */
+static constexpr std::uint32_t waiters_bit     = 0x80000000;
+static constexpr std::uint32_t died_bit        = 0x40000000;
+/** rwlock only, the writer is in rather than waiting for readers **/
+static constexpr std::uint32_t active_bit      = 0x20000000;
+static constexpr std::uint32_t tid_mask        = 0x00ffffff;
+/** no thread has this id, the robust_mutex word once it's given up **/
+static constexpr std::uint32_t unrecoverable   = tid_mask;
+/**
+ * ticket_lock, tickets step by two so that the low bit of serving
+ * is free to say its holder took the lock over from a dead one
+ */
+static constexpr std::uint32_t ticket_step     = 2;
+static constexpr std::uint32_t inherited_bit   = 1;
+/** how long a sleeping waiter goes before it checks on the holder **/
+static constexpr std::uint64_t probe_ns        = 10000000;
+/** how often, in spins, a spinning waiter checks on the holder **/
+static constexpr std::uint32_t probe_spins     = 0x3ff;
+
+static thread_local pid_t cached_tid = 0;
+
+static void
+forget_tid()
+{
+   cached_tid = 0;
+}
+
+/** self - thread id of the caller, the cache is dropped in a forked child **/
+static pid_t
+self()
+{
+   if( cached_tid == 0 )
+   {
+      static const int registered( pthread_atfork( nullptr, nullptr, forget_tid ) );
+      (void) registered;
+      cached_tid = static_cast< pid_t >( syscall( SYS_gettid ) );
+   }
+   return( cached_tid );
+}
+
+/** alive - false only if tid is definitely gone (same pid namespace) **/
+static bool
+alive( const pid_t tid )
+{
+   return( kill( tid, 0 ) == 0 || errno != ESRCH );
+}
+
+static std::uint64_t
+now_ns()
+{
+   return( static_cast< std::uint64_t >(
+      std::chrono::duration_cast< std::chrono::nanoseconds >(
+         std::chrono::steady_clock::now().time_since_epoch() ).count() ) );
+}
+
+/**
+ * lock_stats
+ */
+void
+shm::lock_stats::reset()
+{
+   acquired_.store( 0, std::memory_order_relaxed );
+   contended_.store( 0, std::memory_order_relaxed );
+   wait_ns_.store( 0, std::memory_order_relaxed );
+   deaths.store( 0, std::memory_order_relaxed );
+   for( auto &bucket : histogram )
+   {
+      bucket.store( 0, std::memory_order_relaxed );
+   }
+}
+
+void
+shm::lock_stats::record( const std::uint64_t since, const bool exclusive )
+{
+   auto bump = [&]( std::atomic< std::uint64_t > &counter, const std::uint64_t n )
+   {
+      if( exclusive )
+      {
+         counter.store( counter.load( std::memory_order_relaxed ) + n, std::memory_order_relaxed );
+      }
+      else
+      {
+         counter.fetch_add( n, std::memory_order_relaxed );
+      }
+   };
+   bump( acquired_, 1 );
+   if( since == 0 )
+   {
+      return;
+   }
+   const auto waited( now_ns() - since );
+   const auto bucket( waited == 0 ? 0 :
+      std::min< std::size_t >( 63 - __builtin_clzll( waited ), buckets - 1 ) );
+   bump( contended_, 1 );
+   bump( wait_ns_, waited );
+   bump( histogram[ bucket ], 1 );
+}
+
+void
+shm::lock_stats::died()
+{
+   deaths.fetch_add( 1, std::memory_order_relaxed );
+}
+
+/**
+ * robust_mutex
+ */
+shm::robust_mutex::status
+shm::robust_mutex::lock( const wait_policy &policy )
+{
+   const auto me( static_cast< std::uint32_t >( self() ) );
+   status out( status::ok );
+   std::uint64_t since( 0 );
+   if( ! try_acquire( me, 0, out, false ) )
+   {
+      since = now_ns();
+      std::uint32_t spins( 0 );
+      if( ! futex::spin( [&](){ return( try_acquire( me, 0, out, ( ++spins & probe_spins ) == 0 ) ); },
+                         policy,
+                         hint ) )
+      {
+         /** sleep, looking in on the holder every probe_ns **/
+         while( ! try_acquire( me, waiters_bit, out, true ) )
+         {
+            auto v( word.load( std::memory_order_relaxed ) );
+            if( v == 0 )
+            {
+               continue;
+            }
+            if( ( v & waiters_bit ) == 0 &&
+                ! word.compare_exchange_weak( v, v | waiters_bit, std::memory_order_relaxed ) )
+            {
+               continue;
+            }
+            futex::wait_for( word, v | waiters_bit, probe_ns );
+         }
+      }
+   }
+   if( out != status::not_recoverable )
+   {
+      stats_.record( since, true );
+   }
+   return( out );
+}
+
+shm::robust_mutex::status
+shm::robust_mutex::try_lock()
+{
+   auto v( word.load( std::memory_order_relaxed ) );
+   if( v == unrecoverable )
+   {
+      return( status::not_recoverable );
+   }
+   if( v != 0 ||
+       ! word.compare_exchange_strong( v,
+                                       static_cast< std::uint32_t >( self() ),
+                                       std::memory_order_acquire,
+                                       std::memory_order_relaxed ) )
+   {
+      return( status::busy );
+   }
+   stats_.record( 0, true );
+   return( status::ok );
+}
+
+void
+shm::robust_mutex::consistent()
+{
+   word.fetch_and( ~died_bit, std::memory_order_relaxed );
+}
+
+void
+shm::robust_mutex::unlock()
+{
+   /** only the holder changes the died bit **/
+   if( ( word.load( std::memory_order_relaxed ) & died_bit ) != 0 )
+   {
+      word.store( unrecoverable, std::memory_order_release );
+      futex::wake_all( word );
+      return;
+   }
+   if( ( word.exchange( 0, std::memory_order_release ) & waiters_bit ) != 0 )
+   {
+      futex::wake( word, 1 );
+   }
+}
+
+pid_t
+shm::robust_mutex::owner() const
+{
+   const auto v( word.load( std::memory_order_relaxed ) );
+   return( v == unrecoverable ? 0 : static_cast< pid_t >( v & tid_mask ) );
+}
+
+bool
+shm::robust_mutex::try_acquire( const std::uint32_t me,
+                                const std::uint32_t bits,
+                                status &out,
+                                const bool probe )
+{
+   auto v( word.load( std::memory_order_relaxed ) );
+   if( v == unrecoverable )
+   {
+      out = status::not_recoverable;
+      return( true );
+   }
+   if( v == 0 )
+   {
+      if( word.compare_exchange_strong( v,
+                                        me | bits,
+                                        std::memory_order_acquire,
+                                        std::memory_order_relaxed ) )
+      {
+         out = status::ok;
+         return( true );
+      }
+      return( false );
+   }
+   if( probe &&
+       ! alive( static_cast< pid_t >( v & tid_mask ) ) &&
+       word.compare_exchange_strong( v,
+                                     me | bits | died_bit | ( v & waiters_bit ),
+                                     std::memory_order_acquire,
+                                     std::memory_order_relaxed ) )
+   {
+      stats_.died();
+      out = status::owner_died;
+      return( true );
+   }
+   return( false );
+}
+
+/**
+ * rwlock
+ */
+shm::rwlock::status
+shm::rwlock::read_lock( const wait_policy &policy )
+{
+   const auto me( self() );
+   std::uint64_t since( 0 );
+   if( ! claim( me ) )
+   {
+      since = now_ns();
+      while( ! claim( me ) )
+      {
+         std::this_thread::yield();
+      }
+   }
+   const auto w( wait_writer( policy, since ) );
+   read_stats_.record( since, false );
+   return( ( w & died_bit ) != 0 ? status::owner_died : status::ok );
+}
+
+shm::rwlock::status
+shm::rwlock::try_read_lock()
+{
+   const auto me( self() );
+   if( ! claim( me ) )
+   {
+      return( status::busy );
+   }
+   const auto w( writer.load( std::memory_order_seq_cst ) );
+   if( ( w & active_bit ) != 0 )
+   {
+      unclaim( me );
+      return( status::busy );
+   }
+   read_stats_.record( 0, false );
+   return( ( w & died_bit ) != 0 ? status::owner_died : status::ok );
+}
+
+void
+shm::rwlock::read_unlock()
+{
+   unclaim( self() );
+}
+
+shm::rwlock::status
+shm::rwlock::write_lock( const wait_policy &policy )
+{
+   const auto me( static_cast< std::uint32_t >( self() ) );
+   std::uint64_t since( 0 );
+   std::uint32_t died( 0 );
+   /** become the writer **/
+   if( ! take( me, 0, died, false ) )
+   {
+      since = now_ns();
+      std::uint32_t spins( 0 );
+      if( ! futex::spin( [&](){ return( take( me, 0, died, ( ++spins & probe_spins ) == 0 ) ); },
+                         policy,
+                         hint ) )
+      {
+         while( ! take( me, waiters_bit, died, true ) )
+         {
+            auto w( writer.load( std::memory_order_relaxed ) );
+            if( ( w & tid_mask ) == 0 )
+            {
+               continue;
+            }
+            if( ( w & waiters_bit ) == 0 &&
+                ! writer.compare_exchange_weak( w, w | waiters_bit, std::memory_order_relaxed ) )
+            {
+               continue;
+            }
+            futex::wait_for( writer, w | waiters_bit, probe_ns );
+         }
+      }
+   }
+   /**
+    * go in once no reader holds a slot. Readers take a slot and then
+    * look for active_bit, we set it and then look at the slots, so
+    * at least one side sees the other. Readers win, we back out.
+    */
+   std::uint64_t last_probe( 0 );
+   for( ;; )
+   {
+      writer.fetch_or( active_bit, std::memory_order_seq_cst );
+      if( drained( false ) )
+      {
+         break;
+      }
+      if( ( writer.fetch_and( ~( active_bit | waiters_bit ), std::memory_order_seq_cst ) & waiters_bit ) != 0 )
+      {
+         futex::wake_all( writer );
+      }
+      if( since == 0 )
+      {
+         since = now_ns();
+      }
+      std::uint32_t spins( 0 );
+      if( futex::spin( [&](){ return( drained( ( ++spins & probe_spins ) == 0 ) ); }, policy, hint ) )
+      {
+         continue;
+      }
+      sleeping.store( 1, std::memory_order_seq_cst );
+      const auto seen( leaving.load( std::memory_order_seq_cst ) );
+      const auto now( now_ns() );
+      if( last_probe == 0 )
+      {
+         last_probe = now;
+      }
+      const bool probe( now - last_probe >= probe_ns );
+      if( probe )
+      {
+         last_probe = now;
+      }
+      if( ! drained( probe ) )
+      {
+         futex::wait_for( leaving, seen, probe_ns );
+      }
+      sleeping.store( 0, std::memory_order_relaxed );
+   }
+   write_stats_.record( since, true );
+   return( died != 0 ? status::owner_died : status::ok );
+}
+
+shm::rwlock::status
+shm::rwlock::try_write_lock()
+{
+   const auto me( static_cast< std::uint32_t >( self() ) );
+   std::uint32_t died( 0 );
+   if( ! take( me, 0, died, false ) )
+   {
+      return( status::busy );
+   }
+   writer.fetch_or( active_bit, std::memory_order_seq_cst );
+   if( ! drained( false ) )
+   {
+      /** hand it back as it was, including a dead writer's mark **/
+      if( ( writer.exchange( died, std::memory_order_seq_cst ) & waiters_bit ) != 0 )
+      {
+         futex::wake_all( writer );
+      }
+      return( status::busy );
+   }
+   write_stats_.record( 0, true );
+   return( died != 0 ? status::owner_died : status::ok );
+}
+
+void
+shm::rwlock::write_unlock()
+{
+   if( ( writer.exchange( 0, std::memory_order_release ) & waiters_bit ) != 0 )
+   {
+      futex::wake_all( writer );
+   }
+}
+
+std::size_t
+shm::rwlock::readers() const
+{
+   return( static_cast< std::size_t >(
+      std::count_if( std::begin( slots ), std::end( slots ), []( const slot &s )
+      {
+         return( s.tid.load( std::memory_order_relaxed ) != 0 );
+      } ) ) );
+}
+
+bool
+shm::rwlock::claim( const pid_t me )
+{
+   const auto start( static_cast< std::size_t >( me ) % max_readers );
+   for( std::size_t i( 0 ); i < max_readers; i++ )
+   {
+      auto &tid( slots[ ( start + i ) % max_readers ].tid );
+      pid_t expected( 0 );
+      if( tid.load( std::memory_order_relaxed ) == 0 &&
+          tid.compare_exchange_strong( expected, me, std::memory_order_seq_cst ) )
+      {
+         return( true );
+      }
+   }
+   return( false );
+}
+
+void
+shm::rwlock::unclaim( const pid_t me )
+{
+   const auto start( static_cast< std::size_t >( me ) % max_readers );
+   for( std::size_t i( 0 ); i < max_readers; i++ )
+   {
+      auto &tid( slots[ ( start + i ) % max_readers ].tid );
+      if( tid.load( std::memory_order_relaxed ) == me )
+      {
+         tid.store( 0, std::memory_order_seq_cst );
+         break;
+      }
+   }
+   if( sleeping.load( std::memory_order_seq_cst ) != 0 )
+   {
+      leaving.fetch_add( 1, std::memory_order_seq_cst );
+      futex::wake_all( leaving );
+   }
+}
+
+bool
+shm::rwlock::drained( const bool probe )
+{
+   bool empty( true );
+   for( auto &s : slots )
+   {
+      auto tid( s.tid.load( std::memory_order_seq_cst ) );
+      if( tid == 0 )
+      {
+         continue;
+      }
+      if( probe &&
+          ! alive( tid ) &&
+          s.tid.compare_exchange_strong( tid, 0, std::memory_order_seq_cst ) )
+      {
+         read_stats_.died();
+         continue;
+      }
+      if( ! probe )
+      {
+         return( false );
+      }
+      empty = false;
+   }
+   return( empty );
+}
+
+std::uint32_t
+shm::rwlock::wait_writer( const wait_policy &policy, std::uint64_t &since )
+{
+   std::uint32_t w( 0 );
+   if( gone( w, false ) )
+   {
+      return( w );
+   }
+   if( since == 0 )
+   {
+      since = now_ns();
+   }
+   std::uint32_t spins( 0 );
+   if( futex::spin( [&](){ return( gone( w, ( ++spins & probe_spins ) == 0 ) ); }, policy, hint ) )
+   {
+      return( w );
+   }
+   while( ! gone( w, true ) )
+   {
+      if( ( w & waiters_bit ) == 0 &&
+          ! writer.compare_exchange_weak( w, w | waiters_bit, std::memory_order_relaxed ) )
+      {
+         continue;
+      }
+      futex::wait_for( writer, w | waiters_bit, probe_ns );
+   }
+   return( w );
+}
+
+bool
+shm::rwlock::gone( std::uint32_t &w, const bool probe )
+{
+   w = writer.load( std::memory_order_seq_cst );
+   if( ( w & active_bit ) == 0 )
+   {
+      return( true );
+   }
+   /** a dead writer leaves only its mark, nobody is in **/
+   if( probe &&
+       ! alive( static_cast< pid_t >( w & tid_mask ) ) &&
+       writer.compare_exchange_strong( w, died_bit, std::memory_order_seq_cst ) )
+   {
+      write_stats_.died();
+      futex::wake_all( writer );
+      w = died_bit;
+      return( true );
+   }
+   return( false );
+}
+
+bool
+shm::rwlock::take( const std::uint32_t me,
+                   const std::uint32_t bits,
+                   std::uint32_t &died,
+                   const bool probe )
+{
+   auto w( writer.load( std::memory_order_relaxed ) );
+   if( ( w & tid_mask ) == 0 )
+   {
+      if( writer.compare_exchange_strong( w,
+                                          me | bits | ( w & ( died_bit | waiters_bit ) ),
+                                          std::memory_order_acquire,
+                                          std::memory_order_relaxed ) )
+      {
+         died = w & died_bit;
+         return( true );
+      }
+      return( false );
+   }
+   if( probe &&
+       ! alive( static_cast< pid_t >( w & tid_mask ) ) &&
+       writer.compare_exchange_strong( w,
+                                       me | bits | died_bit | ( w & waiters_bit ),
+                                       std::memory_order_acquire,
+                                       std::memory_order_relaxed ) )
+   {
+      write_stats_.died();
+      died = died_bit;
+      return( true );
+   }
+   return( false );
+}
+
+/**
+ * ticket_lock
+ */
+shm::ticket_lock::status
+shm::ticket_lock::lock( const wait_policy &policy )
+{
+   const auto me( self() );
+   const auto ticket( next.fetch_add( ticket_step, std::memory_order_relaxed ) );
+   holders[ ( ticket / ticket_step ) % max_waiters ].store( ( static_cast< std::uint64_t >( ticket ) << 32 ) |
+                                                            static_cast< std::uint32_t >( me ),
+                                                            std::memory_order_relaxed );
+   if( ( serving.load( std::memory_order_acquire ) & ~inherited_bit ) == ticket )
+   {
+      return( served( 0 ) );
+   }
+   const auto since( now_ns() );
+   std::uint32_t spins( 0 );
+   if( ! futex::spin( [&](){ return( turn( ticket, ( ++spins & probe_spins ) == 0 ) ); }, policy, hint ) )
+   {
+      sleepers.fetch_add( 1, std::memory_order_seq_cst );
+      for( ;; )
+      {
+         const auto now( serving.load( std::memory_order_seq_cst ) );
+         if( ( now & ~inherited_bit ) == ticket )
+         {
+            break;
+         }
+         futex::wait_for( serving, now, probe_ns );
+         /** only look in on the holder if nothing moved for a while **/
+         if( turn( ticket, serving.load( std::memory_order_relaxed ) == now ) )
+         {
+            break;
+         }
+      }
+      sleepers.fetch_sub( 1, std::memory_order_relaxed );
+   }
+   return( served( since ) );
+}
+
+shm::ticket_lock::status
+shm::ticket_lock::try_lock()
+{
+   const auto now( serving.load( std::memory_order_acquire ) & ~inherited_bit );
+   auto expected( now );
+   if( next.load( std::memory_order_relaxed ) != now ||
+       ! next.compare_exchange_strong( expected,
+                                       now + ticket_step,
+                                       std::memory_order_acquire,
+                                       std::memory_order_relaxed ) )
+   {
+      return( status::busy );
+   }
+   holders[ ( now / ticket_step ) % max_waiters ].store( ( static_cast< std::uint64_t >( now ) << 32 ) |
+                                                         static_cast< std::uint32_t >( self() ),
+                                                         std::memory_order_relaxed );
+   return( served( 0 ) );
+}
+
+void
+shm::ticket_lock::unlock()
+{
+   /** 
+    * only the holder moves serving on while it lives, a waiter that
+    * finds it dead CASes, so a plain store can't lose either one
+    */
+   const auto now( serving.load( std::memory_order_relaxed ) & ~inherited_bit );
+   serving.store( now + ticket_step, std::memory_order_seq_cst );
+   if( sleepers.load( std::memory_order_seq_cst ) != 0 )
+   {
+      /** can't wake just the next ticket, the rest go back to sleep **/
+      futex::wake_all( serving );
+   }
+}
+
+bool
+shm::ticket_lock::turn( const std::uint32_t ticket, const bool probe )
+{
+   auto now( serving.load( std::memory_order_acquire ) );
+   if( ( now & ~inherited_bit ) == ticket )
+   {
+      return( true );
+   }
+   if( ! probe )
+   {
+      return( false );
+   }
+   const auto current( now & ~inherited_bit );
+   const auto holder( holders[ ( current / ticket_step ) % max_waiters ].load( std::memory_order_relaxed ) );
+   if( static_cast< std::uint32_t >( holder >> 32 ) != current ||
+       alive( static_cast< pid_t >( holder & 0xffffffff ) ) )
+   {
+      return( false );
+   }
+   /**
+    * the heir learns about the death from the same word that hands
+    * it the lock, if the holder unlocked in the meantime this fails
+    * and nobody is told anything
+    */
+   if( serving.compare_exchange_strong( now,
+                                        ( current + ticket_step ) | inherited_bit,
+                                        std::memory_order_acq_rel ) )
+   {
+      stats_.died();
+      futex::wake_all( serving );
+   }
+   return( ( serving.load( std::memory_order_acquire ) & ~inherited_bit ) == ticket );
+}
+
+shm::ticket_lock::status
+shm::ticket_lock::served( const std::uint64_t since )
+{
+   stats_.record( since, true );
+   return( ( serving.load( std::memory_order_relaxed ) & inherited_bit ) != 0 ?
+           status::owner_died : status::ok );
+}
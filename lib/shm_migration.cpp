@@ -0,0 +1,234 @@
+/*
+ * shm_migration.cpp -
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author: Jonathan Beard
+ * @version: October 18 2026
+ */
+#include <shm>
+#include <shm_migration.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <sstream>
+
+#if __linux && ( PLATFORM_HAS_NUMA == 1 )
+#include <numaif.h>
+#include <numa.h>
+#endif
+
+shm::migration::migration( void               *ptr,
+                           const std::size_t  nbytes,
+                           const int          target_node,
+                           const std::size_t  chunk_pages ) :
+   base( reinterpret_cast< char* >( ptr ) ),
+   page_size( shm::get_page_size( ptr ) ),
+   num_pages( ( nbytes + page_size - 1 ) / page_size ),
+   target( target_node ),
+   chunk_pages( std::max( chunk_pages, std::size_t( 1 ) ) )
+{
+   const auto misaligned( reinterpret_cast< std::uintptr_t >( ptr ) % page_size );
+   if( misaligned != 0 )
+   {
+#if USE_CPP_EXCEPTIONS==1
+      std::stringstream ss;
+      ss << "Variable 'ptr' must be page aligned, currently it is(" <<
+         misaligned << ") off, please fix.\n";
+      throw page_alignment_exception( ss.str() );
+#else
+      out.error = EINVAL;
+#endif
+   }
+#if __linux && ( PLATFORM_HAS_NUMA == 1 )
+   if( numa_available() != -1 )
+   {
+      out.moved_from.resize( numa_max_node() + 1, 0 );
+   }
+#endif
+}
+
+shm::migration::~migration()
+{
+   cancel();
+   if( worker.joinable() )
+   {
+      worker.join();
+   }
+}
+
+bool
+shm::migration::run()
+{
+   if( started.exchange( true ) )
+   {
+      return( false );
+   }
+   migrate_all();
+   return( true );
+}
+
+bool
+shm::migration::start()
+{
+   if( started.exchange( true ) )
+   {
+      return( false );
+   }
+   worker = std::thread( [ this ](){ migrate_all(); } );
+   return( true );
+}
+
+void
+shm::migration::migrate_all()
+{
+   if( out.error == 0 )
+   {
+#if __linux && ( PLATFORM_HAS_NUMA == 1 )
+      if( numa_available() == -1 ||
+          target < 0 ||
+          static_cast< std::size_t >( target ) >= out.moved_from.size() )
+      {
+         out.error = ( numa_available() == -1 ? ENOSYS : EINVAL );
+      }
+#else
+      out.error = ENOSYS;
+#endif
+   }
+   if( out.error != 0 )
+   {
+      out.skipped = num_pages;
+      finished.store( true, std::memory_order_release );
+      return;
+   }
+   pages.resize( chunk_pages );
+   nodes.assign( chunk_pages, target );
+   status.resize( chunk_pages );
+   source.resize( chunk_pages );
+   for( std::size_t first( 0 ); first < num_pages; first += chunk_pages )
+   {
+      if( stop.load( std::memory_order_relaxed ) )
+      {
+         out.cancelled  = true;
+         out.skipped    = num_pages - first;
+         break;
+      }
+      const auto count( std::min( chunk_pages, num_pages - first ) );
+      migrate_chunk( first, count );
+      pages_done.fetch_add( count, std::memory_order_release );
+   }
+   finished.store( true, std::memory_order_release );
+}
+
+void
+shm::migration::cancel()
+{
+   stop.store( true, std::memory_order_relaxed );
+}
+
+std::size_t
+shm::migration::bytes_done() const
+{
+   return( pages_done.load( std::memory_order_acquire ) * page_size );
+}
+
+double
+shm::migration::progress() const
+{
+   if( num_pages == 0 )
+   {
+      return( 1.0 );
+   }
+   return( static_cast< double >( pages_done.load( std::memory_order_acquire ) ) / num_pages );
+}
+
+bool
+shm::migration::done() const
+{
+   return( finished.load( std::memory_order_acquire ) );
+}
+
+const shm::migration::result&
+shm::migration::wait()
+{
+   if( worker.joinable() )
+   {
+      worker.join();
+   }
+   return( out );
+}
+
+void
+shm::migration::migrate_chunk( const std::size_t first, const std::size_t count )
+{
+#if __linux && ( PLATFORM_HAS_NUMA == 1 )
+   for( std::size_t i( 0 ); i < count; i++ )
+   {
+      pages[ i ] = base + ( first + i ) * page_size;
+   }
+   /** where is everything now, no target nodes just reports **/
+   if( move_pages( 0, count, pages.data(), nullptr, status.data(), 0 ) != 0 )
+   {
+      out.error   = errno;
+      out.failed += count;
+      return;
+   }
+   /** only the pages that aren't on the target go to the kernel **/
+   std::size_t to_move( 0 );
+   for( std::size_t i( 0 ); i < count; i++ )
+   {
+      if( status[ i ] == target )
+      {
+         out.already_there++;
+      }
+      else if( status[ i ] == -ENOENT )
+      {
+         out.not_present++;
+      }
+      else if( status[ i ] < 0 )
+      {
+         out.failed++;
+      }
+      else
+      {
+         pages [ to_move ] = pages[ i ];
+         source[ to_move ] = status[ i ];
+         to_move++;
+      }
+   }
+   if( to_move == 0 )
+   {
+      return;
+   }
+   if( move_pages( 0, to_move, pages.data(), nodes.data(), status.data(), MPOL_MF_MOVE ) < 0 )
+   {
+      out.error   = errno;
+      out.failed += to_move;
+      return;
+   }
+   for( std::size_t i( 0 ); i < to_move; i++ )
+   {
+      if( status[ i ] == target )
+      {
+         out.moved_from[ source[ i ] ]++;
+      }
+      else
+      {
+         out.failed++;
+      }
+   }
+#else
+   (void) first;
+   out.skipped += count;
+#endif
+}
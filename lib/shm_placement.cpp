@@ -0,0 +1,307 @@
+/*
+ * shm_placement.cpp -
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author: Jonathan Beard
+ * @version: October 18 2026
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE 1
+#endif
+#include <sched.h>
+#include <unistd.h>
+
+#include <shm>
+#include <shm_placement.hpp>
+#include <shm_topology.hpp>
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <thread>
+
+#if __linux
+#include <sys/sysinfo.h>
+#if PLATFORM_HAS_NUMA == 1
+#include <numa.h>
+#endif
+#endif
+
+static std::mutex                   cache_mutex;
+static bool                         cached( false );
+static shm::placement::matrix       cache;
+
+/**
+ * distances - the firmware's view from the cached topology, a node
+ * has memory if it has some and this process may allocate on it.
+ */
+static shm::placement::matrix
+distances()
+{
+   shm::placement::matrix out;
+   const auto nodes( static_cast< std::size_t >( shm::topology::max_node() + 1 ) );
+   out.nodes = nodes;
+   out.distance.resize( nodes * nodes, 0 );
+   out.has_memory.resize( nodes, false );
+#if __linux && ( PLATFORM_HAS_NUMA == 1 )
+   struct bitmask *allowed( numa_available() != -1 ? numa_get_mems_allowed() : nullptr );
+#endif
+   for( const auto &node : shm::topology::nodes() )
+   {
+      out.has_memory[ node.id ] = node.total_bytes > 0;
+#if __linux && ( PLATFORM_HAS_NUMA == 1 )
+      if( allowed != nullptr && ! numa_bitmask_isbitset( allowed, node.id ) )
+      {
+         out.has_memory[ node.id ] = false;
+      }
+#endif
+      for( std::size_t mem( 0 ); mem < nodes; mem++ )
+      {
+         out.distance[ node.id * nodes + mem ] = shm::topology::distance( node.id, mem );
+      }
+   }
+#if __linux && ( PLATFORM_HAS_NUMA == 1 )
+   if( allowed != nullptr )
+   {
+      numa_bitmask_free( allowed );
+   }
+#endif
+   return( out );
+}
+
+double
+shm::placement::matrix::cost( const int cpu_node, const int mem_node ) const
+{
+   constexpr auto unusable( std::numeric_limits< double >::infinity() );
+   if( cpu_node < 0 || mem_node < 0 ||
+       static_cast< std::size_t >( cpu_node ) >= nodes ||
+       static_cast< std::size_t >( mem_node ) >= nodes ||
+       ! has_memory[ mem_node ] )
+   {
+      return( unusable );
+   }
+   const auto index( cpu_node * nodes + mem_node );
+   const double firmware( distance[ index ] == 0 ? unusable : distance[ index ] );
+   if( latency_ns.empty() || best_latency_ns <= 0.0 ||
+       latency_ns[ index ] <= 0.0 || bandwidth_mbs[ index ] <= 0.0 )
+   {
+      return( firmware );
+   }
+   /** relative to the best pair, so that 10 is local like the distances **/
+   return( 5.0 * ( latency_ns[ index ] / best_latency_ns ) +
+           5.0 * ( best_bandwidth_mbs / bandwidth_mbs[ index ] ) );
+}
+
+shm::placement::matrix
+shm::placement::costs()
+{
+   std::lock_guard< std::mutex > lock( cache_mutex );
+   if( ! cached )
+   {
+      cache  = distances();
+      cached = true;
+   }
+   return( cache );
+}
+
+#if __linux && ( PLATFORM_HAS_NUMA == 1 )
+/**
+ * measure_pair - latency of a dependent load chain and the read
+ * bandwidth over bytes of memory on mem_node, the caller is
+ * already running on the cpu node.
+ */
+static void
+measure_pair( const int mem_node,
+              const std::size_t bytes,
+              double &latency_ns,
+              double &bandwidth_mbs )
+{
+   using clock = std::chrono::steady_clock;
+   /** one chain link per cache line, in random order so prefetch can't help **/
+   constexpr std::size_t line = 64 / sizeof( std::size_t );
+   const auto slots( bytes / ( line * sizeof( std::size_t ) ) );
+   auto *buffer( reinterpret_cast< std::size_t* >( numa_alloc_onnode( bytes, mem_node ) ) );
+   if( buffer == nullptr )
+   {
+      return;
+   }
+   if( slots < 2 )
+   {
+      numa_free( buffer, bytes );
+      return;
+   }
+   std::vector< std::size_t > order( slots );
+   std::iota( order.begin(), order.end(), 0 );
+   std::shuffle( order.begin() + 1, order.end(), std::mt19937( 42 ) );
+   for( std::size_t i( 0 ); i < slots; i++ )
+   {
+      buffer[ order[ i ] * line ] = order[ ( i + 1 ) % slots ] * line;
+   }
+   const auto steps( std::min( slots * 2, std::size_t( 1 ) << 20 ) );
+   std::size_t next( 0 );
+   auto start( clock::now() );
+   for( std::size_t i( 0 ); i < steps; i++ )
+   {
+      next = buffer[ next ];
+   }
+   auto elapsed( std::chrono::duration< double, std::nano >( clock::now() - start ).count() );
+   latency_ns = elapsed / steps;
+
+   const auto words( bytes / sizeof( std::size_t ) );
+   std::size_t sum( next );
+   start = clock::now();
+   for( int pass( 0 ); pass < 2; pass++ )
+   {
+      for( std::size_t i( 0 ); i < words; i++ )
+      {
+         sum += buffer[ i ];
+      }
+   }
+   elapsed = std::chrono::duration< double, std::nano >( clock::now() - start ).count();
+   bandwidth_mbs = ( 2.0 * bytes / ( 1 << 20 ) ) / ( elapsed / 1e9 );
+   /** keep the loops from being optimized away **/
+   __asm__ __volatile__( "" : : "r"( sum ) : "memory" );
+   numa_free( buffer, bytes );
+}
+#endif
+
+shm::placement::matrix
+shm::placement::measure( const std::size_t bytes )
+{
+   auto out( distances() );
+#if __linux && ( PLATFORM_HAS_NUMA == 1 )
+   if( numa_available() != -1 )
+   {
+      const auto nodes( out.nodes );
+      out.latency_ns.assign( nodes * nodes, 0.0 );
+      out.bandwidth_mbs.assign( nodes * nodes, 0.0 );
+      for( std::size_t cpu( 0 ); cpu < nodes; cpu++ )
+      {
+         struct bitmask *cpus( numa_allocate_cpumask() );
+         const auto has_cpus( numa_node_to_cpus( cpu, cpus ) == 0 &&
+                              numa_bitmask_weight( cpus ) > 0 );
+         numa_free_cpumask( cpus );
+         if( ! has_cpus )
+         {
+            continue;
+         }
+         /** a thread of its own so the caller's affinity is left alone **/
+         std::thread runner( [ & ]()
+         {
+            if( numa_run_on_node( cpu ) != 0 )
+            {
+               return;
+            }
+            for( std::size_t mem( 0 ); mem < nodes; mem++ )
+            {
+               if( out.has_memory[ mem ] )
+               {
+                  measure_pair( mem,
+                                bytes,
+                                out.latency_ns[ cpu * nodes + mem ],
+                                out.bandwidth_mbs[ cpu * nodes + mem ] );
+               }
+            }
+         } );
+         runner.join();
+      }
+      /** once here rather than on every cost() **/
+      for( std::size_t i( 0 ); i < out.latency_ns.size(); i++ )
+      {
+         if( out.latency_ns[ i ] > 0.0 )
+         {
+            out.best_latency_ns    = out.best_latency_ns <= 0.0 ?
+                                     out.latency_ns[ i ] :
+                                     std::min( out.best_latency_ns, out.latency_ns[ i ] );
+            out.best_bandwidth_mbs = std::max( out.best_bandwidth_mbs, out.bandwidth_mbs[ i ] );
+         }
+      }
+   }
+#else
+   (void) bytes;
+#endif
+   std::lock_guard< std::mutex > lock( cache_mutex );
+   cache  = out;
+   cached = true;
+   return( out );
+}
+
+int
+shm::placement::best_node( const std::vector< double > &weights )
+{
+   return( best_node( weights, costs() ) );
+}
+
+int
+shm::placement::best_node( const std::vector< double > &weights, const matrix &costs )
+{
+   int     best( 0 );
+   double  best_cost( std::numeric_limits< double >::infinity() );
+   for( std::size_t mem( 0 ); mem < costs.nodes; mem++ )
+   {
+      if( ! costs.has_memory[ mem ] )
+      {
+         continue;
+      }
+      double total( 0.0 );
+      for( std::size_t cpu( 0 ); cpu < std::min( weights.size(), costs.nodes ); cpu++ )
+      {
+         if( weights[ cpu ] > 0.0 )
+         {
+            total += weights[ cpu ] * costs.cost( cpu, mem );
+         }
+      }
+      if( total < best_cost )
+      {
+         best       = static_cast< int >( mem );
+         best_cost  = total;
+      }
+   }
+   return( best );
+}
+
+std::vector< double >
+shm::placement::thread_weights( const pid_t thread_id )
+{
+   std::vector< double > weights( shm::topology::max_node() + 1, 0.0 );
+#if __linux
+   const auto num_cpus( get_nprocs_conf() );
+   cpu_set_t *cpuset( CPU_ALLOC( num_cpus ) );
+   const auto cpuset_size( CPU_ALLOC_SIZE( num_cpus ) );
+   CPU_ZERO_S( cpuset_size, cpuset );
+   if( sched_getaffinity( thread_id, cpuset_size, cpuset ) == 0 )
+   {
+      for( int cpu( 0 ); cpu < num_cpus; cpu++ )
+      {
+         const auto node( CPU_ISSET_S( cpu, cpuset_size, cpuset ) ?
+                          shm::topology::node_of_cpu( cpu ) : -1 );
+         if( node >= 0 && static_cast< std::size_t >( node ) < weights.size() )
+         {
+            weights[ node ] += 1.0;
+         }
+      }
+   }
+   CPU_FREE( cpuset );
+#else
+   (void) thread_id;
+#endif
+   if( std::all_of( weights.begin(), weights.end(), []( const double w ){ return( w == 0.0 ); } ) )
+   {
+      weights[ shm::topology::nodes().front().id ] = 1.0;
+   }
+   return( weights );
+}
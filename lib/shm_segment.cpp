@@ -0,0 +1,438 @@
+/*
+ * shm_segment.cpp -
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author: Jonathan Beard
+ * @version: October 18 2026
+ */
+#include <shm>
+#include <shm_segment.hpp>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <string>
+
+/** which backend_t a backend tag is **/
+template < class Backend > struct backend_kind;
+
+template <> struct backend_kind< shm::posix >
+{
+   static constexpr shm::segment::backend_t value = shm::segment::backend_t::posix;
+};
+
+template <> struct backend_kind< shm::sysv >
+{
+   static constexpr shm::segment::backend_t value = shm::segment::backend_t::sysv;
+};
+
+template <> struct backend_kind< shm::memfd >
+{
+   static constexpr shm::segment::backend_t value = shm::segment::backend_t::memfd;
+};
+
+/** POSIX and memfd keys are names, SystemV keys are numbers **/
+static void
+store_key( const shm::posix::key_type &key, char *name, key_t &id )
+{
+   std::memcpy( name, key, shm_key_length );
+   id = 0;
+}
+
+static void
+store_key( const shm::sysv::key_type &key, char *name, key_t &id )
+{
+   std::memset( name, 0x0, shm_key_length );
+   id = key;
+}
+
+static void
+load_key( shm::posix::key_type &dst, const char *name, const key_t id )
+{
+   std::memcpy( dst, name, shm_key_length );
+   (void) id;
+}
+
+static void
+load_key( shm::sysv::key_type &dst, const char *name, const key_t id )
+{
+   dst = id;
+   (void) name;
+}
+
+shm::segment::segment( segment &&other ) noexcept
+{
+   *this = std::move( other );
+}
+
+shm::segment&
+shm::segment::operator = ( segment &&other ) noexcept
+{
+   if( this == &other )
+   {
+      return( *this );
+   }
+   drop();
+   addr           = other.addr;
+   alloc_bytes    = other.alloc_bytes;
+   page_bytes     = other.page_bytes;
+   ring_bytes     = other.ring_bytes;
+   handle         = other.handle;
+   handle_owned   = other.handle_owned;
+   owner          = other.owner;
+   kind           = other.kind;
+   std::memcpy( name, other.name, shm_key_length );
+   id             = other.id;
+   other.reset();
+   return( *this );
+}
+
+shm::segment::~segment()
+{
+   drop();
+}
+
+template < class Backend >
+shm::segment
+shm::segment::create( const typename Backend::key_type &key,
+                      const std::size_t                nbytes,
+                      const shm::page_t                page,
+                      const shm::numa_policy           &numa,
+                      const shm::populate_t            populate,
+                      void                             *ptr )
+{
+   segment out;
+   shm::backing info;
+   void *mem( shm::init_mapping< Backend >( key, nbytes, ptr, page, numa, populate, info ) );
+   if( mem == nullptr || mem == (void*)-1 )
+   {
+      return( out );
+   }
+   out.addr          = mem;
+   out.alloc_bytes   = info.alloc_bytes;
+   out.page_bytes    = info.page_size;
+   out.handle        = info.handle;
+   out.handle_owned  = info.owned;
+   out.owner         = true;
+   out.kind          = backend_kind< Backend >::value;
+   store_key( key, out.name, out.id );
+   return( out );
+}
+
+template < class Backend >
+shm::segment
+shm::segment::open( const typename Backend::key_type &key )
+{
+   segment out;
+   shm::backing info;
+   void *mem( shm::open_mapping< Backend >( key, info ) );
+   if( mem == nullptr || mem == (void*)-1 )
+   {
+      return( out );
+   }
+   out.addr          = mem;
+   out.alloc_bytes   = info.alloc_bytes;
+   out.page_bytes    = info.page_size;
+   out.handle        = info.handle;
+   out.handle_owned  = info.owned;
+   out.owner         = false;
+   out.kind          = backend_kind< Backend >::value;
+   store_key( key, out.name, out.id );
+   return( out );
+}
+
+/** round_up - bytes in whole pages **/
+static std::size_t
+round_up( const std::size_t bytes, const std::size_t page_size )
+{
+   return( ( bytes + page_size - 1 ) / page_size * page_size );
+}
+
+/** mirror_failure - what create_mirrored/open_mirrored hand back when mirroring fails **/
+static shm::segment
+mirror_failure()
+{
+#if USE_CPP_EXCEPTIONS==1
+   throw bad_shm_alloc( std::string( "Failed to mirror segment: " ) + std::strerror( errno ) );
+#else
+   return( shm::segment() );
+#endif
+}
+
+template < class Backend >
+shm::segment
+shm::segment::create_mirrored( const typename Backend::key_type &key,
+                               const std::size_t                ring_bytes,
+                               const std::size_t                header_bytes,
+                               const shm::page_t                page,
+                               void                             *ptr )
+{
+   if( backend_kind< Backend >::value == backend_t::sysv || ring_bytes == 0 )
+   {
+      errno = ( ring_bytes == 0 ? EINVAL : ENOTSUP );
+      return( mirror_failure() );
+   }
+   /** in the page size asked for, still whole pages if it falls back **/
+   const auto page_size( shm::requested_page_bytes( page ) );
+   const auto header( round_up( header_bytes, page_size ) );
+   const auto ring( round_up( ring_bytes, page_size ) );
+   segment out( create< Backend >( key, header + ring, page ) );
+   if( ! out )
+   {
+      return( out );
+   }
+   if( ! mirror( out, header, ring, ptr ) )
+   {
+      /** out unlinks the key on the way out **/
+      return( mirror_failure() );
+   }
+   return( out );
+}
+
+template < class Backend >
+shm::segment
+shm::segment::open_mirrored( const typename Backend::key_type &key,
+                             const std::size_t                header_bytes,
+                             void                             *ptr )
+{
+   if( backend_kind< Backend >::value == backend_t::sysv )
+   {
+      errno = ENOTSUP;
+      return( mirror_failure() );
+   }
+   segment out( open< Backend >( key ) );
+   if( ! out )
+   {
+      return( out );
+   }
+   const auto header( round_up( header_bytes, out.page_size() ) );
+   if( header >= out.size() )
+   {
+      errno = EINVAL;
+      return( mirror_failure() );
+   }
+   if( ! mirror( out, header, out.size() - header, ptr ) )
+   {
+      return( mirror_failure() );
+   }
+   return( out );
+}
+
+bool
+shm::segment::mirror( segment           &seg,
+                      const std::size_t header_bytes,
+                      const std::size_t ring_bytes,
+                      void              *ptr )
+{
+   if( seg.fd() < 0 )
+   {
+      errno = ENOTSUP;
+      return( false );
+   }
+   void *out( shm::mirror_mapping( seg.addr, seg.handle, header_bytes, ring_bytes, ptr ) );
+   if( out == nullptr )
+   {
+      return( false );
+   }
+   seg.addr         = out;
+   seg.alloc_bytes  = header_bytes + 2 * ring_bytes + seg.page_bytes;
+   seg.ring_bytes   = ring_bytes;
+   return( true );
+}
+
+template < class Backend >
+bool
+shm::segment::key( typename Backend::key_type &dst ) const
+{
+   if( addr == nullptr || kind != backend_kind< Backend >::value )
+   {
+      errno = EINVAL;
+      return( false );
+   }
+   load_key( dst, name, id );
+   return( true );
+}
+
+bool
+shm::segment::resize( const std::size_t nbytes )
+{
+   if( addr == nullptr )
+   {
+      errno = EINVAL;
+      return( false );
+   }
+   if( kind == backend_t::sysv )
+   {
+      errno = ENOTSUP;
+      return( false );
+   }
+   const int fd( handle );
+   if( ! shm::resize_mapping( &addr,
+                              nbytes,
+                              [ fd ]( const std::size_t bytes )
+                              {
+                                 return( ftruncate( fd, bytes ) == 0 );
+                              } ) )
+   {
+      return( false );
+   }
+   alloc_bytes = shm::get_mapped_size( addr ) + page_bytes;
+   return( true );
+}
+
+bool
+shm::segment::remap( const std::size_t nbytes )
+{
+   if( addr == nullptr )
+   {
+      errno = EINVAL;
+      return( false );
+   }
+   if( ! shm::remap( &addr, nbytes ) )
+   {
+      return( false );
+   }
+   alloc_bytes = shm::get_mapped_size( addr ) + page_bytes;
+   return( true );
+}
+
+bool
+shm::segment::discard( const std::size_t offset, const std::size_t len )
+{
+   if( addr == nullptr || offset > size() || len > size() - offset )
+   {
+      errno = EINVAL;
+      return( false );
+   }
+   return( shm::discard( addr, offset, len ) );
+}
+
+std::vector< std::size_t >
+shm::segment::numa_placement() const
+{
+   if( addr == nullptr )
+   {
+      return( std::vector< std::size_t >() );
+   }
+   return( shm::get_numa_placement( addr, size() ) );
+}
+
+bool
+shm::segment::move_to_tid_numa( const pid_t thread_id )
+{
+   if( addr == nullptr )
+   {
+      return( true );
+   }
+   return( shm::move_to_tid_numa( thread_id, addr, size() ) );
+}
+
+bool
+shm::segment::close( const shm::release_t release, const bool unlink )
+{
+   if( addr == nullptr )
+   {
+      return( true );
+   }
+   void *ptr( addr );
+   const auto nbytes( size() );
+   const auto backend( kind );
+   char key_name[ shm_key_length ];
+   std::memcpy( key_name, name, shm_key_length );
+   const key_t key_id( id );
+   /** ours before the backend's, the close below may throw **/
+   if( handle_owned )
+   {
+      ::close( handle );
+   }
+   reset();
+   switch( backend )
+   {
+      case( backend_t::sysv ):
+         return( shm::close< shm::sysv >( key_id, &ptr, nbytes, release, unlink ) );
+      case( backend_t::memfd ):
+         return( shm::close< shm::memfd >( key_name, &ptr, nbytes, release, unlink ) );
+      default:
+         return( shm::close< shm::posix >( key_name, &ptr, nbytes, release, unlink ) );
+   }
+}
+
+void*
+shm::segment::release()
+{
+   void *out( addr );
+   if( handle_owned )
+   {
+      ::close( handle );
+   }
+   reset();
+   return( out );
+}
+
+void
+shm::segment::drop() noexcept
+{
+#if USE_CPP_EXCEPTIONS==1
+   try
+   {
+      close( release_t::none, owner );
+   }
+   catch( const std::exception & )
+   {
+      /** nowhere to report it from a destructor **/
+   }
+#else
+   close( release_t::none, owner );
+#endif
+}
+
+void
+shm::segment::reset()
+{
+   addr           = nullptr;
+   alloc_bytes    = 0;
+   page_bytes     = 0;
+   ring_bytes     = 0;
+   handle         = -1;
+   handle_owned   = false;
+   owner          = false;
+   kind           = backend_t::posix;
+   std::memset( name, 0x0, shm_key_length );
+   id             = 0;
+}
+
+#define SEGMENT_INSTANTIATE( BACKEND )                                           \
+template shm::segment shm::segment::create< BACKEND >( const BACKEND::key_type&, \
+                                                       const std::size_t,        \
+                                                       const shm::page_t,        \
+                                                       const shm::numa_policy&,  \
+                                                       const shm::populate_t,    \
+                                                       void* );                  \
+template shm::segment shm::segment::open< BACKEND >( const BACKEND::key_type& );  \
+template shm::segment shm::segment::create_mirrored< BACKEND >(                   \
+                                                       const BACKEND::key_type&, \
+                                                       const std::size_t,        \
+                                                       const std::size_t,        \
+                                                       const shm::page_t,        \
+                                                       void* );                  \
+template shm::segment shm::segment::open_mirrored< BACKEND >(                     \
+                                                       const BACKEND::key_type&, \
+                                                       const std::size_t,        \
+                                                       void* );                  \
+template bool shm::segment::key< BACKEND >( BACKEND::key_type& ) const
+
+SEGMENT_INSTANTIATE( shm::posix );
+SEGMENT_INSTANTIATE( shm::sysv );
+SEGMENT_INSTANTIATE( shm::memfd );
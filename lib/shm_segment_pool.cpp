@@ -0,0 +1,322 @@
+/*
+ * shm_segment_pool.cpp -
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author: Jonathan Beard
+ * @version: October 18 2026
+ */
+#include <shm>
+#include <shm_segment.hpp>
+#include <shm_segment_pool.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <new>
+
+/** how long the background thread sleeps with nothing to do **/
+static const auto idle_wait( std::chrono::milliseconds( 100 ) );
+
+shm::segment_pool::~segment_pool()
+{
+   {
+      std::lock_guard< std::mutex > lock( work_lock );
+      stop.store( true, std::memory_order_relaxed );
+   }
+   work.notify_one();
+   filled.notify_all();
+   if( filler.joinable() )
+   {
+      filler.join();
+   }
+   /** the buckets and returned close whatever is left **/
+}
+
+void*
+shm::segment_pool::bucket::operator new( const std::size_t nbytes )
+{
+   void *out( nullptr );
+   if( posix_memalign( &out, alignof( bucket ), nbytes ) != 0 )
+   {
+      throw std::bad_alloc();
+   }
+   return( out );
+}
+
+void
+shm::segment_pool::bucket::operator delete( void *ptr )
+{
+   std::free( ptr );
+}
+
+std::uint32_t
+shm::segment_pool::next_serial()
+{
+   static std::atomic< std::uint32_t > serial = { 0 };
+   return( serial.fetch_add( 1, std::memory_order_relaxed ) );
+}
+
+void
+shm::segment_pool::start( std::vector< size_class > classes )
+{
+   std::sort( classes.begin(), classes.end(),
+              []( const size_class &a, const size_class &b ){ return( a.bytes < b.bytes ); } );
+   for( const auto &c : classes )
+   {
+      std::unique_ptr< bucket > b( new bucket() );
+      b->bytes = c.bytes;
+      b->depth = c.depth;
+      b->ready.reserve( c.depth );
+      buckets.push_back( std::move( b ) );
+   }
+   filler = std::thread( [ this ](){ run(); } );
+}
+
+shm::segment
+shm::segment_pool::acquire( const std::size_t nbytes )
+{
+   for( auto &b : buckets )
+   {
+      if( b->bytes < nbytes )
+      {
+         continue;
+      }
+      segment out;
+      bool low( false );
+      {
+         std::lock_guard< std::mutex > lock( b->lock );
+         if( ! b->ready.empty() )
+         {
+            out = std::move( b->ready.back() );
+            b->ready.pop_back();
+         }
+         /** wake the background thread at half depth, not on every acquire **/
+         low = b->ready.size() * 2 <= b->depth;
+      }
+      if( low && ! wanted.exchange( true, std::memory_order_relaxed ) )
+      {
+         /** a missed wake up only costs the idle wait **/
+         work.notify_one();
+      }
+      if( out )
+      {
+         b->hits.fetch_add( 1, std::memory_order_relaxed );
+         return( out );
+      }
+      b->misses.fetch_add( 1, std::memory_order_relaxed );
+      return( make( b->bytes ) );
+   }
+   oversize.fetch_add( 1, std::memory_order_relaxed );
+   return( make( nbytes ) );
+}
+
+void
+shm::segment_pool::release( segment &&seg )
+{
+   if( ! seg )
+   {
+      return;
+   }
+   bool first( false );
+   {
+      std::lock_guard< std::mutex > lock( work_lock );
+      first = returned.empty();
+      returned.push_back( std::move( seg ) );
+   }
+   if( first )
+   {
+      work.notify_one();
+   }
+}
+
+bool
+shm::segment_pool::wait_ready()
+{
+   wanted.store( true, std::memory_order_relaxed );
+   work.notify_one();
+   std::unique_lock< std::mutex > lock( work_lock );
+   filled.wait( lock, [ this ]()
+   {
+      return( stop.load( std::memory_order_relaxed ) ||
+              stalled.load( std::memory_order_relaxed ) ||
+              full() );
+   } );
+   return( full() );
+}
+
+std::size_t
+shm::segment_pool::ready( const std::size_t index ) const
+{
+   std::lock_guard< std::mutex > lock( buckets[ index ]->lock );
+   return( buckets[ index ]->ready.size() );
+}
+
+shm::segment_pool::stats
+shm::segment_pool::get_stats() const
+{
+   stats out;
+   for( std::size_t i( 0 ); i < buckets.size(); i++ )
+   {
+      const auto one( get_stats( i ) );
+      out.hits     += one.hits;
+      out.misses   += one.misses;
+      out.created  += one.created;
+      out.recycled += one.recycled;
+      out.failed   += one.failed;
+   }
+   out.misses += oversize.load( std::memory_order_relaxed );
+   return( out );
+}
+
+shm::segment_pool::stats
+shm::segment_pool::get_stats( const std::size_t index ) const
+{
+   const auto &b( *buckets[ index ] );
+   stats out;
+   out.hits     = b.hits.load( std::memory_order_relaxed );
+   out.misses   = b.misses.load( std::memory_order_relaxed );
+   out.created  = b.created.load( std::memory_order_relaxed );
+   out.recycled = b.recycled.load( std::memory_order_relaxed );
+   out.failed   = b.failed.load( std::memory_order_relaxed );
+   return( out );
+}
+
+void
+shm::segment_pool::run()
+{
+   bool failing( false );
+   while( ! stop.load( std::memory_order_relaxed ) )
+   {
+      std::vector< segment > todo;
+      {
+         std::unique_lock< std::mutex > lock( work_lock );
+         /** after a failed create wait out the idle time before retrying **/
+         work.wait_for( lock, idle_wait, [ & ]()
+         {
+            return( stop.load( std::memory_order_relaxed ) ||
+                    ! returned.empty() ||
+                    ( ! failing && wanted.load( std::memory_order_relaxed ) ) );
+         } );
+         todo.swap( returned );
+         wanted.store( false, std::memory_order_relaxed );
+      }
+      if( stop.load( std::memory_order_relaxed ) )
+      {
+         break;
+      }
+      for( auto &seg : todo )
+      {
+         recycle( std::move( seg ) );
+      }
+      /** closes (and unlinks) whatever wasn't recycled **/
+      todo.clear();
+      failing = ! fill();
+      {
+         std::lock_guard< std::mutex > lock( work_lock );
+         stalled.store( failing, std::memory_order_relaxed );
+      }
+      filled.notify_all();
+   }
+}
+
+bool
+shm::segment_pool::fill()
+{
+   for( auto &b : buckets )
+   {
+      for( ;; )
+      {
+         {
+            std::lock_guard< std::mutex > lock( b->lock );
+            if( b->ready.size() >= b->depth )
+            {
+               break;
+            }
+         }
+         if( stop.load( std::memory_order_relaxed ) )
+         {
+            return( true );
+         }
+         segment seg;
+#if USE_CPP_EXCEPTIONS==1
+         try
+         {
+            seg = make( b->bytes );
+         }
+         catch( const std::exception & )
+         {
+            /** counted below, acquire reports the error on a miss **/
+         }
+#else
+         seg = make( b->bytes );
+#endif
+         if( ! seg )
+         {
+            b->failed.fetch_add( 1, std::memory_order_relaxed );
+            return( false );
+         }
+         b->created.fetch_add( 1, std::memory_order_relaxed );
+         std::lock_guard< std::mutex > lock( b->lock );
+         b->ready.push_back( std::move( seg ) );
+      }
+   }
+   return( true );
+}
+
+void
+shm::segment_pool::recycle( segment &&seg )
+{
+   if( ! opts.recycle )
+   {
+      return;
+   }
+   /** largest class it can serve **/
+   for( auto it( buckets.rbegin() ); it != buckets.rend(); ++it )
+   {
+      auto &b( **it );
+      if( b.bytes > seg.size() )
+      {
+         continue;
+      }
+      {
+         std::lock_guard< std::mutex > lock( b.lock );
+         if( b.ready.size() >= b.depth )
+         {
+            return;
+         }
+      }
+      /** keeps the pages, unlike discard **/
+      std::memset( seg.get(), 0x0, seg.size() );
+      b.recycled.fetch_add( 1, std::memory_order_relaxed );
+      std::lock_guard< std::mutex > lock( b.lock );
+      b.ready.push_back( std::move( seg ) );
+      return;
+   }
+}
+
+bool
+shm::segment_pool::full() const
+{
+   for( const auto &b : buckets )
+   {
+      std::lock_guard< std::mutex > lock( b->lock );
+      if( b->ready.size() < b->depth )
+      {
+         return( false );
+      }
+   }
+   return( true );
+}
@@ -0,0 +1,183 @@
+/*
+ * shm_string.cpp -
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author: Jonathan Beard
+ * @version: October 18 2026
+ */
+#include <shm>
+#include <shm_string.hpp>
+#include <algorithm>
+#include <cstring>
+
+shm::string::string( arena *a ) : a( a )
+{
+}
+
+shm::string::string( arena *a, const char *str ) : a( a )
+{
+   assign( str, std::strlen( str ) );
+}
+
+shm::string::string( arena *a, const char *str, const size_type len ) : a( a )
+{
+   assign( str, len );
+}
+
+shm::string::string( arena *a, const std::string &str ) : a( a )
+{
+   assign( str.data(), str.size() );
+}
+
+shm::string::string( string &&other ) noexcept : a( other.a ),
+                                                 chars( other.chars ),
+                                                 size_( other.size_ ),
+                                                 capacity_( other.capacity_ )
+{
+   other.chars     = nullptr;
+   other.size_     = 0;
+   other.capacity_ = 0;
+}
+
+shm::string&
+shm::string::operator = ( string &&other ) noexcept
+{
+   if( this != &other )
+   {
+      if( chars )
+      {
+         a->deallocate( chars.get() );
+      }
+      a               = other.a;
+      chars           = other.chars;
+      size_           = other.size_;
+      capacity_       = other.capacity_;
+      other.chars     = nullptr;
+      other.size_     = 0;
+      other.capacity_ = 0;
+   }
+   return( *this );
+}
+
+shm::string::~string()
+{
+   if( chars )
+   {
+      a->deallocate( chars.get() );
+   }
+}
+
+bool
+shm::string::reserve( const size_type n )
+{
+   if( n <= capacity_ )
+   {
+      return( true );
+   }
+   /** one more for the terminator **/
+   auto *fresh( reinterpret_cast< char* >( a->allocate( n + 1 ) ) );
+   if( fresh == nullptr )
+   {
+      return( false );
+   }
+   std::memcpy( fresh, c_str(), size_ + 1 );
+   if( chars )
+   {
+      a->deallocate( chars.get() );
+   }
+   chars     = fresh;
+   capacity_ = arena::usable_size( fresh ) - 1;
+   return( true );
+}
+
+bool
+shm::string::assign( const char *str, const size_type len )
+{
+   if( len == 0 )
+   {
+      clear();
+      return( true );
+   }
+   if( ! reserve( len ) )
+   {
+      return( false );
+   }
+   std::memmove( chars.get(), str, len );
+   chars[ len ] = '\0';
+   size_ = len;
+   return( true );
+}
+
+bool
+shm::string::append( const char *str, const size_type len )
+{
+   if( size_ + len > capacity_ )
+   {
+      /** str may be our own characters, copy them before they move **/
+      const auto *old( c_str() );
+      const bool self( str >= old && str < old + size_ );
+      const auto self_offset( str - old );
+      if( ! reserve( std::max( size_ + len, capacity_ * 2 ) ) )
+      {
+         return( false );
+      }
+      if( self )
+      {
+         str = chars.get() + self_offset;
+      }
+   }
+   if( len == 0 )
+   {
+      return( true );
+   }
+   std::memmove( chars.get() + size_, str, len );
+   size_ += len;
+   chars[ size_ ] = '\0';
+   return( true );
+}
+
+void
+shm::string::clear() noexcept
+{
+   size_ = 0;
+   if( chars )
+   {
+      chars[ 0 ] = '\0';
+   }
+}
+
+int
+shm::string::compare( const char *str, const size_type len ) const noexcept
+{
+   const auto common( std::min( size_, len ) );
+   const auto result( common == 0 ? 0 : std::memcmp( c_str(), str, common ) );
+   if( result != 0 )
+   {
+      return( result );
+   }
+   return( size_ < len ? -1 : ( size_ > len ? 1 : 0 ) );
+}
+
+std::size_t
+shm::string::hash( const char *str, const size_type len ) noexcept
+{
+   std::uint64_t h( 0xcbf29ce484222325ULL );
+   for( size_type i( 0 ); i < len; i++ )
+   {
+      h ^= static_cast< unsigned char >( str[ i ] );
+      h *= 0x100000001b3ULL;
+   }
+   return( static_cast< std::size_t >( h ) );
+}
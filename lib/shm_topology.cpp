@@ -0,0 +1,328 @@
+/*
+ * shm_topology.cpp -
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author: Jonathan Beard
+ * @version: October 18 2026
+ */
+#include <shm>
+#include <shm_topology.hpp>
+#include <unistd.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+static const std::string sys_node( "/sys/devices/system/node/" );
+static const std::string sys_cpu ( "/sys/devices/system/cpu/" );
+
+/** machine - everything but free memory, built once **/
+struct machine
+{
+   std::vector< shm::topology::node >          nodes;
+   std::vector< int >                          cpus;
+   /** cpu_node[ cpu ], -1 for cpus that aren't online **/
+   std::vector< int >                          cpu_node;
+   std::vector< shm::topology::cache_group >   llc;
+};
+
+/** read_line - first line of a sysfs file, empty if it can't be read **/
+static std::string
+read_line( const std::string &path )
+{
+   std::ifstream in( path );
+   std::string line;
+   std::getline( in, line );
+   return( line );
+}
+
+/**
+ * meminfo_bytes - the value of field (e.g., "MemFree:") in a
+ * meminfo style file, which reports kB.
+ */
+static std::size_t
+meminfo_bytes( const std::string &path, const char *field )
+{
+   std::ifstream in( path );
+   std::string line;
+   while( std::getline( in, line ) )
+   {
+      const auto at( line.find( field ) );
+      if( at != std::string::npos )
+      {
+         return( std::strtoull( line.c_str() + at + std::strlen( field ), nullptr, 10 ) << 10 );
+      }
+   }
+   return( 0 );
+}
+
+/** size_bytes - cache sizes read like "48K" or "2M" **/
+static std::size_t
+size_bytes( const std::string &text )
+{
+   char *end( nullptr );
+   std::size_t out( std::strtoull( text.c_str(), &end, 10 ) );
+   switch( end != nullptr ? *end : '\0' )
+   {
+      case( 'K' ):
+         out <<= 10;
+         break;
+      case( 'M' ):
+         out <<= 20;
+         break;
+      case( 'G' ):
+         out <<= 30;
+         break;
+      default:
+         break;
+   }
+   return( out );
+}
+
+/**
+ * llc_of - the highest data or unified cache cpu has, nothing if
+ * sysfs doesn't describe its caches.
+ */
+static bool
+llc_of( const int cpu, shm::topology::cache_group &group )
+{
+   bool found( false );
+   const auto base( sys_cpu + "cpu" + std::to_string( cpu ) + "/cache/index" );
+   for( int index( 0 ); ; index++ )
+   {
+      const auto dir( base + std::to_string( index ) + "/" );
+      const auto level( read_line( dir + "level" ) );
+      if( level.empty() )
+      {
+         break;
+      }
+      if( read_line( dir + "type" ) == "Instruction" )
+      {
+         continue;
+      }
+      const auto value( std::atoi( level.c_str() ) );
+      if( value >= group.level )
+      {
+         group.level = value;
+         group.cpus  = shm::topology::parse_list( read_line( dir + "shared_cpu_list" ).c_str() );
+         group.bytes = size_bytes( read_line( dir + "size" ) );
+         found       = true;
+      }
+   }
+   return( found );
+}
+
+static machine
+discover()
+{
+   machine out;
+   out.cpus = shm::topology::parse_list( read_line( sys_cpu + "online" ).c_str() );
+   if( out.cpus.empty() )
+   {
+      /** not Linux, or no sysfs **/
+      const auto count( std::max( sysconf( _SC_NPROCESSORS_ONLN ), 1L ) );
+      for( int cpu( 0 ); cpu < count; cpu++ )
+      {
+         out.cpus.push_back( cpu );
+      }
+   }
+   out.cpu_node.assign( out.cpus.back() + 1, -1 );
+
+   const auto ids( shm::topology::parse_list( read_line( sys_node + "online" ).c_str() ) );
+   for( const auto id : ids )
+   {
+      const auto dir( sys_node + "node" + std::to_string( id ) + "/" );
+      shm::topology::node node;
+      node.id           = id;
+      node.total_bytes  = meminfo_bytes( dir + "meminfo", "MemTotal:" );
+      /** the kernel lists distances to the online nodes in id order **/
+      node.distance.assign( ids.back() + 1, 0 );
+      std::istringstream distances( read_line( dir + "distance" ) );
+      for( std::size_t i( 0 ); i < ids.size() && distances >> node.distance[ ids[ i ] ]; i++ );
+      for( const auto cpu : shm::topology::parse_list( read_line( dir + "cpulist" ).c_str() ) )
+      {
+         if( static_cast< std::size_t >( cpu ) < out.cpu_node.size() &&
+             std::binary_search( out.cpus.begin(), out.cpus.end(), cpu ) )
+         {
+            node.cpus.push_back( cpu );
+            out.cpu_node[ cpu ] = id;
+         }
+      }
+      out.nodes.push_back( node );
+   }
+   if( out.nodes.empty() )
+   {
+      /** a kernel without NUMA, everything is node 0 **/
+      shm::topology::node node;
+      node.cpus        = out.cpus;
+      node.distance    = { 10 };
+      node.total_bytes = meminfo_bytes( "/proc/meminfo", "MemTotal:" );
+      if( node.total_bytes == 0 )
+      {
+         node.total_bytes = static_cast< std::size_t >( sysconf( _SC_PHYS_PAGES ) ) *
+                            static_cast< std::size_t >( sysconf( _SC_PAGESIZE ) );
+      }
+      out.nodes.push_back( node );
+      for( const auto cpu : out.cpus )
+      {
+         out.cpu_node[ cpu ] = 0;
+      }
+   }
+
+   /** one group per distinct shared_cpu_list, each cpu lands in one **/
+   std::vector< bool > grouped( out.cpu_node.size(), false );
+   for( const auto cpu : out.cpus )
+   {
+      if( grouped[ cpu ] )
+      {
+         continue;
+      }
+      shm::topology::cache_group group;
+      if( ! llc_of( cpu, group ) )
+      {
+         group.cpus = { cpu };
+      }
+      /** offline cpus show up in shared_cpu_list too **/
+      group.cpus.erase( std::remove_if( group.cpus.begin(), group.cpus.end(),
+         [ & ]( const int other )
+         {
+            return( static_cast< std::size_t >( other ) >= out.cpu_node.size() ||
+                    out.cpu_node[ other ] == -1 ||
+                    grouped[ other ] );
+         } ), group.cpus.end() );
+      if( group.cpus.empty() )
+      {
+         group.cpus = { cpu };
+      }
+      for( const auto member : group.cpus )
+      {
+         grouped[ member ] = true;
+      }
+      group.node = out.cpu_node[ group.cpus.front() ];
+      out.llc.push_back( group );
+   }
+   return( out );
+}
+
+/** the magic static makes the first call build it, once **/
+static const machine&
+get()
+{
+   static const machine cached( discover() );
+   return( cached );
+}
+
+const std::vector< shm::topology::node >&
+shm::topology::nodes()
+{
+   return( get().nodes );
+}
+
+int
+shm::topology::max_node()
+{
+   return( get().nodes.back().id );
+}
+
+int
+shm::topology::distance( const int from, const int to )
+{
+   for( const auto &node : get().nodes )
+   {
+      if( node.id == from )
+      {
+         if( to < 0 || static_cast< std::size_t >( to ) >= node.distance.size() )
+         {
+            return( 0 );
+         }
+         return( node.distance[ to ] );
+      }
+   }
+   return( 0 );
+}
+
+const std::vector< int >&
+shm::topology::cpus()
+{
+   return( get().cpus );
+}
+
+int
+shm::topology::node_of_cpu( const int cpu )
+{
+   const auto &cpu_node( get().cpu_node );
+   if( cpu < 0 || static_cast< std::size_t >( cpu ) >= cpu_node.size() )
+   {
+      return( -1 );
+   }
+   return( cpu_node[ cpu ] );
+}
+
+const std::vector< shm::topology::cache_group >&
+shm::topology::llc_groups()
+{
+   return( get().llc );
+}
+
+std::size_t
+shm::topology::free_memory( const int node )
+{
+   const auto &nodes( get().nodes );
+   if( std::none_of( nodes.begin(), nodes.end(),
+                     [ & ]( const shm::topology::node &n ){ return( n.id == node ); } ) )
+   {
+      return( 0 );
+   }
+   const auto per_node( meminfo_bytes( sys_node + "node" + std::to_string( node ) + "/meminfo",
+                                       "MemFree:" ) );
+   if( per_node != 0 || nodes.size() > 1 )
+   {
+      return( per_node );
+   }
+   return( meminfo_bytes( "/proc/meminfo", "MemFree:" ) );
+}
+
+std::vector< int >
+shm::topology::parse_list( const char *list )
+{
+   std::vector< int > out;
+   const char *at( list );
+   while( at != nullptr && *at != '\0' )
+   {
+      if( ! std::isdigit( static_cast< unsigned char >( *at ) ) )
+      {
+         at++;
+         continue;
+      }
+      char *end( nullptr );
+      const auto first( std::strtol( at, &end, 10 ) );
+      auto last( first );
+      if( *end == '-' )
+      {
+         last = std::strtol( end + 1, &end, 10 );
+      }
+      for( auto i( first ); i <= last; i++ )
+      {
+         out.push_back( static_cast< int >( i ) );
+      }
+      at = end;
+   }
+   std::sort( out.begin(), out.end() );
+   out.erase( std::unique( out.begin(), out.end() ), out.end() );
+   return( out );
+}
@@ -0,0 +1,177 @@
+/**
+ * arena.cpp -
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <shm>
+#include <shm_arena.hpp>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "check.hpp"
+
+static constexpr std::size_t    nbytes      = 1 << 22;
+static constexpr std::uint64_t  workers     = 4;
+static constexpr std::uint64_t  rounds      = 20000;
+static constexpr std::size_t    handoff     = 256;
+
+static bool holds( const void *ptr, const std::size_t len, const unsigned char value )
+{
+   const auto *bytes( reinterpret_cast< const unsigned char* >( ptr ) );
+   for( std::size_t i( 0 ); i < len; i++ )
+   {
+      if( bytes[ i ] != value )
+      {
+         return( false );
+      }
+   }
+   return( true );
+}
+
+int
+main( int argc, char **argv )
+{
+   shm_key_t key    = { shm_initial_key };
+   shm::gen_key( key, 104 );
+   void *mem( shm::init( key, nbytes, true, nullptr ) );
+   if( mem == (void*)-1 || mem == nullptr )
+   {
+      std::fprintf( stderr, "Failed to allocate pointer\n" );
+      exit( EXIT_FAILURE );
+   }
+   auto *a( shm::arena::create( mem, nbytes ) );
+   check( a != nullptr, "a != nullptr" );
+
+   /** size classes round up, never down, and keep alignment **/
+   for( std::size_t n( 1 ); n < 70000; n += ( n < 512 ? 1 : 97 ) )
+   {
+      void *p( a->allocate( n ) );
+      check( p != nullptr, "p != nullptr" );
+      check( reinterpret_cast< std::uintptr_t >( p ) % shm::arena::alignment == 0,
+             "pointer is aligned" );
+      check( shm::arena::usable_size( p ) >= n, "usable_size( p ) >= n" );
+      check( shm::arena::usable_size( p ) <= n + n / 4 + 16, "usable_size( p ) is tight" );
+      a->deallocate( p );
+   }
+
+   /** frees recycle memory rather than carving more **/
+   {
+      void *p( a->allocate( 100 ) );
+      a->deallocate( p );
+      const auto carved( a->carved() );
+      void *q( a->allocate( 100 ) );
+      check( p == q, "p == q" );
+      check( a->carved() == carved, "a->carved() == carved" );
+      a->deallocate( q );
+   }
+
+   /**
+    * every worker allocates random sizes through its own cache,
+    * fills them with its id and checks nobody else wrote there.
+    */
+   for( std::uint64_t w( 0 ); w < workers; w++ )
+   {
+      if( fork() == 0 )
+      {
+         auto *ca( shm::arena::attach( shm::open( key ) ) );
+         shm::arena::cache cache( ca );
+         std::mt19937 gen( w );
+         std::uniform_int_distribution< std::size_t > size( 1, 2048 );
+         const auto value( static_cast< unsigned char >( w + 1 ) );
+         std::vector< std::pair< void*, std::size_t > > live;
+         for( std::uint64_t r( 0 ); r < rounds; r++ )
+         {
+            if( live.size() < 64 && ( live.empty() || gen() % 3 != 0 ) )
+            {
+               const auto len( size( gen ) );
+               void *p( cache.allocate( len ) );
+               check( p != nullptr, "cache.allocate( len ) != nullptr" );
+               std::memset( p, value, len );
+               live.emplace_back( p, len );
+            }
+            else
+            {
+               const auto i( gen() % live.size() );
+               check( holds( live[ i ].first, live[ i ].second, value ), "block untouched" );
+               cache.deallocate( live[ i ].first );
+               live[ i ] = live.back();
+               live.pop_back();
+            }
+         }
+         for( const auto &block : live )
+         {
+            check( holds( block.first, block.second, value ), "block untouched" );
+            cache.deallocate( block.first );
+         }
+         _exit( EXIT_SUCCESS );
+      }
+   }
+   check( wait_all( workers ), "wait_all( workers )" );
+
+   /** blocks allocated here, freed by another process **/
+   auto *offsets( reinterpret_cast< std::uint64_t* >( a->allocate( handoff * sizeof( std::uint64_t ) ) ) );
+   for( std::size_t i( 0 ); i < handoff; i++ )
+   {
+      offsets[ i ] = a->offset_of( a->allocate( 48 ) );
+   }
+   if( fork() == 0 )
+   {
+      auto *ca( shm::arena::attach( shm::open( key ) ) );
+      for( std::size_t i( 0 ); i < handoff; i++ )
+      {
+         ca->deallocate( ca->at( offsets[ i ] ) );
+      }
+      _exit( EXIT_SUCCESS );
+   }
+   check( wait_all( 1 ), "wait_all( 1 )" );
+   const auto carved( a->carved() );
+   for( std::size_t i( 0 ); i < handoff; i++ )
+   {
+      check( a->allocate( 48 ) != nullptr, "a->allocate( 48 ) != nullptr" );
+   }
+   check( a->carved() == carved, "a->carved() == carved" );
+
+   /** running out is reported, not silently wrapped **/
+   bool exhausted( false );
+   for( std::size_t i( 0 ); i < nbytes && ! exhausted; i++ )
+   {
+#if USE_CPP_EXCEPTIONS==1
+      try
+      {
+         a->allocate( 1 << 16 );
+      }
+      catch( bad_shm_alloc &ex )
+      {
+         exhausted = true;
+      }
+#else
+      exhausted = ( a->allocate( 1 << 16 ) == nullptr );
+#endif
+   }
+   check( exhausted, "exhausted" );
+   check( a->carved() <= a->capacity(), "a->carved() <= a->capacity()" );
+
+   shm::close( key, &mem, nbytes, false, true );
+   return( EXIT_SUCCESS );
+}
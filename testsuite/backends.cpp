@@ -0,0 +1,110 @@
+/**
+ * backends.cpp -
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <shm>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "check.hpp"
+
+static constexpr std::size_t nitems = 0x1000;
+
+/**
+ * segment - one segment of a given backend, every one of them
+ * lives at the same time as the others.
+ */
+template < class Backend > struct segment
+{
+   segment( const int proj_id, const std::uint32_t seed ) : seed( seed )
+   {
+      shm::gen_key< Backend >( key, proj_id );
+      ptr = shm::einit< std::uint32_t, Backend >( key, nitems );
+      check( ptr != nullptr && ptr != (void*)-1, "shm::einit< T, Backend >" );
+      for( std::size_t i( 0 ); i < nitems; i++ )
+      {
+         ptr[ i ] = seed + i;
+      }
+   }
+
+   /** child side, sees the parent's writes and answers **/
+   void reply()
+   {
+      auto *other( shm::eopen< std::uint32_t, Backend >( key ) );
+      check( other != nullptr, "shm::eopen< T, Backend >" );
+      for( std::size_t i( 0 ); i < nitems; i++ )
+      {
+         check( other[ i ] == seed + i, "contents" );
+      }
+      other[ 0 ] = ~seed;
+      shm::close< Backend >( key,
+                             reinterpret_cast< void** >( &other ),
+                             nitems * sizeof( std::uint32_t ),
+                             false,
+                             false );
+      check( other == nullptr, "close nulls the pointer" );
+   }
+
+   ~segment()
+   {
+      check( ptr[ 0 ] == ~seed, "child's write is visible" );
+      shm::close< Backend >( key,
+                             reinterpret_cast< void** >( &ptr ),
+                             nitems * sizeof( std::uint32_t ),
+                             false,
+                             true );
+   }
+
+   typename Backend::key_type key;
+   std::uint32_t              *ptr = nullptr;
+   const std::uint32_t        seed;
+};
+
+int
+main( int argc, char **argv )
+{
+   {
+      segment< shm::posix > posix( 1, 0x100 );
+      segment< shm::sysv >  sysv( 2, 0x200 );
+#if __linux
+      segment< shm::memfd > memfd( 3, 0x300 );
+#endif
+      /** the default backend is one of the above, without a template argument **/
+      shm_key_t key;
+      shm::gen_key( key, 4 );
+      void *def( shm::init( key, 0x1000 ) );
+      check( def != nullptr && def != (void*)-1, "shm::init" );
+      shm::close( key, &def, 0x1000, false, true );
+
+      if( fork() == 0 )
+      {
+         posix.reply();
+         sysv.reply();
+#if __linux
+         memfd.reply();
+#endif
+         _exit( EXIT_SUCCESS );
+      }
+      check( wait_all( 1 ), "child" );
+   }
+   return( EXIT_SUCCESS );
+}
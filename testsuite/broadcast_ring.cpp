@@ -0,0 +1,145 @@
+/**
+ * broadcast_ring.cpp -
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <shm>
+#include <shm_broadcast_ring.hpp>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "check.hpp"
+
+using ring_t = shm::broadcast_ring< std::uint64_t >;
+
+static constexpr std::uint64_t  count    = 1 << 16;
+static constexpr std::size_t    readers  = 3;
+
+/** every reader gets every item, in order, with backpressure **/
+static void everyone_gets_everything()
+{
+   shm_key_t key;
+   shm::gen_key( key, 21 );
+   const auto nbytes( ring_t::required_bytes( 64, readers ) );
+   void *mem( shm::init( key, nbytes, false, nullptr ) );
+   auto *ring( ring_t::create( mem, 64, readers ) );
+   check( ring->capacity() == 64, "capacity" );
+
+   pid_t children[ readers ];
+   for( auto &child : children )
+   {
+      child = fork();
+      if( child == 0 )
+      {
+         void *cmem( shm::open( key ) );
+         auto *cring( ring_t::attach( cmem ) );
+         const auto id( cring->subscribe() );
+         check( id >= 0, "subscribe" );
+         std::uint64_t item( 0 );
+         for( std::uint64_t expected( 0 ); expected < count; expected++ )
+         {
+            cring->pop( id, item );
+            check( item == expected, "in order, nothing missing" );
+         }
+         check( cring->lost( id ) == 0, "nothing lost" );
+         cring->unsubscribe( id );
+         shm::close( key, &cmem, nbytes, false, false );
+         _exit( EXIT_SUCCESS );
+      }
+   }
+   while( ring->readers() != readers )
+   {
+      std::this_thread::yield();
+   }
+   check( ring->subscribe() == -1, "no cursor left" );
+   for( std::uint64_t i( 0 ); i < count; i++ )
+   {
+      ring->push( i );
+   }
+   for( const auto child : children )
+   {
+      exited( child );
+   }
+   check( ring->readers() == 0, "all unsubscribed" );
+   shm::close( key, &mem, nbytes, false, true );
+}
+
+/** a slow reader is lapped and moved up, the producer never waits **/
+static void lapped()
+{
+   shm_key_t key;
+   shm::gen_key( key, 21 );
+   const auto nbytes( ring_t::required_bytes( 16, 2 ) );
+   void *mem( shm::init( key, nbytes, false, nullptr ) );
+   auto *ring( ring_t::create( mem, 16, 2, ring_t::policy_t::lapped ) );
+   const auto id( ring->subscribe() );
+   std::uint64_t item( 0 );
+   check( ring->try_pop( id, item ) == ring_t::status::empty, "empty" );
+   for( std::uint64_t i( 0 ); i < 100; i++ )
+   {
+      check( ring->try_push( i ), "never full" );
+   }
+   check( ring->try_pop( id, item ) == ring_t::status::lapped, "lapped" );
+   check( ring->lost( id ) == 100 - 15, "lost what was overwritten" );
+   for( std::uint64_t expected( 85 ); expected < 100; expected++ )
+   {
+      check( ring->try_pop( id, item ) == ring_t::status::ok && item == expected, "oldest left" );
+   }
+   check( ring->try_pop( id, item ) == ring_t::status::empty, "caught up" );
+   shm::close( key, &mem, nbytes, false, true );
+}
+
+/** a reader that dies subscribed doesn't hold the producer forever **/
+static void reaped()
+{
+   shm_key_t key;
+   shm::gen_key( key, 21 );
+   const auto nbytes( ring_t::required_bytes( 8, 2 ) );
+   void *mem( shm::init( key, nbytes, false, nullptr ) );
+   auto *ring( ring_t::create( mem, 8, 2 ) );
+   const auto child( fork() );
+   if( child == 0 )
+   {
+      check( ring->subscribe() >= 0, "subscribe" );
+      _exit( EXIT_SUCCESS );
+   }
+   exited( child );
+   check( ring->readers() == 1, "still subscribed" );
+   for( std::uint64_t i( 0 ); i < 8; i++ )
+   {
+      check( ring->try_push( i ), "room for a ring" );
+   }
+   check( ! ring->try_push( 8 ), "held by the dead reader" );
+   /** push reaps it **/
+   ring->push( 8 );
+   check( ring->readers() == 0, "reaped" );
+   shm::close( key, &mem, nbytes, false, true );
+}
+
+int
+main( int argc, char **argv )
+{
+   everyone_gets_everything();
+   lapped();
+   reaped();
+   return( EXIT_SUCCESS );
+}
@@ -0,0 +1,154 @@
+/**
+ * buffer_pool.cpp -
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <shm>
+#include <shm_buffer_pool.hpp>
+#include <shm_spsc_ring.hpp>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "check.hpp"
+
+using descriptor_t = shm::buffer_pool::descriptor;
+using ring_t       = shm::spsc_ring< descriptor_t >;
+
+static constexpr std::size_t   buffer_size = 1 << 16;
+static constexpr std::size_t   buffers     = 8;
+static constexpr std::uint64_t count       = 1 << 10;
+
+int
+main( int argc, char **argv )
+{
+   /** pool and a ring of descriptors in one segment **/
+   shm_key_t key;
+   shm::gen_key( key, 22 );
+   const auto pool_bytes( shm::buffer_pool::required_bytes( buffer_size, buffers ) );
+   const auto nbytes( pool_bytes + ring_t::required_bytes( buffers ) );
+   void *mem( shm::init( key, nbytes, false, nullptr ) );
+   auto *pool( shm::buffer_pool::create( mem, buffer_size, buffers, 7 ) );
+   auto *ring( ring_t::create( reinterpret_cast< char* >( mem ) + pool_bytes, buffers ) );
+   const auto me( pool->join() );
+   check( me >= 0, "join" );
+
+   /** allocate until empty, buffers don't overlap **/
+   descriptor_t all[ buffers ];
+   for( auto &d : all )
+   {
+      check( pool->allocate( me, d ), "allocate" );
+      check( d.pool_id == 7 && d.length == buffer_size && d.offset % 4096 == 0, "descriptor" );
+      std::memset( pool->data( d ), static_cast< int >( d.index ), buffer_size );
+   }
+   descriptor_t extra;
+   check( ! pool->allocate( me, extra ), "empty" );
+   for( const auto &d : all )
+   {
+      check( reinterpret_cast< std::uint8_t* >( pool->data( d ) )[ buffer_size - 1 ] == d.index,
+             "buffers don't overlap" );
+      pool->release( me, d );
+   }
+   check( pool->available() == buffers, "all back" );
+
+   /** handed to another process through the ring, no copies **/
+   auto child( fork() );
+   if( child == 0 )
+   {
+      const auto reader( pool->join() );
+      check( reader >= 0 && reader != me, "second client" );
+      for( std::uint64_t i( 0 ); i < count; i++ )
+      {
+         descriptor_t d;
+         while( ! ring->pop( d ) )
+         {
+            std::this_thread::yield();
+         }
+         check( d.owner == static_cast< std::uint32_t >( me ), "sender owns it in flight" );
+         check( pool->adopt( reader, d ), "adopt" );
+         const auto *bytes( reinterpret_cast< const std::uint64_t* >( pool->data( d ) ) );
+         check( d.length == 64 && bytes[ 0 ] == i && bytes[ 7 ] == i, "payload" );
+         pool->release( reader, d );
+      }
+      pool->leave( reader );
+      _exit( EXIT_SUCCESS );
+   }
+   for( std::uint64_t i( 0 ); i < count; i++ )
+   {
+      descriptor_t d;
+      while( ! pool->allocate( me, d ) )
+      {
+         std::this_thread::yield();
+      }
+      auto *bytes( reinterpret_cast< std::uint64_t* >( pool->data( d ) ) );
+      for( int w( 0 ); w < 8; w++ )
+      {
+         bytes[ w ] = i;
+      }
+      d.length = 64;
+      while( ! ring->push( d ) )
+      {
+         std::this_thread::yield();
+      }
+   }
+   exited( child );
+   check( pool->available() == buffers, "reader released everything" );
+
+   /** fan out, the last release frees it **/
+   const auto other( pool->join() );
+   descriptor_t d;
+   check( pool->allocate( me, d ), "allocate" );
+   descriptor_t copy( d );
+   check( pool->retain( me, copy ) && pool->references( d ) == 2, "retain" );
+   check( pool->adopt( other, copy ), "adopt a copy" );
+   pool->release( me, d );
+   check( pool->available() == buffers - 1, "still held by the other client" );
+   pool->release( other, copy );
+   check( pool->available() == buffers, "freed by the last holder" );
+   check( ! pool->retain( me, d ), "stale descriptor" );
+
+   /** a holder that dies, including a buffer it had sent **/
+   child = fork();
+   if( child == 0 )
+   {
+      const auto doomed( pool->join() );
+      descriptor_t held;
+      for( int i( 0 ); i < 3; i++ )
+      {
+         check( pool->allocate( doomed, held ), "allocate" );
+      }
+      check( ring->push( held ), "send one" );
+      _exit( EXIT_SUCCESS );
+   }
+   exited( child );
+   check( pool->available() == buffers - 3, "held by the dead process" );
+   check( pool->reclaim() == 3, "reclaimed" );
+   check( pool->available() == buffers, "all back" );
+   descriptor_t in_flight;
+   check( ring->pop( in_flight ), "sent" );
+   check( ! pool->adopt( me, in_flight ), "can't adopt a reclaimed buffer" );
+
+   pool->leave( other );
+   pool->leave( me );
+   shm::close( key, &mem, nbytes, false, true );
+   return( EXIT_SUCCESS );
+}
@@ -0,0 +1,65 @@
+/**
+ * check.hpp - helpers shared by the tests. asserts vanish in
+ * release builds and the checks have side effects, so a failed
+ * check prints what failed and exits the process (a forked child
+ * exits on its own, its parent sees that through exited or
+ * wait_all).
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _SHM_CHECK_HPP_
+#define _SHM_CHECK_HPP_  1
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+/** check - exits with EXIT_FAILURE unless cond holds **/
+inline void check( const bool cond, const char *what )
+{
+   if( ! cond )
+   {
+      std::fprintf( stderr, "check failed: %s\n", what );
+      _exit( EXIT_FAILURE );
+   }
+}
+
+/** exited - waits for child, which must have exited with EXIT_SUCCESS **/
+inline void exited( const pid_t child )
+{
+   int status( 0 );
+   waitpid( child, &status, 0 );
+   check( WIFEXITED( status ) && WEXITSTATUS( status ) == EXIT_SUCCESS, "child" );
+}
+
+/** wait_all - waits for n children, true if all of them exited with EXIT_SUCCESS **/
+inline bool wait_all( const std::uint64_t n )
+{
+   bool ok( true );
+   for( std::uint64_t i( 0 ); i < n; i++ )
+   {
+      int status( 0 );
+      wait( &status );
+      ok = ok && WIFEXITED( status ) && WEXITSTATUS( status ) == EXIT_SUCCESS;
+   }
+   return( ok );
+}
+
+#endif /* END _SHM_CHECK_HPP_ */
@@ -0,0 +1,203 @@
+/**
+ * concurrent_map.cpp -
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <shm>
+#include <shm_concurrent_map.hpp>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "check.hpp"
+
+using map_t = shm::concurrent_map< std::uint64_t, std::uint64_t >;
+using result = map_t::result;
+
+/** every key in the same group with the same tag, probes have to go far **/
+struct collide
+{
+   std::size_t operator()( const std::uint32_t ) const
+   {
+      return( 0 );
+   }
+};
+
+using collide_t = shm::concurrent_map< std::uint32_t, std::uint32_t, collide >;
+
+static constexpr std::size_t   capacity  = 1 << 14;
+static constexpr std::uint64_t workers   = 4;
+static constexpr std::uint64_t shared    = 1000;
+static constexpr std::uint64_t own       = 2000;
+
+struct counts
+{
+   std::atomic< std::uint64_t > inserted;
+   std::atomic< std::uint64_t > erased;
+   std::atomic< std::uint64_t > arrived;
+};
+
+/** value - what every process stores for key **/
+static std::uint64_t value( const std::uint64_t key )
+{
+   return( key * 3 + 1 );
+}
+
+int
+main( int argc, char **argv )
+{
+   shm_key_t key;
+   shm::gen_key( key, 25 );
+   const auto map_bytes( ( map_t::required_bytes( capacity ) + SHM_CACHE_LINE_SIZE - 1 ) &
+                         ~std::size_t( SHM_CACHE_LINE_SIZE - 1 ) );
+   const auto collide_bytes( ( collide_t::required_bytes( 64 ) + SHM_CACHE_LINE_SIZE - 1 ) &
+                             ~std::size_t( SHM_CACHE_LINE_SIZE - 1 ) );
+   const auto nbytes( map_bytes + collide_bytes + sizeof( counts ) );
+   void *mem( shm::init( key, nbytes, false, nullptr ) );
+   auto *map( map_t::create( mem, capacity ) );
+   auto *c( new ( reinterpret_cast< char* >( mem ) + map_bytes + collide_bytes ) counts() );
+   c->inserted = 0;
+   c->erased   = 0;
+   c->arrived  = 0;
+   check( map_t::attach( mem ) == map && map->capacity() == capacity, "attach" );
+#if USE_CPP_EXCEPTIONS==1
+   bool wrong_type( false );
+   try
+   {
+      shm::concurrent_map< std::uint64_t, std::uint32_t >::attach( mem );
+   }
+   catch( invalid_segment_exception &ex )
+   {
+      wrong_type = true;
+   }
+   check( wrong_type, "attach as another type" );
+#else
+   check( shm::concurrent_map< std::uint64_t, std::uint32_t >::attach( mem ) == nullptr,
+          "attach as another type" );
+#endif
+
+   /** one process **/
+   std::uint64_t out( 0 );
+   check( ! map->find( 7, out ), "empty" );
+   check( map->insert( 7, 70 ) == result::inserted, "insert" );
+   check( map->insert( 7, 71 ) == result::exists, "insert twice" );
+   check( map->find( 7, out ) && out == 70, "find" );
+   check( map->insert_or_assign( 7, 72 ) == result::exists && map->find( 7, out ) && out == 72,
+          "assign" );
+   check( map->insert( ~std::uint64_t( 0 ), 1 ) == result::invalid_key, "reserved key" );
+   check( ! map->contains( ~std::uint64_t( 0 ) ), "reserved key" );
+   check( map->erase( 7 ) && ! map->erase( 7 ) && ! map->contains( 7 ), "erase" );
+   check( map->insert( 7, 73 ) == result::inserted && map->find( 7, out ) && out == 73, "reinsert" );
+   check( map->erase( 7 ) && map->size() == 0, "size" );
+
+   /** another reserved key frees all ones up **/
+   auto *zero( map_t::create( mem, capacity, 0 ) );
+   check( zero->insert( ~std::uint64_t( 0 ), 1 ) == result::inserted, "all ones" );
+   check( zero->insert( 0, 1 ) == result::invalid_key, "zero reserved" );
+   map = map_t::create( mem, capacity );
+
+   /** probes across groups, and a full table **/
+   auto *col( collide_t::create( reinterpret_cast< char* >( mem ) + map_bytes, 64 ) );
+   for( std::uint32_t k( 0 ); k < 64; k++ )
+   {
+      check( col->insert( k, k + 100 ) == collide_t::result::inserted, "insert colliding" );
+   }
+   check( col->insert( 64, 0 ) == collide_t::result::full, "full" );
+   for( std::uint32_t k( 0 ); k < 64; k += 2 )
+   {
+      check( col->erase( k ), "erase colliding" );
+   }
+   for( std::uint32_t k( 0 ); k < 64; k++ )
+   {
+      std::uint32_t v( 0 );
+      check( col->find( k, v ) == ( ( k & 1 ) == 1 ) && ( ( k & 1 ) == 0 || v == k + 100 ),
+             "find past erased slots" );
+   }
+   check( col->insert( 64, 0 ) == collide_t::result::full, "erased slots keep their keys" );
+   check( col->insert( 2, 5 ) == collide_t::result::inserted, "reinsert colliding" );
+
+   /**
+    * processes at once: every one inserts the same shared keys and
+    * its own, reads everything it can see, then all erase the
+    * shared keys again
+    */
+   pid_t pids[ workers ];
+   for( std::uint64_t n( 0 ); n < workers; n++ )
+   {
+      pids[ n ] = fork();
+      if( pids[ n ] != 0 )
+      {
+         continue;
+      }
+      const auto base( 1000000 * ( n + 1 ) );
+      for( std::uint64_t i( 0 ); i < own; i++ )
+      {
+         check( map->insert( base + i, value( base + i ) ) == result::inserted, "own key" );
+         if( i < shared && map->insert( i, value( i ) ) == result::inserted )
+         {
+            c->inserted++;
+         }
+         /** a value seen is always a whole one **/
+         std::uint64_t v( 0 );
+         const auto probe( ( i * 7919 ) % shared );
+         check( ! map->find( probe, v ) || v == value( probe ), "shared value" );
+         check( map->find( base + i, v ) && v == value( base + i ), "own value" );
+      }
+      /** every insert is done before anybody erases **/
+      c->arrived++;
+      while( c->arrived.load() != workers )
+      {
+         std::this_thread::yield();
+      }
+      for( std::uint64_t i( 0 ); i < shared; i++ )
+      {
+         if( map->erase( i ) )
+         {
+            c->erased++;
+         }
+      }
+      _exit( EXIT_SUCCESS );
+   }
+   for( const auto pid : pids )
+   {
+      exited( pid );
+   }
+   check( c->inserted == shared, "each shared key inserted once" );
+   check( c->erased == shared, "each shared key erased once" );
+   check( map->size() == workers * own, "size" );
+   for( std::uint64_t n( 0 ); n < workers; n++ )
+   {
+      const auto base( 1000000 * ( n + 1 ) );
+      for( std::uint64_t i( 0 ); i < own; i++ )
+      {
+         check( map->find( base + i, out ) && out == value( base + i ), "everybody's keys" );
+      }
+   }
+   for( std::uint64_t i( 0 ); i < shared; i++ )
+   {
+      check( ! map->contains( i ), "shared keys gone" );
+   }
+
+   shm::close( key, &mem, nbytes, false, true );
+   return( EXIT_SUCCESS );
+}
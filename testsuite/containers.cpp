@@ -0,0 +1,164 @@
+/**
+ * containers.cpp -
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <shm>
+#include <shm_arena.hpp>
+#include <shm_offset_ptr.hpp>
+#include <shm_vector.hpp>
+#include <shm_string.hpp>
+#include <shm_hash_map.hpp>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "check.hpp"
+
+using list_t   = shm::vector< std::uint64_t >;
+using index_t  = shm::hash_map< shm::string, list_t >;
+
+static constexpr std::size_t    nbytes      = 1 << 22;
+static constexpr std::uint64_t  keys        = 2000;
+
+static std::string key_of( const std::uint64_t i )
+{
+   return( "key-" + std::to_string( i ) );
+}
+
+/** every fifth key is erased again, the rest hold i % 7 + 1 items **/
+static void verify( const index_t *index, const std::uint64_t extra )
+{
+   check( index->size() == keys - keys / 5 + extra, "index->size()" );
+   for( std::uint64_t i( 0 ); i < keys; i++ )
+   {
+      const auto *list( index->find( key_of( i ) ) );
+      if( i % 5 == 0 )
+      {
+         check( list == nullptr, "erased key is gone" );
+         continue;
+      }
+      check( list != nullptr, "key is there" );
+      check( list->size() == i % 7 + 1, "list->size()" );
+      for( std::uint64_t j( 0 ); j < list->size(); j++ )
+      {
+         check( ( *list )[ j ] == i * 10 + j, "list contents" );
+      }
+   }
+   std::uint64_t seen( 0 );
+   for( const auto &entry : *index )
+   {
+      check( index->find( entry.first.c_str() ) == &entry.second, "iteration matches find" );
+      seen++;
+   }
+   check( seen == index->size(), "seen == index->size()" );
+}
+
+int
+main( int argc, char **argv )
+{
+   shm_key_t key    = { shm_initial_key };
+   shm::gen_key( key, 105 );
+   void *mem( shm::init( key, nbytes, true, nullptr ) );
+   if( mem == (void*)-1 || mem == nullptr )
+   {
+      std::fprintf( stderr, "Failed to allocate pointer\n" );
+      exit( EXIT_FAILURE );
+   }
+   auto *a( shm::arena::create( mem, nbytes ) );
+
+   /** offset_ptr follows its target through copies **/
+   {
+      auto *values( reinterpret_cast< int* >( a->allocate( 4 * sizeof( int ) ) ) );
+      auto *ptrs( new ( a->allocate( 2 * sizeof( shm::offset_ptr< int > ) ) ) shm::offset_ptr< int >[ 2 ] );
+      check( ! ptrs[ 0 ] && ptrs[ 0 ] == nullptr, "default offset_ptr is null" );
+      ptrs[ 0 ] = values + 2;
+      ptrs[ 1 ] = ptrs[ 0 ];
+      check( ptrs[ 1 ].get() == values + 2, "copy points at the same place" );
+      --ptrs[ 1 ];
+      check( ptrs[ 1 ] - ptrs[ 0 ] == -1, "offset_ptr arithmetic" );
+      ptrs[ 1 ] = nullptr;
+      check( ! ptrs[ 1 ], "assigned null" );
+      a->deallocate( ptrs );
+      a->deallocate( values );
+   }
+
+   /** string edge cases **/
+   {
+      shm::string s( a );
+      check( s.empty() && s == "", "empty string" );
+      s += "abc";
+      s.append( s.c_str(), s.size() );
+      s.append( s.c_str(), s.size() );
+      check( s == "abcabcabcabc", "self append" );
+      check( s != std::string( "abc" ), "s != abc" );
+      shm::string t( std::move( s ) );
+      check( s.empty() && t.size() == 12, "move" );
+      check( std::hash< shm::string >()( t ) == std::hash< shm::string >()( "abcabcabcabc" ),
+             "hash doesn't depend on the type" );
+   }
+
+   auto *index( new ( a->allocate( sizeof( index_t ) ) ) index_t( a ) );
+   a->set_root( index );
+   for( std::uint64_t i( 0 ); i < keys; i++ )
+   {
+      auto result( index->try_emplace( shm::string( a, key_of( i ) ), a ) );
+      check( result.second, "fresh key inserted" );
+      for( std::uint64_t j( 0 ); j <= i % 7; j++ )
+      {
+         check( result.first->push_back( i * 10 + j ), "push_back" );
+      }
+   }
+   check( ! index->try_emplace( shm::string( a, key_of( 1 ) ), a ).second, "duplicate refused" );
+   for( std::uint64_t i( 0 ); i < keys; i += 5 )
+   {
+      check( index->erase( key_of( i ) ), "erase" );
+   }
+   check( ! index->erase( "missing" ), "erase missing" );
+
+   /**
+    * the child maps the segment again at another address and
+    * must see the same index through the arena's root.
+    */
+   if( fork() == 0 )
+   {
+      void *other( shm::open( key ) );
+      check( other != mem, "second mapping is somewhere else" );
+      auto *ca( shm::arena::attach( other ) );
+      auto *cindex( reinterpret_cast< index_t* >( ca->root() ) );
+      check( cindex != nullptr, "root" );
+      check( cindex->get_arena() == ca, "arena follows the mapping" );
+      check( static_cast< void* >( cindex ) != static_cast< void* >( index ), "index moved" );
+      verify( cindex, 0 );
+      cindex->try_emplace( shm::string( ca, "child" ), ca ).first->push_back( 42 );
+      _exit( EXIT_SUCCESS );
+   }
+   check( wait_all( 1 ), "child" );
+
+   verify( index, 1 );
+   const auto *child( index->find( "child" ) );
+   check( child != nullptr && child->size() == 1 && ( *child )[ 0 ] == 42, "child's entry" );
+
+   index->~index_t();
+   shm::close( key, &mem, nbytes, false, true );
+   return( EXIT_SUCCESS );
+}
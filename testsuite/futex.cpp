@@ -0,0 +1,141 @@
+/**
+ * futex.cpp -
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <shm>
+#include <shm_futex.hpp>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "check.hpp"
+
+static constexpr std::uint32_t  producers   = 2;
+static constexpr std::uint32_t  consumers   = 3;
+static constexpr std::uint32_t  per_producer= 10000;
+static constexpr std::uint32_t  round_trips = 2000;
+
+struct shared
+{
+   shm::event                    go;
+   shm::semaphore                items;
+   shm::condition                cond;
+   std::atomic< std::uint32_t >  counter;
+   std::atomic< std::uint32_t >  taken;
+};
+
+static const shm::wait_policy policies[] = { shm::wait_policy( shm::wait_policy::spin ),
+                                             shm::wait_policy( shm::wait_policy::block ),
+                                             shm::wait_policy( shm::wait_policy::adaptive, 256 ) };
+
+int
+main( int argc, char **argv )
+{
+   shm_key_t key    = { shm_initial_key };
+   shm::gen_key( key, 106 );
+   void *mem( shm::init( key, sizeof( shared ), true, nullptr ) );
+   if( mem == (void*)-1 || mem == nullptr )
+   {
+      std::fprintf( stderr, "Failed to allocate pointer\n" );
+      exit( EXIT_FAILURE );
+   }
+   auto *s( new ( mem ) shared() );
+
+   /** one waiter per policy, all released by a single set() **/
+   for( const auto &policy : policies )
+   {
+      if( fork() == 0 )
+      {
+         auto *cs( reinterpret_cast< shared* >( shm::open( key ) ) );
+         cs->go.wait( policy );
+         check( cs->go.is_set(), "cs->go.is_set()" );
+         _exit( EXIT_SUCCESS );
+      }
+   }
+   std::this_thread::sleep_for( std::chrono::milliseconds( 20 ) );
+   s->go.set();
+   check( wait_all( 3 ), "event waiters" );
+
+   /** every post is taken exactly once **/
+   for( std::uint32_t c( 0 ); c < consumers; c++ )
+   {
+      if( fork() == 0 )
+      {
+         auto *cs( reinterpret_cast< shared* >( shm::open( key ) ) );
+         const auto total( producers * per_producer );
+         const auto share( total / consumers + ( c == 0 ? total % consumers : 0 ) );
+         for( std::uint32_t i( 0 ); i < share; i++ )
+         {
+            cs->items.wait( policies[ c % 3 ] );
+            cs->taken++;
+         }
+         _exit( EXIT_SUCCESS );
+      }
+   }
+   for( std::uint32_t p( 0 ); p < producers; p++ )
+   {
+      if( fork() == 0 )
+      {
+         auto *cs( reinterpret_cast< shared* >( shm::open( key ) ) );
+         for( std::uint32_t i( 0 ); i < per_producer; i++ )
+         {
+            cs->items.post();
+         }
+         _exit( EXIT_SUCCESS );
+      }
+   }
+   check( wait_all( producers + consumers ), "semaphore users" );
+   check( s->taken == producers * per_producer, "s->taken == total" );
+   check( s->items.value() == 0 && ! s->items.try_wait(), "semaphore drained" );
+
+   /**
+    * ping-pong on one counter, odd values are the child's turn,
+    * blocking both ways so a lost wake up hangs the test.
+    */
+   s->counter = 0;
+   if( fork() == 0 )
+   {
+      auto *cs( reinterpret_cast< shared* >( shm::open( key ) ) );
+      for( std::uint32_t i( 0 ); i < round_trips; i++ )
+      {
+         cs->cond.wait( [&](){ return( cs->counter.load() == 2 * i + 1 ); }, policies[ i % 3 ] );
+         cs->counter.store( 2 * i + 2 );
+         cs->cond.notify_all();
+      }
+      _exit( EXIT_SUCCESS );
+   }
+   for( std::uint32_t i( 0 ); i < round_trips; i++ )
+   {
+      s->counter.store( 2 * i + 1 );
+      s->cond.notify_one();
+      s->cond.wait( [&](){ return( s->counter.load() == 2 * i + 2 ); },
+                    shm::wait_policy( shm::wait_policy::block ) );
+   }
+   check( wait_all( 1 ), "condition child" );
+   check( s->counter == 2 * round_trips, "s->counter == 2 * round_trips" );
+
+   shm::close( key, &mem, sizeof( shared ), false, true );
+   return( EXIT_SUCCESS );
+}
@@ -0,0 +1,108 @@
+/**
+ * hugepage.cpp -
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdint>
+#include <iostream>
+#include <shm>
+#include <cstring>
+#include <cassert>
+#include <string>
+#include <unistd.h>
+
+int
+main( int argc, char **argv )
+{
+   const auto base_page( static_cast< std::size_t >( sysconf( _SC_PAGESIZE ) ) );
+   const std::size_t nbytes( 3 << 20 );
+   /**
+    * huge pages may or may not be set up on the test machine,
+    * either way we should get back writable memory, backed by
+    * either 2MiB pages or base pages with the THP advice.
+    */
+   for( const auto page : { shm::page_t::huge_2MB, shm::page_t::transparent } )
+   {
+      shm_key_t key;
+      shm::gen_key( key, 42 );
+      std::uint8_t *ptr( nullptr );
+#if (USE_CPP_EXCEPTIONS==1)
+      try
+      {
+         ptr = reinterpret_cast< std::uint8_t* >(
+            shm::init( key, nbytes, true, nullptr, page ) );
+      }
+      catch( bad_shm_alloc ex )
+      {
+         std::cerr << ex.what() << "\n";
+         exit( EXIT_FAILURE );
+      }
+#else
+      ptr = reinterpret_cast< std::uint8_t* >(
+         shm::init( key, nbytes, true, nullptr, page ) );
+      if( ptr == (void*)-1 || ptr == nullptr )
+      {
+         std::fprintf( stderr, "Failed to initialize SHM ptr, exiting!" );
+         exit( EXIT_FAILURE );
+      }
+#endif
+      const auto page_size( shm::get_page_size( ptr ) );
+      std::cout << "page size: " << page_size << "\n";
+      assert( page_size == base_page || page_size == ( 1 << 20 ) * 2 );
+      assert( page != shm::page_t::transparent || page_size == base_page );
+      std::memset( ptr, 0x42, nbytes );
+
+      /** open must find the segment and agree on its page size **/
+      auto *ptr2( shm::eopen< std::uint8_t >( key ) );
+      assert( ptr2 != nullptr );
+      assert( shm::get_page_size( ptr2 ) == page_size );
+      assert( std::memcmp( ptr, ptr2, nbytes ) == 0 );
+
+      shm::close( key,
+                  reinterpret_cast< void** >( &ptr2 ),
+                  nbytes,
+                  false,
+                  false );
+      shm::close( key,
+                  reinterpret_cast< void** >( &ptr ),
+                  nbytes,
+                  false,
+                  true );
+      assert( ptr == nullptr );
+   }
+
+   /**
+    * SystemV opens have no file to ask, the page size comes from
+    * the mapping itself and has to match what init got
+    */
+   for( const auto page : { shm::page_t::huge_2MB, shm::page_t::normal } )
+   {
+      key_t key;
+      shm::gen_key< shm::sysv >( key, 101 );
+      void *ptr( shm::init< shm::sysv >( key, nbytes, false, nullptr, page ) );
+      assert( ptr != nullptr && ptr != (void*)-1 );
+      const auto page_size( shm::get_page_size( ptr ) );
+      std::cout << "SystemV page size: " << page_size << "\n";
+      void *ptr2( shm::open< shm::sysv >( key ) );
+      assert( ptr2 != nullptr && ptr2 != (void*)-1 );
+      assert( shm::get_page_size( ptr2 ) == page_size );
+      assert( page != shm::page_t::normal || page_size == base_page );
+      shm::close< shm::sysv >( key, &ptr2, nbytes, false, false );
+      shm::close< shm::sysv >( key, &ptr, nbytes, false, true );
+   }
+   return( EXIT_SUCCESS );
+}
@@ -0,0 +1,285 @@
+/**
+ * lock.cpp -
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <shm>
+#include <shm_lock.hpp>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "check.hpp"
+
+using status = shm::robust_mutex::status;
+
+static constexpr std::uint64_t workers     = 3;
+static constexpr std::uint64_t per_worker  = 5000;
+
+struct shared
+{
+   shm::robust_mutex             mutex;
+   shm::robust_mutex             doomed;
+   shm::rwlock                   rw;
+   shm::ticket_lock              ticket;
+   std::uint64_t                 counter;
+   std::uint64_t                 a;
+   std::uint64_t                 b;
+   std::atomic< std::uint32_t >  flag;
+};
+
+static const shm::wait_policy policies[] = { shm::wait_policy( shm::wait_policy::spin ),
+                                             shm::wait_policy( shm::wait_policy::block ),
+                                             shm::wait_policy( shm::wait_policy::adaptive, 256 ) };
+
+/** contended - every wait landed in a histogram bucket **/
+static bool consistent_stats( const shm::lock_stats &stats, const std::uint64_t acquired )
+{
+   std::uint64_t waits( 0 );
+   for( std::size_t i( 0 ); i < shm::lock_stats::buckets; i++ )
+   {
+      waits += stats.waits( i );
+   }
+   return( stats.acquired() == acquired &&
+           stats.contended() <= acquired &&
+           waits == stats.contended() );
+}
+
+/** hammer - workers processes bump counter under lock **/
+template < class Lock, class Unlock >
+static void hammer( shared *s, Lock &&lock, Unlock &&unlock )
+{
+   s->counter = 0;
+   pid_t pids[ workers ];
+   for( std::uint64_t n( 0 ); n < workers; n++ )
+   {
+      pids[ n ] = fork();
+      if( pids[ n ] != 0 )
+      {
+         continue;
+      }
+      for( std::uint64_t i( 0 ); i < per_worker; i++ )
+      {
+         check( lock( policies[ n ] ) == status::ok, "lock" );
+         /** not atomic, two holders at once lose increments **/
+         const auto seen( s->counter );
+         if( ( i & 0x3f ) == 0 )
+         {
+            std::this_thread::yield();
+         }
+         s->counter = seen + 1;
+         unlock();
+      }
+      _exit( EXIT_SUCCESS );
+   }
+   for( const auto pid : pids )
+   {
+      exited( pid );
+   }
+   check( s->counter == workers * per_worker, "mutual exclusion" );
+}
+
+/** dies_holding - forks a process that takes the lock and exits **/
+template < class Lock >
+static void dies_holding( Lock &&lock )
+{
+   auto child( fork() );
+   if( child == 0 )
+   {
+      check( lock() == status::ok, "lock" );
+      _exit( EXIT_SUCCESS );
+   }
+   exited( child );
+}
+
+int
+main( int argc, char **argv )
+{
+   shm_key_t key;
+   shm::gen_key( key, 24 );
+   void *mem( shm::init( key, sizeof( shared ), false, nullptr ) );
+   auto *s( new ( mem ) shared() );
+
+   /** robust_mutex **/
+   hammer( s,
+           [&]( const shm::wait_policy &p ){ return( s->mutex.lock( p ) ); },
+           [&](){ s->mutex.unlock(); } );
+   check( consistent_stats( s->mutex.stats(), workers * per_worker ), "mutex stats" );
+   check( s->mutex.try_lock() == status::ok && s->mutex.owner() != 0, "try_lock" );
+   auto child( fork() );
+   if( child == 0 )
+   {
+      check( s->mutex.try_lock() == status::busy, "held elsewhere" );
+      _exit( EXIT_SUCCESS );
+   }
+   exited( child );
+   s->mutex.unlock();
+   check( s->mutex.owner() == 0, "unlocked" );
+
+   /** holder dies, the next one repairs **/
+   dies_holding( [&](){ return( s->mutex.lock() ); } );
+   check( s->mutex.lock() == status::owner_died, "owner died" );
+   s->mutex.consistent();
+   s->mutex.unlock();
+   check( s->mutex.lock() == status::ok, "repaired" );
+   s->mutex.unlock();
+   check( s->mutex.stats().owner_deaths() == 1, "death counted" );
+
+   /** ...or doesn't, and nobody can have it again **/
+   dies_holding( [&](){ return( s->doomed.lock() ); } );
+   check( s->doomed.lock() == status::owner_died, "owner died" );
+   s->doomed.unlock();
+   check( s->doomed.lock() == status::not_recoverable, "not recoverable" );
+   check( s->doomed.try_lock() == status::not_recoverable, "not recoverable" );
+
+   /** a waiter asleep when the holder dies wakes up to take it over **/
+   s->flag = 0;
+   const auto holder( fork() );
+   if( holder == 0 )
+   {
+      check( s->mutex.lock() == status::ok, "lock" );
+      s->flag = 1;
+      std::this_thread::sleep_for( std::chrono::milliseconds( 50 ) );
+      _exit( EXIT_SUCCESS );
+   }
+   const auto waiter( fork() );
+   if( waiter == 0 )
+   {
+      while( s->flag.load() == 0 )
+      {
+         std::this_thread::yield();
+      }
+      check( s->mutex.lock( shm::wait_policy( shm::wait_policy::block ) ) == status::owner_died,
+             "blocked waiter takes over" );
+      s->mutex.consistent();
+      s->mutex.unlock();
+      _exit( EXIT_SUCCESS );
+   }
+   exited( holder );
+   exited( waiter );
+   check( s->mutex.lock() == status::ok, "repaired" );
+   s->mutex.unlock();
+
+   /** ticket_lock **/
+   hammer( s,
+           [&]( const shm::wait_policy &p ){ return( s->ticket.lock( p ) ); },
+           [&](){ s->ticket.unlock(); } );
+   check( consistent_stats( s->ticket.stats(), workers * per_worker ), "ticket stats" );
+   check( s->ticket.queued() == 0, "nobody queued" );
+   check( s->ticket.try_lock() == status::ok, "try_lock" );
+   check( s->ticket.try_lock() == status::busy, "busy" );
+   s->ticket.unlock();
+   dies_holding( [&](){ return( s->ticket.lock() ); } );
+   check( s->ticket.lock() == status::owner_died, "owner died" );
+   s->ticket.unlock();
+   check( s->ticket.lock() == status::ok, "next holder is fine" );
+   s->ticket.unlock();
+
+   /** rwlock, writers keep a == b, readers check it **/
+   s->a = 0;
+   s->b = 0;
+   pid_t pids[ 4 ];
+   for( std::uint64_t n( 0 ); n < 4; n++ )
+   {
+      pids[ n ] = fork();
+      if( pids[ n ] != 0 )
+      {
+         continue;
+      }
+      for( std::uint64_t i( 0 ); i < per_worker; i++ )
+      {
+         if( n < 2 )
+         {
+            check( s->rw.write_lock( policies[ i % 3 ] ) == status::ok, "write_lock" );
+            s->a++;
+            if( ( i & 0x3f ) == 0 )
+            {
+               std::this_thread::yield();
+            }
+            s->b++;
+            s->rw.write_unlock();
+         }
+         else
+         {
+            check( s->rw.read_lock( policies[ i % 3 ] ) == status::ok, "read_lock" );
+            check( s->a == s->b, "no torn writes" );
+            s->rw.read_unlock();
+         }
+      }
+      _exit( EXIT_SUCCESS );
+   }
+   for( const auto pid : pids )
+   {
+      exited( pid );
+   }
+   check( s->a == 2 * per_worker && s->b == 2 * per_worker, "writers excluded each other" );
+   check( consistent_stats( s->rw.write_stats(), 2 * per_worker ), "write stats" );
+   check( consistent_stats( s->rw.read_stats(), 2 * per_worker ), "read stats" );
+
+   /** readers share, writers wait for them **/
+   s->flag = 0;
+   child = fork();
+   if( child == 0 )
+   {
+      check( s->rw.read_lock() == status::ok, "read_lock" );
+      s->flag = 1;
+      while( s->flag.load() != 2 )
+      {
+         std::this_thread::yield();
+      }
+      s->rw.read_unlock();
+      _exit( EXIT_SUCCESS );
+   }
+   while( s->flag.load() != 1 )
+   {
+      std::this_thread::yield();
+   }
+   check( s->rw.try_read_lock() == status::ok && s->rw.readers() == 2, "two readers" );
+   check( s->rw.try_write_lock() == status::busy, "writer waits for readers" );
+   s->rw.read_unlock();
+   s->flag = 2;
+   check( s->rw.write_lock() == status::ok, "in once the reader left" );
+   check( s->rw.try_read_lock() == status::busy, "readers wait for a writer that's in" );
+   s->rw.write_unlock();
+   exited( child );
+
+   /** a reader that died doesn't keep writers out **/
+   dies_holding( [&](){ return( s->rw.read_lock() ); } );
+   check( s->rw.readers() == 1, "dead reader's slot" );
+   check( s->rw.write_lock() == status::ok, "dead reader cleared" );
+   s->rw.write_unlock();
+   check( s->rw.readers() == 0 && s->rw.read_stats().owner_deaths() == 1, "reader death counted" );
+
+   /** a writer that died is reported until the next writer is done **/
+   dies_holding( [&](){ return( s->rw.write_lock() ); } );
+   check( s->rw.read_lock() == status::owner_died, "reader sees the dead writer" );
+   s->rw.read_unlock();
+   check( s->rw.write_lock() == status::owner_died, "writer sees the dead writer" );
+   s->rw.write_unlock();
+   check( s->rw.read_lock() == status::ok, "repaired" );
+   s->rw.read_unlock();
+
+   shm::close( key, &mem, sizeof( shared ), false, true );
+   return( EXIT_SUCCESS );
+}
@@ -0,0 +1,145 @@
+/**
+ * mapping_cache.cpp -
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include <shm>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "check.hpp"
+
+static const std::size_t page_size( sysconf( _SC_PAGESIZE ) );
+
+/** mapped - true while something is mapped at ptr **/
+static bool mapped( void *ptr )
+{
+   return( msync( ptr, page_size, MS_ASYNC ) == 0 );
+}
+
+template < class Backend >
+static void
+cached()
+{
+   typename Backend::key_type key;
+   shm::gen_key< Backend >( key, 117 );
+   void *owner( shm::init< Backend >( key, page_size ) );
+   check( owner != nullptr && owner != (void*)-1, "shm::init" );
+
+   void *first( shm::open< Backend >( key ) );
+   void *second( shm::open< Backend >( key ) );
+   check( first != nullptr && first == second, "one mapping per key" );
+   check( first != owner, "init isn't cached" );
+   *reinterpret_cast< std::uint32_t* >( owner ) = 0x1137;
+
+   /** every thread gets the same mapping, none of them unmaps it **/
+   std::atomic< bool > same( true );
+   std::vector< std::thread > threads;
+   for( int i( 0 ); i < 4; i++ )
+   {
+      threads.emplace_back( [ & ]()
+      {
+         for( int j( 0 ); j < 1000; j++ )
+         {
+            void *ptr( shm::open< Backend >( key ) );
+            if( ptr != first || *reinterpret_cast< std::uint32_t* >( ptr ) != 0x1137 )
+            {
+               same = false;
+            }
+            shm::close< Backend >( key, &ptr, page_size, false, false );
+         }
+      } );
+   }
+   for( auto &thread : threads )
+   {
+      thread.join();
+   }
+   check( same, "threads share the mapping" );
+
+   shm::close< Backend >( key, &second, page_size, false, false );
+   check( second == nullptr && mapped( first ), "still referenced" );
+   void *gone( first );
+   shm::close< Backend >( key, &first, page_size, false, false );
+   check( ! mapped( gone ) && mapped( owner ), "last close unmaps" );
+
+   /** last close unmapped it, the next open maps again **/
+   void *again( shm::open< Backend >( key ) );
+   check( again != nullptr && *reinterpret_cast< std::uint32_t* >( again ) == 0x1137, "reopened" );
+
+   /** unlinking takes the key out of the cache, the mapping drains **/
+   void *held( shm::open< Backend >( key ) );
+   check( held == again, "cached again" );
+   shm::close< Backend >( key, &owner, page_size, false, false );
+   shm::close< Backend >( key, &again, page_size, false, true );
+   check( mapped( held ) && *reinterpret_cast< std::uint32_t* >( held ) == 0x1137,
+          "unlinked, still mapped" );
+
+   /** a new segment under the same name isn't the old mapping **/
+   void *fresh( shm::init< Backend >( key, page_size ) );
+   check( fresh != nullptr, "reused key" );
+   void *view( shm::open< Backend >( key ) );
+   check( view != held && *reinterpret_cast< std::uint32_t* >( view ) == 0, "new segment" );
+   gone = held;
+   shm::close< Backend >( key, &held, page_size, false, false );
+   check( ! mapped( gone ) && mapped( view ), "orphan unmapped on its last close" );
+
+   /** unlinking by name alone, with no mapping to hand, drops it as well **/
+   void *named( shm::open< Backend >( key ) );
+   check( named == view, "cached" );
+   shm::close< Backend >( key, nullptr, page_size, false, true );
+   void *renewed( shm::init< Backend >( key, page_size ) );
+   check( renewed != nullptr && renewed != (void*)-1, "reused key" );
+   *reinterpret_cast< std::uint32_t* >( renewed ) = 0x2248;
+   void *seen( shm::open< Backend >( key ) );
+   check( seen != view && *reinterpret_cast< std::uint32_t* >( seen ) == 0x2248,
+          "unlinked without a pointer, new segment" );
+   shm::close< Backend >( key, &seen, page_size, false, false );
+   shm::close< Backend >( key, &named, page_size, false, false );
+   check( mapped( view ), "orphan still referenced" );
+   shm::close< Backend >( key, &view, page_size, false, false );
+   shm::close< Backend >( key, &fresh, page_size, false, false );
+   shm::close< Backend >( key, &renewed, page_size, false, true );
+}
+
+int
+main( int argc, char **argv )
+{
+   shm_key_t key;
+   shm::gen_key( key, 217 );
+   void *owner( shm::init( key, page_size ) );
+   check( owner != nullptr, "shm::init" );
+   /** off by default, every open maps **/
+   void *a( shm::open( key ) );
+   void *b( shm::open( key ) );
+   check( a != nullptr && a != b, "not cached by default" );
+   shm::close( key, &a, page_size, false, false );
+   shm::close( key, &b, page_size, false, false );
+   shm::close( key, &owner, page_size, false, true );
+
+   shm::cache_mappings( true );
+   cached< shm::posix >();
+   cached< shm::sysv >();
+   shm::cache_mappings( false );
+   return( EXIT_SUCCESS );
+}
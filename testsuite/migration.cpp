@@ -0,0 +1,108 @@
+/**
+ * migration.cpp -
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <shm>
+#include <shm_migration.hpp>
+#include <unistd.h>
+#if __linux && ( PLATFORM_HAS_NUMA == 1 )
+#include <numa.h>
+#endif
+
+#include "check.hpp"
+
+static constexpr std::size_t nbytes = 8 << 20;
+
+int
+main( int argc, char **argv )
+{
+#if __linux && ( PLATFORM_HAS_NUMA == 1 )
+   if( numa_available() == -1 )
+   {
+      std::fprintf( stderr, "NUMA not available, skipping\n" );
+      return( EXIT_SUCCESS );
+   }
+   const auto pages( nbytes / sysconf( _SC_PAGESIZE ) );
+   /** the highest node we may use, the other end from where we probably run **/
+   int target( 0 );
+   for( int node( 0 ); node <= numa_max_node(); node++ )
+   {
+      if( numa_bitmask_isbitset( numa_all_nodes_ptr, node ) )
+      {
+         target = node;
+      }
+   }
+   shm_key_t key = { shm_initial_key };
+   shm::gen_key( key, 110 );
+   void *ptr( shm::init( key, nbytes, false ) );
+   check( ptr != nullptr && ptr != (void*)-1, "shm::init" );
+   /** only the first half exists, the rest is never touched **/
+   std::memset( ptr, 0x1, nbytes / 2 );
+
+   {
+      /** small chunks so that the background thread takes a few steps **/
+      shm::migration migration( ptr, nbytes, target, 64 );
+      check( ! migration.done() && migration.progress() == 0.0, "nothing before start" );
+      migration.start();
+      double last( 0.0 );
+      while( ! migration.done() )
+      {
+         const auto now( migration.progress() );
+         check( now >= last && now <= 1.0, "progress only moves forward" );
+         last = now;
+      }
+      const auto &result( migration.wait() );
+      check( migration.progress() == 1.0 && migration.bytes_done() == nbytes, "all of it" );
+      check( result.error == 0 && ! result.cancelled && result.skipped == 0, "finished" );
+      check( result.not_present == pages / 2, "untouched pages aren't moved" );
+      check( result.moved() + result.already_there + result.failed == pages / 2, "every page counted" );
+      check( result.failed == 0, "nothing failed" );
+      const auto placement( shm::get_numa_placement( ptr, nbytes ) );
+      check( placement[ target ] == pages / 2, "resident pages are on the target" );
+   }
+
+   {
+      /** cancelled before it starts, nothing is looked at **/
+      shm::migration migration( ptr, nbytes, target, 1 );
+      migration.cancel();
+      check( migration.start(), "start" );
+      /** a migration goes once, the second start and a run back off **/
+      check( ! migration.start() && ! migration.run(), "only once" );
+      const auto &result( migration.wait() );
+      check( result.cancelled && result.skipped == pages, "cancelled" );
+      check( migration.done(), "done after cancel" );
+   }
+
+   {
+      /** not a node **/
+      shm::migration migration( ptr, nbytes, numa_max_node() + 1 );
+      migration.run();
+      check( migration.wait().error == EINVAL, "invalid node" );
+   }
+
+   /** already where it belongs **/
+   check( shm::move_to_tid_numa( 0, ptr, nbytes ) || numa_num_configured_nodes() > 1,
+          "shm::move_to_tid_numa" );
+   shm::close( key, &ptr, nbytes, false, true );
+#endif
+   return( EXIT_SUCCESS );
+}
@@ -0,0 +1,130 @@
+/**
+ * mirrored.cpp -
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <shm>
+#include <shm_segment.hpp>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "check.hpp"
+
+static const std::size_t page_size( sysconf( _SC_PAGESIZE ) );
+
+/** faults - true if a child touching addr dies of SIGSEGV **/
+static bool faults( volatile char *addr )
+{
+   const pid_t child( fork() );
+   if( child == 0 )
+   {
+      *addr = 1;
+      _exit( EXIT_SUCCESS );
+   }
+   int status( 0 );
+   waitpid( child, &status, 0 );
+   return( WIFSIGNALED( status ) && WTERMSIG( status ) == SIGSEGV );
+}
+
+template < class Backend >
+static void
+mirrored()
+{
+   typename Backend::key_type key;
+   shm::gen_key< Backend >( key, 19 );
+   shm::segment seg( shm::segment::create_mirrored< Backend >( key, 3 * page_size + 1, 100 ) );
+   check( static_cast< bool >( seg ), "create_mirrored" );
+   check( seg.ring_size() == 4 * page_size, "ring in whole pages" );
+   check( seg.size() == page_size + 8 * page_size, "header and two copies" );
+   auto *ring( reinterpret_cast< char* >( seg.ring() ) );
+   check( ring == seg.as< char >() + page_size, "ring after the header" );
+
+   /** the second copy is the first one **/
+   for( std::size_t i( 0 ); i < seg.ring_size(); i += 511 )
+   {
+      ring[ i ] = static_cast< char >( i );
+      check( ring[ i + seg.ring_size() ] == static_cast< char >( i ), "aliased" );
+   }
+   /** a record across the wrap is one span **/
+   const char record[] = "a record that crosses the end of the ring";
+   std::memcpy( ring + seg.ring_size() - 10, record, sizeof( record ) );
+   check( std::memcmp( ring, record + 10, sizeof( record ) - 10 ) == 0, "wrapped to the start" );
+   check( faults( ring + 2 * seg.ring_size() ), "guard after the second copy" );
+
+   /** another mapping sees the same ring, header included **/
+   std::memcpy( seg.get(), "header", 7 );
+   {
+      shm::segment view( shm::segment::open_mirrored< Backend >( key, 100 ) );
+      check( static_cast< bool >( view ), "open_mirrored" );
+      check( view.ring_size() == seg.ring_size(), "same ring size" );
+      check( std::strcmp( view.as< char >(), "header" ) == 0, "same header" );
+      auto *other( reinterpret_cast< char* >( view.ring() ) );
+      check( std::memcmp( other + seg.ring_size() - 10, record, sizeof( record ) ) == 0, "same ring" );
+      other[ 2 * seg.ring_size() - 1 ] = 'z';
+      check( ring[ seg.ring_size() - 1 ] == 'z', "written through the other mapping" );
+   }
+
+   check( ! seg.resize( 16 * page_size ) && errno == ENOTSUP, "can't resize" );
+   check( ! seg.remap( 16 * page_size ) && errno == ENOTSUP, "can't remap" );
+   check( shm::get_mapped_size( seg.get() ) == seg.size(), "registered" );
+   seg.close( shm::release_t::none, true );
+
+   /** placement, a free range that is page aligned **/
+   const auto span( 8 * page_size );
+   void *hint( mmap( nullptr, span, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 ) );
+   check( hint != MAP_FAILED, "find a free range" );
+   munmap( hint, span );
+   shm::gen_key< Backend >( key, 19 );
+   shm::segment placed( shm::segment::create_mirrored< Backend >( key, 2 * page_size, 0,
+                                                                  shm::page_t::normal, hint ) );
+   check( placed.get() == hint && placed.ring() == hint, "placed at ptr" );
+}
+
+int
+main( int argc, char **argv )
+{
+   mirrored< shm::posix >();
+#if __linux
+   mirrored< shm::memfd >();
+#endif
+
+   /** SystemV can't map part of a segment **/
+   shm::sysv::key_type key;
+   shm::gen_key< shm::sysv >( key, 19 );
+#if USE_CPP_EXCEPTIONS==1
+   try
+   {
+      shm::segment::create_mirrored< shm::sysv >( key, page_size );
+      check( false, "sysv mirrored" );
+   }
+   catch( bad_shm_alloc &ex )
+   {
+      check( errno == ENOTSUP, "sysv is ENOTSUP" );
+   }
+#else
+   auto seg( shm::segment::create_mirrored< shm::sysv >( key, page_size ) );
+   check( ! seg && errno == ENOTSUP, "sysv is ENOTSUP" );
+#endif
+   return( EXIT_SUCCESS );
+}
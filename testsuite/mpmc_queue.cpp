@@ -0,0 +1,218 @@
+/**
+ * mpmc_queue.cpp -
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <shm>
+#include <shm_mpmc_queue.hpp>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "check.hpp"
+
+using queue_t = shm::mpmc_queue< std::uint64_t >;
+
+static constexpr std::uint64_t  producers      = 3;
+static constexpr std::uint64_t  consumers      = 3;
+static constexpr std::uint64_t  per_producer   = 20000;
+static constexpr std::size_t    capacity       = 64;
+
+/** lives after the queue in the same segment **/
+struct totals
+{
+   std::atomic< std::uint64_t > count;
+   std::atomic< std::uint64_t > sum;
+   std::atomic< std::uint64_t > errors;
+};
+
+/** pops until it succeeds or gives up after a lot of tries **/
+static bool pop_eventually( queue_t *q, std::uint64_t &item )
+{
+   for( auto tries( 0 ); tries < 10000000; tries++ )
+   {
+      if( q->try_pop( item ) )
+      {
+         return( true );
+      }
+   }
+   return( false );
+}
+
+static bool push_eventually( queue_t *q, const std::uint64_t item )
+{
+   for( auto tries( 0 ); tries < 10000000; tries++ )
+   {
+      if( q->try_push( item ) )
+      {
+         return( true );
+      }
+   }
+   return( false );
+}
+
+int
+main( int argc, char **argv )
+{
+   shm_key_t key    = { shm_initial_key };
+   shm::gen_key( key, 103 );
+   const auto queue_bytes( ( queue_t::required_bytes( capacity ) + 63 ) & ~std::size_t( 63 ) );
+   const auto nbytes( queue_bytes + sizeof( totals ) );
+   void *mem( shm::init( key, nbytes, true, nullptr ) );
+   if( mem == (void*)-1 || mem == nullptr )
+   {
+      std::fprintf( stderr, "Failed to allocate pointer\n" );
+      exit( EXIT_FAILURE );
+   }
+   auto *q( queue_t::create( mem, capacity ) );
+   auto *t( new ( reinterpret_cast< char* >( mem ) + queue_bytes ) totals() );
+   t->count = 0; t->sum = 0; t->errors = 0;
+
+   /** many producers to many consumers, item = producer << 32 | seq **/
+   for( std::uint64_t p( 0 ); p < producers; p++ )
+   {
+      if( fork() == 0 )
+      {
+         auto *cq( queue_t::attach( shm::open( key ) ) );
+         for( std::uint64_t i( 0 ); i < per_producer; i++ )
+         {
+            cq->push( ( p << 32 ) | i );
+         }
+         _exit( EXIT_SUCCESS );
+      }
+   }
+   const auto total( producers * per_producer );
+   for( std::uint64_t c( 0 ); c < consumers; c++ )
+   {
+      if( fork() == 0 )
+      {
+         auto *cq( queue_t::attach( shm::open( key ) ) );
+         /** each consumer sees each producer's items in order **/
+         std::int64_t last[ producers ] = { -1, -1, -1 };
+         while( t->count.load() < total )
+         {
+            std::uint64_t item( 0 );
+            if( ! cq->try_pop( item ) )
+            {
+               std::this_thread::yield();
+               continue;
+            }
+            const auto p( item >> 32 );
+            const auto i( static_cast< std::int64_t >( item & 0xffffffff ) );
+            if( p >= producers || i <= last[ p ] )
+            {
+               t->errors++;
+            }
+            last[ p ] = i;
+            t->sum += item;
+            t->count++;
+         }
+         _exit( EXIT_SUCCESS );
+      }
+   }
+   check( wait_all( producers + consumers ), "wait_all( producers + consumers )" );
+   std::uint64_t expected_sum( 0 );
+   for( std::uint64_t p( 0 ); p < producers; p++ )
+   {
+      for( std::uint64_t i( 0 ); i < per_producer; i++ )
+      {
+         expected_sum += ( p << 32 ) | i;
+      }
+   }
+   check( t->errors == 0, "t->errors == 0" );
+   check( t->count == total, "t->count == total" );
+   check( t->sum == expected_sum, "t->sum == expected_sum" );
+   check( q->size() == 0, "q->size() == 0" );
+
+   /** producer dies between claiming a slot and publishing it **/
+   if( fork() == 0 )
+   {
+      std::uint64_t ticket( 0 );
+      check( q->begin_push( ticket ) != nullptr, "q->begin_push( ticket ) != nullptr" );
+      _exit( EXIT_SUCCESS );
+   }
+   check( wait_all( 1 ), "wait_all( 1 )" );
+   for( std::uint64_t i( 0 ); i < 5; i++ )
+   {
+      check( q->try_push( i ), "q->try_push( i )" );
+   }
+   for( std::uint64_t i( 0 ); i < 5; i++ )
+   {
+      std::uint64_t item( ~0ULL );
+      check( pop_eventually( q, item ), "pop_eventually( q, item )" );
+      check( item == i, "item == i" );
+   }
+
+   /** consumer dies between claiming an item and releasing the slot **/
+   for( std::uint64_t i( 0 ); i < q->capacity(); i++ )
+   {
+      check( q->try_push( i ), "q->try_push( i )" );
+   }
+   if( fork() == 0 )
+   {
+      std::uint64_t ticket( 0 );
+      check( q->begin_pop( ticket ) != nullptr, "q->begin_pop( ticket ) != nullptr" );
+      _exit( EXIT_SUCCESS );
+   }
+   check( wait_all( 1 ), "wait_all( 1 )" );
+   for( std::uint64_t i( 1 ); i < q->capacity(); i++ )
+   {
+      std::uint64_t item( ~0ULL );
+      check( q->try_pop( item ), "q->try_pop( item )" );
+      check( item == i, "item == i" );
+   }
+   /** the dead consumer's slot comes back to the producers **/
+   for( std::uint64_t i( 0 ); i < q->capacity(); i++ )
+   {
+      check( push_eventually( q, i ), "push_eventually( q, i )" );
+   }
+   for( std::uint64_t i( 0 ); i < q->capacity(); i++ )
+   {
+      std::uint64_t item( ~0ULL );
+      check( pop_eventually( q, item ), "pop_eventually( q, item )" );
+      check( item == i, "item == i" );
+   }
+
+   /** a dead producer's slot is reached by the next lap's producer first **/
+   if( fork() == 0 )
+   {
+      std::uint64_t ticket( 0 );
+      check( q->begin_push( ticket ) != nullptr, "q->begin_push( ticket ) != nullptr" );
+      _exit( EXIT_SUCCESS );
+   }
+   check( wait_all( 1 ), "wait_all( 1 )" );
+   for( std::uint64_t i( 1 ); i < q->capacity(); i++ )
+   {
+      check( q->try_push( i ), "q->try_push( i )" );
+   }
+   check( push_eventually( q, q->capacity() ), "push_eventually( q, q->capacity() )" );
+   for( std::uint64_t i( 1 ); i <= q->capacity(); i++ )
+   {
+      std::uint64_t item( ~0ULL );
+      check( pop_eventually( q, item ), "pop_eventually( q, item )" );
+      check( item == i, "item == i" );
+   }
+
+   shm::close( key, &mem, nbytes, false, true );
+   return( EXIT_SUCCESS );
+}
@@ -0,0 +1,124 @@
+/**
+ * numa_policy.cpp -
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <vector>
+#include <shm>
+#include <unistd.h>
+#if __linux && ( PLATFORM_HAS_NUMA == 1 )
+#include <numaif.h>
+#include <numa.h>
+#endif
+
+#include "check.hpp"
+
+static constexpr std::size_t nbytes = 1 << 20;
+
+/**
+ * place - makes a populated segment with policy, checks that the
+ * kernel kept the policy and returns how many pages landed on
+ * each node.
+ */
+static std::vector< std::size_t > place( const shm::numa_policy &policy, const int expected_mode )
+{
+   shm_key_t key = { shm_initial_key };
+   shm::gen_key( key, 109 );
+   void *ptr( shm::init( key, nbytes, true, nullptr, shm::page_t::normal, policy,
+                         shm::populate_t::populate_write ) );
+   check( ptr != nullptr && ptr != (void*)-1, "shm::init with a NUMA policy" );
+#if __linux && ( PLATFORM_HAS_NUMA == 1 )
+   int mode( -1 );
+   check( get_mempolicy( &mode, nullptr, 0, ptr, MPOL_F_ADDR ) == 0, "get_mempolicy" );
+   check( mode == expected_mode, "policy on the mapping" );
+#else
+   (void) expected_mode;
+#endif
+   auto placement( shm::get_numa_placement( ptr, nbytes ) );
+   shm::close( key, &ptr, nbytes, false, true );
+   return( placement );
+}
+
+int
+main( int argc, char **argv )
+{
+#if __linux && ( PLATFORM_HAS_NUMA == 1 )
+   if( numa_available() == -1 )
+   {
+      std::fprintf( stderr, "NUMA not available, skipping\n" );
+      return( EXIT_SUCCESS );
+   }
+   const auto pages( nbytes / sysconf( _SC_PAGESIZE ) );
+   const auto last( numa_max_node() );
+   std::vector< int > allowed;
+   for( int node( 0 ); node <= last; node++ )
+   {
+      if( numa_bitmask_isbitset( numa_all_nodes_ptr, node ) )
+      {
+         allowed.push_back( node );
+      }
+   }
+   const auto target( allowed.back() );
+
+   /** zeroing touched every page, all of them on the bound node **/
+   auto placement( place( shm::numa_policy( shm::numa_policy::bind, { target } ), MPOL_BIND ) );
+   check( placement.size() == static_cast< std::size_t >( last + 1 ), "one count per node" );
+   check( placement[ target ] == pages, "bind" );
+
+   placement = place( shm::numa_policy( shm::numa_policy::preferred, { target } ), MPOL_PREFERRED );
+   check( std::accumulate( placement.begin(), placement.end(), std::size_t( 0 ) ) == pages,
+          "preferred, every page resident" );
+
+   /** round robin, every allowed node gets its share **/
+   placement = place( shm::numa_policy( shm::numa_policy::interleave ), MPOL_INTERLEAVE );
+   for( const auto node : allowed )
+   {
+      check( placement[ node ] + 1 >= pages / allowed.size(), "interleave" );
+   }
+
+   /** not a node, there is no segment afterwards **/
+   shm_key_t key = { shm_initial_key };
+   shm::gen_key( key, 109 );
+   void *ptr( nullptr );
+#if USE_CPP_EXCEPTIONS==1
+   try
+   {
+      ptr = shm::init( key, nbytes, true, nullptr, shm::page_t::normal,
+                       shm::numa_policy( shm::numa_policy::bind, { last + 1 } ) );
+   }
+   catch( bad_shm_alloc &ex )
+   {
+      ptr = nullptr;
+   }
+#else
+   ptr = shm::init( key, nbytes, true, nullptr, shm::page_t::normal,
+                    shm::numa_policy( shm::numa_policy::bind, { last + 1 } ) );
+#endif
+   check( ptr == nullptr, "invalid node is an error" );
+   ptr = shm::init( key, nbytes );
+   check( ptr != nullptr && ptr != (void*)-1, "key is still free" );
+   shm::close( key, &ptr, nbytes, false, true );
+#else
+   /** no NUMA, node 0 is all there is **/
+   place( shm::numa_policy( shm::numa_policy::bind, { 0 } ), 0 );
+#endif
+   return( EXIT_SUCCESS );
+}
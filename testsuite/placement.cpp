@@ -0,0 +1,93 @@
+/**
+ * placement.cpp -
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <shm>
+#include <shm_placement.hpp>
+#include <unistd.h>
+
+#include "check.hpp"
+
+int
+main( int argc, char **argv )
+{
+   /**
+    * four nodes, 0 and 3 are neighbors and 1, 2 are far from
+    * both, a thread allowed on 0 and 3 must never get node 1
+    * (the average of the node ids).
+    */
+   shm::placement::matrix costs;
+   costs.nodes      = 4;
+   costs.distance   = { 10, 30, 30, 20,
+                        30, 10, 20, 30,
+                        30, 20, 10, 30,
+                        20, 30, 30, 10 };
+   costs.has_memory = { true, true, true, true };
+   const auto even( shm::placement::best_node( { 1, 0, 0, 1 }, costs ) );
+   check( even == 0 || even == 3, "node the thread runs on" );
+   check( shm::placement::best_node( { 1, 0, 0, 3 }, costs ) == 3, "weighted toward node 3" );
+   costs.has_memory[ 3 ] = false;
+   check( shm::placement::best_node( { 1, 0, 0, 3 }, costs ) == 0, "node 3 has no memory" );
+   check( std::isinf( costs.cost( 0, 3 ) ), "no memory, no access" );
+   costs.has_memory[ 3 ] = true;
+
+   /** measurements win over the distances, node 3's memory is faster here **/
+   costs.latency_ns.assign( 16, 100.0 );
+   costs.bandwidth_mbs.assign( 16, 10000.0 );
+   costs.latency_ns[ 0 * 4 + 3 ]    = 90.0;
+   costs.latency_ns[ 3 * 4 + 3 ]    = 80.0;
+   costs.best_latency_ns            = 80.0;
+   costs.best_bandwidth_mbs         = 10000.0;
+   check( shm::placement::best_node( { 1, 0, 0, 1 }, costs ) == 3, "measured costs" );
+   check( std::fabs( costs.cost( 3, 3 ) - 10.0 ) < 1e-9, "best pair costs 10" );
+
+   /** this machine **/
+   const auto local( shm::placement::costs() );
+   check( local.nodes >= 1 && local.distance.size() == local.nodes * local.nodes, "matrix" );
+   check( local.latency_ns.empty(), "distances until measured" );
+   const auto weights( shm::placement::thread_weights( 0 ) );
+   check( std::accumulate( weights.begin(), weights.end(), 0.0 ) >= 1.0, "at least one cpu" );
+   const auto node( shm::placement::best_node( weights ) );
+   check( node >= 0 && static_cast< std::size_t >( node ) < local.nodes && local.has_memory[ node ],
+          "a node with memory" );
+   check( local.cost( node, node ) == 10.0, "local distance is 10" );
+
+   const auto measured( shm::placement::measure( 8 << 20 ) );
+   check( shm::placement::costs().latency_ns.size() == measured.latency_ns.size(), "cached" );
+#if __linux && ( PLATFORM_HAS_NUMA == 1 )
+   if( ! measured.latency_ns.empty() )
+   {
+      const auto self( static_cast< std::size_t >( node ) * measured.nodes + node );
+      check( measured.latency_ns[ self ] > 0.0 && measured.bandwidth_mbs[ self ] > 0.0,
+             "local pair measured" );
+      check( measured.best_latency_ns > 0.0 &&
+             measured.best_latency_ns <= measured.latency_ns[ self ] &&
+             measured.best_bandwidth_mbs >= measured.bandwidth_mbs[ self ], "best pair kept" );
+      std::fprintf( stderr, "node %d: %.1f ns, %.0f MiB/s\n",
+                    node,
+                    measured.latency_ns[ self ],
+                    measured.bandwidth_mbs[ self ] );
+   }
+#endif
+   return( EXIT_SUCCESS );
+}
@@ -0,0 +1,212 @@
+/**
+ * pool.cpp -
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <set>
+#include <shm>
+#include <shm_pool.hpp>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "check.hpp"
+
+struct order
+{
+   order( const std::uint64_t id, const std::uint32_t owner ) : id( id ),
+                                                                owner( owner ),
+                                                                check( ~id )
+   {
+   }
+
+   std::uint64_t id;
+   std::uint32_t owner;
+   std::uint64_t check;
+};
+
+using pool_t = shm::pool< order >;
+
+static constexpr std::size_t   slots    = 1024;
+static constexpr std::uint64_t children = 4;
+static constexpr std::uint64_t rounds   = 1 << 12;
+
+/** allocate_all - takes every slot, checks that the next one fails **/
+static std::set< order* > allocate_all( pool_t *p )
+{
+   std::set< order* > out;
+   for( std::size_t i( 0 ); i < p->capacity(); i++ )
+   {
+      auto *o( p->allocate() );
+      check( o != nullptr, "allocate" );
+      out.insert( o );
+   }
+   check( out.size() == p->capacity(), "slots are distinct" );
+   bool exhausted( false );
+#if USE_CPP_EXCEPTIONS==1
+   try
+   {
+      p->allocate();
+   }
+   catch( bad_shm_alloc &ex )
+   {
+      exhausted = true;
+   }
+#else
+   exhausted = ( p->allocate() == nullptr );
+#endif
+   check( exhausted, "exhausted" );
+   return( out );
+}
+
+int
+main( int argc, char **argv )
+{
+   shm_key_t key;
+   shm::gen_key( key, 23 );
+   const auto packed_bytes( pool_t::required_bytes( slots ) );
+   const auto nbytes( packed_bytes + pool_t::required_bytes( slots, pool_t::align_t::cache_line ) );
+   void *mem( shm::init( key, nbytes, false, nullptr ) );
+   auto *p( pool_t::create( mem, slots ) );
+   auto *lined( pool_t::create( reinterpret_cast< char* >( mem ) + packed_bytes,
+                                slots,
+                                pool_t::align_t::cache_line ) );
+   check( pool_t::attach( mem ) == p, "attach" );
+#if USE_CPP_EXCEPTIONS==1
+   bool wrong_type( false );
+   try
+   {
+      shm::pool< std::uint64_t >::attach( mem );
+   }
+   catch( invalid_segment_exception &ex )
+   {
+      wrong_type = true;
+   }
+   check( wrong_type, "attach as another type" );
+#else
+   check( shm::pool< std::uint64_t >::attach( mem ) == nullptr, "attach as another type" );
+#endif
+
+   /** layouts **/
+   check( p->slot_size() == sizeof( order ), "packed" );
+   check( lined->slot_size() == SHM_CACHE_LINE_SIZE, "cache line" );
+   for( std::uint32_t i( 0 ); i < slots; i++ )
+   {
+      check( reinterpret_cast< std::uintptr_t >( lined->at( i ) ) % SHM_CACHE_LINE_SIZE == 0,
+             "slot on its own line" );
+      check( p->index_of( p->at( i ) ) == i, "index_of( at( i ) )" );
+   }
+
+   /** every slot once, and all of them come back **/
+   for( auto *pool : { p, lined } )
+   {
+      for( auto *o : allocate_all( pool ) )
+      {
+         pool->deallocate( o );
+      }
+      for( auto *o : allocate_all( pool ) )
+      {
+         pool->deallocate( o );
+      }
+   }
+
+   /** magazines, frees go back in batches **/
+   {
+      pool_t::cache c( p );
+      std::set< order* > held;
+      for( std::size_t i( 0 ); i < slots; i++ )
+      {
+         held.insert( c.make( i, 0 ) );
+      }
+      check( held.size() == slots, "cache hands out every slot once" );
+      for( auto *o : held )
+      {
+         c.destroy( o );
+      }
+      c.flush();
+      for( auto *o : allocate_all( p ) )
+      {
+         p->deallocate( o );
+      }
+   }
+
+   /** indices name the same object in another process **/
+   auto *o( p->make( 42, 0 ) );
+   const auto index( p->index_of( o ) );
+   auto child( fork() );
+   if( child == 0 )
+   {
+      auto *q( pool_t::attach( mem ) );
+      check( q->at( index )->id == 42, "object by index" );
+      q->destroy( q->at( index ) );
+      _exit( EXIT_SUCCESS );
+   }
+   exited( child );
+
+   /** processes allocating and freeing at once, with and without a cache **/
+   pid_t pids[ children ];
+   for( std::uint64_t n( 0 ); n < children; n++ )
+   {
+      pids[ n ] = fork();
+      if( pids[ n ] != 0 )
+      {
+         continue;
+      }
+      const auto me( static_cast< std::uint32_t >( n + 1 ) );
+      pool_t::cache c( p );
+      order *live[ 16 ];
+      for( std::uint64_t r( 0 ); r < rounds; r++ )
+      {
+         for( std::uint64_t i( 0 ); i < 16; i++ )
+         {
+            const auto id( ( r << 4 ) | i );
+            live[ i ] = ( n & 1 ) ? c.make( id, me ) : p->make( id, me );
+         }
+         for( std::uint64_t i( 0 ); i < 16; i++ )
+         {
+            const auto id( ( r << 4 ) | i );
+            /** a slot handed out twice gets written by someone else **/
+            check( live[ i ]->id == id &&
+                   live[ i ]->owner == me &&
+                   live[ i ]->check == ~id, "slot held by one process" );
+            if( n & 1 )
+            {
+               c.destroy( live[ i ] );
+            }
+            else
+            {
+               p->destroy( live[ i ] );
+            }
+         }
+      }
+      /** _exit skips the destructor **/
+      c.flush();
+      _exit( EXIT_SUCCESS );
+   }
+   for( const auto pid : pids )
+   {
+      exited( pid );
+   }
+   /** caches flushed, nothing lost **/
+   allocate_all( p );
+
+   shm::close( key, &mem, nbytes, false, true );
+   return( EXIT_SUCCESS );
+}
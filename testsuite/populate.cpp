@@ -0,0 +1,130 @@
+/**
+ * populate.cpp -
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <shm>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "check.hpp"
+
+static constexpr std::size_t nbytes = 16 << 20;
+
+/** resident - pages of the segment that exist **/
+static std::size_t resident( void *ptr )
+{
+   const auto page_size( static_cast< std::size_t >( sysconf( _SC_PAGESIZE ) ) );
+   std::vector< unsigned char > vec( nbytes / page_size );
+   check( mincore( ptr, nbytes, vec.data() ) == 0, "mincore" );
+   std::size_t count( 0 );
+   for( const auto page : vec )
+   {
+      count += ( page & 1 );
+   }
+   return( count );
+}
+
+/** reserved - the object has its blocks, only POSIX has a path to look at **/
+template < class Backend >
+static bool reserved( const typename Backend::key_type &key )
+{
+   return( true );
+}
+
+template <>
+bool reserved< shm::posix >( const shm::posix::key_type &key )
+{
+   struct stat st;
+   const auto path( std::string( "/dev/shm/" ) + key );
+   return( stat( path.c_str(), &st ) == 0 &&
+           static_cast< std::size_t >( st.st_blocks ) * 512 >= nbytes );
+}
+
+template < class Backend >
+static void
+populate( const shm::populate_t mode, bool all, const shm::numa_policy &numa = shm::numa_policy() )
+{
+   typename Backend::key_type key;
+   shm::gen_key< Backend >( key, 113 );
+   auto *ptr( reinterpret_cast< std::uint64_t* >(
+      shm::init< Backend >( key, nbytes, true, nullptr, shm::page_t::normal, numa, mode ) ) );
+   check( ptr != nullptr && ptr != (void*)-1, "shm::init" );
+   const auto pages( nbytes / sysconf( _SC_PAGESIZE ) );
+   if( mode == shm::populate_t::fallocate && resident( ptr ) != pages )
+   {
+      /** 
+       * tmpfs allocates the pages but they aren't up to date until 
+       * written, so mincore doesn't see them, the file's blocks do
+       */
+      check( reserved< Backend >( key ), "blocks reserved" );
+      all = false;
+   }
+   else if( all )
+   {
+      check( resident( ptr ) == pages, "every page populated" );
+   }
+   else if( mode == shm::populate_t::none )
+   {
+      check( resident( ptr ) == 0, "nothing populated" );
+   }
+   std::uint64_t bits( 0 );
+   for( std::size_t i( 0 ); i < nbytes / sizeof( std::uint64_t ); i++ )
+   {
+      bits |= ptr[ i ];
+   }
+   check( bits == 0, "zero without a memset" );
+   if( all && numa.mode == shm::numa_policy::bind )
+   {
+      const auto placement( shm::get_numa_placement( ptr, nbytes ) );
+      check( placement[ numa.nodes.front() ] == pages, "populated after the policy" );
+   }
+   void *base( ptr );
+   shm::close< Backend >( key, &base, nbytes, false, true );
+}
+
+template < class Backend >
+static void
+all_modes()
+{
+   populate< Backend >( shm::populate_t::none,           false );
+   populate< Backend >( shm::populate_t::map_populate,   true  );
+   populate< Backend >( shm::populate_t::populate_write, true  );
+   populate< Backend >( shm::populate_t::fallocate,      true  );
+   populate< Backend >( shm::populate_t::first_touch,    true  );
+   /** with a policy map_populate has to wait for mbind **/
+   populate< Backend >( shm::populate_t::map_populate, 
+                        true, 
+                        shm::numa_policy( shm::numa_policy::bind, { 0 } ) );
+}
+
+int
+main( int argc, char **argv )
+{
+   all_modes< shm::posix >();
+   all_modes< shm::sysv >();
+#if __linux
+   all_modes< shm::memfd >();
+#endif
+   return( EXIT_SUCCESS );
+}
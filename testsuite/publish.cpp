@@ -0,0 +1,159 @@
+/**
+ * publish.cpp -
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <shm>
+#include <shm_seqlock.hpp>
+#include <shm_triple_buffer.hpp>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "check.hpp"
+
+/** every word of a record holds the version it was published as **/
+struct record
+{
+   std::uint64_t words[ 6 ];
+};
+
+struct frame
+{
+   std::uint64_t words[ 8192 ];
+};
+
+static constexpr int readers = 2;
+
+template < class T > static void fill( T &item, const std::uint64_t version )
+{
+   for( auto &word : item.words )
+   {
+      word = version;
+   }
+}
+
+template < class T > static bool whole( const T &item, const std::uint64_t version )
+{
+   for( const auto &word : item.words )
+   {
+      if( word != version )
+      {
+         return( false );
+      }
+   }
+   return( true );
+}
+
+/**
+ * reader - until it sees the last version, every read has to be
+ * whole and no older than the one before it.
+ */
+template < class Latest, class T >
+static void reader( const Latest *latest, const std::uint64_t last )
+{
+   T *item( new T() );
+   std::uint64_t seen( 0 );
+   while( seen < last )
+   {
+      const auto version( latest->read( *item ) );
+      check( whole( *item, version ), "read isn't torn" );
+      check( version >= seen, "versions don't go backwards" );
+      if( version == seen )
+      {
+         sched_yield();
+      }
+      seen = version;
+   }
+   delete( item );
+}
+
+template < class Latest, class T >
+static void
+run( const std::uint64_t count )
+{
+   shm_key_t key;
+   shm::gen_key( key, 20 );
+   const auto nbytes( Latest::required_bytes() );
+   void *mem( shm::init( key, nbytes, false, nullptr ) );
+   check( mem != nullptr, "init" );
+   auto *latest( Latest::create( mem ) );
+   T *item( new T() );
+   check( latest->version() == 0, "nothing published" );
+   std::uint64_t version( 1 );
+   check( latest->try_read( *item, version ) && version == 0 && whole( *item, 0 ),
+          "zero before the first publish" );
+
+   pid_t children[ readers ];
+   for( auto &child : children )
+   {
+      child = fork();
+      if( child == 0 )
+      {
+         void *cmem( shm::open( key ) );
+         reader< Latest, T >( Latest::attach( cmem ), count );
+         _exit( EXIT_SUCCESS );
+      }
+   }
+   for( std::uint64_t i( 1 ); i <= count; i++ )
+   {
+      fill( *item, i );
+      latest->publish( *item );
+      if( ( i & 0xff ) == 0 )
+      {
+         sched_yield();
+      }
+   }
+   check( latest->version() == count, "version counts publishes" );
+   for( const auto child : children )
+   {
+      exited( child );
+   }
+   delete( item );
+   shm::close( key, &mem, nbytes, false, true );
+}
+
+int
+main( int argc, char **argv )
+{
+   run< shm::seqlock< record >, record >( 1 << 16 );
+   run< shm::triple_buffer< frame >, frame >( 1 << 11 );
+
+   /** in place writes for the triple buffer **/
+   shm_key_t key;
+   shm::gen_key( key, 20 );
+   using frames_t = shm::triple_buffer< frame >;
+   void *mem( shm::init( key, frames_t::required_bytes(), false, nullptr ) );
+   auto *frames( frames_t::create( mem ) );
+   for( std::uint64_t i( 1 ); i <= 4; i++ )
+   {
+      frame *next( frames->begin() );
+      fill( *next, i );
+      /** still the previous frame until commit **/
+      frame *copy( new frame() );
+      check( frames->read( *copy ) == i - 1 && whole( *copy, i - 1 ), "old frame until commit" );
+      frames->commit();
+      check( frames->read( *copy ) == i && whole( *copy, i ), "new frame after commit" );
+      delete( copy );
+   }
+   shm::close( key, &mem, frames_t::required_bytes(), false, true );
+   return( EXIT_SUCCESS );
+}
@@ -0,0 +1,147 @@
+/**
+ * release.cpp -
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include <shm>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "check.hpp"
+
+static const std::size_t page_size( sysconf( _SC_PAGESIZE ) );
+static const std::size_t nbytes( 16 * page_size );
+
+/** resident - which pages of the first nbytes at ptr exist **/
+static std::vector< bool > resident( void *ptr )
+{
+   std::vector< unsigned char > vec( nbytes / page_size );
+   check( mincore( ptr, nbytes, vec.data() ) == 0, "mincore" );
+   return( std::vector< bool >( vec.begin(), vec.end() ) );
+}
+
+static bool all( const std::uint8_t *ptr, const std::size_t len, const std::uint8_t value )
+{
+   for( std::size_t i( 0 ); i < len; i++ )
+   {
+      if( ptr[ i ] != value )
+      {
+         return( false );
+      }
+   }
+   return( true );
+}
+
+/** 
+ * release - fills a segment, closes one of two mappings with
+ * release and checks what the other one sees.
+ */
+template < class Backend >
+static void
+release( const shm::release_t release )
+{
+   typename Backend::key_type key;
+   shm::gen_key< Backend >( key, 114 );
+   void *ptr( shm::init< Backend >( key, nbytes ) );
+   check( ptr != nullptr && ptr != (void*)-1, "shm::init" );
+   auto *other( reinterpret_cast< std::uint8_t* >( shm::open< Backend >( key ) ) );
+   check( other != nullptr, "shm::open" );
+   std::memset( ptr, 0xff, nbytes );
+   shm::close< Backend >( key, &ptr, nbytes, release, false );
+   check( ptr == nullptr, "unmapped" );
+   const auto pages( resident( other ) );
+   switch( release )
+   {
+      case( shm::release_t::none ):
+         check( all( other, nbytes, 0xff ), "left alone" );
+         break;
+      case( shm::release_t::zero ):
+         check( all( other, nbytes, 0 ), "zeroed" );
+         break;
+      default:
+         check( std::none_of( pages.begin(), pages.end(), []( bool p ){ return( p ); } ),
+                "pages handed back" );
+         check( all( other, nbytes, 0 ), "reads back zero" );
+         break;
+   }
+   void *base( other );
+   shm::close< Backend >( key, &base, nbytes, false, true );
+}
+
+template < class Backend >
+static void
+discard()
+{
+   typename Backend::key_type key;
+   shm::gen_key< Backend >( key, 114 );
+   auto *ptr( reinterpret_cast< std::uint8_t* >( shm::init< Backend >( key, nbytes ) ) );
+   check( ptr != nullptr && ptr != (void*)-1, "shm::init" );
+   std::memset( ptr, 0xff, nbytes );
+   /** half a page, two whole pages, half a page **/
+   const auto offset( page_size + page_size / 2 );
+   const auto len( 3 * page_size );
+   check( shm::discard( ptr, offset, len ), "shm::discard" );
+   /** before reading, a read faults the pages back in **/
+   const auto pages( resident( ptr ) );
+   check( pages[ 1 ] && ! pages[ 2 ] && ! pages[ 3 ] && pages[ 4 ],
+          "whole pages handed back, partial ones zeroed" );
+   check( all( ptr, offset, 0xff ), "before the range" );
+   check( all( ptr + offset, len, 0 ), "the range" );
+   check( all( ptr + offset + len, nbytes - offset - len, 0xff ), "after the range" );
+   check( shm::discard( ptr, 0, 0 ), "nothing" );
+   /** past the end would run into the guard page **/
+   const auto mapped( shm::get_mapped_size( ptr ) );
+   errno = 0;
+   check( ! shm::discard( ptr, mapped - page_size / 2, page_size ) && errno == EINVAL,
+          "out of range" );
+   check( ! shm::discard( ptr, page_size, ~std::size_t( 0 ) ) && errno == EINVAL,
+          "offset + len overflows" );
+   check( all( ptr + offset + len, nbytes - offset - len, 0xff ), "nothing discarded" );
+   check( shm::discard( ptr, mapped - page_size, page_size ), "up to the end" );
+   void *base( ptr );
+   shm::close< Backend >( key, &base, nbytes, false, true );
+}
+
+template < class Backend >
+static void
+all_modes()
+{
+   release< Backend >( shm::release_t::none );
+   release< Backend >( shm::release_t::zero );
+   release< Backend >( shm::release_t::punch_hole );
+   release< Backend >( shm::release_t::remove );
+   discard< Backend >();
+}
+
+int
+main( int argc, char **argv )
+{
+   all_modes< shm::posix >();
+   all_modes< shm::sysv >();
+#if __linux
+   all_modes< shm::memfd >();
+#endif
+   check( ! shm::discard( nullptr, 0, 1 ), "not a segment" );
+   return( EXIT_SUCCESS );
+}
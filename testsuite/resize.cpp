@@ -0,0 +1,135 @@
+/**
+ * resize.cpp -
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <shm>
+#include <shm_growth.hpp>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "check.hpp"
+
+static const std::size_t page_size( sysconf( _SC_PAGESIZE ) );
+
+static bool all( const void *ptr, const std::size_t len, const std::uint8_t value )
+{
+   const auto *bytes( reinterpret_cast< const std::uint8_t* >( ptr ) );
+   for( std::size_t i( 0 ); i < len; i++ )
+   {
+      if( bytes[ i ] != value )
+      {
+         return( false );
+      }
+   }
+   return( true );
+}
+
+/** faults - true if touching addr kills a child with SIGSEGV **/
+static bool faults( volatile char *addr )
+{
+   const auto child( fork() );
+   if( child == 0 )
+   {
+      addr[ 0 ] = 1;
+      _exit( EXIT_SUCCESS );
+   }
+   int status( 0 );
+   waitpid( child, &status, 0 );
+   return( WIFSIGNALED( status ) && WTERMSIG( status ) == SIGSEGV );
+}
+
+template < class Backend >
+static void
+grow( const bool can_shrink )
+{
+   typename Backend::key_type key;
+   shm::gen_key< Backend >( key, 115 );
+   const auto small( shm::growth::required_bytes( page_size ) );
+   const auto large( shm::growth::required_bytes( 64 * page_size ) );
+   void *mem( shm::init< Backend >( key, small ) );
+   check( mem != nullptr && mem != (void*)-1, "shm::init" );
+   auto *header( shm::growth::create( mem, small ) );
+   std::memset( header->data(), 0xab, header->data_bytes() );
+
+   /** a second mapping stands in for another process **/
+   void *reader( shm::open< Backend >( key ) );
+   check( reader != nullptr, "shm::open" );
+   std::uint64_t seen( shm::growth::attach( reader )->generation() );
+   check( seen == 0 && shm::get_mapped_size( reader ) >= small, "opened" );
+
+   header = shm::growth::grow< Backend >( key, &mem, large );
+   check( header != nullptr && header->generation() == 1 && header->size() == large, "grew" );
+   check( shm::get_mapped_size( mem ) >= large, "owner remapped" );
+   check( all( header->data(), page_size, 0xab ), "contents kept" );
+   check( all( reinterpret_cast< char* >( header->data() ) + page_size,
+               header->data_bytes() - page_size,
+               0 ), "growth reads zero" );
+   reinterpret_cast< char* >( header->data() )[ header->data_bytes() - 1 ] = 0x7;
+   check( faults( reinterpret_cast< char* >( mem ) + shm::get_mapped_size( mem ) ),
+          "guard page at the new end" );
+   check( shm::growth::grow< Backend >( key, &mem, small ) == nullptr && errno == EINVAL,
+          "growth never shrinks" );
+
+   /** the reader catches up when it looks **/
+   auto *view( shm::growth::refresh( &reader, seen ) );
+   check( view != nullptr && seen == 1 && shm::get_mapped_size( reader ) >= large, "refreshed" );
+   check( all( view->data(), page_size, 0xab ), "reader sees the old contents" );
+   check( reinterpret_cast< char* >( view->data() )[ view->data_bytes() - 1 ] == 0x7,
+          "reader sees the new end" );
+   check( shm::growth::refresh( &reader, seen ) == view, "nothing new" );
+
+   /** only the raw call shrinks **/
+   check( shm::resize< Backend >( key, &reader, small ) == false || can_shrink, "memfd can't shrink" );
+   if( can_shrink )
+   {
+      check( shm::get_mapped_size( reader ) < large, "shrunk" );
+   }
+   else
+   {
+      check( shm::get_mapped_size( reader ) >= large, "mapping left alone" );
+   }
+   /** close unmaps what is mapped, whatever nbytes says **/
+   shm::close< Backend >( key, &reader, small, false, false );
+   shm::close< Backend >( key, &mem, small, false, true );
+}
+
+int
+main( int argc, char **argv )
+{
+   grow< shm::posix >( true );
+#if __linux
+   grow< shm::memfd >( false );
+#endif
+   shm::sysv::key_type key;
+   shm::gen_key< shm::sysv >( key, 115 );
+   void *mem( shm::init< shm::sysv >( key, page_size ) );
+   check( mem != nullptr && mem != (void*)-1, "shm::init< sysv >" );
+   check( ! shm::resize< shm::sysv >( key, &mem, 2 * page_size ) && errno == ENOTSUP,
+          "SystemV segments are fixed" );
+   check( shm::get_mapped_size( mem ) == page_size, "left alone" );
+   shm::close< shm::sysv >( key, &mem, page_size, false, true );
+   void *nothing( nullptr );
+   check( ! shm::remap( &nothing, page_size ) && errno == EINVAL, "not a mapping" );
+   return( EXIT_SUCCESS );
+}
@@ -0,0 +1,169 @@
+/**
+ * segment.cpp -
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include <shm>
+#include <shm_segment.hpp>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "check.hpp"
+
+static const std::size_t page_size( sysconf( _SC_PAGESIZE ) );
+
+/** open_fds - descriptors this process has open **/
+static int open_fds()
+{
+   int count( 0 );
+   DIR *dir( opendir( "/proc/self/fd" ) );
+   if( dir == nullptr )
+   {
+      return( 0 );
+   }
+   while( readdir( dir ) != nullptr )
+   {
+      count++;
+   }
+   closedir( dir );
+   return( count );
+}
+
+/** opens - true if key can still be opened **/
+template < class Backend >
+static bool opens( const typename Backend::key_type &key )
+{
+#if USE_CPP_EXCEPTIONS==1
+   try
+   {
+      return( static_cast< bool >( shm::segment::open< Backend >( key ) ) );
+   }
+   catch( bad_shm_alloc &ex )
+   {
+      return( false );
+   }
+#else
+   return( static_cast< bool >( shm::segment::open< Backend >( key ) ) );
+#endif
+}
+
+template < class Backend >
+static void
+handle( const shm::segment::backend_t kind, const bool can_resize )
+{
+   typename Backend::key_type key;
+   shm::gen_key< Backend >( key, 116 );
+   {
+      shm::segment owner( shm::segment::create< Backend >( key, 3 * page_size + 1 ) );
+      check( static_cast< bool >( owner ), "create" );
+      check( owner.backend() == kind, "backend" );
+      check( owner.page_size() == page_size, "page size" );
+      check( owner.size() == 4 * page_size, "size, whole pages" );
+      check( owner.size() == shm::get_mapped_size( owner.get() ), "same as the static call" );
+      /** init on a key in use still says so, open it instead **/
+#if USE_CPP_EXCEPTIONS==1
+      bool exists( false );
+      try
+      {
+         shm::init< Backend >( key, page_size );
+      }
+      catch( shm_already_exists & )
+      {
+         exists = true;
+      }
+      check( exists, "init on a key in use" );
+#else
+      check( shm::init< Backend >( key, page_size ) == (void*)-1 && errno == EEXIST,
+             "init on a key in use" );
+#endif
+      if( kind == shm::segment::backend_t::sysv )
+      {
+         check( owner.fd() == -1 && owner.shmid() >= 0, "shmid" );
+      }
+      else
+      {
+         check( owner.shmid() == -1 && fcntl( owner.fd(), F_GETFD ) != -1, "descriptor kept" );
+      }
+
+      shm::segment reader( shm::segment::open< Backend >( key ) );
+      check( static_cast< bool >( reader ) && reader.get() != owner.get(), "open" );
+      check( reader.size() >= owner.size(), "opened size" );
+      owner.as< std::uint32_t >()[ 0 ] = 0x1137;
+      check( reader.as< std::uint32_t >()[ 0 ] == 0x1137, "shared" );
+
+      /** moving hands the mapping over **/
+      shm::segment moved( std::move( reader ) );
+      check( ! reader && moved.as< std::uint32_t >()[ 0 ] == 0x1137, "moved" );
+
+      if( can_resize )
+      {
+         check( owner.resize( 64 * page_size ), "resize" );
+         check( owner.size() == 64 * page_size, "resized size" );
+         check( owner.as< std::uint32_t >()[ 0 ] == 0x1137, "contents kept" );
+         owner.as< char >()[ 64 * page_size - 1 ] = 0x7;
+         check( moved.remap( 64 * page_size ) && moved.size() == 64 * page_size, "remap" );
+         check( moved.as< char >()[ 64 * page_size - 1 ] == 0x7, "reader sees the new end" );
+      }
+      else
+      {
+         check( ! owner.resize( 64 * page_size ) && errno == ENOTSUP, "fixed size" );
+         check( owner.size() == 4 * page_size, "left alone" );
+      }
+      check( owner.discard( 0, owner.size() ) &&
+             moved.as< std::uint32_t >()[ 0 ] == 0, "discard" );
+      check( ! owner.discard( 0, owner.size() + 1 ) && errno == EINVAL, "discard past the end" );
+      /** moved and owner go out of scope, owner unlinks **/
+   }
+   if( kind != shm::segment::backend_t::memfd )
+   {
+      /** memfd descriptor numbers get reused, nothing to look at **/
+      check( ! opens< Backend >( key ), "unlinked when the owner went away" );
+   }
+
+   /** the static calls are built on segment and don't leak its descriptor **/
+   const auto before( open_fds() );
+   shm::gen_key< Backend >( key, 216 );
+   void *mem( shm::init< Backend >( key, page_size ) );
+   check( mem != nullptr && mem != (void*)-1, "shm::init" );
+   void *other( shm::open< Backend >( key ) );
+   check( other != nullptr && other != (void*)-1, "shm::open" );
+   shm::close< Backend >( key, &other, page_size, false, false );
+   shm::close< Backend >( key, &mem, page_size, false, true );
+   check( open_fds() == before, "no descriptors left behind" );
+
+   /** close on an empty segment does nothing **/
+   shm::segment empty;
+   check( ! empty && empty.close() && empty.size() == 0, "empty" );
+}
+
+int
+main( int argc, char **argv )
+{
+   handle< shm::posix >( shm::segment::backend_t::posix, true );
+   handle< shm::sysv >( shm::segment::backend_t::sysv, false );
+#if __linux
+   handle< shm::memfd >( shm::segment::backend_t::memfd, true );
+#endif
+   return( EXIT_SUCCESS );
+}
@@ -0,0 +1,149 @@
+/**
+ * segment_pool.cpp -
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include <vector>
+#include <shm>
+#include <shm_segment.hpp>
+#include <shm_segment_pool.hpp>
+#include <unistd.h>
+
+#include "check.hpp"
+
+static const std::size_t page_size( sysconf( _SC_PAGESIZE ) );
+
+static bool zero( const shm::segment &seg )
+{
+   const auto *bytes( seg.as< const std::uint8_t >() );
+   for( std::size_t i( 0 ); i < seg.size(); i++ )
+   {
+      if( bytes[ i ] != 0 )
+      {
+         return( false );
+      }
+   }
+   return( true );
+}
+
+template < class Backend >
+static void
+pooled( const Backend backend )
+{
+   shm::segment_pool pool( { { 64 * page_size, 2 }, { 4 * page_size, 4 } },
+                           shm::segment_pool::options(),
+                           backend );
+   check( pool.wait_ready(), "filled" );
+   check( pool.classes() == 2, "classes" );
+   check( pool.ready( 0 ) == 4 && pool.ready( 1 ) == 2, "sorted by size, at depth" );
+
+   auto seg( pool.acquire( 100 ) );
+   check( static_cast< bool >( seg ) && seg.size() >= 4 * page_size &&
+          seg.size() < 64 * page_size, "smallest class that fits" );
+   check( zero( seg ), "new segments are zero" );
+   auto stats( pool.get_stats( 0 ) );
+   check( stats.hits == 1 && stats.misses == 0 && stats.created >= 4, "hit" );
+
+   /** the key reaches the same segment **/
+   typename Backend::key_type key;
+   check( seg.template key< Backend >( key ), "key" );
+   seg.template as< std::uint32_t >()[ 0 ] = 0x1137;
+   {
+      auto view( shm::segment::open< Backend >( key ) );
+      check( view.template as< std::uint32_t >()[ 0 ] == 0x1137, "shared through its key" );
+   }
+
+   auto big( pool.acquire( 256 * page_size ) );
+   check( static_cast< bool >( big ) && big.size() >= 256 * page_size, "bigger than every class" );
+   stats = pool.get_stats();
+   check( stats.hits == 1 && stats.misses == 1, "oversize is a miss" );
+
+   /** draining a class past its depth still hands out segments **/
+   std::vector< shm::segment > held;
+   for( int i( 0 ); i < 8; i++ )
+   {
+      held.push_back( pool.acquire( page_size ) );
+      check( static_cast< bool >( held.back() ), "acquire" );
+   }
+   stats = pool.get_stats( 0 );
+   check( stats.hits + stats.misses == 9, "every acquire counted" );
+   check( stats.hit_rate() > 0.0 && stats.hit_rate() <= 1.0, "hit rate" );
+
+   pool.release( std::move( seg ) );
+   pool.release( std::move( big ) );
+   for( auto &one : held )
+   {
+      pool.release( std::move( one ) );
+   }
+   check( pool.wait_ready(), "topped back up" );
+}
+
+int
+main( int argc, char **argv )
+{
+   /**
+    * pools go round every SystemV key of the working directory (ftok),
+    * a directory of our own keeps them off other tests' keys
+    */
+   char dir[] = "/tmp/segment_pool.XXXXXX";
+   check( mkdtemp( dir ) != nullptr && chdir( dir ) == 0, "own working directory" );
+
+   pooled( shm::default_backend() );
+#if __linux
+   pooled( shm::memfd() );
+#endif
+
+   /** SystemV keys come from one short list, two pools mustn't make the same ones **/
+   {
+      shm::segment_pool first( { { 4 * page_size, 4 } }, shm::segment_pool::options(), shm::sysv() );
+      shm::segment_pool second( { { 4 * page_size, 4 } }, shm::segment_pool::options(), shm::sysv() );
+      check( first.wait_ready() && second.wait_ready(), "two SystemV pools" );
+      check( first.get_stats().failed == 0 && second.get_stats().failed == 0, "no key clashes" );
+      /** a key already taken outside the pools is skipped, going round every key **/
+      key_t taken;
+      shm::gen_key< shm::sysv >( taken, 8 );
+      void *outside( shm::init< shm::sysv >( taken, page_size ) );
+      check( outside != nullptr && outside != (void*)-1, "outside segment" );
+      for( std::uint32_t i( 0 ); i < shm::segment_pool::max_keys + 16; i++ )
+      {
+         auto seg( first.acquire( page_size ) );
+         check( static_cast< bool >( seg ), "acquire past a taken key" );
+         first.release( std::move( seg ) );
+      }
+      shm::close< shm::sysv >( taken, &outside, page_size, false, true );
+   }
+
+   /** recycled segments come back zeroed **/
+   shm::segment_pool::options opts;
+   opts.recycle = true;
+   shm::segment_pool pool( { { 4 * page_size, 2 } }, opts );
+   check( pool.wait_ready(), "filled" );
+   for( int round( 0 ); round < 16; round++ )
+   {
+      auto seg( pool.acquire( page_size ) );
+      check( static_cast< bool >( seg ) && zero( seg ), "zeroed" );
+      std::memset( seg.get(), 0xff, seg.size() );
+      pool.release( std::move( seg ) );
+   }
+   rmdir( dir );
+   return( EXIT_SUCCESS );
+}
@@ -0,0 +1,85 @@
+/**
+ * send_key.cpp -
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <shm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "check.hpp"
+
+static constexpr std::size_t nbytes = 0x10000;
+
+int
+main( int argc, char **argv )
+{
+   int sockets[ 2 ];
+   check( socketpair( AF_UNIX, SOCK_STREAM, 0, sockets ) == 0, "socketpair" );
+   /**
+    * fork before the segment exists so that the child can't
+    * inherit it, everything it knows comes over the socket.
+    */
+   if( fork() == 0 )
+   {
+      ::close( sockets[ 0 ] );
+      shm_key_t key = { shm_initial_key };
+      check( shm::recv_key( sockets[ 1 ], key ), "shm::recv_key" );
+      auto *ptr( reinterpret_cast< std::uint8_t* >( shm::open( key ) ) );
+      check( ptr != nullptr, "shm::open( received key )" );
+      for( std::size_t i( 0 ); i < nbytes; i++ )
+      {
+         check( ptr[ i ] == static_cast< std::uint8_t >( i ), "contents" );
+      }
+#if _USE_MEMFD_SHM_ == 1
+      /** it can't shrink, readers never fault past the end **/
+      int pid( 0 ), fd( -1 );
+      check( std::sscanf( key, "%d/%d", &pid, &fd ) == 2 && pid == getpid(), "key names our fd" );
+      const auto seals( fcntl( fd, F_GET_SEALS ) );
+      check( seals != -1 && ( seals & F_SEAL_SHRINK ) && ! ( seals & F_SEAL_GROW ), "sealed" );
+      check( ftruncate( fd, 0 ) != 0, "can't shrink a sealed segment" );
+#endif
+      ptr[ 0 ] = 0xff;
+      shm::close( key, reinterpret_cast< void** >( &ptr ), nbytes, false, false );
+      _exit( EXIT_SUCCESS );
+   }
+   ::close( sockets[ 1 ] );
+   shm_key_t key = { shm_initial_key };
+   shm::gen_key( key, 107 );
+   auto *ptr( reinterpret_cast< std::uint8_t* >( shm::init( key, nbytes, false, nullptr ) ) );
+   if( ptr == (void*)-1 || ptr == nullptr )
+   {
+      std::fprintf( stderr, "Failed to allocate pointer\n" );
+      exit( EXIT_FAILURE );
+   }
+   for( std::size_t i( 0 ); i < nbytes; i++ )
+   {
+      ptr[ i ] = static_cast< std::uint8_t >( i );
+   }
+   check( shm::send_key( sockets[ 0 ], key ), "shm::send_key" );
+   check( wait_all( 1 ), "child" );
+   check( ptr[ 0 ] == 0xff, "child's write is visible" );
+   shm::close( key, reinterpret_cast< void** >( &ptr ), nbytes, false, true );
+   return( EXIT_SUCCESS );
+}
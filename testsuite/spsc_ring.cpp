@@ -0,0 +1,135 @@
+/**
+ * spsc_ring.cpp -
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdint>
+#include <iostream>
+#include <shm>
+#include <shm_spsc_ring.hpp>
+#include <cassert>
+#include <thread>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+using ring_t = shm::spsc_ring< std::uint64_t >;
+
+static constexpr std::uint64_t  count      = 1 << 20;
+static constexpr std::size_t    capacity   = 1000; /** rounds to 1024 **/
+static constexpr std::size_t    batch      = 37;
+
+int
+main( int argc, char **argv )
+{
+   shm_key_t key    = { shm_initial_key };
+   shm::gen_key( key, 102 );
+   const auto nbytes( ring_t::required_bytes( capacity ) );
+   void *mem( shm::init( key, nbytes, false, nullptr ) );
+   if( mem == (void*)-1 || mem == nullptr )
+   {
+      std::fprintf( stderr, "Failed to allocate pointer\n" );
+      exit( EXIT_FAILURE );
+   }
+   auto *ring( ring_t::create( mem, capacity ) );
+   assert( ring->capacity() == 1024 );
+   assert( ring->empty() );
+
+   auto child = fork();
+   switch( child )
+   {
+      case( 0 /** child, consumer **/ ):
+      {
+         void *cmem( shm::open( key ) );
+         auto *cring( ring_t::attach( cmem ) );
+         std::uint64_t expected( 0 );
+         std::uint64_t buffer[ batch ];
+         while( expected < count )
+         {
+            /** alternate between single and batch pops **/
+            std::size_t n( 0 );
+            if( expected & 1 )
+            {
+               n = cring->pop( buffer[ 0 ] ) ? 1 : 0;
+            }
+            else
+            {
+               n = cring->pop( buffer, batch );
+            }
+            if( n == 0 )
+            {
+               std::this_thread::yield();
+            }
+            for( std::size_t i( 0 ); i < n; i++ )
+            {
+               if( buffer[ i ] != expected++ )
+               {
+                  std::fprintf( stderr, "out of order item\n" );
+                  _exit( EXIT_FAILURE );
+               }
+            }
+         }
+         shm::close( key, &cmem, nbytes, false, false );
+         _exit( EXIT_SUCCESS );
+      }
+      break;
+      case( -1 /** error, back to parent **/ ):
+      {
+         exit( EXIT_FAILURE );
+      }
+      break;
+      default:
+      {
+         std::uint64_t next( 0 );
+         std::uint64_t buffer[ batch ];
+         while( next < count )
+         {
+            if( next & 1 )
+            {
+               if( ring->push( next ) )
+               {
+                  next++;
+                  continue;
+               }
+            }
+            else
+            {
+               std::size_t n( 0 );
+               for( ; n < batch && next + n < count; n++ )
+               {
+                  buffer[ n ] = next + n;
+               }
+               const auto pushed( ring->push( buffer, n ) );
+               next += pushed;
+               if( pushed != 0 )
+               {
+                  continue;
+               }
+            }
+            std::this_thread::yield();
+         }
+         int status = 0;
+         waitpid( child, &status, 0 );
+         shm::close( key, &mem, nbytes, false, true );
+         if( ! WIFEXITED( status ) || WEXITSTATUS( status ) != EXIT_SUCCESS )
+         {
+            return( EXIT_FAILURE );
+         }
+      }
+   }
+   return( EXIT_SUCCESS );
+}
@@ -0,0 +1,105 @@
+/**
+ * topology.cpp -
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <set>
+#include <vector>
+#include <shm>
+#include <shm_topology.hpp>
+#include <unistd.h>
+#if __linux && ( PLATFORM_HAS_NUMA == 1 )
+#include <numa.h>
+#endif
+
+#include "check.hpp"
+
+int
+main( int argc, char **argv )
+{
+   check( shm::topology::parse_list( "0-3,8,10-11\n" ) ==
+          std::vector< int >( { 0, 1, 2, 3, 8, 10, 11 } ), "list with ranges" );
+   check( shm::topology::parse_list( "5" ) == std::vector< int >( { 5 } ), "single" );
+   check( shm::topology::parse_list( "" ).empty(), "empty list" );
+
+   const auto &nodes( shm::topology::nodes() );
+   check( ! nodes.empty(), "at least one node" );
+   check( &nodes == &shm::topology::nodes(), "cached" );
+   check( shm::topology::max_node() == nodes.back().id, "max node" );
+
+   /** every online cpu on exactly one node **/
+   std::set< int > seen;
+   std::size_t memory( 0 );
+   for( const auto &node : nodes )
+   {
+      check( shm::topology::distance( node.id, node.id ) == 10, "local distance is 10" );
+      for( const auto &other : nodes )
+      {
+         check( shm::topology::distance( node.id, other.id ) >= 10, "remote distance" );
+      }
+      for( const auto cpu : node.cpus )
+      {
+         check( seen.insert( cpu ).second, "a cpu on two nodes" );
+         check( shm::topology::node_of_cpu( cpu ) == node.id, "node of cpu" );
+      }
+      check( shm::topology::free_memory( node.id ) <= node.total_bytes, "free <= total" );
+      memory += node.total_bytes;
+   }
+   check( memory > 0, "some node has memory" );
+   check( seen == std::set< int >( shm::topology::cpus().begin(), shm::topology::cpus().end() ),
+          "every online cpu" );
+   check( shm::topology::node_of_cpu( -1 ) == -1 && shm::topology::distance( -1, 0 ) == 0,
+          "not a cpu or node" );
+   check( shm::topology::free_memory( shm::topology::max_node() + 1 ) == 0, "not a node" );
+
+   /** last level caches split the cpus **/
+   std::set< int > cached;
+   for( const auto &group : shm::topology::llc_groups() )
+   {
+      check( ! group.cpus.empty(), "empty cache group" );
+      check( group.node == shm::topology::node_of_cpu( group.cpus.front() ), "group node" );
+      for( const auto cpu : group.cpus )
+      {
+         check( cached.insert( cpu ).second, "a cpu in two cache groups" );
+      }
+   }
+   check( cached == seen, "every cpu has a last level cache" );
+
+#if __linux && ( PLATFORM_HAS_NUMA == 1 )
+   /** agrees with libnuma **/
+   if( numa_available() != -1 )
+   {
+      check( shm::topology::max_node() == numa_max_node(), "libnuma max node" );
+      for( const auto &node : nodes )
+      {
+         for( const auto &other : nodes )
+         {
+            check( shm::topology::distance( node.id, other.id ) == numa_distance( node.id, other.id ),
+                   "libnuma distance" );
+         }
+         for( const auto cpu : node.cpus )
+         {
+            check( numa_node_of_cpu( cpu ) == node.id, "libnuma node of cpu" );
+         }
+      }
+   }
+#endif
+   return( EXIT_SUCCESS );
+}